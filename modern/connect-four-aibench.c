@@ -0,0 +1,328 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "connect_four.h"
+#include "connect_four_ai.h"
+#include "connect_four_engine.h"
+
+/*
+ * AI latency benchmark.
+ *
+ * Runs the game's move choice (cf_engine_choose_move, i.e. what
+ * cf_ai_choose_move_ex does) at depths 6, 7 and 8, with and without a
+ * blocked column, over a fixed corpus of openings, middlegames and
+ * endgames. Every search starts from an empty private transposition table
+ * so runs are reproducible; -n disables the table entirely.
+ *
+ * Reports per depth / blocked / category: positions, effective depth
+ * range (endgame overrides raise it), nodes, NPS and p50/p95/p99/max wall
+ * time. -j writes the same numbers as JSON.
+ */
+
+enum {
+    MAX_POSITIONS = 1024,
+    LINE_CHARS = 256,
+    CATEGORY_CHARS = 32,
+    MAX_CATEGORIES = 8,
+    DEPTH_COUNT = 3
+};
+
+static const int kDepths[DEPTH_COUNT] = {6, 7, 8};
+
+typedef struct {
+    char category[CATEGORY_CHARS];
+    char moves[CF_ROWS * CF_COLS + 1];
+    CfGame game;
+    bool blocked_cols[CF_COLS];
+} CorpusEntry;
+
+typedef struct {
+    double ms;
+    uint64_t nodes;
+    int depth;
+} Sample;
+
+typedef struct {
+    int positions;
+    int min_depth;
+    int max_depth;
+    uint64_t nodes;
+    double total_ms;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+} Summary;
+
+static CorpusEntry g_corpus[MAX_POSITIONS];
+static int g_corpus_count;
+static char g_categories[MAX_CATEGORIES][CATEGORY_CHARS];
+static int g_category_count;
+
+/* --------------------- Corpus --------------------- */
+
+/* Blocks one column per position, chosen from its index, keeping at least two columns open. */
+static void pick_blocked_column(CorpusEntry *e, int index) {
+    int open = 0;
+
+    for (int col = 0; col < CF_COLS; ++col) {
+        open += cf_is_valid_move(&e->game, col) ? 1 : 0;
+    }
+    if (open < 3) {
+        return;
+    }
+    for (int i = 0; i < CF_COLS; ++i) {
+        int col = (index + i) % CF_COLS;
+        if (cf_is_valid_move(&e->game, col)) {
+            e->blocked_cols[col] = true;
+            return;
+        }
+    }
+}
+
+static bool load_corpus(const char *path) {
+    char line[LINE_CHARS];
+    int line_no = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL) {
+        fprintf(stderr, "aibench: cannot open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL && g_corpus_count < MAX_POSITIONS) {
+        CorpusEntry *e = &g_corpus[g_corpus_count];
+        size_t bad_index;
+        bool known = false;
+
+        line_no += 1;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        memset(e, 0, sizeof(*e));
+        if (sscanf(line, "%31s %36s", e->category, e->moves) != 2 ||
+            !cf_load_moves(&e->game, e->moves, strlen(e->moves), CF_AI, &bad_index)) {
+            fprintf(stderr, "aibench: %s:%d: bad position\n", path, line_no);
+            fclose(fp);
+            return false;
+        }
+        pick_blocked_column(e, g_corpus_count);
+
+        for (int c = 0; c < g_category_count; ++c) {
+            known = known || strcmp(g_categories[c], e->category) == 0;
+        }
+        if (!known && g_category_count < MAX_CATEGORIES) {
+            memcpy(g_categories[g_category_count++], e->category, CATEGORY_CHARS);
+        }
+        g_corpus_count += 1;
+    }
+
+    fclose(fp);
+    return g_corpus_count > 0;
+}
+
+/* --------------------- Statistics --------------------- */
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of an ascending array. */
+static double percentile(const double *sorted, int count, double pct) {
+    int rank = (int)((pct / 100.0) * count + 0.999999);
+
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > count) {
+        rank = count;
+    }
+    return sorted[rank - 1];
+}
+
+static void summarize(const Sample *samples, const char *category, Summary *out) {
+    static double times[MAX_POSITIONS];
+    int count = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->min_depth = CF_AI_MAX_DEPTH;
+    for (int i = 0; i < g_corpus_count; ++i) {
+        if (category != NULL && strcmp(g_corpus[i].category, category) != 0) {
+            continue;
+        }
+        times[count++] = samples[i].ms;
+        out->nodes += samples[i].nodes;
+        out->total_ms += samples[i].ms;
+        if (samples[i].depth < out->min_depth) {
+            out->min_depth = samples[i].depth;
+        }
+        if (samples[i].depth > out->max_depth) {
+            out->max_depth = samples[i].depth;
+        }
+    }
+
+    out->positions = count;
+    if (count == 0) {
+        out->min_depth = 0;
+        return;
+    }
+    qsort(times, (size_t)count, sizeof(double), compare_double);
+    out->p50 = percentile(times, count, 50);
+    out->p95 = percentile(times, count, 95);
+    out->p99 = percentile(times, count, 99);
+    out->max = times[count - 1];
+}
+
+static double summary_nps(const Summary *s) {
+    return s->total_ms > 0 ? (double)s->nodes * 1000.0 / s->total_ms : 0;
+}
+
+/* --------------------- Runs --------------------- */
+static void run_config(CfEngine *engine, int depth, bool blocked, Sample *samples) {
+    for (int i = 0; i < g_corpus_count; ++i) {
+        CorpusEntry *e = &g_corpus[i];
+        CfGame game = e->game;
+        CfSearchInfo info;
+
+        cf_engine_clear(engine);
+        cf_engine_choose_move(engine, &game, depth, blocked ? e->blocked_cols : NULL, 0, &info);
+
+        samples[i].ms = info.elapsed_ms;
+        samples[i].nodes = info.nodes;
+        samples[i].depth = info.depth;
+    }
+}
+
+static void print_row(FILE *fp, int depth, bool blocked, const char *category, const Summary *s) {
+    char depths[16];
+
+    if (s->min_depth == s->max_depth) {
+        snprintf(depths, sizeof(depths), "%d", s->min_depth);
+    } else {
+        snprintf(depths, sizeof(depths), "%d-%d", s->min_depth, s->max_depth);
+    }
+    fprintf(
+        fp,
+        "%5d %-7s %-11s %4d %6s %12llu %11.0f %9.2f %9.2f %9.2f %9.2f\n",
+        depth,
+        blocked ? "yes" : "no",
+        category,
+        s->positions,
+        depths,
+        (unsigned long long)s->nodes,
+        summary_nps(s),
+        s->p50,
+        s->p95,
+        s->p99,
+        s->max
+    );
+}
+
+static void json_row(FILE *fp, bool *first, int depth, bool blocked, const char *category, const Summary *s) {
+    fprintf(
+        fp,
+        "%s    {\"depth\": %d, \"blocked\": %s, \"category\": \"%s\", \"positions\": %d, "
+        "\"effective_depth_min\": %d, \"effective_depth_max\": %d, \"nodes\": %llu, \"nps\": %.0f, "
+        "\"p50_ms\": %.3f, \"p95_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f}",
+        *first ? "" : ",\n",
+        depth,
+        blocked ? "true" : "false",
+        category,
+        s->positions,
+        s->min_depth,
+        s->max_depth,
+        (unsigned long long)s->nodes,
+        summary_nps(s),
+        s->p50,
+        s->p95,
+        s->p99,
+        s->max
+    );
+    *first = false;
+}
+
+/* --------------------- Main --------------------- */
+int main(int argc, char **argv) {
+    static Sample samples[MAX_POSITIONS];
+    const char *corpus_path = "modern/ai-bench-corpus.txt";
+    const char *json_path = NULL;
+    bool use_tt = true;
+    bool first_json = true;
+    FILE *json = NULL;
+    FILE *table;
+    CfEngineConfig config;
+    CfEngine *engine;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0) {
+            use_tt = false;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (argv[i][0] != '-') {
+            corpus_path = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [-n] [-j out.json|-] [corpus.txt]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (!load_corpus(corpus_path)) {
+        return 1;
+    }
+    if (json_path != NULL) {
+        json = strcmp(json_path, "-") == 0 ? stdout : fopen(json_path, "w");
+        if (json == NULL) {
+            fprintf(stderr, "aibench: cannot write %s: %s\n", json_path, strerror(errno));
+            return 1;
+        }
+        fprintf(json, "{\n  \"corpus\": \"%s\",\n  \"positions\": %d,\n  \"transposition_table\": %s,\n  \"results\": [\n",
+            corpus_path, g_corpus_count, use_tt ? "true" : "false");
+    }
+
+    cf_engine_config_init(&config);
+    config.tt_slots = use_tt ? CF_TT_DEFAULT_SLOTS : 0;
+    config.tablebase_path = getenv("CF_TABLEBASE");
+    engine = cf_engine_create(&config);
+    if (engine == NULL) {
+        fprintf(stderr, "aibench: out of memory\n");
+        return 1;
+    }
+
+    /* With JSON on stdout the table goes to stderr so the JSON stays parseable. */
+    table = (json == stdout) ? stderr : stdout;
+    fprintf(table, "%5s %-7s %-11s %4s %6s %12s %11s %9s %9s %9s %9s\n",
+        "depth", "blocked", "category", "n", "eff", "nodes", "nps", "p50 ms", "p95 ms", "p99 ms", "max ms");
+
+    for (int d = 0; d < DEPTH_COUNT; ++d) {
+        for (int b = 0; b < 2; ++b) {
+            Summary summary;
+
+            run_config(engine, kDepths[d], b == 1, samples);
+            for (int c = 0; c <= g_category_count; ++c) {
+                const char *category = (c < g_category_count) ? g_categories[c] : NULL;
+
+                summarize(samples, category, &summary);
+                print_row(table, kDepths[d], b == 1, category ? category : "all", &summary);
+                if (json != NULL) {
+                    json_row(json, &first_json, kDepths[d], b == 1, category ? category : "all", &summary);
+                }
+            }
+            fflush(table);
+        }
+    }
+
+    if (json != NULL) {
+        fprintf(json, "\n  ]\n}\n");
+        if (json != stdout) {
+            fclose(json);
+        }
+    }
+
+    cf_engine_destroy(engine);
+    return 0;
+}
@@ -0,0 +1,690 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "connect_four.h"
+#include "connect_four_ai.h"
+#include "connect_four_engine.h"
+
+/*
+ * Streaming batch analyser.
+ *
+ * Input: one position per line, "<moves> [blocked]" with 1-based column
+ * digits (see connect-four-engine); blank lines and '#' comments are
+ * skipped. The side to move is analysed as CF_AI.
+ *
+ * Output: one tab-separated line per position, in input order:
+ *   line  moves  bestmove  score  depth  nodes  time_us
+ *
+ * The reader cuts the input into ~64 KB batches on line boundaries (a
+ * memory-mapped file is sliced in place, a pipe is read in chunks), worker
+ * threads analyse whole batches into private output buffers, and a writer
+ * thread emits finished batches strictly in sequence. At most
+ * WINDOW_PER_THREAD batches per worker are in flight, so memory stays flat
+ * however large the input is.
+ *
+ * Each worker owns an engine whose transposition table is cleared before
+ * every position, so a line's node count does not depend on what was
+ * analysed before it or on the thread count. -s shares one table (and
+ * CF_TT_FILE) across the run instead: faster, but order-dependent.
+ */
+
+enum {
+    BATCH_BYTES = 1 << 16,
+    WINDOW_PER_THREAD = 4,
+    MAX_THREADS = 256,
+    MAX_LINE_OUTPUT = 160,
+    /* Small enough that clearing it per position (a fresh mapping) costs little next to the search. */
+    POSITION_TT_SLOTS = 1 << 16
+};
+
+typedef enum {
+    MODE_GAME = 0,
+    MODE_SEARCH
+} AnalyseMode;
+
+typedef enum {
+    SLOT_FREE = 0,
+    SLOT_READY,
+    SLOT_BUSY,
+    SLOT_DONE
+} SlotState;
+
+typedef struct {
+    AnalyseMode mode;
+    int depth;
+    double movetime_ms;
+    uint64_t node_limit;
+    int threads;
+    bool shared_tt;
+    const char *in_path;
+    const char *out_path;
+} Options;
+
+typedef struct {
+    SlotState state;
+    uint64_t first_line;
+    const char *data;
+    size_t len;
+    char *owned;
+    size_t owned_cap;
+    char *out;
+    size_t out_len;
+    size_t out_cap;
+    uint64_t positions;
+    uint64_t nodes;
+    uint64_t dropped;
+} Batch;
+
+typedef struct {
+    const Options *opts;
+    Batch *slots;
+    size_t window;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint64_t produced;
+    uint64_t claimed;
+    uint64_t written;
+    bool input_done;
+    bool write_failed;
+    FILE *out;
+    const uint8_t *map;
+    size_t map_size;
+    uint64_t positions;
+    uint64_t nodes;
+    uint64_t dropped;
+} Pipeline;
+
+typedef struct {
+    Pipeline *pipeline;
+    CfEngine *engine;
+} Worker;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool reserve(char **buf, size_t *cap, size_t need) {
+    char *grown;
+    size_t new_cap;
+
+    if (need <= *cap) {
+        return true;
+    }
+    new_cap = *cap ? *cap : 4096;
+    while (new_cap < need) {
+        new_cap *= 2;
+    }
+    grown = realloc(*buf, new_cap);
+    if (grown == NULL) {
+        return false;
+    }
+    *buf = grown;
+    *cap = new_cap;
+    return true;
+}
+
+/* --------------------- Analysis --------------------- */
+static void format_score(int score, char *buf, size_t cap) {
+    int mate = cf_ai_score_to_mate(score);
+
+    if (mate > 0) {
+        snprintf(buf, cap, "win %d", mate);
+    } else if (mate < 0) {
+        snprintf(buf, cap, "loss %d", -mate);
+    } else {
+        snprintf(buf, cap, "%d", score);
+    }
+}
+
+static void analyse_line(
+    const Options *opts,
+    CfEngine *engine,
+    Batch *batch,
+    uint64_t line_no,
+    const char *line,
+    size_t len
+) {
+    const char *moves = line;
+    size_t moves_len = 0;
+    const char *blocked = NULL;
+    size_t blocked_len = 0;
+    bool blocked_cols[CF_COLS] = {false};
+    bool ok = true;
+    CfGame game;
+    CfSearchInfo info;
+    char score[32];
+    size_t bad_index;
+    int written;
+
+    while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ' || line[len - 1] == '\t')) {
+        len -= 1;
+    }
+    while (len > 0 && (*moves == ' ' || *moves == '\t')) {
+        moves += 1;
+        len -= 1;
+    }
+    if (len == 0 || *moves == '#') {
+        return;
+    }
+
+    while (moves_len < len && moves[moves_len] != ' ' && moves[moves_len] != '\t') {
+        moves_len += 1;
+    }
+    blocked = moves + moves_len;
+    while (blocked < moves + len && (*blocked == ' ' || *blocked == '\t')) {
+        blocked += 1;
+    }
+    blocked_len = (size_t)(moves + len - blocked);
+
+    for (size_t i = 0; i < blocked_len; ++i) {
+        int col = blocked[i] - '1';
+        if (col < 0 || col >= CF_COLS) {
+            ok = false;
+            break;
+        }
+        blocked_cols[col] = true;
+    }
+    if (moves_len == 1 && moves[0] == '-') {
+        moves_len = 0;
+    }
+
+    /* No room even for an error line: count it so the run cannot pass as complete. */
+    if (!reserve(&batch->out, &batch->out_cap, batch->out_len + MAX_LINE_OUTPUT + moves_len)) {
+        batch->dropped += 1;
+        return;
+    }
+
+    ok = ok && cf_load_moves(&game, moves, moves_len, CF_AI, &bad_index);
+    ok = ok && (opts->shared_tt || cf_engine_clear(engine));
+    if (!ok) {
+        written = snprintf(
+            batch->out + batch->out_len,
+            batch->out_cap - batch->out_len,
+            "%llu\t%.*s\terror\n",
+            (unsigned long long)line_no,
+            (int)moves_len,
+            moves
+        );
+        batch->out_len += (size_t)written;
+        return;
+    }
+
+    if (opts->mode == MODE_GAME) {
+        cf_engine_choose_move(engine, &game, opts->depth, blocked_cols, 0, &info);
+    } else {
+        CfSearchLimits limits;
+        limits.depth = opts->depth;
+        limits.time_limit_ms = opts->movetime_ms;
+        limits.node_limit = opts->node_limit;
+        cf_engine_search(engine, &game, blocked_cols, &limits, NULL, NULL, &info);
+    }
+
+    format_score(info.score, score, sizeof(score));
+    written = snprintf(
+        batch->out + batch->out_len,
+        batch->out_cap - batch->out_len,
+        "%llu\t%.*s\t%d\t%s\t%d\t%llu\t%.0f\n",
+        (unsigned long long)line_no,
+        (int)moves_len,
+        moves,
+        info.best_col >= 0 ? info.best_col + 1 : 0,
+        score,
+        info.depth,
+        (unsigned long long)info.nodes,
+        info.elapsed_ms * 1000.0
+    );
+    batch->out_len += (size_t)written;
+    batch->positions += 1;
+    batch->nodes += info.nodes;
+}
+
+static void analyse_batch(const Options *opts, CfEngine *engine, Batch *batch) {
+    const char *cursor = batch->data;
+    const char *end = batch->data + batch->len;
+    uint64_t line_no = batch->first_line;
+
+    batch->out_len = 0;
+    batch->positions = 0;
+    batch->nodes = 0;
+    batch->dropped = 0;
+
+    while (cursor < end) {
+        const char *nl = memchr(cursor, '\n', (size_t)(end - cursor));
+        const char *line_end = nl ? nl : end;
+
+        analyse_line(opts, engine, batch, line_no, cursor, (size_t)(line_end - cursor));
+        line_no += 1;
+        cursor = nl ? nl + 1 : end;
+    }
+}
+
+/* --------------------- Pipeline threads --------------------- */
+static void *worker_main(void *arg) {
+    Worker *worker = arg;
+    Pipeline *p = worker->pipeline;
+
+    pthread_mutex_lock(&p->lock);
+    while (true) {
+        Batch *batch;
+
+        while (p->claimed == p->produced && !p->input_done) {
+            pthread_cond_wait(&p->changed, &p->lock);
+        }
+        if (p->claimed == p->produced) {
+            break;
+        }
+
+        batch = &p->slots[p->claimed % p->window];
+        batch->state = SLOT_BUSY;
+        p->claimed += 1;
+        pthread_mutex_unlock(&p->lock);
+
+        analyse_batch(p->opts, worker->engine, batch);
+
+        pthread_mutex_lock(&p->lock);
+        batch->state = SLOT_DONE;
+        pthread_cond_broadcast(&p->changed);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+static void *writer_main(void *arg) {
+    Pipeline *p = arg;
+    long page = sysconf(_SC_PAGESIZE);
+
+    pthread_mutex_lock(&p->lock);
+    while (true) {
+        Batch *batch = &p->slots[p->written % p->window];
+
+        while (!(p->written < p->produced && batch->state == SLOT_DONE) &&
+               !(p->input_done && p->written == p->produced)) {
+            pthread_cond_wait(&p->changed, &p->lock);
+        }
+        if (p->written == p->produced) {
+            break;
+        }
+        pthread_mutex_unlock(&p->lock);
+
+        if (batch->out_len > 0 && fwrite(batch->out, 1, batch->out_len, p->out) != batch->out_len) {
+            p->write_failed = true;
+        }
+
+        /* Drop consumed input pages so a huge mapped file never pins memory. */
+        if (p->map != NULL && page > 0) {
+            size_t consumed = (size_t)((const uint8_t *)batch->data + batch->len - p->map);
+            size_t aligned = consumed - consumed % (size_t)page;
+            if (aligned > 0) {
+                madvise((void *)p->map, aligned, MADV_DONTNEED);
+            }
+        }
+
+        pthread_mutex_lock(&p->lock);
+        p->positions += batch->positions;
+        p->nodes += batch->nodes;
+        p->dropped += batch->dropped;
+        batch->state = SLOT_FREE;
+        p->written += 1;
+        pthread_cond_broadcast(&p->changed);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+static Batch *acquire_slot(Pipeline *p) {
+    Batch *batch;
+
+    pthread_mutex_lock(&p->lock);
+    while (p->produced - p->written >= p->window) {
+        pthread_cond_wait(&p->changed, &p->lock);
+    }
+    batch = &p->slots[p->produced % p->window];
+    pthread_mutex_unlock(&p->lock);
+    return batch;
+}
+
+static void publish_slot(Pipeline *p, Batch *batch) {
+    pthread_mutex_lock(&p->lock);
+    batch->state = SLOT_READY;
+    p->produced += 1;
+    pthread_cond_broadcast(&p->changed);
+    pthread_mutex_unlock(&p->lock);
+}
+
+static uint64_t count_lines(const char *data, size_t len) {
+    uint64_t lines = 0;
+    const char *cursor = data;
+    const char *end = data + len;
+
+    while (cursor < end) {
+        const char *nl = memchr(cursor, '\n', (size_t)(end - cursor));
+        if (nl == NULL) {
+            break;
+        }
+        lines += 1;
+        cursor = nl + 1;
+    }
+    return lines;
+}
+
+static void feed_mapped(Pipeline *p) {
+    const char *data = (const char *)p->map;
+    size_t size = p->map_size;
+    size_t offset = 0;
+    uint64_t line = 1;
+
+    while (offset < size) {
+        Batch *batch = acquire_slot(p);
+        size_t end = offset + BATCH_BYTES;
+
+        if (end >= size) {
+            end = size;
+        } else {
+            const char *nl = memchr(data + end, '\n', size - end);
+            end = nl ? (size_t)(nl - data) + 1 : size;
+        }
+
+        batch->first_line = line;
+        batch->data = data + offset;
+        batch->len = end - offset;
+        line += count_lines(batch->data, batch->len);
+        offset = end;
+        publish_slot(p, batch);
+    }
+}
+
+static bool feed_stream(Pipeline *p, int fd) {
+    char *pending = NULL;
+    size_t pending_len = 0;
+    size_t pending_cap = 0;
+    uint64_t line = 1;
+    bool eof = false;
+    bool ok = true;
+
+    while (ok && (!eof || pending_len > 0)) {
+        const char *last_nl = NULL;
+        Batch *batch;
+        size_t take;
+
+        while (!eof && pending_len < BATCH_BYTES) {
+            ssize_t got;
+
+            if (!reserve(&pending, &pending_cap, pending_len + BATCH_BYTES)) {
+                ok = false;
+                break;
+            }
+            got = read(fd, pending + pending_len, BATCH_BYTES);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                eof = true;
+                ok = got == 0;
+                break;
+            }
+            pending_len += (size_t)got;
+        }
+
+        for (size_t i = pending_len; i > 0; --i) {
+            if (pending[i - 1] == '\n') {
+                last_nl = pending + i - 1;
+                break;
+            }
+        }
+        if (last_nl == NULL && !eof) {
+            /* A single line longer than a batch: keep reading. */
+            if (!reserve(&pending, &pending_cap, pending_len + BATCH_BYTES)) {
+                ok = false;
+            }
+            continue;
+        }
+        take = last_nl ? (size_t)(last_nl - pending) + 1 : pending_len;
+        if (take == 0) {
+            break;
+        }
+
+        batch = acquire_slot(p);
+        if (!reserve(&batch->owned, &batch->owned_cap, take)) {
+            ok = false;
+            break;
+        }
+        memcpy(batch->owned, pending, take);
+        memmove(pending, pending + take, pending_len - take);
+        pending_len -= take;
+
+        batch->first_line = line;
+        batch->data = batch->owned;
+        batch->len = take;
+        line += count_lines(batch->data, batch->len);
+        publish_slot(p, batch);
+    }
+
+    free(pending);
+    return ok;
+}
+
+/* --------------------- Main --------------------- */
+static void print_usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [options] [positions.txt|-]\n", argv0);
+    fprintf(stderr, "  -m game|search  game: same choice as the UI AI (default); search: iterative deepening\n");
+    fprintf(stderr, "  -d depth        search depth (default 8)\n");
+    fprintf(stderr, "  -T ms           per-position time limit (search mode)\n");
+    fprintf(stderr, "  -n nodes        per-position node limit (search mode)\n");
+    fprintf(stderr, "  -t threads      worker threads (default: online CPUs)\n");
+    fprintf(stderr, "  -s              share one transposition table across the run (nodes depend on input order)\n");
+    fprintf(stderr, "  -o file         write results to file instead of stdout\n");
+}
+
+static bool parse_options(int argc, char **argv, Options *opts) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    memset(opts, 0, sizeof(*opts));
+    opts->mode = MODE_GAME;
+    opts->depth = 8;
+    opts->threads = cpus > 0 ? (int)cpus : 1;
+    opts->in_path = "-";
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (arg[0] != '-' || strcmp(arg, "-") == 0) {
+            opts->in_path = arg;
+            continue;
+        }
+        if (strcmp(arg, "-s") == 0) {
+            opts->shared_tt = true;
+            continue;
+        }
+        if (value == NULL) {
+            return false;
+        }
+
+        if (strcmp(arg, "-m") == 0) {
+            if (strcmp(value, "game") == 0) {
+                opts->mode = MODE_GAME;
+            } else if (strcmp(value, "search") == 0) {
+                opts->mode = MODE_SEARCH;
+            } else {
+                return false;
+            }
+        } else if (strcmp(arg, "-d") == 0) {
+            opts->depth = atoi(value);
+        } else if (strcmp(arg, "-T") == 0) {
+            opts->movetime_ms = atof(value);
+        } else if (strcmp(arg, "-n") == 0) {
+            opts->node_limit = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "-t") == 0) {
+            opts->threads = atoi(value);
+        } else if (strcmp(arg, "-o") == 0) {
+            opts->out_path = value;
+        } else {
+            return false;
+        }
+        i += 1;
+    }
+
+    if (opts->threads < 1) {
+        opts->threads = 1;
+    }
+    if (opts->threads > MAX_THREADS) {
+        opts->threads = MAX_THREADS;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options opts;
+    Pipeline p;
+    Worker workers[MAX_THREADS];
+    pthread_t worker_ids[MAX_THREADS];
+    pthread_t writer;
+    CfEngineConfig config;
+    int fd = STDIN_FILENO;
+    int started_workers = 0;
+    bool ok = true;
+    double started;
+    double elapsed;
+
+    if (!parse_options(argc, argv, &opts)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    memset(&p, 0, sizeof(p));
+    p.opts = &opts;
+    p.window = (size_t)opts.threads * WINDOW_PER_THREAD;
+    p.slots = calloc(p.window, sizeof(Batch));
+    p.out = stdout;
+    if (p.slots == NULL) {
+        return 1;
+    }
+    if (opts.out_path != NULL) {
+        p.out = fopen(opts.out_path, "w");
+        if (p.out == NULL) {
+            fprintf(stderr, "batch: cannot open %s: %s\n", opts.out_path, strerror(errno));
+            return 1;
+        }
+    }
+    setvbuf(p.out, NULL, _IOFBF, 1 << 20);
+
+    if (strcmp(opts.in_path, "-") != 0) {
+        struct stat st;
+
+        fd = open(opts.in_path, O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "batch: cannot open %s: %s\n", opts.in_path, strerror(errno));
+            return 1;
+        }
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                p.map = map;
+                p.map_size = (size_t)st.st_size;
+                madvise(map, p.map_size, MADV_SEQUENTIAL);
+            }
+        }
+    }
+
+    /* The pipeline keeps its own workers; engines only hold the tables. A table cleared per position cannot be a shared file. */
+    cf_engine_config_init(&config);
+    config.tt_path = opts.shared_tt ? getenv("CF_TT_FILE") : NULL;
+    if (!opts.shared_tt) {
+        config.tt_slots = POSITION_TT_SLOTS;
+    }
+    config.tablebase_path = getenv("CF_TABLEBASE");
+    for (int i = 0; i < opts.threads; ++i) {
+        workers[i].pipeline = &p;
+        workers[i].engine = (opts.shared_tt && i > 0) ? workers[0].engine : cf_engine_create(&config);
+        if (workers[i].engine == NULL) {
+            return 1;
+        }
+    }
+
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.changed, NULL);
+    started = now_seconds();
+
+    if (pthread_create(&writer, NULL, writer_main, &p) != 0) {
+        return 1;
+    }
+    for (int i = 0; i < opts.threads; ++i) {
+        if (pthread_create(&worker_ids[i], NULL, worker_main, &workers[i]) != 0) {
+            break;
+        }
+        started_workers += 1;
+    }
+    if (started_workers == 0) {
+        fprintf(stderr, "batch: cannot start worker threads\n");
+        return 1;
+    }
+
+    if (p.map != NULL) {
+        feed_mapped(&p);
+    } else {
+        ok = feed_stream(&p, fd);
+    }
+
+    pthread_mutex_lock(&p.lock);
+    p.input_done = true;
+    pthread_cond_broadcast(&p.changed);
+    pthread_mutex_unlock(&p.lock);
+
+    for (int i = 0; i < started_workers; ++i) {
+        pthread_join(worker_ids[i], NULL);
+    }
+    pthread_join(writer, NULL);
+    elapsed = now_seconds() - started;
+
+    if (fflush(p.out) != 0 || p.write_failed) {
+        ok = false;
+    }
+    if (p.dropped > 0) {
+        fprintf(stderr, "batch: out of memory, %llu line(s) missing from the output\n", (unsigned long long)p.dropped);
+        ok = false;
+    }
+    if (p.out != stdout) {
+        fclose(p.out);
+    }
+
+    fprintf(
+        stderr,
+        "batch: %llu positions, %llu nodes in %.2fs (%.0f positions/s, %.0f nps, %d threads)\n",
+        (unsigned long long)p.positions,
+        (unsigned long long)p.nodes,
+        elapsed,
+        elapsed > 0 ? (double)p.positions / elapsed : 0,
+        elapsed > 0 ? (double)p.nodes / elapsed : 0,
+        started_workers
+    );
+
+    if (p.map != NULL) {
+        munmap((void *)p.map, p.map_size);
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    for (size_t i = 0; i < p.window; ++i) {
+        free(p.slots[i].owned);
+        free(p.slots[i].out);
+    }
+    free(p.slots);
+    for (int i = 0; i < (opts.shared_tt ? 1 : opts.threads); ++i) {
+        cf_engine_destroy(workers[i].engine);
+    }
+    pthread_mutex_destroy(&p.lock);
+    pthread_cond_destroy(&p.changed);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,480 @@
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "connect_four.h"
+#include "connect_four_kernels.h"
+
+/*
+ * Board-core microbenchmarks.
+ *
+ * Every kernel runs over the same fixed, seeded position set, so numbers
+ * are comparable across builds on one machine. Each kernel is sampled
+ * several times; the report gives mean ns/op with a 95% confidence
+ * interval. With a baseline file the run fails when a kernel is slower
+ * than baseline by more than the threshold even at the low end of its
+ * interval, so noise alone does not trip it.
+ *
+ * The board kernels run through the table picked at startup (CF_KERNELS
+ * forces one). Before timing, every set this CPU supports is checked
+ * against the scalar one on the whole position set.
+ */
+
+enum {
+    POSITION_COUNT = 512,
+    WINDOWS_PER_POSITION = CF_ROWS * (CF_COLS - 3) + (CF_ROWS - 3) * CF_COLS + 2 * (CF_ROWS - 3) * (CF_COLS - 3),
+    DEFAULT_SAMPLES = 15,
+    MAX_SAMPLES = 64,
+    DEFAULT_SAMPLE_MS = 20,
+    BENCH_SEED = 0x5eed
+};
+
+typedef uint64_t (*KernelFn)(uint64_t *sink);
+
+typedef struct {
+    const char *name;
+    KernelFn run;
+} Kernel;
+
+typedef struct {
+    double mean;
+    double ci;
+    double min;
+} KernelResult;
+
+static CfGame g_positions[POSITION_COUNT];
+static CfCell g_windows[POSITION_COUNT * WINDOWS_PER_POSITION][4];
+static size_t g_window_count;
+
+/* t(0.975, df) for df = 1..30; larger samples use the normal value. */
+static const double kTCritical[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t next_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* --------------------- Position set --------------------- */
+static void add_window(CfCell a, CfCell b, CfCell c, CfCell d) {
+    CfCell *w = g_windows[g_window_count++];
+    w[0] = a;
+    w[1] = b;
+    w[2] = c;
+    w[3] = d;
+}
+
+static void collect_windows(const CfGame *g) {
+    for (int row = 0; row < CF_ROWS; ++row) {
+        for (int col = 0; col <= CF_COLS - 4; ++col) {
+            add_window(g->board[row][col], g->board[row][col + 1], g->board[row][col + 2], g->board[row][col + 3]);
+        }
+    }
+    for (int row = 0; row <= CF_ROWS - 4; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            add_window(g->board[row][col], g->board[row + 1][col], g->board[row + 2][col], g->board[row + 3][col]);
+        }
+    }
+    for (int row = 0; row <= CF_ROWS - 4; ++row) {
+        for (int col = 0; col <= CF_COLS - 4; ++col) {
+            add_window(
+                g->board[row][col],
+                g->board[row + 1][col + 1],
+                g->board[row + 2][col + 2],
+                g->board[row + 3][col + 3]
+            );
+        }
+    }
+    for (int row = 3; row < CF_ROWS; ++row) {
+        for (int col = 0; col <= CF_COLS - 4; ++col) {
+            add_window(
+                g->board[row][col],
+                g->board[row - 1][col + 1],
+                g->board[row - 2][col + 2],
+                g->board[row - 3][col + 3]
+            );
+        }
+    }
+}
+
+/* Random four-free positions spread evenly from empty to nearly full. */
+static void build_positions(void) {
+    uint32_t rng = BENCH_SEED;
+
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        CfGame *g = &g_positions[i];
+        int target = i % (CF_ROWS * CF_COLS - 2);
+        int attempts = 0;
+        CfCell piece = CF_HUMAN;
+
+        cf_init(g);
+        while (g->moves < target && attempts < 200) {
+            int col = (int)(next_random(&rng) % CF_COLS);
+
+            attempts += 1;
+            if (cf_drop_piece(g, col, piece) < 0) {
+                continue;
+            }
+            if (cf_has_winner(g, piece)) {
+                cf_undo_piece(g, col);
+                continue;
+            }
+            piece = (piece == CF_HUMAN) ? CF_AI : CF_HUMAN;
+        }
+        collect_windows(g);
+    }
+}
+
+/* --------------------- Kernels --------------------- */
+static uint64_t kernel_drop_undo(uint64_t *sink) {
+    uint64_t ops = 0;
+
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        CfGame *g = &g_positions[i];
+        for (int col = 0; col < CF_COLS; ++col) {
+            int row = cf_drop_piece(g, col, CF_AI);
+            if (row >= 0) {
+                *sink += (uint64_t)row;
+                cf_undo_piece(g, col);
+                ops += 1;
+            }
+        }
+    }
+    return ops;
+}
+
+static uint64_t kernel_has_winner(uint64_t *sink) {
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        *sink += cf_has_winner(&g_positions[i], CF_AI);
+        *sink += cf_has_winner(&g_positions[i], CF_HUMAN);
+    }
+    return POSITION_COUNT * 2;
+}
+
+static uint64_t kernel_valid_moves(uint64_t *sink) {
+    int cols[CF_COLS];
+
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        *sink += (uint64_t)cf_valid_moves(&g_positions[i], cols);
+        *sink += (uint64_t)cols[0];
+    }
+    return POSITION_COUNT;
+}
+
+static uint64_t kernel_score_position(uint64_t *sink) {
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        *sink += (uint64_t)cf_kernels()->score_position(&g_positions[i]);
+    }
+    return POSITION_COUNT;
+}
+
+static uint64_t kernel_evaluate_window(uint64_t *sink) {
+    for (size_t i = 0; i < g_window_count; ++i) {
+        *sink += (uint64_t)cf_evaluate_window(g_windows[i]);
+    }
+    return g_window_count;
+}
+
+static uint64_t kernel_eval_children(uint64_t *sink) {
+    const CfKernels *kernels = cf_kernels();
+    CfChildEval out[CF_COLS];
+    int cols[CF_COLS];
+    uint64_t ops = 0;
+
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        int count = cf_valid_moves(&g_positions[i], cols);
+
+        kernels->eval_children(&g_positions[i], cols, count, CF_AI, out);
+        for (int c = 0; c < count; ++c) {
+            *sink += (uint64_t)out[c].score + out[c].ai_wins;
+        }
+        ops += (uint64_t)count;
+    }
+    return ops;
+}
+
+static uint64_t kernel_winning_drops(uint64_t *sink) {
+    const CfKernels *kernels = cf_kernels();
+    int cols[CF_COLS];
+
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        int count = cf_valid_moves(&g_positions[i], cols);
+
+        *sink += kernels->winning_drops(&g_positions[i], cols, count, CF_AI);
+        *sink += kernels->winning_drops(&g_positions[i], cols, count, CF_HUMAN);
+    }
+    return POSITION_COUNT * 2;
+}
+
+static const Kernel kKernels[] = {
+    {"drop_undo", kernel_drop_undo},
+    {"has_winner", kernel_has_winner},
+    {"valid_moves", kernel_valid_moves},
+    {"score_position", kernel_score_position},
+    {"evaluate_window", kernel_evaluate_window},
+    {"eval_children", kernel_eval_children},
+    {"winning_drops", kernel_winning_drops}
+};
+
+enum {
+    KERNEL_COUNT = (int)(sizeof(kKernels) / sizeof(kKernels[0]))
+};
+
+/* --------------------- Kernel sets --------------------- */
+static bool same_children(const CfKernels *kernels, const CfGame *g, CfCell piece) {
+    const CfKernels *scalar = cf_kernels_for(CF_KERNELS_SCALAR);
+    CfChildEval want[CF_COLS];
+    CfChildEval got[CF_COLS];
+    int cols[CF_COLS];
+    int count = cf_valid_moves(g, cols);
+
+    scalar->eval_children(g, cols, count, piece, want);
+    kernels->eval_children(g, cols, count, piece, got);
+    for (int c = 0; c < count; ++c) {
+        if (got[c].ai_wins != want[c].ai_wins || got[c].human_wins != want[c].human_wins || got[c].score != want[c].score) {
+            return false;
+        }
+    }
+    return kernels->winning_drops(g, cols, count, piece) == scalar->winning_drops(g, cols, count, piece);
+}
+
+/* Every available set must agree with the scalar reference on every position, or the timings mean nothing. */
+static bool check_kernel_sets(void) {
+    const CfKernels *scalar = cf_kernels_for(CF_KERNELS_SCALAR);
+    bool ok = true;
+
+    printf("kernel set: %s (available:", cf_kernel_set_name(cf_kernels()->set));
+    for (int set = 0; set < CF_KERNEL_SETS; ++set) {
+        if (cf_kernel_set_available((CfKernelSet)set)) {
+            printf(" %s", cf_kernel_set_name((CfKernelSet)set));
+        }
+    }
+    printf(")\n");
+
+    for (int set = 0; set < CF_KERNEL_SETS; ++set) {
+        const CfKernels *kernels = cf_kernels_for((CfKernelSet)set);
+
+        if (kernels == NULL || kernels == scalar) {
+            continue;
+        }
+        for (int i = 0; i < POSITION_COUNT; ++i) {
+            const CfGame *g = &g_positions[i];
+
+            if (kernels->has_winner(g, CF_AI) != scalar->has_winner(g, CF_AI) ||
+                kernels->has_winner(g, CF_HUMAN) != scalar->has_winner(g, CF_HUMAN) ||
+                kernels->score_position(g) != scalar->score_position(g) ||
+                !same_children(kernels, g, CF_AI) ||
+                !same_children(kernels, g, CF_HUMAN)) {
+                fprintf(stderr, "bench: kernel set %s disagrees with scalar on position %d\n", cf_kernel_set_name(kernels->set), i);
+                ok = false;
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+/* --------------------- Measurement --------------------- */
+static volatile uint64_t g_sink;
+
+static KernelResult measure(const Kernel *kernel, int samples, double sample_ms) {
+    double values[MAX_SAMPLES];
+    uint64_t sink = 0;
+    long passes = 1;
+    double sum = 0;
+    double var = 0;
+    KernelResult result;
+
+    /* Warm up and size a sample to roughly sample_ms. */
+    while (true) {
+        double started = now_ns();
+        for (long p = 0; p < passes; ++p) {
+            kernel->run(&sink);
+        }
+        if (now_ns() - started >= sample_ms * 1e6 / 4 || passes >= (1L << 30)) {
+            passes *= 4;
+            break;
+        }
+        passes *= 2;
+    }
+
+    for (int s = 0; s < samples; ++s) {
+        uint64_t ops = 0;
+        double started = now_ns();
+
+        for (long p = 0; p < passes; ++p) {
+            ops += kernel->run(&sink);
+        }
+        values[s] = (now_ns() - started) / (double)ops;
+    }
+    g_sink += sink;
+
+    result.min = values[0];
+    for (int s = 0; s < samples; ++s) {
+        sum += values[s];
+        if (values[s] < result.min) {
+            result.min = values[s];
+        }
+    }
+    result.mean = sum / samples;
+    for (int s = 0; s < samples; ++s) {
+        var += (values[s] - result.mean) * (values[s] - result.mean);
+    }
+    var /= (samples > 1) ? samples - 1 : 1;
+    result.ci = (samples > 1)
+        ? ((samples - 1 <= 30) ? kTCritical[samples - 2] : 1.96) * sqrt(var / samples)
+        : 0;
+    return result;
+}
+
+/* --------------------- Baseline --------------------- */
+static bool load_baseline(const char *path, double out[KERNEL_COUNT]) {
+    char name[64];
+    double value;
+    bool any = false;
+    FILE *fp;
+
+    for (int k = 0; k < KERNEL_COUNT; ++k) {
+        out[k] = 0;
+    }
+    if (path == NULL || (fp = fopen(path, "r")) == NULL) {
+        return false;
+    }
+
+    while (true) {
+        int got = fscanf(fp, "%63s %lf", name, &value);
+        if (got == EOF) {
+            break;
+        }
+        if (got != 2 || name[0] == '#') {
+            int c;
+            while ((c = fgetc(fp)) != EOF && c != '\n') {
+            }
+            continue;
+        }
+        for (int k = 0; k < KERNEL_COUNT; ++k) {
+            if (strcmp(name, kKernels[k].name) == 0) {
+                out[k] = value;
+                any = true;
+            }
+        }
+    }
+    fclose(fp);
+    return any;
+}
+
+static bool save_baseline(const char *path, const KernelResult results[KERNEL_COUNT]) {
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        fprintf(stderr, "bench: cannot write %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    fprintf(fp, "# kernel ns_per_op (connect-four-bench baseline)\n");
+    for (int k = 0; k < KERNEL_COUNT; ++k) {
+        fprintf(fp, "%s %.4f\n", kKernels[k].name, results[k].mean);
+    }
+    return fclose(fp) == 0;
+}
+
+/* --------------------- Main --------------------- */
+int main(int argc, char **argv) {
+    const char *baseline_path = NULL;
+    bool write_baseline = false;
+    double threshold_pct = 10.0;
+    double sample_ms = DEFAULT_SAMPLE_MS;
+    int samples = DEFAULT_SAMPLES;
+    double baseline[KERNEL_COUNT];
+    KernelResult results[KERNEL_COUNT];
+    bool have_baseline;
+    int regressions = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "-w") == 0) {
+            write_baseline = true;
+            continue;
+        }
+        if (value == NULL) {
+            fprintf(stderr, "Usage: %s [-b baseline] [-w] [-r percent] [-n samples] [-q sample_ms]\n", argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "-b") == 0) {
+            baseline_path = value;
+        } else if (strcmp(argv[i], "-r") == 0) {
+            threshold_pct = atof(value);
+        } else if (strcmp(argv[i], "-n") == 0) {
+            samples = atoi(value);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            sample_ms = atof(value);
+        } else {
+            fprintf(stderr, "Usage: %s [-b baseline] [-w] [-r percent] [-n samples] [-q sample_ms]\n", argv[0]);
+            return 2;
+        }
+        i += 1;
+    }
+    if (samples < 2) {
+        samples = 2;
+    }
+    if (samples > MAX_SAMPLES) {
+        samples = MAX_SAMPLES;
+    }
+
+    build_positions();
+    if (!check_kernel_sets()) {
+        return 1;
+    }
+    have_baseline = !write_baseline && load_baseline(baseline_path, baseline);
+
+    printf("%-16s %10s %9s %10s", "kernel", "ns/op", "+-95%", "min");
+    if (have_baseline) {
+        printf(" %10s %8s", "baseline", "delta");
+    }
+    printf("\n");
+
+    for (int k = 0; k < KERNEL_COUNT; ++k) {
+        results[k] = measure(&kKernels[k], samples, sample_ms);
+        printf("%-16s %10.3f %9.3f %10.3f", kKernels[k].name, results[k].mean, results[k].ci, results[k].min);
+
+        if (have_baseline && baseline[k] > 0) {
+            double delta = (results[k].mean / baseline[k] - 1.0) * 100.0;
+            bool regressed = results[k].mean - results[k].ci > baseline[k] * (1.0 + threshold_pct / 100.0);
+
+            printf(" %10.3f %+7.1f%%%s", baseline[k], delta, regressed ? "  REGRESSION" : "");
+            regressions += regressed ? 1 : 0;
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    if (baseline_path != NULL && !have_baseline) {
+        if (!save_baseline(baseline_path, results)) {
+            return 1;
+        }
+        printf("baseline written to %s\n", baseline_path);
+    }
+    if (regressions > 0) {
+        printf("%d kernel(s) regressed by more than %.1f%%\n", regressions, threshold_pct);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,268 @@
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "connect_four.h"
+#include "connect_four_ai.h"
+#include "connect_four_engine.h"
+
+/*
+ * Headless engine: one command per line on stdin, replies on stdout.
+ *
+ *   position <moves>    moves as 1-based column digits, first player first;
+ *                       "startpos" or "-" for the empty board
+ *   blocked <cols>      locked columns as digits, "-" to clear
+ *   go [depth N] [movetime MS] [nodes N]
+ *                       search for the side to move; streams
+ *                       "info depth D score S nodes N nps X time MS pv ..."
+ *                       lines and ends with "bestmove C"
+ *   newgame             forget cached search results (private table only)
+ *   isready             replies "readyok" once earlier commands are done
+ *   d                   prints the current board
+ *   quit
+ *
+ * Commands are handled strictly in order, so a client may pipeline any
+ * number of them without waiting for replies. Scores are from the side to
+ * move; forced results print as "score win N" / "score loss N" (plies).
+ * The side to move is always searched as CF_AI, so the evaluator's weights
+ * apply to whoever is on move.
+ */
+
+enum {
+    LINE_CHARS = 4096,
+    DEFAULT_DEPTH = 8
+};
+
+typedef struct {
+    CfGame game;
+    bool blocked_cols[CF_COLS];
+    CfEngine *engine;
+} Engine;
+
+static void reply(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    putchar('\n');
+}
+
+static char *next_token(char **cursor) {
+    char *start = *cursor;
+    char *end;
+
+    while (*start != '\0' && isspace((unsigned char)*start)) {
+        start += 1;
+    }
+    if (*start == '\0') {
+        *cursor = start;
+        return NULL;
+    }
+
+    end = start;
+    while (*end != '\0' && !isspace((unsigned char)*end)) {
+        end += 1;
+    }
+    if (*end != '\0') {
+        *end = '\0';
+        end += 1;
+    }
+    *cursor = end;
+    return start;
+}
+
+/* The side to move always plays as CF_AI. A rejected position leaves the previous one in place. */
+static bool load_position(Engine *e, const char *moves, char *err, size_t err_cap) {
+    CfGame game;
+    size_t bad_index;
+
+    if (!cf_load_moves(&game, moves, strlen(moves), CF_AI, &bad_index)) {
+        snprintf(err, err_cap, "illegal move '%c' at move %zu", moves[bad_index], bad_index + 1);
+        return false;
+    }
+    e->game = game;
+    return true;
+}
+
+static bool load_blocked(Engine *e, const char *cols, char *err, size_t err_cap) {
+    bool blocked[CF_COLS] = {false};
+
+    if (strcmp(cols, "-") != 0) {
+        for (const char *p = cols; *p != '\0'; ++p) {
+            if (*p < '1' || *p > '0' + CF_COLS) {
+                snprintf(err, err_cap, "bad column '%c'", *p);
+                return false;
+            }
+            blocked[*p - '1'] = true;
+        }
+    }
+
+    memcpy(e->blocked_cols, blocked, sizeof(blocked));
+    return true;
+}
+
+static void format_score(int score, char *buf, size_t cap) {
+    int mate = cf_ai_score_to_mate(score);
+
+    if (mate > 0) {
+        snprintf(buf, cap, "win %d", mate);
+    } else if (mate < 0) {
+        snprintf(buf, cap, "loss %d", -mate);
+    } else {
+        snprintf(buf, cap, "%d", score);
+    }
+}
+
+static void print_info(const CfSearchInfo *info, void *user) {
+    char score[32];
+    char pv[CF_ROWS * CF_COLS * 2 + 1];
+    size_t len = 0;
+    double nps = info->elapsed_ms > 0 ? (double)info->nodes * 1000.0 / info->elapsed_ms : 0;
+
+    (void)user;
+    format_score(info->score, score, sizeof(score));
+    for (int i = 0; i < info->pv_length && len + 2 < sizeof(pv); ++i) {
+        if (i > 0) {
+            pv[len++] = ' ';
+        }
+        pv[len++] = (char)('1' + info->pv[i]);
+    }
+    pv[len] = '\0';
+
+    reply(
+        "info depth %d score %s nodes %llu nps %.0f time %.0f pv %s",
+        info->depth,
+        score,
+        (unsigned long long)info->nodes,
+        nps,
+        info->elapsed_ms,
+        pv
+    );
+    /* Progress is only useful while the search runs, so info lines do not wait for bestmove. */
+    fflush(stdout);
+}
+
+static void cmd_go(Engine *e, char *args) {
+    CfSearchLimits limits = {0, 0, 0};
+    CfSearchInfo info;
+    char *token;
+    int best;
+
+    while ((token = next_token(&args)) != NULL) {
+        char *value = next_token(&args);
+
+        if (value == NULL) {
+            reply("error missing value for %s", token);
+            return;
+        }
+        if (strcmp(token, "depth") == 0) {
+            limits.depth = atoi(value);
+        } else if (strcmp(token, "movetime") == 0) {
+            limits.time_limit_ms = atof(value);
+        } else if (strcmp(token, "nodes") == 0) {
+            limits.node_limit = strtoull(value, NULL, 10);
+        } else {
+            reply("error unknown go option %s", token);
+            return;
+        }
+    }
+
+    if (limits.depth <= 0 && limits.time_limit_ms <= 0 && limits.node_limit == 0) {
+        limits.depth = DEFAULT_DEPTH;
+    }
+
+    best = cf_engine_search(e->engine, &e->game, e->blocked_cols, &limits, print_info, NULL, &info);
+    if (best < 0) {
+        reply("bestmove none");
+    } else {
+        reply("bestmove %d", best + 1);
+    }
+}
+
+static void cmd_print(const Engine *e) {
+    for (int row = 0; row < CF_ROWS; ++row) {
+        char line[CF_COLS * 2 + 1];
+        for (int col = 0; col < CF_COLS; ++col) {
+            CfCell cell = e->game.board[row][col];
+            line[col * 2] = cell == CF_AI ? 'X' : (cell == CF_HUMAN ? 'O' : '.');
+            line[col * 2 + 1] = ' ';
+        }
+        line[CF_COLS * 2] = '\0';
+        reply("%s", line);
+    }
+    reply("moves %d, X to move", e->game.moves);
+}
+
+static bool handle_line(Engine *e, char *line) {
+    char err[128];
+    char *cursor = line;
+    char *cmd = next_token(&cursor);
+
+    if (cmd == NULL) {
+        return true;
+    }
+
+    if (strcmp(cmd, "quit") == 0) {
+        return false;
+    } else if (strcmp(cmd, "isready") == 0) {
+        reply("readyok");
+    } else if (strcmp(cmd, "position") == 0) {
+        char *moves = next_token(&cursor);
+        if (moves == NULL || strcmp(moves, "startpos") == 0 || strcmp(moves, "-") == 0) {
+            moves = "";
+        }
+        if (!load_position(e, moves, err, sizeof(err))) {
+            reply("error %s", err);
+        }
+    } else if (strcmp(cmd, "blocked") == 0) {
+        char *cols = next_token(&cursor);
+        if (!load_blocked(e, cols != NULL ? cols : "-", err, sizeof(err))) {
+            reply("error %s", err);
+        }
+    } else if (strcmp(cmd, "go") == 0) {
+        cmd_go(e, cursor);
+    } else if (strcmp(cmd, "newgame") == 0) {
+        cf_engine_clear(e->engine);
+    } else if (strcmp(cmd, "d") == 0) {
+        cmd_print(e);
+    } else {
+        reply("error unknown command %s", cmd);
+    }
+
+    return true;
+}
+
+int main(void) {
+    static char line[LINE_CHARS];
+    Engine e;
+    CfEngineConfig config;
+
+    memset(&e, 0, sizeof(e));
+    cf_init(&e.game);
+
+    cf_engine_config_init(&config);
+    config.tt_path = getenv("CF_TT_FILE");
+    config.tablebase_path = getenv("CF_TABLEBASE");
+    e.engine = cf_engine_create(&config);
+    if (e.engine == NULL) {
+        fprintf(stderr, "connect-four-engine: out of memory\n");
+        return 1;
+    }
+
+    /* Fully buffered and flushed once per input line and per info line, so a multi-line reply such as `d` goes out in one write. */
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        bool keep_going = handle_line(&e, line);
+        fflush(stdout);
+        if (!keep_going) {
+            break;
+        }
+    }
+
+    cf_engine_destroy(e.engine);
+    return 0;
+}
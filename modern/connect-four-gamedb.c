@@ -0,0 +1,198 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "connect_four.h"
+#include "connect_four_gamedb.h"
+
+/*
+ * Game record tool for files written with CF_GAMEDB=... connect-four-virus.
+ *
+ *   index games.cfg            build or update games.cfg.idx
+ *   query games.cfg [-a] 3434  how often the position after 3,4,3,4 came up
+ *                              and what the side to move did next
+ *   dump games.cfg             one line per recorded round
+ *
+ * Moves are 1-based columns. The player moves first unless -a says the AI
+ * opened (AutoStart).
+ */
+
+enum {
+    PATH_CHARS = 512
+};
+
+static const char *const kOutcomeNames[CF_GAME_OUTCOMES] = {"win", "loss", "draw"};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void index_path_for(const char *games_path, char *out, size_t out_size) {
+    snprintf(out, out_size, "%s%s", games_path, CF_GAMEDB_INDEX_SUFFIX);
+}
+
+static int run_index(const char *games_path) {
+    char index_path[PATH_CHARS];
+    CfGameIndexStats stats;
+    double started = now_seconds();
+
+    index_path_for(games_path, index_path, sizeof(index_path));
+    if (!cf_gamedb_index_update(games_path, index_path, &stats)) {
+        fprintf(stderr, "gamedb: cannot index %s into %s\n", games_path, index_path);
+        return 1;
+    }
+    printf(
+        "%s: %llu games (%llu new), %llu entries, %.3f s\n",
+        index_path,
+        (unsigned long long)stats.games,
+        (unsigned long long)stats.new_games,
+        (unsigned long long)stats.entries,
+        now_seconds() - started
+    );
+    return 0;
+}
+
+static int run_query(const char *games_path, const char *moves, bool ai_first) {
+    char index_path[PATH_CHARS];
+    size_t len = strlen(moves);
+    CfCell first = ai_first ? CF_AI : CF_HUMAN;
+    CfCell to_move = len % 2 == 0 ? first : (first == CF_AI ? CF_HUMAN : CF_AI);
+    CfGameIndex *index;
+    CfPositionStats stats;
+    CfGame game;
+    size_t bad = 0;
+
+    if (!cf_load_moves(&game, moves, len, to_move, &bad)) {
+        fprintf(stderr, "gamedb: bad move %zu in \"%s\"\n", bad + 1, moves);
+        return 2;
+    }
+    index_path_for(games_path, index_path, sizeof(index_path));
+    index = cf_gamedb_index_open(index_path);
+    if (index == NULL) {
+        fprintf(stderr, "gamedb: no index at %s (run: index %s)\n", index_path, games_path);
+        return 1;
+    }
+
+    cf_gamedb_index_lookup(index, &game, to_move, &stats);
+    printf(
+        "position \"%s\" (%s to move): seen %llu times in %llu games\n",
+        moves,
+        to_move == CF_HUMAN ? "player" : "AI",
+        (unsigned long long)stats.occurrences,
+        (unsigned long long)cf_gamedb_index_games(index)
+    );
+    for (int next = 0; next <= CF_COLS; ++next) {
+        uint64_t total = 0;
+
+        for (int o = 0; o < CF_GAME_OUTCOMES; ++o) {
+            total += stats.next[next][o];
+        }
+        if (total == 0) {
+            continue;
+        }
+        if (next < CF_COLS) {
+            printf("  column %d", next + 1);
+        } else {
+            printf("  round over");
+        }
+        printf(
+            "  %8llu  (%5.1f%%)  mover won %llu, lost %llu, drew %llu\n",
+            (unsigned long long)total,
+            100.0 * (double)total / (double)stats.occurrences,
+            (unsigned long long)stats.next[next][CF_GAME_WIN],
+            (unsigned long long)stats.next[next][CF_GAME_LOSS],
+            (unsigned long long)stats.next[next][CF_GAME_DRAW]
+        );
+    }
+    cf_gamedb_index_close(index);
+    return 0;
+}
+
+static int run_dump(const char *games_path) {
+    CfGameReader *reader = cf_gamedb_reader_open(games_path);
+    CfGameRecord rec;
+    uint64_t games = 0;
+
+    if (reader == NULL) {
+        fprintf(stderr, "gamedb: cannot read %s\n", games_path);
+        return 1;
+    }
+    while (cf_gamedb_reader_next(reader, &rec)) {
+        char moves[CF_GAMEDB_MAX_EVENTS * 2 + 1];
+        char blocked[CF_COLS + 1];
+        size_t len = 0;
+        double ai_ms = 0;
+        int ai_moves = 0;
+        int nblocked = 0;
+
+        for (int i = 0; i < rec.event_count; ++i) {
+            const CfGameEvent *ev = &rec.events[i];
+
+            /* Player drops as digits, AI drops as letters, corruption as x<col>. */
+            if (ev->kind == CF_EVENT_CORRUPT) {
+                moves[len++] = 'x';
+                moves[len++] = (char)('1' + ev->col);
+            } else if (ev->kind == CF_EVENT_AI) {
+                moves[len++] = (char)('a' + ev->col);
+                ai_ms += ev->ai_us / 1000.0;
+                ai_moves += 1;
+            } else {
+                moves[len++] = (char)('1' + ev->col);
+            }
+        }
+        moves[len] = '\0';
+        for (int col = 0; col < CF_COLS; ++col) {
+            if (rec.fx.blocked_cols[col]) {
+                blocked[nblocked++] = (char)('1' + col);
+            }
+        }
+        blocked[nblocked] = '\0';
+
+        printf(
+            "%lld %-4s %3d%% locked=%s openers=%d jitter=%d%% forced=%d%% ai=%d moves=%s ai_ms=%.1f\n",
+            (long long)rec.finished_at,
+            kOutcomeNames[rec.outcome],
+            rec.compromised_pct,
+            nblocked > 0 ? blocked : "-",
+            rec.fx.ai_opening_moves,
+            rec.fx.input_glitch_pct,
+            rec.fx.forced_move_pct,
+            ai_moves,
+            moves,
+            ai_moves > 0 ? ai_ms / ai_moves : 0
+        );
+        games += 1;
+    }
+    cf_gamedb_reader_close(reader);
+    fprintf(stderr, "%llu games\n", (unsigned long long)games);
+    return 0;
+}
+
+static void print_usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s index games.cfg\n", argv0);
+    fprintf(stderr, "       %s query games.cfg [-a] moves\n", argv0);
+    fprintf(stderr, "       %s dump games.cfg\n", argv0);
+    fprintf(stderr, "  -a  the AI made the first move (AutoStart opener)\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "index") == 0) {
+        return run_index(argv[2]);
+    }
+    if (argc == 3 && strcmp(argv[1], "dump") == 0) {
+        return run_dump(argv[2]);
+    }
+    if (argc == 4 && strcmp(argv[1], "query") == 0) {
+        return run_query(argv[2], argv[3], false);
+    }
+    if (argc == 5 && strcmp(argv[1], "query") == 0 && strcmp(argv[3], "-a") == 0) {
+        return run_query(argv[2], argv[4], true);
+    }
+    print_usage(argv[0]);
+    return 2;
+}
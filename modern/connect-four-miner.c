@@ -0,0 +1,279 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "connect_four_miner.h"
+
+/*
+ * CPU benchmark for the kernel behind the Bitcoin Miner mini-game.
+ *
+ * Every kernel first has to find the Bitcoin genesis block's nonce (a hash
+ * with 43 leading zero bits) in a window around it; a kernel that does not
+ * is reported and skipped. Then each selected kernel mines a made-up header
+ * on -t threads for -s seconds and the hash rate is printed. Offline only.
+ */
+
+enum {
+    MAX_THREADS = 256,
+    SELF_CHECK_WINDOW = 4096,
+    GENESIS_BITS = 43,
+    POLL_MS = 100
+};
+
+static const char kGenesisHex[] =
+    "0100000000000000000000000000000000000000000000000000000000000000"
+    "000000003ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa"
+    "4b1e5e4a29ab5f49ffff001d1dac2b7c";
+static const char kGenesisHashHex[] = "000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f";
+static const uint32_t kGenesisNonce = 2083236893u;
+
+typedef struct {
+    int threads;
+    double seconds;
+    int zero_bits;
+    bool all_kernels;
+    bool have_kernel;
+    CfShaKernel kernel;
+    const char *json_path;
+} Options;
+
+typedef struct {
+    bool checked;
+    bool passed;
+    CfMinerStats stats;
+} KernelRun;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+static void parse_hex(const char *hex, uint8_t *out, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        unsigned value = 0;
+        sscanf(hex + i * 2, "%2x", &value);
+        out[i] = (uint8_t)value;
+    }
+}
+
+/* The genesis hash as Bitcoin prints it, then every kernel on a window around its nonce. */
+static bool genesis_hash_ok(void) {
+    uint8_t header[CF_BLOCK_HEADER_BYTES];
+    uint8_t hash[CF_SHA256_BYTES];
+    uint8_t expected[CF_SHA256_BYTES];
+
+    parse_hex(kGenesisHex, header, sizeof(header));
+    parse_hex(kGenesisHashHex, expected, sizeof(expected));
+    cf_block_hash(header, hash);
+    for (int i = 0; i < CF_SHA256_BYTES; ++i) {
+        if (hash[i] != expected[CF_SHA256_BYTES - 1 - i]) {
+            return false;
+        }
+    }
+    return cf_block_hash_zero_bits(hash) == GENESIS_BITS;
+}
+
+static bool kernel_finds_genesis(CfShaKernel kernel) {
+    uint8_t header[CF_BLOCK_HEADER_BYTES];
+    CfMineResult result = {0};
+
+    parse_hex(kGenesisHex, header, sizeof(header));
+    /* Odd start and length so the vector kernels also run their scalar tail. */
+    cf_mine_scan(kernel, header, kGenesisNonce - SELF_CHECK_WINDOW / 2 - 3, SELF_CHECK_WINDOW + 5, 32, &result);
+    return result.hashes == SELF_CHECK_WINDOW + 5 && result.shares == 1 && result.best_bits == GENESIS_BITS &&
+           result.best_nonce == kGenesisNonce;
+}
+
+/* A made-up header: nothing in it refers to a real chain. */
+static void bench_header(uint8_t header[CF_BLOCK_HEADER_BYTES]) {
+    cf_sha256((const uint8_t *)"connect-four-miner", 18, header + 4);
+    cf_sha256((const uint8_t *)"offline benchmark", 17, header + 36);
+    memset(header, 0, 4);
+    header[0] = 2;
+    memset(header + 68, 0, 12);
+}
+
+static bool run_kernel(const Options *opts, CfShaKernel kernel, CfMinerStats *out) {
+    uint8_t header[CF_BLOCK_HEADER_BYTES];
+    CfMiner *miner;
+    double until;
+
+    bench_header(header);
+    miner = cf_miner_start(header, kernel, opts->threads, opts->zero_bits);
+    if (miner == NULL) {
+        return false;
+    }
+    until = now_seconds() + opts->seconds;
+    while (now_seconds() < until) {
+        sleep_ms(POLL_MS);
+    }
+    cf_miner_stats(miner, out);
+    cf_miner_stop(miner);
+    return true;
+}
+
+static void write_json(FILE *fp, const Options *opts, const KernelRun *runs) {
+    bool first = true;
+
+    fprintf(
+        fp,
+        "{\n  \"threads\": %d,\n  \"seconds\": %.3f,\n  \"zero_bits\": %d,\n  \"best_kernel\": \"%s\",\n  \"kernels\": [",
+        opts->threads,
+        opts->seconds,
+        opts->zero_bits,
+        cf_sha_kernel_name(cf_sha_best_kernel())
+    );
+    for (int k = 0; k < CF_SHA_KERNELS; ++k) {
+        const KernelRun *run = &runs[k];
+
+        if (!run->checked) {
+            continue;
+        }
+        fprintf(
+            fp,
+            "%s\n    {\"name\": \"%s\", \"self_check\": %s, \"hashes\": %llu, \"seconds\": %.3f, "
+            "\"mhash_per_second\": %.3f, \"shares\": %llu, \"best_bits\": %d}",
+            first ? "" : ",",
+            cf_sha_kernel_name((CfShaKernel)k),
+            run->passed ? "true" : "false",
+            (unsigned long long)run->stats.hashes,
+            run->stats.seconds,
+            run->stats.seconds > 0 ? (double)run->stats.hashes / run->stats.seconds / 1e6 : 0.0,
+            (unsigned long long)run->stats.shares,
+            run->stats.best_bits
+        );
+        first = false;
+    }
+    fprintf(fp, "\n  ]\n}\n");
+}
+
+static void print_usage(const char *argv0) {
+    fprintf(
+        stderr,
+        "Usage: %s [-t threads] [-s seconds] [-k auto|all|scalar|lanes|avx2|sha-ni] [-z zero_bits]\n"
+        "          [-j out.json|-]\n",
+        argv0
+    );
+}
+
+int main(int argc, char **argv) {
+    Options opts;
+    KernelRun runs[CF_SHA_KERNELS];
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    FILE *json = NULL;
+    int status = 0;
+
+    memset(&opts, 0, sizeof(opts));
+    memset(runs, 0, sizeof(runs));
+    opts.threads = cpus > 0 ? (int)cpus : 1;
+    opts.seconds = 3.0;
+    opts.zero_bits = 24;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (value == NULL) {
+            print_usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "-t") == 0) {
+            opts.threads = atoi(value);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            opts.seconds = atof(value);
+        } else if (strcmp(argv[i], "-z") == 0) {
+            opts.zero_bits = atoi(value);
+        } else if (strcmp(argv[i], "-k") == 0 && strcmp(value, "all") == 0) {
+            opts.all_kernels = true;
+        } else if (strcmp(argv[i], "-k") == 0 && strcmp(value, "auto") == 0) {
+            opts.have_kernel = false;
+        } else if (strcmp(argv[i], "-k") == 0 && cf_sha_kernel_parse(value, &opts.kernel)) {
+            opts.have_kernel = true;
+        } else if (strcmp(argv[i], "-j") == 0) {
+            opts.json_path = value;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+        i += 1;
+    }
+
+    opts.threads = opts.threads < 1 ? 1 : (opts.threads > MAX_THREADS ? MAX_THREADS : opts.threads);
+    opts.seconds = opts.seconds < 0.1 ? 0.1 : opts.seconds;
+    opts.zero_bits = opts.zero_bits < 0 ? 0 : (opts.zero_bits > 64 ? 64 : opts.zero_bits);
+    if (!opts.have_kernel) {
+        opts.kernel = cf_sha_best_kernel();
+    }
+    if (!cf_sha_kernel_available(opts.kernel)) {
+        fprintf(stderr, "miner: kernel %s is not supported on this CPU\n", cf_sha_kernel_name(opts.kernel));
+        return 1;
+    }
+    if (!genesis_hash_ok()) {
+        fprintf(stderr, "miner: SHA-256 self-check failed on the genesis header\n");
+        return 1;
+    }
+
+    if (opts.json_path != NULL) {
+        json = strcmp(opts.json_path, "-") == 0 ? stdout : fopen(opts.json_path, "w");
+        if (json == NULL) {
+            fprintf(stderr, "miner: cannot write %s: %s\n", opts.json_path, strerror(errno));
+            return 1;
+        }
+    }
+
+    if (json != stdout) {
+        printf(
+            "%d thread%s, %.1f s per kernel, shares at %d zero bits\n",
+            opts.threads,
+            opts.threads == 1 ? "" : "s",
+            opts.seconds,
+            opts.zero_bits
+        );
+    }
+    for (int k = 0; k < CF_SHA_KERNELS; ++k) {
+        KernelRun *run = &runs[k];
+
+        if (!cf_sha_kernel_available((CfShaKernel)k) || (!opts.all_kernels && k != (int)opts.kernel)) {
+            continue;
+        }
+        run->checked = true;
+        run->passed = kernel_finds_genesis((CfShaKernel)k);
+        if (!run->passed) {
+            fprintf(stderr, "miner: kernel %s missed the genesis nonce\n", cf_sha_kernel_name((CfShaKernel)k));
+            status = 1;
+            continue;
+        }
+        if (!run_kernel(&opts, (CfShaKernel)k, &run->stats)) {
+            fprintf(stderr, "miner: cannot start worker threads\n");
+            return 1;
+        }
+        if (json != stdout) {
+            printf(
+                "  %-7s %9.3f MH/s  %12llu hashes  %6llu shares  best %d bits\n",
+                cf_sha_kernel_name((CfShaKernel)k),
+                run->stats.seconds > 0 ? (double)run->stats.hashes / run->stats.seconds / 1e6 : 0.0,
+                (unsigned long long)run->stats.hashes,
+                (unsigned long long)run->stats.shares,
+                run->stats.best_bits
+            );
+        }
+    }
+
+    if (json != NULL) {
+        write_json(json, &opts, runs);
+        if (json != stdout) {
+            fclose(json);
+        }
+    }
+    return status;
+}
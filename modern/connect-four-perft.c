@@ -0,0 +1,404 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "connect_four.h"
+#include "connect_four_kernels.h"
+
+/*
+ * Perft for the board core: counts every legal move sequence of exactly
+ * `depth` plies from a position. A sequence that wins (or fills the board)
+ * earlier cannot be continued and contributes nothing, as in chess perft.
+ * Depth-1 nodes are bulk-counted from the valid-move list.
+ *
+ * The tree is split three plies below the root into independent tasks
+ * that worker threads claim from an atomic counter. With -u the tool
+ * instead counts unique positions per ply: a shared lock-free key set
+ * remembers every position reached, and a transposition is not expanded
+ * again (every path to a position has the same remaining depth).
+ *
+ * From the empty board the counts are checked against kStartposPerft, so
+ * a new board representation can be validated by running this tool.
+ */
+
+enum {
+    MAX_THREADS = 256,
+    MAX_DEPTH = CF_ROWS * CF_COLS,
+    MAX_TASKS = CF_COLS * CF_COLS * CF_COLS,
+    DEFAULT_DEPTH = 8,
+    DEFAULT_SET_BITS = 24
+};
+
+/* Sequences from the empty 6x6 board, indexed by depth. */
+static const uint64_t kStartposPerft[] = {
+    1ULL,
+    6ULL,
+    36ULL,
+    216ULL,
+    1296ULL,
+    7776ULL,
+    46656ULL,
+    279930ULL,
+    1648950ULL,
+    9813000ULL,
+    57111174ULL,
+    336407760ULL
+};
+
+typedef struct {
+    int moves[3];
+    int length;
+    int root_col;
+} Task;
+
+typedef struct {
+    CfGame root;
+    CfCell to_move;
+    int depth;
+    bool unique;
+    Task tasks[MAX_TASKS];
+    int task_count;
+    _Atomic int next_task;
+    _Atomic uint64_t root_counts[CF_COLS];
+    _Atomic uint64_t interior_nodes;
+    _Atomic uint64_t *set;
+    uint64_t set_mask;
+    _Atomic uint64_t set_used;
+    _Atomic bool set_full;
+    _Atomic uint64_t unique_per_ply[MAX_DEPTH + 1];
+} Perft;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static CfCell other(CfCell piece) {
+    return piece == CF_AI ? CF_HUMAN : CF_AI;
+}
+
+/* --------------------- Unique-position set --------------------- */
+static uint64_t mix_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= UINT64_C(0xff51afd7ed558ccd);
+    key ^= key >> 33;
+    return key;
+}
+
+/* Returns true when `key` was not in the set yet. Keys are never 0 (sentinel bits). */
+static bool set_insert(Perft *p, uint64_t key) {
+    uint64_t slot = mix_key(key) & p->set_mask;
+
+    if (atomic_load_explicit(&p->set_full, memory_order_relaxed)) {
+        return false;
+    }
+    while (true) {
+        uint64_t seen = atomic_load_explicit(&p->set[slot], memory_order_relaxed);
+
+        if (seen == key) {
+            return false;
+        }
+        if (seen == 0) {
+            uint64_t expected = 0;
+            if (atomic_compare_exchange_strong(&p->set[slot], &expected, key)) {
+                /* Keep probe chains short; past 3/4 full the counts stop being trustworthy. */
+                if (atomic_fetch_add_explicit(&p->set_used, 1, memory_order_relaxed) > p->set_mask / 4 * 3) {
+                    atomic_store(&p->set_full, true);
+                }
+                return true;
+            }
+            if (expected == key) {
+                return false;
+            }
+        }
+        slot = (slot + 1) & p->set_mask;
+    }
+}
+
+/* --------------------- Enumeration --------------------- */
+static uint64_t perft(Perft *p, CfGame *game, CfCell to_move, int depth, uint64_t *interior) {
+    int cols[CF_COLS];
+    int count = cf_valid_moves(game, cols);
+    uint64_t total = 0;
+    unsigned wins;
+
+    if (depth == 0) {
+        return 1;
+    }
+    if (depth == 1) {
+        return (uint64_t)count;
+    }
+
+    /* Winning drops end the line; one kernel call finds them for every child. */
+    wins = cf_kernels()->winning_drops(game, cols, count, to_move);
+    *interior += 1;
+    for (int i = 0; i < count; ++i) {
+        if (wins & (1u << i)) {
+            continue;
+        }
+        cf_drop_piece(game, cols[i], to_move);
+        total += perft(p, game, other(to_move), depth - 1, interior);
+        cf_undo_piece(game, cols[i]);
+    }
+    return total;
+}
+
+static void unique_walk(Perft *p, CfGame *game, CfCell to_move, int ply, uint64_t *interior);
+
+/* Children of a position that is already counted and is neither terminal nor at full depth. */
+static void unique_expand(Perft *p, CfGame *game, CfCell to_move, int ply, uint64_t *interior) {
+    int cols[CF_COLS];
+    int count = cf_valid_moves(game, cols);
+
+    *interior += 1;
+    for (int i = 0; i < count; ++i) {
+        cf_drop_piece(game, cols[i], to_move);
+        unique_walk(p, game, other(to_move), ply + 1, interior);
+        cf_undo_piece(game, cols[i]);
+    }
+}
+
+/* Counts the position once; returns true when it is new and should be expanded. */
+static bool unique_visit(Perft *p, const CfGame *game, CfCell to_move, int ply) {
+    if (!set_insert(p, cf_position_key(game, to_move))) {
+        return false;
+    }
+    atomic_fetch_add_explicit(&p->unique_per_ply[ply], 1, memory_order_relaxed);
+    return ply < p->depth && !cf_has_winner(game, other(to_move));
+}
+
+static void unique_walk(Perft *p, CfGame *game, CfCell to_move, int ply, uint64_t *interior) {
+    if (unique_visit(p, game, to_move, ply)) {
+        unique_expand(p, game, to_move, ply, interior);
+    }
+}
+
+/*
+ * Task prefixes: every non-terminal line of `split` plies (shorter where a
+ * prefix wins). In unique mode the positions along the prefixes are
+ * counted here and only new, expandable ones become tasks.
+ */
+static void build_tasks(Perft *p, CfGame *game, CfCell to_move, Task *prefix, int split) {
+    int cols[CF_COLS];
+    int count;
+
+    if (p->unique && !unique_visit(p, game, to_move, prefix->length)) {
+        return;
+    }
+    if (prefix->length == split || p->task_count == MAX_TASKS) {
+        p->tasks[p->task_count++] = *prefix;
+        return;
+    }
+
+    count = cf_valid_moves(game, cols);
+    for (int i = 0; i < count; ++i) {
+        cf_drop_piece(game, cols[i], to_move);
+        if (p->unique || !cf_has_winner(game, to_move)) {
+            prefix->moves[prefix->length++] = cols[i];
+            if (prefix->length == 1) {
+                prefix->root_col = cols[i];
+            }
+            build_tasks(p, game, other(to_move), prefix, split);
+            prefix->length -= 1;
+        }
+        cf_undo_piece(game, cols[i]);
+    }
+}
+
+static void *worker_main(void *arg) {
+    Perft *p = arg;
+    uint64_t interior = 0;
+
+    while (true) {
+        int index = atomic_fetch_add(&p->next_task, 1);
+        const Task *task;
+        CfGame game;
+        CfCell to_move = p->to_move;
+
+        if (index >= p->task_count) {
+            break;
+        }
+        task = &p->tasks[index];
+        game = p->root;
+        for (int i = 0; i < task->length; ++i) {
+            cf_drop_piece(&game, task->moves[i], to_move);
+            to_move = other(to_move);
+        }
+
+        if (p->unique) {
+            unique_expand(p, &game, to_move, task->length, &interior);
+        } else {
+            uint64_t count = perft(p, &game, to_move, p->depth - task->length, &interior);
+            atomic_fetch_add(&p->root_counts[task->root_col], count);
+        }
+    }
+
+    atomic_fetch_add(&p->interior_nodes, interior);
+    return NULL;
+}
+
+/* --------------------- Main --------------------- */
+static void print_usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-d depth] [-t threads] [-u] [-H set_bits] [moves|-]\n", argv0);
+    fprintf(stderr, "  -u  count unique positions per ply instead of move sequences\n");
+}
+
+int main(int argc, char **argv) {
+    static Perft p;
+    const char *moves = "";
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    int set_bits = DEFAULT_SET_BITS;
+    int split;
+    pthread_t workers[MAX_THREADS];
+    int started_workers = 0;
+    size_t set_bytes = 0;
+    size_t bad_index;
+    uint64_t total = 0;
+    double started;
+    double elapsed;
+    Task prefix;
+    int status = 0;
+
+    p.depth = DEFAULT_DEPTH;
+    for (int i = 1; i < argc; ++i) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "-u") == 0) {
+            p.unique = true;
+            continue;
+        }
+        if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            moves = strcmp(argv[i], "-") == 0 ? "" : argv[i];
+            continue;
+        }
+        if (value == NULL) {
+            print_usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "-d") == 0) {
+            p.depth = atoi(value);
+        } else if (strcmp(argv[i], "-t") == 0) {
+            threads = atoi(value);
+        } else if (strcmp(argv[i], "-H") == 0) {
+            set_bits = atoi(value);
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+        i += 1;
+    }
+
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    if (set_bits < 10 || set_bits > 34) {
+        set_bits = DEFAULT_SET_BITS;
+    }
+
+    /* The side to move plays CF_AI, as in the engine. */
+    p.to_move = CF_AI;
+    if (!cf_load_moves(&p.root, moves, strlen(moves), CF_AI, &bad_index)) {
+        fprintf(stderr, "perft: illegal move '%c' at move %zu\n", moves[bad_index], bad_index + 1);
+        return 2;
+    }
+    if (p.depth < 0) {
+        p.depth = 0;
+    }
+    if (p.depth > MAX_DEPTH - p.root.moves) {
+        p.depth = MAX_DEPTH - p.root.moves;
+    }
+
+    if (p.unique) {
+        set_bytes = ((size_t)1 << set_bits) * sizeof(uint64_t);
+        p.set = mmap(NULL, set_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (p.set == MAP_FAILED) {
+            fprintf(stderr, "perft: cannot allocate %zu MB for the position set\n", set_bytes >> 20);
+            return 1;
+        }
+        p.set_mask = ((uint64_t)1 << set_bits) - 1;
+    }
+
+    split = p.depth >= 4 ? 3 : (p.depth >= 2 ? p.depth - 1 : 0);
+    memset(&prefix, 0, sizeof(prefix));
+    prefix.root_col = -1;
+    if (p.unique || split > 0) {
+        CfGame scratch = p.root;
+        build_tasks(&p, &scratch, p.to_move, &prefix, split);
+    }
+
+    started = now_seconds();
+    if (!p.unique && split == 0) {
+        uint64_t interior = 0;
+        total = perft(&p, &p.root, p.to_move, p.depth, &interior);
+        atomic_store(&p.interior_nodes, interior);
+    } else {
+        for (int i = 0; i < threads; ++i) {
+            if (pthread_create(&workers[i], NULL, worker_main, &p) != 0) {
+                break;
+            }
+            started_workers += 1;
+        }
+        if (started_workers == 0) {
+            worker_main(&p);
+        }
+        for (int i = 0; i < started_workers; ++i) {
+            pthread_join(workers[i], NULL);
+        }
+    }
+    elapsed = now_seconds() - started;
+
+    if (p.unique) {
+        printf("unique positions from %s, %d plies:\n", moves[0] ? moves : "startpos", p.depth);
+        for (int ply = 0; ply <= p.depth; ++ply) {
+            uint64_t count = atomic_load(&p.unique_per_ply[ply]);
+            printf("  ply %2d  %llu\n", p.root.moves + ply, (unsigned long long)count);
+            total += count;
+        }
+        if (atomic_load(&p.set_full)) {
+            printf("position set full: counts are incomplete, rerun with a larger -H\n");
+            status = 1;
+        }
+    } else {
+        if (split > 0) {
+            for (int col = 0; col < CF_COLS; ++col) {
+                uint64_t count = atomic_load(&p.root_counts[col]);
+                if (cf_is_valid_move(&p.root, col)) {
+                    printf("  %d: %llu\n", col + 1, (unsigned long long)count);
+                }
+                total += count;
+            }
+        }
+        printf("perft %d from %s: %llu\n", p.depth, moves[0] ? moves : "startpos", (unsigned long long)total);
+
+        if (p.root.moves == 0 && p.depth < (int)(sizeof(kStartposPerft) / sizeof(kStartposPerft[0]))) {
+            bool ok = total == kStartposPerft[p.depth];
+            printf("reference %llu: %s\n", (unsigned long long)kStartposPerft[p.depth], ok ? "ok" : "MISMATCH");
+            status = ok ? 0 : 1;
+        }
+    }
+
+    printf(
+        "%.3fs, %llu interior nodes, %.1f M/s, %d thread(s)\n",
+        elapsed,
+        (unsigned long long)atomic_load(&p.interior_nodes),
+        elapsed > 0 ? (double)total / elapsed / 1e6 : 0,
+        started_workers > 0 ? started_workers : 1
+    );
+
+    if (p.set != NULL) {
+        munmap((void *)p.set, set_bytes);
+    }
+    return status;
+}
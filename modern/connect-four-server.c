@@ -0,0 +1,536 @@
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "connect_four.h"
+#include "connect_four_ai.h"
+#include "connect_four_client.h"
+#include "connect_four_engine.h"
+
+/*
+ * Local analysis server: frontends and tools on one host share one warm
+ * engine (one transposition table, one tablebase) over a Unix socket.
+ *
+ * The main thread multiplexes the listening socket and every client with
+ * poll() and turns complete request lines into jobs on a bounded queue.
+ * A fixed pool of workers drains the queue in batches: identical positions
+ * queued together are searched once and answered together, and a job whose
+ * deadline has already passed is answered "error <id> expired" without
+ * searching. The remaining budget becomes the search deadline, so a reply
+ * always arrives in time with the deepest finished result.
+ *
+ * Protocol: see connect_four_client.h. "stats" and "ping" are also answered.
+ */
+
+enum {
+    MAX_CLIENTS = 64,
+    LINE_CHARS = 512,
+    QUEUE_CAPACITY = 1024,
+    BATCH_MAX = 16,
+    MAX_THREADS = 64,
+    DEFAULT_DEPTH = 8,
+    POLL_INTERVAL_MS = 250,
+    SEND_TIMEOUT_MS = 1000
+};
+
+#ifdef MSG_NOSIGNAL
+#define SERVER_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SERVER_SEND_FLAGS 0
+#endif
+
+typedef struct {
+    int fd;
+    unsigned gen;
+    char buf[LINE_CHARS];
+    size_t len;
+    pthread_mutex_t write_lock;
+} Client;
+
+typedef struct {
+    int client;
+    unsigned gen;
+    unsigned long id;
+    CfGame game;
+    bool blocked_cols[CF_COLS];
+    int depth;
+    double deadline_ms;
+} Job;
+
+typedef struct {
+    Client clients[MAX_CLIENTS];
+    Job queue[QUEUE_CAPACITY];
+    size_t head;
+    size_t count;
+    bool stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    CfEngine *engine;
+    _Atomic uint64_t requests;
+    _Atomic uint64_t searched;
+    _Atomic uint64_t coalesced;
+    _Atomic uint64_t expired;
+    _Atomic uint64_t nodes;
+} Server;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* --------------------- Replies --------------------- */
+
+/* Workers and the main thread both reply; the generation check drops replies to a reused slot. */
+static void send_reply(Server *srv, int slot, unsigned gen, const char *fmt, ...) {
+    Client *c = &srv->clients[slot];
+    char line[LINE_CHARS];
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(line, sizeof(line) - 1, fmt, args);
+    va_end(args);
+    if (len < 0) {
+        return;
+    }
+    if ((size_t)len > sizeof(line) - 2) {
+        len = (int)sizeof(line) - 2;
+    }
+    line[len++] = '\n';
+
+    pthread_mutex_lock(&c->write_lock);
+    if (c->fd >= 0 && c->gen == gen) {
+        const char *p = line;
+        size_t left = (size_t)len;
+
+        while (left > 0) {
+            ssize_t sent = send(c->fd, p, left, SERVER_SEND_FLAGS);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                /* The poll loop notices the dead peer and frees the slot. */
+                shutdown(c->fd, SHUT_RDWR);
+                break;
+            }
+            p += sent;
+            left -= (size_t)sent;
+        }
+    }
+    pthread_mutex_unlock(&c->write_lock);
+}
+
+/* --------------------- Workers --------------------- */
+static bool same_question(const Job *a, const Job *b) {
+    return a->depth == b->depth &&
+        memcmp(a->game.board, b->game.board, sizeof(a->game.board)) == 0 &&
+        memcmp(a->blocked_cols, b->blocked_cols, sizeof(a->blocked_cols)) == 0;
+}
+
+static void answer(Server *srv, const Job *job, const CfSearchInfo *info) {
+    send_reply(
+        srv,
+        job->client,
+        job->gen,
+        "ok %lu %d %d %d %llu %.0f",
+        job->id,
+        info->best_col,
+        info->score,
+        info->depth,
+        (unsigned long long)info->nodes,
+        info->elapsed_ms * 1000.0
+    );
+}
+
+static void run_batch(Server *srv, Job *batch, int count) {
+    bool done[BATCH_MAX] = {false};
+
+    for (int i = 0; i < count; ++i) {
+        Job *job = &batch[i];
+        CfSearchInfo info;
+        double remaining = 0;
+
+        if (done[i]) {
+            continue;
+        }
+        if (job->deadline_ms > 0) {
+            remaining = job->deadline_ms - monotonic_ms();
+            if (remaining <= 0) {
+                atomic_fetch_add(&srv->expired, 1);
+                send_reply(srv, job->client, job->gen, "error %lu expired", job->id);
+                continue;
+            }
+        }
+
+        cf_engine_choose_move(srv->engine, &job->game, job->depth, job->blocked_cols, remaining, &info);
+        atomic_fetch_add(&srv->searched, 1);
+        atomic_fetch_add(&srv->nodes, info.nodes);
+        answer(srv, job, &info);
+
+        for (int j = i + 1; j < count; ++j) {
+            if (!done[j] && same_question(job, &batch[j])) {
+                done[j] = true;
+                atomic_fetch_add(&srv->coalesced, 1);
+                answer(srv, &batch[j], &info);
+            }
+        }
+    }
+}
+
+static void *worker_main(void *arg) {
+    Server *srv = arg;
+    Job batch[BATCH_MAX];
+
+    while (true) {
+        int count = 0;
+
+        pthread_mutex_lock(&srv->lock);
+        while (srv->count == 0 && !srv->stopping) {
+            pthread_cond_wait(&srv->ready, &srv->lock);
+        }
+        if (srv->count == 0) {
+            pthread_mutex_unlock(&srv->lock);
+            break;
+        }
+        while (srv->count > 0 && count < BATCH_MAX) {
+            batch[count++] = srv->queue[srv->head];
+            srv->head = (srv->head + 1) % QUEUE_CAPACITY;
+            srv->count -= 1;
+        }
+        pthread_mutex_unlock(&srv->lock);
+
+        run_batch(srv, batch, count);
+    }
+    return NULL;
+}
+
+/* --------------------- Requests --------------------- */
+static bool parse_choose(char *args, Job *job) {
+    char board[64];
+    char blocked[16];
+    double budget_ms;
+
+    if (sscanf(args, "%lu %63s %15s %d %lf", &job->id, board, blocked, &job->depth, &budget_ms) != 5) {
+        return false;
+    }
+    if (!cf_board_parse(&job->game, board, strlen(board))) {
+        return false;
+    }
+
+    memset(job->blocked_cols, 0, sizeof(job->blocked_cols));
+    if (strcmp(blocked, "-") != 0) {
+        for (const char *p = blocked; *p != '\0'; ++p) {
+            if (*p < '1' || *p > '0' + CF_COLS) {
+                return false;
+            }
+            job->blocked_cols[*p - '1'] = true;
+        }
+    }
+
+    if (job->depth <= 0) {
+        job->depth = DEFAULT_DEPTH;
+    }
+    job->deadline_ms = budget_ms > 0 ? monotonic_ms() + budget_ms : 0;
+    return true;
+}
+
+static void handle_request(Server *srv, int slot, char *line) {
+    Client *c = &srv->clients[slot];
+    unsigned long id = 0;
+    Job job;
+
+    if (strncmp(line, "choose ", 7) == 0) {
+        bool queued = false;
+
+        atomic_fetch_add(&srv->requests, 1);
+        memset(&job, 0, sizeof(job));
+        if (!parse_choose(line + 7, &job)) {
+            sscanf(line + 7, "%lu", &id);
+            send_reply(srv, slot, c->gen, "error %lu bad-request", id);
+            return;
+        }
+        job.client = slot;
+        job.gen = c->gen;
+
+        pthread_mutex_lock(&srv->lock);
+        if (srv->count < QUEUE_CAPACITY) {
+            srv->queue[(srv->head + srv->count) % QUEUE_CAPACITY] = job;
+            srv->count += 1;
+            queued = true;
+            pthread_cond_signal(&srv->ready);
+        }
+        pthread_mutex_unlock(&srv->lock);
+
+        if (!queued) {
+            send_reply(srv, slot, c->gen, "error %lu busy", job.id);
+        }
+    } else if (strcmp(line, "ping") == 0) {
+        send_reply(srv, slot, c->gen, "pong");
+    } else if (strcmp(line, "stats") == 0) {
+        CfTtStats tt;
+        cf_tt_get_stats(cf_engine_tt(srv->engine), &tt);
+        send_reply(
+            srv,
+            slot,
+            c->gen,
+            "stats requests %llu searched %llu coalesced %llu expired %llu nodes %llu tt_probes %llu tt_hits %llu",
+            (unsigned long long)atomic_load(&srv->requests),
+            (unsigned long long)atomic_load(&srv->searched),
+            (unsigned long long)atomic_load(&srv->coalesced),
+            (unsigned long long)atomic_load(&srv->expired),
+            (unsigned long long)atomic_load(&srv->nodes),
+            (unsigned long long)tt.probes,
+            (unsigned long long)tt.hits
+        );
+    } else if (line[0] != '\0') {
+        send_reply(srv, slot, c->gen, "error 0 unknown-command");
+    }
+}
+
+/* --------------------- Connections --------------------- */
+static void drop_client(Server *srv, int slot) {
+    Client *c = &srv->clients[slot];
+
+    pthread_mutex_lock(&c->write_lock);
+    close(c->fd);
+    c->fd = -1;
+    c->gen += 1;
+    c->len = 0;
+    pthread_mutex_unlock(&c->write_lock);
+}
+
+static void accept_client(Server *srv, int listen_fd) {
+    struct timeval send_timeout = {SEND_TIMEOUT_MS / 1000, (SEND_TIMEOUT_MS % 1000) * 1000};
+    int fd = accept(listen_fd, NULL, NULL);
+
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        Client *c = &srv->clients[i];
+        if (c->fd < 0) {
+            /* A stuck reader must not pin a worker forever. */
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+            pthread_mutex_lock(&c->write_lock);
+            c->fd = fd;
+            c->len = 0;
+            pthread_mutex_unlock(&c->write_lock);
+            return;
+        }
+    }
+    close(fd);
+}
+
+static void read_client(Server *srv, int slot) {
+    Client *c = &srv->clients[slot];
+    ssize_t got = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+    char *start;
+    char *nl;
+
+    if (got < 0 && errno == EINTR) {
+        return;
+    }
+    if (got <= 0) {
+        drop_client(srv, slot);
+        return;
+    }
+    c->len += (size_t)got;
+
+    start = c->buf;
+    while ((nl = memchr(start, '\n', c->len - (size_t)(start - c->buf))) != NULL) {
+        *nl = '\0';
+        if (nl > start && nl[-1] == '\r') {
+            nl[-1] = '\0';
+        }
+        handle_request(srv, slot, start);
+        start = nl + 1;
+    }
+
+    c->len -= (size_t)(start - c->buf);
+    memmove(c->buf, start, c->len);
+    if (c->len == sizeof(c->buf)) {
+        drop_client(srv, slot);
+    }
+}
+
+static int open_listener(const char *path) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "server: socket path too long\n");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+
+    /* Refuse to steal the socket from a live server; clear a stale one. */
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        fprintf(stderr, "server: %s is already served\n", path);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    unlink(path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, MAX_CLIENTS) != 0) {
+        fprintf(stderr, "server: cannot listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* --------------------- Main --------------------- */
+int main(int argc, char **argv) {
+    static Server srv;
+    const char *path = getenv("CF_SERVER_SOCKET");
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    pthread_t workers[MAX_THREADS];
+    int started_workers = 0;
+    CfEngineConfig config;
+    int listen_fd;
+
+    if (path == NULL || path[0] == '\0') {
+        path = CF_SERVER_DEFAULT_SOCKET;
+    }
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-s") == 0) {
+            path = argv[i + 1];
+        } else if (strcmp(argv[i], "-t") == 0) {
+            threads = atoi(argv[i + 1]);
+        } else {
+            fprintf(stderr, "Usage: %s [-s socket] [-t threads]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, on_stop_signal);
+    signal(SIGTERM, on_stop_signal);
+
+    listen_fd = open_listener(path);
+    if (listen_fd < 0) {
+        return 1;
+    }
+
+    /* The workers below batch and coalesce requests themselves, so the engine runs without a pool. */
+    cf_engine_config_init(&config);
+    config.tt_path = getenv("CF_TT_FILE");
+    config.tablebase_path = getenv("CF_TABLEBASE");
+    srv.engine = cf_engine_create(&config);
+    if (srv.engine == NULL) {
+        close(listen_fd);
+        unlink(path);
+        return 1;
+    }
+
+    pthread_mutex_init(&srv.lock, NULL);
+    pthread_cond_init(&srv.ready, NULL);
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        srv.clients[i].fd = -1;
+        pthread_mutex_init(&srv.clients[i].write_lock, NULL);
+    }
+    for (int i = 0; i < threads; ++i) {
+        if (pthread_create(&workers[i], NULL, worker_main, &srv) != 0) {
+            break;
+        }
+        started_workers += 1;
+    }
+    if (started_workers == 0) {
+        fprintf(stderr, "server: cannot start worker threads\n");
+        return 1;
+    }
+    fprintf(stderr, "server: listening on %s with %d workers\n", path, started_workers);
+
+    while (!g_stop) {
+        struct pollfd fds[MAX_CLIENTS + 1];
+        int slots[MAX_CLIENTS + 1];
+        nfds_t count = 0;
+
+        fds[count].fd = listen_fd;
+        fds[count].events = POLLIN;
+        slots[count++] = -1;
+        for (int i = 0; i < MAX_CLIENTS; ++i) {
+            if (srv.clients[i].fd >= 0) {
+                fds[count].fd = srv.clients[i].fd;
+                fds[count].events = POLLIN;
+                slots[count++] = i;
+            }
+        }
+
+        if (poll(fds, count, POLL_INTERVAL_MS) <= 0) {
+            continue;
+        }
+        for (nfds_t i = 0; i < count; ++i) {
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+                continue;
+            }
+            if (slots[i] < 0) {
+                accept_client(&srv, listen_fd);
+            } else {
+                read_client(&srv, slots[i]);
+            }
+        }
+    }
+
+    pthread_mutex_lock(&srv.lock);
+    srv.stopping = true;
+    srv.count = 0;
+    pthread_cond_broadcast(&srv.ready);
+    pthread_mutex_unlock(&srv.lock);
+    for (int i = 0; i < started_workers; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        if (srv.clients[i].fd >= 0) {
+            drop_client(&srv, i);
+        }
+        pthread_mutex_destroy(&srv.clients[i].write_lock);
+    }
+    close(listen_fd);
+    unlink(path);
+
+    cf_engine_destroy(srv.engine);
+    pthread_mutex_destroy(&srv.lock);
+    pthread_cond_destroy(&srv.ready);
+    return 0;
+}
@@ -0,0 +1,760 @@
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "connect_four.h"
+#include "connect_four_ai.h"
+#include "connect_four_engine.h"
+#include "connect_four_meta.h"
+#include "connect_four_rng.h"
+
+/*
+ * Monte Carlo simulator for the meta-game.
+ *
+ * Plays whole sessions without a terminal. Each round rolls its effects from
+ * the incident stacks, plays a simulated player against the AI with every
+ * per-move payload applied, feeds the result back into the stacks and the
+ * System Compromised meter, and may run a mini-game before the next round.
+ * The rules are the game's own (connect_four_meta.c); only the player is
+ * modelled:
+ *
+ *   - each move, with probability `skill`, the player picks the move a
+ *     depth -p search would pick for them, otherwise a random open column;
+ *     the drop then goes through remap, flip, jitter and hijack as in the
+ *     game, and a drop that lands on a locked or full column is retried;
+ *   - the miner is passed with probability `skill`; each phishing question
+ *     is answered right with probability (1 + skill) / 2, two of three pass.
+ *
+ * The opponent is the game's AI at the game's depth (-a ai) or the same
+ * search four plies shallower (-a proxy, the default), which keeps the
+ * Macro depth bonus meaningful at a fraction of the cost.
+ *
+ * Sessions are seeded from (seed, session number) and handed out to -t
+ * threads. With -n (no transposition table) a run is exactly repeatable
+ * for any thread count; with the shared table, which of two equal moves
+ * the AI picks can depend on what other threads stored.
+ */
+
+enum {
+    MAX_THREADS = 256,
+    MAX_ROUNDS = 10000,
+    PCT_BINS = 101,
+    LENGTH_BINS = 64,
+    MAX_DROP_TRIES = 64,
+    PRINT_ROUND_ROWS = 20,
+    PROXY_DEPTH_CUT = 4,
+    PHISHING_QUESTIONS = 3
+};
+
+/* Same split as the game, so a session here draws what the game would from the same seed. */
+enum {
+    SIM_RNG_EFFECTS,
+    SIM_RNG_PUNISHMENTS,
+    SIM_RNG_MINIGAMES,
+    SIM_RNG_GLITCHES,
+    SIM_RNG_PLAYER,
+    SIM_RNG_STREAMS
+};
+
+typedef enum {
+    OUTCOME_WIN,
+    OUTCOME_LOSS,
+    OUTCOME_DRAW,
+    OUTCOMES
+} Outcome;
+
+typedef enum {
+    EFFECT_JITTER,
+    EFFECT_FORCED,
+    EFFECT_REMAP,
+    EFFECT_LOCKED,
+    EFFECT_AI_BONUS,
+    EFFECT_OPENER,
+    EFFECT_CORRUPTION,
+    EFFECT_FLIP,
+    EFFECT_PURPLE,
+    EFFECTS
+} Effect;
+
+typedef enum {
+    PAYLOAD_JITTER,
+    PAYLOAD_HIJACK,
+    PAYLOAD_CORRUPTION,
+    PAYLOAD_RETRY,
+    PAYLOADS
+} Payload;
+
+static const char *const kOutcomeNames[OUTCOMES] = {"win", "loss", "draw"};
+static const char *const kEffectNames[EFFECTS] = {
+    "nVIR jitter",
+    "forced move",
+    "MDEF remap",
+    "WDEF locked cols",
+    "Macro AI bonus",
+    "AutoStart opener",
+    "666 corruption",
+    "grid flip",
+    "purple takeover"
+};
+static const char *const kEffectKeys[EFFECTS] = {
+    "jitter",
+    "forced_move",
+    "remap",
+    "locked_cols",
+    "ai_depth_bonus",
+    "opener",
+    "corruption",
+    "flip",
+    "purple"
+};
+static const char *const kPayloadNames[PAYLOADS] = {
+    "jitter rerouted",
+    "hijacked",
+    "token deleted",
+    "retried (locked/full)"
+};
+static const char *const kPayloadKeys[PAYLOADS] = {"jitter", "hijack", "corruption", "retry"};
+static const char *const kIncidentNames[CF_INCIDENT_TYPES] = {
+    "nVIR",
+    "MDEF",
+    "WDEF",
+    "Macro",
+    "AutoStart",
+    "SevenDust"
+};
+static const char *const kMinigameNames[2] = {"mining", "phishing"};
+
+typedef struct {
+    int sessions;
+    int rounds;
+    double skill;
+    int player_depth;
+    bool proxy;
+    bool use_tt;
+    int threads;
+    uint64_t seed;
+    const char *json_path;
+} Options;
+
+/* Per-thread tallies; merged by adding every field. */
+typedef struct {
+    uint64_t *compromised; /* rounds x PCT_BINS: the meter after round r */
+    uint64_t outcomes[OUTCOMES];
+    uint64_t lengths[OUTCOMES][LENGTH_BINS];
+    uint64_t effects[EFFECTS];
+    uint64_t payloads[PAYLOADS];
+    uint64_t player_moves;
+    uint64_t incidents[CF_INCIDENT_TYPES];
+    uint64_t minigames[2];
+    uint64_t minigames_passed[2];
+    uint64_t ai_searches;
+} Stats;
+
+typedef struct {
+    const Options *opts;
+    _Atomic int next_session;
+    Stats *stats;
+} Sim;
+
+typedef struct {
+    Sim *sim;
+    Stats *stats;
+} Worker;
+
+typedef struct {
+    const Options *opts;
+    CfEngine *engine;
+    Stats *stats;
+    CfRng rng[SIM_RNG_STREAMS];
+    CfMeta meta;
+    CfRoundEffects fx;
+    CfGame game;
+} Session;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool chance(CfRng *rng, double p) {
+    return (double)cf_rng_next(rng) < p * 4294967296.0;
+}
+
+/* --------------------- Moves --------------------- */
+static int random_playable(Session *ses) {
+    int open[CF_COLS];
+    int count = 0;
+
+    for (int col = 0; col < CF_COLS; ++col) {
+        if (cf_meta_playable(&ses->fx, &ses->game, col)) {
+            open[count++] = col;
+        }
+    }
+    return count > 0 ? open[cf_rng_below(&ses->rng[SIM_RNG_PLAYER], count)] : -1;
+}
+
+/* The AI searches for CF_AI; the player's view is the same board with the pieces swapped. */
+static int player_choice(Session *ses) {
+    CfGame mirror = ses->game;
+
+    if (!chance(&ses->rng[SIM_RNG_PLAYER], ses->opts->skill)) {
+        return random_playable(ses);
+    }
+    for (int row = 0; row < CF_ROWS; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            CfCell cell = mirror.board[row][col];
+            mirror.board[row][col] = cell == CF_HUMAN ? CF_AI : (cell == CF_AI ? CF_HUMAN : cell);
+        }
+    }
+    ses->stats->ai_searches += 1;
+    return cf_engine_choose_move(ses->engine, &mirror, ses->opts->player_depth, ses->fx.blocked_cols, 0, NULL);
+}
+
+static int ai_choice(Session *ses) {
+    int depth = cf_meta_ai_depth(&ses->meta, &ses->fx);
+
+    if (ses->opts->proxy) {
+        depth -= PROXY_DEPTH_CUT;
+    }
+    ses->stats->ai_searches += 1;
+    return cf_engine_choose_move(ses->engine, &ses->game, depth, ses->fx.blocked_cols, 0, NULL);
+}
+
+/* Mirrors player_drop(): where the press lands after every payload, or -1 if it never lands. */
+static int player_drop(Session *ses) {
+    for (int attempt = 0; attempt < MAX_DROP_TRIES; ++attempt) {
+        int raw = attempt == 0 ? player_choice(ses) : random_playable(ses);
+        int col;
+        int glitched;
+        int forced;
+
+        if (raw < 0) {
+            return -1;
+        }
+        col = cf_meta_flip_col(&ses->fx, cf_meta_remap_col(&ses->fx, raw));
+        glitched = cf_meta_glitch_col(&ses->fx, &ses->rng[SIM_RNG_GLITCHES], col);
+        if (glitched >= 0) {
+            ses->stats->payloads[PAYLOAD_JITTER] += 1;
+            col = glitched;
+        }
+        forced = cf_meta_forced_col(&ses->fx, &ses->rng[SIM_RNG_GLITCHES], &ses->game, col);
+        if (forced >= 0) {
+            ses->stats->payloads[PAYLOAD_HIJACK] += 1;
+            col = forced;
+        }
+        if (cf_meta_playable(&ses->fx, &ses->game, col)) {
+            return col;
+        }
+        ses->stats->payloads[PAYLOAD_RETRY] += 1;
+    }
+    return -1;
+}
+
+static bool no_playable(const Session *ses) {
+    for (int col = 0; col < CF_COLS; ++col) {
+        if (cf_meta_playable(&ses->fx, &ses->game, col)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* --------------------- Rounds --------------------- */
+static void count_effects(Stats *st, const CfRoundEffects *fx) {
+    st->effects[EFFECT_JITTER] += fx->input_glitch_pct > 0;
+    st->effects[EFFECT_FORCED] += fx->forced_move_pct > 0;
+    st->effects[EFFECT_REMAP] += fx->control_shift > 0;
+    st->effects[EFFECT_LOCKED] += fx->blocked_count > 0;
+    st->effects[EFFECT_AI_BONUS] += fx->ai_depth_bonus > 0;
+    st->effects[EFFECT_OPENER] += fx->ai_opening_moves > 0;
+    st->effects[EFFECT_CORRUPTION] += fx->player_piece_corrupt_pct > 0;
+    st->effects[EFFECT_FLIP] += fx->flip_turns_remaining > 0;
+    st->effects[EFFECT_PURPLE] += fx->purple_turns_remaining > 0;
+}
+
+/* One round from board_clear() to its result, following the game's turn order. */
+static Outcome play_round(Session *ses, int *plies) {
+    Stats *st = ses->stats;
+
+    cf_meta_roll_effects(&ses->meta, &ses->rng[SIM_RNG_EFFECTS], &ses->fx);
+    count_effects(st, &ses->fx);
+    cf_init(&ses->game);
+    *plies = 0;
+
+    for (int i = 0; i < ses->fx.ai_opening_moves; ++i) {
+        int col = ai_choice(ses);
+        if (col < 0) {
+            break;
+        }
+        cf_drop_piece(&ses->game, col, CF_AI);
+        *plies += 1;
+    }
+
+    while (true) {
+        int col;
+
+        if (no_playable(ses)) {
+            return OUTCOME_DRAW;
+        }
+        col = player_drop(ses);
+        if (col < 0) {
+            return OUTCOME_DRAW;
+        }
+        cf_drop_piece(&ses->game, col, CF_HUMAN);
+        st->player_moves += 1;
+        *plies += 1;
+        cf_meta_end_player_turn(&ses->fx);
+        if (cf_has_winner(&ses->game, CF_HUMAN)) {
+            return OUTCOME_WIN;
+        }
+        if (no_playable(ses)) {
+            return OUTCOME_DRAW;
+        }
+        if (cf_meta_corrupt(&ses->fx, &ses->rng[SIM_RNG_GLITCHES], &ses->game) >= 0) {
+            st->payloads[PAYLOAD_CORRUPTION] += 1;
+        }
+        if (no_playable(ses)) {
+            return OUTCOME_DRAW;
+        }
+
+        col = ai_choice(ses);
+        if (col < 0) {
+            return OUTCOME_DRAW;
+        }
+        cf_drop_piece(&ses->game, col, CF_AI);
+        *plies += 1;
+        if (cf_has_winner(&ses->game, CF_AI)) {
+            return OUTCOME_LOSS;
+        }
+    }
+}
+
+static void maybe_play_minigame(Session *ses) {
+    CfRng *rng = &ses->rng[SIM_RNG_MINIGAMES];
+    CfMinigame game;
+    bool passed;
+
+    if (cf_rng_below(rng, 100) >= cf_meta_intermission_chance(&ses->meta)) {
+        return;
+    }
+    game = cf_rng_below(rng, 2) == 0 ? CF_MINIGAME_MINING : CF_MINIGAME_PHISHING;
+    if (game == CF_MINIGAME_MINING) {
+        passed = chance(&ses->rng[SIM_RNG_PLAYER], ses->opts->skill);
+    } else {
+        int correct = 0;
+
+        for (int q = 0; q < PHISHING_QUESTIONS; ++q) {
+            correct += chance(&ses->rng[SIM_RNG_PLAYER], (1.0 + ses->opts->skill) / 2.0);
+        }
+        passed = correct >= 2;
+    }
+    ses->stats->minigames[game] += 1;
+    ses->stats->minigames_passed[game] += passed;
+    cf_meta_minigame_result(&ses->meta, game, passed);
+}
+
+static void run_session(CfEngine *engine, const Options *opts, Stats *st, int index) {
+    Session ses;
+
+    memset(&ses, 0, sizeof(ses));
+    ses.opts = opts;
+    ses.engine = engine;
+    ses.stats = st;
+    for (int i = 0; i < SIM_RNG_STREAMS; ++i) {
+        cf_rng_seed(&ses.rng[i], opts->seed, (uint64_t)index * SIM_RNG_STREAMS + (uint64_t)i);
+    }
+    cf_meta_begin(&ses.meta);
+
+    for (int round = 0; round < opts->rounds; ++round) {
+        int plies;
+        Outcome outcome = play_round(&ses, &plies);
+
+        st->outcomes[outcome] += 1;
+        st->lengths[outcome][plies < LENGTH_BINS ? plies : LENGTH_BINS - 1] += 1;
+        if (outcome == OUTCOME_LOSS) {
+            st->incidents[cf_meta_ai_won(&ses.meta, &ses.rng[SIM_RNG_PUNISHMENTS]) - 1] += 1;
+        } else if (outcome == OUTCOME_WIN) {
+            cf_meta_player_won(&ses.meta);
+        }
+        maybe_play_minigame(&ses);
+        st->compromised[(size_t)round * PCT_BINS + (size_t)ses.meta.compromised_pct] += 1;
+    }
+}
+
+static void worker_main(CfEngine *engine, void *arg) {
+    Worker *w = arg;
+    const Options *opts = w->sim->opts;
+
+    while (true) {
+        int index = atomic_fetch_add(&w->sim->next_session, 1);
+        if (index >= opts->sessions) {
+            break;
+        }
+        run_session(engine, opts, w->stats, index);
+    }
+}
+
+/* --------------------- Reporting --------------------- */
+static bool stats_init(Stats *st, int rounds) {
+    memset(st, 0, sizeof(*st));
+    st->compromised = calloc((size_t)rounds * PCT_BINS, sizeof(*st->compromised));
+    return st->compromised != NULL;
+}
+
+static void stats_merge(Stats *into, const Stats *from, int rounds) {
+    for (size_t i = 0; i < (size_t)rounds * PCT_BINS; ++i) {
+        into->compromised[i] += from->compromised[i];
+    }
+    for (int o = 0; o < OUTCOMES; ++o) {
+        into->outcomes[o] += from->outcomes[o];
+        for (int i = 0; i < LENGTH_BINS; ++i) {
+            into->lengths[o][i] += from->lengths[o][i];
+        }
+    }
+    for (int i = 0; i < EFFECTS; ++i) {
+        into->effects[i] += from->effects[i];
+    }
+    for (int i = 0; i < PAYLOADS; ++i) {
+        into->payloads[i] += from->payloads[i];
+    }
+    for (int i = 0; i < CF_INCIDENT_TYPES; ++i) {
+        into->incidents[i] += from->incidents[i];
+    }
+    for (int i = 0; i < 2; ++i) {
+        into->minigames[i] += from->minigames[i];
+        into->minigames_passed[i] += from->minigames_passed[i];
+    }
+    into->player_moves += from->player_moves;
+    into->ai_searches += from->ai_searches;
+}
+
+static uint64_t hist_total(const uint64_t *bins, int n) {
+    uint64_t total = 0;
+
+    for (int i = 0; i < n; ++i) {
+        total += bins[i];
+    }
+    return total;
+}
+
+static double hist_mean(const uint64_t *bins, int n) {
+    uint64_t total = hist_total(bins, n);
+    double sum = 0;
+
+    for (int i = 0; i < n; ++i) {
+        sum += (double)i * (double)bins[i];
+    }
+    return total > 0 ? sum / (double)total : 0;
+}
+
+/* Smallest bin with at least fraction `q` of the samples at or below it. */
+static int hist_percentile(const uint64_t *bins, int n, double q) {
+    uint64_t total = hist_total(bins, n);
+    uint64_t seen = 0;
+
+    for (int i = 0; i < n; ++i) {
+        seen += bins[i];
+        if (total > 0 && (double)seen >= q * (double)total) {
+            return i;
+        }
+    }
+    return n - 1;
+}
+
+static double share(uint64_t part, uint64_t whole) {
+    return whole > 0 ? 100.0 * (double)part / (double)whole : 0;
+}
+
+static void print_report(const Options *opts, const Stats *st, int threads, double elapsed) {
+    uint64_t rounds = (uint64_t)opts->sessions * (uint64_t)opts->rounds;
+    int step = opts->rounds > PRINT_ROUND_ROWS ? (opts->rounds + PRINT_ROUND_ROWS - 1) / PRINT_ROUND_ROWS : 1;
+
+    printf(
+        "sim: %d sessions x %d rounds, skill %.2f (depth %d), opponent %s, seed %llu, %d thread(s)\n",
+        opts->sessions,
+        opts->rounds,
+        opts->skill,
+        opts->player_depth,
+        opts->proxy ? "proxy" : "ai",
+        (unsigned long long)opts->seed,
+        threads
+    );
+    printf(
+        "rounds %llu: W %.1f%%  L %.1f%%  D %.1f%%   %.2fs, %.0f rounds/s, %llu searches\n\n",
+        (unsigned long long)rounds,
+        share(st->outcomes[OUTCOME_WIN], rounds),
+        share(st->outcomes[OUTCOME_LOSS], rounds),
+        share(st->outcomes[OUTCOME_DRAW], rounds),
+        elapsed,
+        elapsed > 0 ? (double)rounds / elapsed : 0,
+        (unsigned long long)st->ai_searches
+    );
+
+    printf("compromised after round   mean   p10   p50   p90\n");
+    for (int r = 0; r < opts->rounds; r += step) {
+        const uint64_t *bins = &st->compromised[(size_t)r * PCT_BINS];
+
+        /* Always end on the last round. */
+        if (r + step >= opts->rounds) {
+            r = opts->rounds - 1;
+            bins = &st->compromised[(size_t)r * PCT_BINS];
+        }
+        printf(
+            "  %21d  %5.1f  %4d  %4d  %4d\n",
+            r + 1,
+            hist_mean(bins, PCT_BINS),
+            hist_percentile(bins, PCT_BINS, 0.10),
+            hist_percentile(bins, PCT_BINS, 0.50),
+            hist_percentile(bins, PCT_BINS, 0.90)
+        );
+    }
+
+    printf("\neffects active (share of rounds)\n");
+    for (int i = 0; i < EFFECTS; ++i) {
+        printf("  %-22s %5.1f%%\n", kEffectNames[i], share(st->effects[i], rounds));
+    }
+    printf("payloads fired (per player move, %llu moves)\n", (unsigned long long)st->player_moves);
+    for (int i = 0; i < PAYLOADS; ++i) {
+        printf("  %-22s %5.1f%%\n", kPayloadNames[i], share(st->payloads[i], st->player_moves));
+    }
+    printf("incidents (share of losses)\n");
+    for (int i = 0; i < CF_INCIDENT_TYPES; ++i) {
+        printf("  %-22s %5.1f%%\n", kIncidentNames[i], share(st->incidents[i], st->outcomes[OUTCOME_LOSS]));
+    }
+    printf("mini-games\n");
+    for (int i = 0; i < 2; ++i) {
+        printf(
+            "  %-22s %5.1f%% of rounds, passed %5.1f%%\n",
+            kMinigameNames[i],
+            share(st->minigames[i], rounds),
+            share(st->minigames_passed[i], st->minigames[i])
+        );
+    }
+
+    printf("\nround length (plies)     mean   p50   p90\n");
+    for (int o = 0; o < OUTCOMES; ++o) {
+        printf(
+            "  %-22s %5.1f  %4d  %4d\n",
+            kOutcomeNames[o],
+            hist_mean(st->lengths[o], LENGTH_BINS),
+            hist_percentile(st->lengths[o], LENGTH_BINS, 0.50),
+            hist_percentile(st->lengths[o], LENGTH_BINS, 0.90)
+        );
+    }
+}
+
+static void json_counts(FILE *fp, const uint64_t *bins, int n) {
+    fputc('[', fp);
+    for (int i = 0; i < n; ++i) {
+        fprintf(fp, "%s%llu", i > 0 ? ", " : "", (unsigned long long)bins[i]);
+    }
+    fputc(']', fp);
+}
+
+/* Full histograms, so a sweep script can compute any statistic it likes. */
+static void write_json(FILE *fp, const Options *opts, const Stats *st, double elapsed) {
+    fprintf(
+        fp,
+        "{\n  \"sessions\": %d,\n  \"rounds\": %d,\n  \"skill\": %.4f,\n  \"player_depth\": %d,\n"
+        "  \"opponent\": \"%s\",\n  \"transposition_table\": %s,\n  \"seed\": %llu,\n  \"seconds\": %.3f,\n",
+        opts->sessions,
+        opts->rounds,
+        opts->skill,
+        opts->player_depth,
+        opts->proxy ? "proxy" : "ai",
+        opts->use_tt ? "true" : "false",
+        (unsigned long long)opts->seed,
+        elapsed
+    );
+    fprintf(fp, "  \"outcomes\": {");
+    for (int o = 0; o < OUTCOMES; ++o) {
+        fprintf(fp, "%s\"%s\": %llu", o > 0 ? ", " : "", kOutcomeNames[o], (unsigned long long)st->outcomes[o]);
+    }
+    fprintf(fp, "},\n  \"round_length\": {");
+    for (int o = 0; o < OUTCOMES; ++o) {
+        fprintf(fp, "%s\"%s\": ", o > 0 ? ", " : "", kOutcomeNames[o]);
+        json_counts(fp, st->lengths[o], LENGTH_BINS);
+    }
+    fprintf(fp, "},\n  \"effects\": {");
+    for (int i = 0; i < EFFECTS; ++i) {
+        fprintf(fp, "%s\"%s\": %llu", i > 0 ? ", " : "", kEffectKeys[i], (unsigned long long)st->effects[i]);
+    }
+    fprintf(fp, "},\n  \"player_moves\": %llu,\n  \"payloads\": {", (unsigned long long)st->player_moves);
+    for (int i = 0; i < PAYLOADS; ++i) {
+        fprintf(fp, "%s\"%s\": %llu", i > 0 ? ", " : "", kPayloadKeys[i], (unsigned long long)st->payloads[i]);
+    }
+    fprintf(fp, "},\n  \"incidents\": ");
+    json_counts(fp, st->incidents, CF_INCIDENT_TYPES);
+    fprintf(fp, ",\n  \"minigames\": {");
+    for (int i = 0; i < 2; ++i) {
+        fprintf(
+            fp,
+            "%s\"%s\": {\"played\": %llu, \"passed\": %llu}",
+            i > 0 ? ", " : "",
+            kMinigameNames[i],
+            (unsigned long long)st->minigames[i],
+            (unsigned long long)st->minigames_passed[i]
+        );
+    }
+    fprintf(fp, "},\n  \"compromised_after_round\": [\n");
+    for (int r = 0; r < opts->rounds; ++r) {
+        fprintf(fp, "    ");
+        json_counts(fp, &st->compromised[(size_t)r * PCT_BINS], PCT_BINS);
+        fprintf(fp, "%s\n", r + 1 < opts->rounds ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+static void print_usage(const char *argv0) {
+    fprintf(
+        stderr,
+        "Usage: %s [-n sessions] [-r rounds] [-s skill 0..1] [-p player_depth] [-a ai|proxy]\n"
+        "          [-t threads] [-S seed] [-N] [-j out.json|-]\n"
+        "  -N  no transposition table (repeatable for any -t)\n",
+        argv0
+    );
+}
+
+int main(int argc, char **argv) {
+    Options opts;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    Sim sim;
+    Stats total;
+    Stats *per_thread;
+    Worker workers[MAX_THREADS];
+    int started_workers = 0;
+    CfEngineConfig config;
+    CfEngine *engine;
+    double started;
+    double elapsed;
+    FILE *json = NULL;
+
+    memset(&opts, 0, sizeof(opts));
+    opts.sessions = 1000;
+    opts.rounds = 30;
+    opts.skill = 0.5;
+    opts.player_depth = 4;
+    opts.proxy = true;
+    opts.use_tt = true;
+    opts.threads = cpus > 0 ? (int)cpus : 1;
+    opts.seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "-N") == 0) {
+            opts.use_tt = false;
+            continue;
+        }
+        if (value == NULL) {
+            print_usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "-n") == 0) {
+            opts.sessions = atoi(value);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            opts.rounds = atoi(value);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            opts.skill = atof(value);
+        } else if (strcmp(argv[i], "-p") == 0) {
+            opts.player_depth = atoi(value);
+        } else if (strcmp(argv[i], "-a") == 0 && (strcmp(value, "ai") == 0 || strcmp(value, "proxy") == 0)) {
+            opts.proxy = strcmp(value, "proxy") == 0;
+        } else if (strcmp(argv[i], "-t") == 0) {
+            opts.threads = atoi(value);
+        } else if (strcmp(argv[i], "-S") == 0) {
+            opts.seed = strtoull(value, NULL, 0);
+        } else if (strcmp(argv[i], "-j") == 0) {
+            opts.json_path = value;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+        i += 1;
+    }
+
+    opts.sessions = opts.sessions < 1 ? 1 : opts.sessions;
+    opts.rounds = cf_meta_clamp(opts.rounds, 1, MAX_ROUNDS);
+    opts.skill = opts.skill < 0 ? 0 : (opts.skill > 1 ? 1 : opts.skill);
+    opts.player_depth = cf_meta_clamp(opts.player_depth, 1, CF_AI_MAX_DEPTH);
+    opts.threads = cf_meta_clamp(opts.threads, 1, MAX_THREADS);
+
+    if (opts.json_path != NULL) {
+        json = strcmp(opts.json_path, "-") == 0 ? stdout : fopen(opts.json_path, "w");
+        if (json == NULL) {
+            fprintf(stderr, "sim: cannot write %s: %s\n", opts.json_path, strerror(errno));
+            return 1;
+        }
+    }
+
+    per_thread = calloc((size_t)opts.threads, sizeof(*per_thread));
+    if (per_thread == NULL || !stats_init(&total, opts.rounds)) {
+        fprintf(stderr, "sim: out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < opts.threads; ++i) {
+        if (!stats_init(&per_thread[i], opts.rounds)) {
+            fprintf(stderr, "sim: out of memory\n");
+            return 1;
+        }
+    }
+
+    /* Private table only: a shared one would make runs depend on what other processes searched. */
+    cf_engine_config_init(&config);
+    config.tt_slots = opts.use_tt ? CF_TT_DEFAULT_SLOTS : 0;
+    config.tablebase_path = getenv("CF_TABLEBASE");
+    config.threads = opts.threads;
+    engine = cf_engine_create(&config);
+    if (engine == NULL) {
+        fprintf(stderr, "sim: out of memory\n");
+        return 1;
+    }
+
+    sim.opts = &opts;
+    atomic_init(&sim.next_session, 0);
+    sim.stats = per_thread;
+
+    started = now_seconds();
+    for (int i = 0; i < opts.threads; ++i) {
+        workers[i].sim = &sim;
+        workers[i].stats = &per_thread[i];
+        if (!cf_engine_post(engine, worker_main, &workers[i])) {
+            break;
+        }
+        started_workers += 1;
+    }
+    if (started_workers == 0) {
+        workers[0].sim = &sim;
+        workers[0].stats = &per_thread[0];
+        worker_main(engine, &workers[0]);
+    }
+    cf_engine_wait(engine);
+    elapsed = now_seconds() - started;
+
+    for (int i = 0; i < opts.threads; ++i) {
+        stats_merge(&total, &per_thread[i], opts.rounds);
+        free(per_thread[i].compromised);
+    }
+    free(per_thread);
+
+    if (json != stdout) {
+        print_report(&opts, &total, started_workers > 0 ? started_workers : 1, elapsed);
+    }
+    if (json != NULL) {
+        write_json(json, &opts, &total, elapsed);
+        if (json != stdout) {
+            fclose(json);
+        }
+    }
+
+    free(total.compromised);
+    cf_engine_destroy(engine);
+    return 0;
+}
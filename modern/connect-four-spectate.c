@@ -0,0 +1,200 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "connect_four.h"
+#include "connect_four_feed.h"
+#include "connect_four_meta.h"
+
+/*
+ * Read-only spectator for a running game (CF_FEED=... connect-four-virus).
+ *
+ * Maps the game's feed segment and redraws whenever a new snapshot shows
+ * up. It never writes to the segment, so any number of viewers can watch
+ * without the game noticing.
+ */
+
+enum {
+    DEFAULT_INTERVAL_MS = 50
+};
+
+/* Same order as the game's SCENE_* values. */
+static const char *const kSceneNames[] = {
+    "board",
+    "desktop intro",
+    "incident",
+    "squiggles",
+    "bitcoin miner",
+    "phishing quiz"
+};
+static const char *const kIncidentNames[CF_INCIDENT_TYPES] = {
+    "nVIR",
+    "MDEF",
+    "WDEF",
+    "Macro",
+    "AutoStart",
+    "SevenDust"
+};
+
+static void sleep_ms(int ms) {
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+
+static const char *scene_name(int scene) {
+    if (scene < 0 || scene >= (int)(sizeof(kSceneNames) / sizeof(kSceneNames[0]))) {
+        return "?";
+    }
+    return kSceneNames[scene];
+}
+
+static void print_snapshot(const CfFeedSnapshot *snap, bool clear) {
+    const CfMeta *meta = &snap->meta;
+
+    if (clear) {
+        fputs("\033[H\033[2J", stdout);
+    }
+    printf(
+        "%s | frame %llu | %.1f s | %s\n",
+        snap->player_name[0] != '\0' ? snap->player_name : "(no name yet)",
+        (unsigned long long)snap->frame,
+        (double)snap->time_ms / 1000.0,
+        scene_name(snap->scene)
+    );
+    printf(
+        "W:%d L:%d | Compromised %d%% | stacks",
+        meta->total_wins,
+        meta->total_losses,
+        meta->compromised_pct
+    );
+    for (int i = 0; i < CF_INCIDENT_TYPES; ++i) {
+        if (meta->incident_stacks[i] > 0) {
+            printf(" %s:%d", kIncidentNames[i], meta->incident_stacks[i]);
+        }
+    }
+    printf("\n\n");
+
+    printf(" ");
+    for (int col = 0; col < CF_COLS; ++col) {
+        printf(" %c", col == snap->cursor_col && !snap->game_over ? 'v' : ' ');
+    }
+    printf("\n");
+    for (int row = 0; row < CF_ROWS; ++row) {
+        printf(" |");
+        for (int col = 0; col < CF_COLS; ++col) {
+            char piece = '.';
+
+            if (snap->board[row][col] == CF_HUMAN) {
+                piece = 'X';
+            } else if (snap->board[row][col] == CF_AI) {
+                piece = 'O';
+            } else if (snap->blocked_cols[col]) {
+                piece = '#';
+            }
+            printf("%c|", piece);
+        }
+        printf("\n");
+    }
+    printf(" ");
+    for (int col = 0; col < CF_COLS; ++col) {
+        printf(" %d", col + 1);
+    }
+    printf("\n\n");
+
+    printf("%s%s\n", snap->status, snap->ai_thinking && !snap->game_over ? " [AI thinking]" : "");
+    printf("%s\n", snap->effects);
+    printf("Alert: %s\n\n", snap->alert);
+    for (int i = 0; i < snap->log_lines && i < CF_FEED_LOG_LINES; ++i) {
+        printf("  %.*s\n", CF_LOG_CHARS, snap->log[i]);
+    }
+    fflush(stdout);
+}
+
+static void print_usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-n feed_name] [-i interval_ms] [-1]\n", argv0);
+    fprintf(stderr, "  -1  print the current snapshot once and exit\n");
+}
+
+int main(int argc, char **argv) {
+    const char *name = getenv("CF_FEED");
+    int interval_ms = DEFAULT_INTERVAL_MS;
+    bool once = false;
+    bool waiting = false;
+    CfFeedReader *reader = NULL;
+    CfFeedSnapshot snap;
+    uint64_t shown = 0;
+
+    if (name == NULL || name[0] == '\0') {
+        name = CF_FEED_DEFAULT_NAME;
+    }
+    for (int i = 1; i < argc; ++i) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "-1") == 0) {
+            once = true;
+            continue;
+        }
+        if (value == NULL) {
+            print_usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "-n") == 0) {
+            name = value;
+        } else if (strcmp(argv[i], "-i") == 0) {
+            interval_ms = atoi(value);
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+        i += 1;
+    }
+    interval_ms = interval_ms < 1 ? 1 : interval_ms;
+
+    while (reader == NULL) {
+        reader = cf_feed_attach(name);
+        if (reader != NULL) {
+            break;
+        }
+        if (once) {
+            fprintf(stderr, "spectate: no game is publishing %s\n", name);
+            return 1;
+        }
+        if (!waiting) {
+            fprintf(stderr, "spectate: waiting for a game on %s (start it with CF_FEED=%s)\n", name, name);
+            waiting = true;
+        }
+        sleep_ms(interval_ms * 10);
+    }
+
+    while (true) {
+        bool finished = cf_feed_finished(reader);
+
+        /* Check for the end first, so the final snapshot is still shown. */
+        if (cf_feed_read(reader, &snap) && snap.frame != shown) {
+            print_snapshot(&snap, !once);
+            shown = snap.frame;
+            if (once) {
+                break;
+            }
+        }
+        if (finished) {
+            printf("\nspectate: the game has ended.\n");
+            break;
+        }
+        if (once && shown == 0) {
+            fprintf(stderr, "spectate: nothing published yet on %s\n", name);
+            cf_feed_detach(reader);
+            return 1;
+        }
+        sleep_ms(interval_ms);
+    }
+
+    cf_feed_detach(reader);
+    return 0;
+}
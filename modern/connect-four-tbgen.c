@@ -0,0 +1,886 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "connect_four.h"
+#include "connect_four_ai.h"
+#include "connect_four_tablebase.h"
+
+/*
+ * Offline endgame tablebase generator.
+ *
+ * Every layer of the game graph holds the positions with the same number of
+ * stones, and every move goes from one layer to the next, so the table is
+ * solved backwards one layer at a time: a full board is a draw, and each
+ * earlier layer is resolved from the layer after it. A layer is the set of
+ * four-free, gravity-legal boards with regular alternating stone counts
+ * (a superset of the positions reachable in play), keyed by the canonical
+ * mover key from cf_position_key(), so mirror images share one entry.
+ * Each extra empty cell makes a layer about 2.6 times larger than the one
+ * after it, so the default stops at two empties (about 830 MB of table).
+ *
+ * Solved layers are checkpointed to the work directory. A restarted run
+ * loads the finished layers and carries on with the first missing one.
+ *
+ * -c checks a finished table instead: seeded random games are played down
+ * to the tabulated depth, and the AI's move there, with the table and with
+ * a plain search to the end of the game, must reach the same outcome.
+ */
+
+enum {
+    CELLS = CF_ROWS * CF_COLS,
+    COL_BITS = CF_ROWS + 1,
+    SOLVE_CHUNK = 4096,
+    DEFAULT_MAX_EMPTIES = 2,
+    MAX_THREADS = 256,
+    DEFAULT_CHECK_POSITIONS = 2000
+};
+
+static const char kLayerMagic[8] = {'C', 'F', '4', 'L', 'A', 'Y', 'R', '\n'};
+
+typedef struct {
+    char magic[8];
+    uint32_t stones;
+    uint16_t rows;
+    uint16_t cols;
+    uint64_t count;
+    uint64_t reserved;
+} LayerHeader;
+
+typedef struct {
+    uint64_t *keys;
+    uint8_t *values;
+    size_t count;
+    void *map;
+    size_t map_size;
+} LayerTable;
+
+typedef struct {
+    int heights[CF_COLS];
+} HeightVector;
+
+typedef struct {
+    uint64_t *keys;
+    size_t count;
+    size_t cap;
+    bool failed;
+} KeyBuffer;
+
+typedef struct {
+    int stones;
+    const HeightVector *vectors;
+    size_t vector_count;
+    atomic_size_t next_vector;
+    const LayerTable *next_layer;
+    LayerTable *layer;
+    atomic_size_t next_chunk;
+} LayerJob;
+
+typedef struct {
+    LayerJob *job;
+    KeyBuffer found;
+} Worker;
+
+typedef struct {
+    int max_empties;
+    int threads;
+    const char *out_path;
+    const char *work_dir;
+    const char *check_path;
+    int check_positions;
+} GenOptions;
+
+static uint64_t bottom_mask(void) {
+    uint64_t mask = 0;
+    for (int col = 0; col < CF_COLS; ++col) {
+        mask |= UINT64_C(1) << (col * COL_BITS);
+    }
+    return mask;
+}
+
+static bool bb_has_four(uint64_t bb) {
+    static const int kDirections[4] = {1, COL_BITS, COL_BITS - 1, COL_BITS + 1};
+
+    for (int i = 0; i < 4; ++i) {
+        int d = kDirections[i];
+        uint64_t pairs = bb & (bb >> d);
+        if (pairs & (pairs >> (2 * d))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* --------------------- Layer storage --------------------- */
+static void layer_free(LayerTable *layer) {
+    if (layer->map != NULL) {
+        munmap(layer->map, layer->map_size);
+    } else {
+        free(layer->keys);
+        free(layer->values);
+    }
+    memset(layer, 0, sizeof(*layer));
+}
+
+static void layer_path(const GenOptions *opts, int stones, const char *suffix, char *buf, size_t cap) {
+    snprintf(buf, cap, "%s/layer-%02d.%s", opts->work_dir, stones, suffix);
+}
+
+static bool layer_load(const GenOptions *opts, int stones, LayerTable *out) {
+    char path[1024];
+    struct stat st;
+    const LayerHeader *header;
+    size_t expected;
+    void *map;
+    FILE *file;
+
+    layer_path(opts, stones, "bin", path, sizeof(path));
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    if (fstat(fileno(file), &st) != 0 || (size_t)st.st_size < sizeof(LayerHeader)) {
+        fclose(file);
+        return false;
+    }
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fileno(file), 0);
+    fclose(file);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    header = map;
+    expected = sizeof(LayerHeader) + (size_t)header->count * (sizeof(uint64_t) + 1);
+    if (memcmp(header->magic, kLayerMagic, sizeof(kLayerMagic)) != 0 ||
+        header->stones != (uint32_t)stones ||
+        header->rows != CF_ROWS ||
+        header->cols != CF_COLS ||
+        expected != (size_t)st.st_size) {
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+
+    out->map = map;
+    out->map_size = (size_t)st.st_size;
+    out->count = (size_t)header->count;
+    out->keys = (uint64_t *)((uint8_t *)map + sizeof(LayerHeader));
+    out->values = (uint8_t *)(out->keys + out->count);
+    return true;
+}
+
+static bool layer_save(const GenOptions *opts, int stones, const LayerTable *layer) {
+    char tmp_path[1024];
+    char final_path[1024];
+    LayerHeader header;
+    FILE *file;
+    bool ok = true;
+
+    layer_path(opts, stones, "tmp", tmp_path, sizeof(tmp_path));
+    layer_path(opts, stones, "bin", final_path, sizeof(final_path));
+
+    file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kLayerMagic, sizeof(kLayerMagic));
+    header.stones = (uint32_t)stones;
+    header.rows = CF_ROWS;
+    header.cols = CF_COLS;
+    header.count = layer->count;
+
+    ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(layer->keys, sizeof(uint64_t), layer->count, file) == layer->count &&
+        fwrite(layer->values, 1, layer->count, file) == layer->count;
+    ok = (fflush(file) == 0) && ok;
+    ok = (fsync(fileno(file)) == 0) && ok;
+    ok = (fclose(file) == 0) && ok;
+
+    /* The rename is the commit point: a crash leaves either no layer or a complete one. */
+    if (!ok || rename(tmp_path, final_path) != 0) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+static bool layer_lookup(const LayerTable *layer, uint64_t key, uint8_t *out) {
+    size_t lo = 0;
+    size_t hi = layer->count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (layer->keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo < layer->count && layer->keys[lo] == key) {
+        *out = layer->values[lo];
+        return true;
+    }
+    return false;
+}
+
+/* LSD radix sort; keys use at most CF_COLS * COL_BITS bits. */
+static bool radix_sort_keys(uint64_t *keys, size_t count) {
+    uint64_t *scratch;
+    uint64_t *src = keys;
+    uint64_t *dst;
+    int passes = (CF_COLS * COL_BITS + 7) / 8;
+
+    if (count < 2) {
+        return true;
+    }
+
+    scratch = malloc(count * sizeof(*scratch));
+    if (scratch == NULL) {
+        return false;
+    }
+    dst = scratch;
+
+    for (int pass = 0; pass < passes; ++pass) {
+        size_t offsets[256] = {0};
+        int shift = pass * 8;
+        size_t total = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            offsets[(src[i] >> shift) & 0xff] += 1;
+        }
+        for (int b = 0; b < 256; ++b) {
+            size_t n = offsets[b];
+            offsets[b] = total;
+            total += n;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            dst[offsets[(src[i] >> shift) & 0xff]++] = src[i];
+        }
+
+        uint64_t *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != keys) {
+        memcpy(keys, src, count * sizeof(*keys));
+    }
+    free(scratch);
+    return true;
+}
+
+/* --------------------- Enumeration --------------------- */
+static void key_buffer_push(KeyBuffer *buf, uint64_t key) {
+    if (buf->failed) {
+        return;
+    }
+    if (buf->count == buf->cap) {
+        size_t cap = buf->cap ? buf->cap * 2 : 1 << 16;
+        uint64_t *grown = realloc(buf->keys, cap * sizeof(*grown));
+        if (grown == NULL) {
+            buf->failed = true;
+            return;
+        }
+        buf->keys = grown;
+        buf->cap = cap;
+    }
+    buf->keys[buf->count++] = key;
+}
+
+static void collect_heights(int col, int left, HeightVector *current, HeightVector **out, size_t *count, size_t *cap) {
+    if (col == CF_COLS) {
+        if (left != 0) {
+            return;
+        }
+        if (*count == *cap) {
+            size_t grown_cap = *cap ? *cap * 2 : 256;
+            HeightVector *grown = realloc(*out, grown_cap * sizeof(*grown));
+            if (grown == NULL) {
+                return;
+            }
+            *out = grown;
+            *cap = grown_cap;
+        }
+        (*out)[(*count)++] = *current;
+        return;
+    }
+
+    for (int h = 0; h <= CF_ROWS && h <= left; ++h) {
+        current->heights[col] = h;
+        collect_heights(col + 1, left - h, current, out, count, cap);
+    }
+}
+
+typedef struct {
+    int cells[CELLS];
+    int cell_count;
+    uint64_t sentinels;
+    KeyBuffer *found;
+} Filler;
+
+static void fill_cells(const Filler *f, int index, uint64_t mover, uint64_t other, int mover_left, int other_left) {
+    uint64_t bit;
+
+    if (index == f->cell_count) {
+        uint64_t key = mover | f->sentinels;
+        if (key <= cf_mirror_key(key)) {
+            key_buffer_push(f->found, key);
+        }
+        return;
+    }
+
+    bit = UINT64_C(1) << f->cells[index];
+
+    if (mover_left > 0 && !bb_has_four(mover | bit)) {
+        fill_cells(f, index + 1, mover | bit, other, mover_left - 1, other_left);
+    }
+    if (other_left > 0 && !bb_has_four(other | bit)) {
+        fill_cells(f, index + 1, mover, other | bit, mover_left, other_left - 1);
+    }
+}
+
+static void *enumerate_worker(void *arg) {
+    Worker *worker = arg;
+    LayerJob *job = worker->job;
+
+    while (true) {
+        size_t idx = atomic_fetch_add(&job->next_vector, 1);
+        const HeightVector *hv;
+        Filler filler;
+
+        if (idx >= job->vector_count) {
+            break;
+        }
+
+        hv = &job->vectors[idx];
+        filler.cell_count = 0;
+        filler.sentinels = 0;
+        filler.found = &worker->found;
+
+        for (int col = 0; col < CF_COLS; ++col) {
+            for (int row = 0; row < hv->heights[col]; ++row) {
+                filler.cells[filler.cell_count++] = col * COL_BITS + row;
+            }
+            filler.sentinels |= UINT64_C(1) << (col * COL_BITS + hv->heights[col]);
+        }
+
+        fill_cells(&filler, 0, 0, 0, job->stones / 2, job->stones - job->stones / 2);
+    }
+
+    return NULL;
+}
+
+/* --------------------- Solving --------------------- */
+static int value_rank(CfTbValue value) {
+    if (value.result == CF_TB_WIN) {
+        return 1000 - value.distance;
+    }
+    if (value.result == CF_TB_LOSS) {
+        return -1000 + value.distance;
+    }
+    return 0;
+}
+
+static bool solve_key(const LayerJob *job, uint64_t key, uint8_t *out) {
+    const uint64_t column_bits = (UINT64_C(1) << COL_BITS) - 1;
+    uint64_t mover = 0;
+    uint64_t mask = 0;
+    int heights[CF_COLS];
+    CfTbValue best = {CF_TB_LOSS, 0};
+    bool have_best = false;
+
+    for (int col = 0; col < CF_COLS; ++col) {
+        uint64_t bits = (key >> (col * COL_BITS)) & column_bits;
+        int height = 0;
+
+        while ((bits >> (height + 1)) != 0) {
+            height += 1;
+        }
+        heights[col] = height;
+        mover |= (bits & ((UINT64_C(1) << height) - 1)) << (col * COL_BITS);
+        mask |= ((UINT64_C(1) << height) - 1) << (col * COL_BITS);
+    }
+
+    for (int col = 0; col < CF_COLS; ++col) {
+        uint64_t bit;
+        CfTbValue candidate;
+
+        if (heights[col] >= CF_ROWS) {
+            continue;
+        }
+
+        bit = UINT64_C(1) << (col * COL_BITS + heights[col]);
+        if (bb_has_four(mover | bit)) {
+            candidate.result = CF_TB_WIN;
+            candidate.distance = 1;
+        } else if (job->stones + 1 == CELLS) {
+            candidate.result = CF_TB_DRAW;
+            candidate.distance = 1;
+        } else {
+            uint64_t child_mask = mask | bit;
+            uint64_t child_key = cf_canonical_key((mask ^ mover) + child_mask + bottom_mask());
+            uint8_t packed;
+            CfTbValue child;
+
+            if (!layer_lookup(job->next_layer, child_key, &packed)) {
+                return false;
+            }
+
+            child = cf_tb_unpack_value(packed);
+            candidate.distance = child.distance + 1;
+            if (child.result == CF_TB_WIN) {
+                candidate.result = CF_TB_LOSS;
+            } else if (child.result == CF_TB_LOSS) {
+                candidate.result = CF_TB_WIN;
+            } else {
+                candidate.result = CF_TB_DRAW;
+            }
+        }
+
+        if (!have_best || value_rank(candidate) > value_rank(best)) {
+            best = candidate;
+            have_best = true;
+        }
+    }
+
+    *out = cf_tb_pack_value(best);
+    return have_best;
+}
+
+static void *solve_worker(void *arg) {
+    Worker *worker = arg;
+    LayerJob *job = worker->job;
+    LayerTable *layer = job->layer;
+
+    while (true) {
+        size_t start = atomic_fetch_add(&job->next_chunk, SOLVE_CHUNK);
+        size_t end;
+
+        if (start >= layer->count) {
+            break;
+        }
+        end = start + SOLVE_CHUNK;
+        if (end > layer->count) {
+            end = layer->count;
+        }
+
+        for (size_t i = start; i < end; ++i) {
+            if (!solve_key(job, layer->keys[i], &layer->values[i])) {
+                worker->found.failed = true;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static bool run_workers(LayerJob *job, Worker *workers, int threads, void *(*fn)(void *)) {
+    pthread_t ids[MAX_THREADS];
+    int started = 0;
+    bool ok = true;
+
+    for (int i = 0; i < threads; ++i) {
+        workers[i].job = job;
+        if (pthread_create(&ids[i], NULL, fn, &workers[i]) != 0) {
+            ok = false;
+            break;
+        }
+        started += 1;
+    }
+    for (int i = 0; i < started; ++i) {
+        pthread_join(ids[i], NULL);
+    }
+    if (started == 0) {
+        return false;
+    }
+    for (int i = 0; i < threads; ++i) {
+        if (workers[i].found.failed) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static bool build_layer(const GenOptions *opts, int stones, const LayerTable *next_layer, LayerTable *out) {
+    Worker workers[MAX_THREADS];
+    HeightVector current;
+    HeightVector *vectors = NULL;
+    size_t vector_count = 0;
+    size_t vector_cap = 0;
+    LayerJob job;
+    size_t total = 0;
+    bool ok;
+
+    memset(workers, 0, sizeof(workers));
+    memset(&current, 0, sizeof(current));
+    collect_heights(0, stones, &current, &vectors, &vector_count, &vector_cap);
+
+    memset(&job, 0, sizeof(job));
+    job.stones = stones;
+    job.vectors = vectors;
+    job.vector_count = vector_count;
+    job.next_layer = next_layer;
+    atomic_init(&job.next_vector, 0);
+    atomic_init(&job.next_chunk, 0);
+
+    ok = run_workers(&job, workers, opts->threads, enumerate_worker);
+    free(vectors);
+
+    for (int i = 0; i < opts->threads; ++i) {
+        total += workers[i].found.count;
+    }
+
+    memset(out, 0, sizeof(*out));
+    if (ok) {
+        out->keys = malloc((total ? total : 1) * sizeof(uint64_t));
+        out->values = malloc(total ? total : 1);
+        ok = out->keys != NULL && out->values != NULL;
+    }
+    for (int i = 0; i < opts->threads; ++i) {
+        if (ok) {
+            memcpy(out->keys + out->count, workers[i].found.keys, workers[i].found.count * sizeof(uint64_t));
+            out->count += workers[i].found.count;
+        }
+        free(workers[i].found.keys);
+        memset(&workers[i].found, 0, sizeof(workers[i].found));
+    }
+
+    ok = ok && radix_sort_keys(out->keys, out->count);
+    job.layer = out;
+    ok = ok && run_workers(&job, workers, opts->threads, solve_worker);
+
+    if (!ok) {
+        layer_free(out);
+    }
+    return ok;
+}
+
+/* --------------------- Output --------------------- */
+static bool write_table(const GenOptions *opts) {
+    LayerTable layers[CELLS];
+    size_t cursors[CELLS];
+    int layer_count = opts->max_empties;
+    CfTbWriter *writer;
+    size_t written = 0;
+    bool ok = true;
+
+    memset(layers, 0, sizeof(layers));
+    memset(cursors, 0, sizeof(cursors));
+
+    for (int i = 0; i < layer_count; ++i) {
+        if (!layer_load(opts, CELLS - 1 - i, &layers[i])) {
+            fprintf(stderr, "tbgen: missing checkpoint for layer %d\n", CELLS - 1 - i);
+            ok = false;
+        }
+    }
+
+    writer = ok ? cf_tablebase_writer_open(opts->out_path, opts->max_empties) : NULL;
+    if (writer == NULL) {
+        ok = false;
+    }
+
+    /* Layers are disjoint (the key encodes column heights), so a k-way merge keeps keys unique. */
+    while (ok) {
+        int pick = -1;
+
+        for (int i = 0; i < layer_count; ++i) {
+            if (cursors[i] < layers[i].count &&
+                (pick < 0 || layers[i].keys[cursors[i]] < layers[pick].keys[cursors[pick]])) {
+                pick = i;
+            }
+        }
+        if (pick < 0) {
+            break;
+        }
+
+        ok = cf_tablebase_writer_add(writer, layers[pick].keys[cursors[pick]], layers[pick].values[cursors[pick]]);
+        cursors[pick] += 1;
+        written += 1;
+    }
+
+    if (writer != NULL && !cf_tablebase_writer_finish(writer)) {
+        ok = false;
+    }
+    for (int i = 0; i < layer_count; ++i) {
+        layer_free(&layers[i]);
+    }
+
+    if (ok) {
+        printf("tbgen: wrote %zu positions to %s\n", written, opts->out_path);
+    }
+    return ok;
+}
+
+static int generate(const GenOptions *opts) {
+    LayerTable next_layer;
+    double started = now_seconds();
+
+    memset(&next_layer, 0, sizeof(next_layer));
+
+    if (mkdir(opts->work_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "tbgen: cannot create %s: %s\n", opts->work_dir, strerror(errno));
+        return 1;
+    }
+
+    for (int stones = CELLS - 1; stones >= CELLS - opts->max_empties; --stones) {
+        LayerTable layer;
+        double layer_started = now_seconds();
+
+        if (layer_load(opts, stones, &layer)) {
+            printf("tbgen: layer %2d resumed from checkpoint (%zu positions)\n", stones, layer.count);
+        } else {
+            if (!build_layer(opts, stones, &next_layer, &layer)) {
+                fprintf(stderr, "tbgen: failed to build layer %d\n", stones);
+                layer_free(&next_layer);
+                return 1;
+            }
+            if (!layer_save(opts, stones, &layer)) {
+                fprintf(stderr, "tbgen: failed to checkpoint layer %d\n", stones);
+                layer_free(&layer);
+                layer_free(&next_layer);
+                return 1;
+            }
+            printf(
+                "tbgen: layer %2d solved: %zu positions in %.1fs\n",
+                stones,
+                layer.count,
+                now_seconds() - layer_started
+            );
+        }
+        fflush(stdout);
+
+        layer_free(&next_layer);
+        next_layer = layer;
+    }
+
+    layer_free(&next_layer);
+
+    if (!write_table(opts)) {
+        fprintf(stderr, "tbgen: failed to write %s\n", opts->out_path);
+        return 1;
+    }
+
+    printf("tbgen: done in %.1fs\n", now_seconds() - started);
+    return 0;
+}
+
+/* --------------------- Check --------------------- */
+static uint64_t check_next(uint64_t *state) {
+    uint64_t z = (*state += UINT64_C(0x9e3779b97f4a7c15));
+
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+
+/* A random game with no four on the board and CF_AI to move, stopped with `empties` cells left; `moves` gets its columns. */
+static bool check_position(uint64_t *state, int empties, CfGame *game, char moves[CELLS + 1]) {
+    CfCell piece = (CELLS - empties) % 2 == 0 ? CF_AI : CF_HUMAN;
+
+    cf_init(game);
+    while (game->moves < CELLS - empties) {
+        int cols[CF_COLS];
+        int count = 0;
+        int col;
+
+        for (int c = 0; c < CF_COLS; ++c) {
+            if (cf_is_valid_move(game, c)) {
+                cols[count++] = c;
+            }
+        }
+        col = cols[check_next(state) % (uint64_t)count];
+        moves[game->moves] = (char)('1' + col);
+        moves[game->moves + 1] = '\0';
+        cf_drop_piece(game, col, piece);
+        if (cf_has_winner(game, piece)) {
+            return false;
+        }
+        piece = piece == CF_AI ? CF_HUMAN : CF_AI;
+    }
+    return true;
+}
+
+/* What dropping CF_AI into `col` leads to for CF_AI: 1 win, 0 draw, -1 loss; 2 when the table lacks it. */
+static int check_outcome(const CfTablebase *tb, CfGame *game, int col) {
+    CfTbValue value;
+    int outcome = 2;
+
+    cf_drop_piece(game, col, CF_AI);
+    if (cf_has_winner(game, CF_AI)) {
+        outcome = 1;
+    } else if (game->moves == CELLS) {
+        outcome = 0;
+    } else if (cf_tablebase_probe(tb, game, CF_HUMAN, &value)) {
+        outcome = value.result == CF_TB_DRAW ? 0 : (value.result == CF_TB_WIN ? -1 : 1);
+    }
+    cf_undo_piece(game, col);
+    return outcome;
+}
+
+static int check_table(const GenOptions *opts) {
+    static const char *const kPaths[2] = {"search", "choose"};
+    CfTablebase *tb = cf_tablebase_open(opts->check_path);
+    CfAiTables with = {tb, NULL};
+    CfAiTables without = {NULL, NULL};
+    uint64_t state = UINT64_C(0x5eed);
+    int checked = 0;
+    int failures = 0;
+    int max_empties;
+
+    if (tb == NULL) {
+        fprintf(stderr, "tbgen: cannot open table %s\n", opts->check_path);
+        return 1;
+    }
+    max_empties = cf_tablebase_max_empties(tb);
+    printf("tbgen: checking %s (up to %d empties) on %d positions\n", opts->check_path, max_empties, opts->check_positions);
+
+    while (checked < opts->check_positions) {
+        int empties = 1 + (int)(check_next(&state) % (uint64_t)max_empties);
+        CfSearchLimits limits = {empties, 0, 0};
+        CfGame game;
+        char moves[CELLS + 1];
+
+        if (!check_position(&state, empties, &game, moves)) {
+            continue;
+        }
+        checked += 1;
+
+        /* The engine's search and the game's move choice each take the table their own way. */
+        for (int path = 0; path < 2; ++path) {
+            CfGame a = game;
+            CfGame b = game;
+            int move_with;
+            int move_without;
+            int outcome_with;
+            int outcome_without;
+
+            if (path == 0) {
+                move_with = cf_ai_search_with(&with, &a, NULL, &limits, NULL, NULL, NULL);
+                move_without = cf_ai_search_with(&without, &b, NULL, &limits, NULL, NULL, NULL);
+            } else {
+                move_with = cf_ai_choose_move_with(&with, &a, empties, NULL, 0, NULL);
+                move_without = cf_ai_choose_move_with(&without, &b, empties, NULL, 0, NULL);
+            }
+            outcome_with = check_outcome(tb, &game, move_with);
+            outcome_without = check_outcome(tb, &game, move_without);
+            if (outcome_with != outcome_without) {
+                failures += 1;
+                printf(
+                    "tbgen: %s differs at %s: col %d with the table (outcome %d), col %d without (outcome %d)\n",
+                    kPaths[path],
+                    moves,
+                    move_with + 1,
+                    outcome_with,
+                    move_without + 1,
+                    outcome_without
+                );
+            }
+        }
+    }
+
+    cf_tablebase_close(tb);
+    printf("tbgen: %d position(s) checked, %d difference(s)\n", checked, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+static void print_usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-k max_empties] [-t threads] [-o table] [-w work_dir]\n", argv0);
+    fprintf(stderr, "       %s -c table [-n positions]\n", argv0);
+    fprintf(stderr, "  -k  tabulate positions with at most this many empty cells (default %d)\n", DEFAULT_MAX_EMPTIES);
+    fprintf(stderr, "  -t  worker threads (default: online CPUs)\n");
+    fprintf(stderr, "  -o  output table (default connect-four.tb)\n");
+    fprintf(stderr, "  -w  checkpoint directory (default <table>.work)\n");
+    fprintf(stderr, "  -c  check a finished table: moves with and without it must reach the same outcome\n");
+    fprintf(stderr, "  -n  positions to check (default %d)\n", DEFAULT_CHECK_POSITIONS);
+}
+
+int main(int argc, char **argv) {
+    static char default_work_dir[1024];
+    GenOptions opts;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    opts.max_empties = DEFAULT_MAX_EMPTIES;
+    opts.threads = cpus > 0 ? (int)cpus : 1;
+    opts.out_path = "connect-four.tb";
+    opts.work_dir = NULL;
+    opts.check_path = NULL;
+    opts.check_positions = DEFAULT_CHECK_POSITIONS;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (value == NULL) {
+            print_usage(argv[0]);
+            return 2;
+        }
+
+        if (strcmp(arg, "-k") == 0) {
+            opts.max_empties = atoi(value);
+        } else if (strcmp(arg, "-t") == 0) {
+            opts.threads = atoi(value);
+        } else if (strcmp(arg, "-o") == 0) {
+            opts.out_path = value;
+        } else if (strcmp(arg, "-w") == 0) {
+            opts.work_dir = value;
+        } else if (strcmp(arg, "-c") == 0) {
+            opts.check_path = value;
+        } else if (strcmp(arg, "-n") == 0) {
+            opts.check_positions = atoi(value);
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+        i += 1;
+    }
+
+    if (opts.check_path != NULL) {
+        return check_table(&opts);
+    }
+    if (opts.max_empties < 1 || opts.max_empties > CELLS - 1) {
+        fprintf(stderr, "tbgen: -k must be between 1 and %d\n", CELLS - 1);
+        return 2;
+    }
+    if (opts.threads < 1) {
+        opts.threads = 1;
+    }
+    if (opts.threads > MAX_THREADS) {
+        opts.threads = MAX_THREADS;
+    }
+    if (opts.work_dir == NULL) {
+        snprintf(default_work_dir, sizeof(default_work_dir), "%s.work", opts.out_path);
+        opts.work_dir = default_work_dir;
+    }
+
+    printf(
+        "tbgen: %dx%d board, up to %d empties, %d thread(s), checkpoints in %s\n",
+        CF_ROWS,
+        CF_COLS,
+        opts.max_empties,
+        opts.threads,
+        opts.work_dir
+    );
+    return generate(&opts);
+}
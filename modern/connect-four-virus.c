@@ -1,4 +1,4 @@
-#include <ncurses.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -9,26 +9,200 @@
 
 #include "connect_four.h"
 #include "connect_four_ai.h"
+#include "connect_four_client.h"
+#include "connect_four_corpus.h"
+#include "connect_four_engine.h"
+#include "connect_four_events.h"
+#include "connect_four_feed.h"
+#include "connect_four_gamedb.h"
+#include "connect_four_log.h"
+#include "connect_four_meta.h"
+#include "connect_four_metrics.h"
+#include "connect_four_miner.h"
+#include "connect_four_render.h"
+#include "connect_four_replay.h"
+#include "connect_four_rng.h"
+#include "connect_four_trace.h"
 
 enum {
-    VM_LOG_LINES = 8,
-    VM_LOG_CHARS = 100,
+    VM_LOG_CAPACITY = 4096,
+    LOG_SINK_MAX_BYTES = 1 << 20,
+    LOG_SINK_KEEP_FILES = 3,
     LOSS_MSG_CHARS = 96,
-    INCIDENT_TYPES = 6,
     AUTO_RESTART_SECONDS = 3,
     MINING_ROUND_SECONDS = 6,
-    PHISHING_QUESTIONS = 3
+    MINING_BASE_BITS = 4,
+    PHISHING_QUESTIONS = 3,
+    SERVER_DEADLINE_MS = 1500,
+    ENGINE_WORKERS = 2,
+    METRICS_INTERVAL_MS = 1000,
+    SPINNER_FRAME_MS = 250,
+    AI_THINK_MS = 220,
+    HIJACK_PAUSE_MS = 180
 };
 
+/* Render state pieces; each has a generation counter bumped on every change. */
 enum {
-    INCIDENT_NVIR = 1,
-    INCIDENT_MDEF,
-    INCIDENT_WDEF,
-    INCIDENT_MACRO,
-    INCIDENT_AUTOSTART,
-    INCIDENT_SEVENDUST
+    RENDER_BOARD,
+    RENDER_CURSOR,
+    RENDER_STATUS,
+    RENDER_LOGS,
+    RENDER_EFFECTS,
+    RENDER_SCENE, /* scene phase, typed name, mini-game progress: drawn by the scene itself, published to spectators */
+    RENDER_PARTS
 };
 
+/* Main-loop timers; a due time of 0 means disarmed. */
+enum {
+    TIMER_AUTO_RESTART,
+    TIMER_SPINNER,
+    TIMER_ANIMATION,
+    TIMER_TURN,
+    TIMER_COUNT
+};
+
+/* Full-screen effects that take over the terminal; see the Animation section. */
+enum {
+    SCENE_NONE,
+    SCENE_INTRO,
+    SCENE_INCIDENT,
+    SCENE_SQUIGGLES,
+    SCENE_MINING,
+    SCENE_PHISHING,
+    SCENE_KINDS
+};
+
+/* Who the board is waiting on. The last two only end through TIMER_TURN or the AI thread. */
+enum {
+    TURN_PLAYER,
+    TURN_HIJACKED,
+    TURN_AI
+};
+
+/* One RNG stream per subsystem, so e.g. a longer loss flood never changes the next round's effects. */
+enum {
+    RNG_EFFECTS,
+    RNG_PUNISHMENTS,
+    RNG_MINIGAMES,
+    RNG_GLITCHES,
+    RNG_COSMETIC,
+    RNG_STREAMS
+};
+
+/* Recorded events (CF_RECORD): timer ticks that changed state, and keys as REC_KEY + CF_KEY_* (curses) code. */
+enum {
+    REC_TICK,
+    REC_TICK_AI,
+    REC_KEY
+};
+
+#define RENDER_BOARD_PARTS ((1u << RENDER_BOARD) | (1u << RENDER_CURSOR) | (1u << RENDER_STATUS) | (1u << RENDER_EFFECTS))
+#define RENDER_CONSOLE_PARTS ((1u << RENDER_LOGS) | (1u << RENDER_EFFECTS))
+
+/* Every field stays NULL (and every update a no-op) unless CF_METRICS is set. */
+typedef struct {
+    CfMetrics *registry;
+    CfMetric *rounds;
+    CfMetric *wins;
+    CfMetric *losses;
+    CfMetric *compromised;
+    CfMetric *incidents[CF_INCIDENT_TYPES];
+    CfMetric *ai_latency;
+    CfMetric *frame_time;
+    CfMetric *idle_ticks;
+    CfMetric *frames_skipped;
+} GameMetrics;
+
+/*
+ * The running scene. Each one is a small state machine: a phase, an optional
+ * frame period (next_frame_ms) and an optional hold (phase_end_ms). The main
+ * loop calls scene_tick() when either comes due and scene_key() for input,
+ * so nothing in here ever sleeps.
+ */
+typedef struct {
+    int kind;
+    int phase;
+    double frame_ms;
+    double next_frame_ms;
+    double phase_end_ms;
+    double deadline_ms;
+    unsigned long frames;
+
+    int selected;
+    bool name_done;
+    char text[32];
+    int text_len;
+    char message[160];
+
+    int pulses_left;
+    bool pulse_flash;
+    int overlay_y;
+    int severity;
+    int pressure;
+    const char *lines[6];
+
+    bool key_pending;
+    int count;
+    int target;
+    CfMinerStats rig;
+    int question;
+    uint64_t prompt;
+    int choice;
+} Scene;
+
+/* An AI search running on an engine worker; the worker only touches the job. */
+typedef struct {
+    bool running;
+    atomic_bool done;
+    CfGame game;
+    bool blocked_cols[CF_COLS];
+    int depth;
+    CfClient *client;
+    CfEngine *engine;
+    bool client_failed;
+    CfSearchInfo info;
+    uint64_t tt_probes;
+    uint64_t tt_hits;
+} AiJob;
+
+/*
+ * Background warm-up started with the intro: faults in the tablebase and the
+ * transposition table, then searches the positions the first AI move can
+ * come from so that search is answered from the table.
+ */
+typedef struct {
+    bool running;
+    atomic_bool stop;
+    bool presearch;
+    CfMeta meta;
+    CfRoundEffects fx;
+} EngineWarmup;
+
+/* The spectator feed and what it last published; the snapshot is kept here to stay off the stack. */
+typedef struct {
+    CfFeed *feed;
+    unsigned seen[RENDER_PARTS];
+    int scene;
+    int turn;
+    CfFeedSnapshot snap;
+} SpectatorFeed;
+
+/* What is on screen: the renderer, the board and console areas and the generations they were last drawn at. */
+typedef struct {
+    CfRenderer *out;
+    CfRenderArea board;
+    CfRenderArea console; /* no rows when the terminal is too short for it */
+    bool laid_out;
+    int max_y;
+    int max_x;
+    int console_y;
+    unsigned board_seen[RENDER_PARTS];
+    unsigned console_seen[RENDER_PARTS];
+    long board_clock;
+    long console_clock;
+    bool invalid;
+} RenderState;
+
 typedef struct {
     int max_y;
     int max_x;
@@ -44,29 +218,14 @@ typedef struct {
     char loss_msg[LOSS_MSG_CHARS];
     int loss_msg_len;
 
-    char vm_logs[VM_LOG_LINES][VM_LOG_CHARS];
-    int vm_log_count;
+    CfLog *log;
+    uint64_t log_floor;
+    int log_scroll;
     time_t vm_boot_time;
-    unsigned long vm_ticks;
     char vm_current_alert[80];
 
-    int incident_stacks[INCIDENT_TYPES];
-    int last_incident_code;
-    int total_losses;
-    int total_wins;
-    int compromised_pct;
-
-    bool blocked_cols[CF_COLS];
-    int blocked_count;
-    int active_input_glitch_pct;
-    int active_forced_move_pct;
-    int active_control_shift;
-    int active_control_direction;
-    int active_ai_depth_bonus;
-    int active_ai_opening_moves;
-    int active_player_piece_corrupt_pct;
-    int active_flip_turns_remaining;
-    int active_purple_turns_remaining;
+    CfMeta meta;
+    CfRoundEffects fx;
     char effect_summary[220];
 
     char player_name[32];
@@ -74,13 +233,99 @@ typedef struct {
     int desktop_selected_icon;
 
     bool auto_restart_pending;
-    time_t auto_restart_deadline;
+    double timer_due_ms[TIMER_COUNT];
+    bool event_loop;
+
+    uint64_t seed;
+    CfRng rng[RNG_STREAMS];
+    double clock_ms;
+    double clock_origin;
+    CfRecorder *recorder;
+    bool replay_ai_ready;
+
+    Scene scene;
+    unsigned long frames_skipped;
+    int turn;
+    int pending_raw_col;
+    int pending_col;
+    AiJob ai_job;
+    EngineWarmup warmup;
+    CfMiner *miner;
+
+    CfClient *engine_client;
+    CfEngine *engine;
+
+    bool perf_hud;
+    double frame_ms;
+    double loop_rate;
+    unsigned long loop_count;
+    double loop_window_start;
+    bool ai_stats_valid;
+    CfSearchInfo last_ai;
+    uint64_t last_ai_tt_probes;
+    uint64_t last_ai_tt_hits;
+
+    GameMetrics metrics;
+    SpectatorFeed spectators;
+    CfGameDb *gamedb;
+    CfGameRecord round_record;
+    CfCorpus *corpus;
+    CfShuffle corpus_shuffle;
+
+    unsigned render_gen[RENDER_PARTS];
+    RenderState render;
 } AppState;
 
 static void arm_auto_restart(AppState *s);
+static bool maybe_start_intermission_minigame(AppState *s);
+
+/* Set for replays: the clock only moves when an event says so (and the screen is the null renderer). */
+static bool g_headless = false;
 
-static unsigned int make_seed(void) {
-    return (unsigned int)time(NULL) ^ (unsigned int)getpid();
+static uint64_t make_seed(void) {
+    const char *fixed = getenv("CF_SEED");
+
+    if (fixed != NULL && fixed[0] != '\0') {
+        return strtoull(fixed, NULL, 0);
+    }
+    return ((uint64_t)time(NULL) << 20) ^ (uint64_t)getpid();
+}
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* usleep() that shows up as a slice in traces, so animation stalls are visible. */
+static void vm_sleep(useconds_t usec) {
+    CF_TRACE_BEGIN("sleep");
+    usleep(usec);
+    CF_TRACE_END("sleep");
+}
+
+/* Whole milliseconds since the session started. Game logic reads s->clock_ms, set from this per event. */
+static double session_now(const AppState *s) {
+    if (g_headless) {
+        return s->clock_ms;
+    }
+    return (double)(long long)(monotonic_ms() - s->clock_origin);
+}
+
+static void ui_beep(AppState *s) {
+    cf_render_beep(s->render.out);
+}
+
+static void ui_flash(AppState *s) {
+    cf_render_flash(s->render.out);
+}
+
+static void ui_flush_input(AppState *s) {
+    cf_render_flush_input(s->render.out);
+}
+
+static void ui_cursor(AppState *s, bool visible) {
+    cf_render_cursor(s->render.out, visible);
 }
 
 static int clamp_int(int value, int lo, int hi) {
@@ -103,56 +348,47 @@ static int normalize_col(int col) {
     return col;
 }
 
-static int random_color_pair(int color_count) {
-    return (color_count > 0) ? (rand() % color_count) + 1 : 0;
+static int roll(AppState *s, int stream, int bound) {
+    return cf_rng_below(&s->rng[stream], bound);
 }
 
-static void app_update_dimensions(AppState *s) {
-    getmaxyx(stdscr, s->max_y, s->max_x);
+static int random_color_pair(AppState *s) {
+    return (s->color_count > 0) ? roll(s, RNG_COSMETIC, s->color_count) + 1 : 0;
 }
 
-static int infection_pressure(const AppState *s) {
-    int total = 0;
-
-    for (int i = 0; i < INCIDENT_TYPES; ++i) {
-        total += s->incident_stacks[i];
-    }
+static void app_update_dimensions(AppState *s) {
+    cf_render_size(s->render.out, &s->max_y, &s->max_x);
+}
 
-    return total;
+static CfRenderArea screen_area(const AppState *s) {
+    return (CfRenderArea){0, 0, s->max_y, s->max_x};
 }
 
-static int incident_stack(const AppState *s, int code) {
-    if (code < 1 || code > INCIDENT_TYPES) {
-        return 0;
-    }
-    return s->incident_stacks[code - 1];
+/* Colour plus bold, or plain text on a monochrome terminal. */
+static unsigned color_attr(const AppState *s, int pair) {
+    return s->color_count > 0 ? (unsigned)pair | CF_ATTR_BOLD : 0;
 }
 
-static int max_incident_stack(const AppState *s) {
-    int max_stack = 0;
+static void mark_dirty(AppState *s, int part) {
+    s->render_gen[part] += 1;
+}
 
-    for (int i = 0; i < INCIDENT_TYPES; ++i) {
-        if (s->incident_stacks[i] > max_stack) {
-            max_stack = s->incident_stacks[i];
-        }
-    }
+/* For code that painted the whole screen (overlays, minigames): repaint both areas next frame. */
+static void render_invalidate(AppState *s) {
+    s->render.invalid = true;
+}
 
-    return max_stack;
+static int infection_pressure(const AppState *s) {
+    return cf_meta_pressure(&s->meta);
 }
 
-static int compromised_floor(const AppState *s) {
-    int pressure = infection_pressure(s);
-    int max_stack = max_incident_stack(s);
-    int floor_pct = pressure * 4 + max_stack * 5;
-    return clamp_int(floor_pct, 0, 96);
+static int incident_stack(const AppState *s, int code) {
+    return cf_meta_stack(&s->meta, code);
 }
 
 static void sync_compromised_floor(AppState *s) {
-    int floor_pct = compromised_floor(s);
-    if (s->compromised_pct < floor_pct) {
-        s->compromised_pct = floor_pct;
-    }
-    s->compromised_pct = clamp_int(s->compromised_pct, 0, 100);
+    cf_meta_sync_floor(&s->meta);
+    mark_dirty(s, RENDER_EFFECTS);
 }
 
 static const char *display_player_name(const AppState *s) {
@@ -163,81 +399,72 @@ static const char *display_player_name(const AppState *s) {
 }
 
 static void build_player_greeting(const AppState *s, char *buf, size_t cap) {
-    if (s->compromised_pct >= 60) {
+    if (s->meta.compromised_pct >= 60) {
         snprintf(buf, cap, "Hello Loser %s", display_player_name(s));
     } else {
         snprintf(buf, cap, "Hello %s", display_player_name(s));
     }
 }
 
-static void nc_init(AppState *s) {
-    initscr();
-    cbreak();
-    noecho();
-    keypad(stdscr, true);
-    nodelay(stdscr, true);
-    curs_set(0);
-
-    s->color_count = 0;
-    if (has_colors()) {
-        start_color();
-        use_default_colors();
+/* CF_RENDER picks the backend; curses unless it names another. */
+static bool screen_open(AppState *s) {
+    const char *name = getenv("CF_RENDER");
+    CfRenderBackend backend = CF_RENDER_NCURSES;
 
-        init_pair(1, COLOR_RED, -1);
-        init_pair(2, COLOR_YELLOW, -1);
-        init_pair(3, COLOR_CYAN, -1);
-        init_pair(4, COLOR_GREEN, -1);
-        init_pair(5, COLOR_MAGENTA, -1);
-        init_pair(6, COLOR_BLUE, -1);
-        init_pair(7, COLOR_WHITE, -1);
-        s->color_count = 7;
+    if (name != NULL && name[0] != '\0' && !cf_render_backend_parse(name, &backend)) {
+        fprintf(stderr, "connect-four-virus: unknown CF_RENDER backend %s (ncurses, null, ansi)\n", name);
+        return false;
     }
-
-    erase();
-    refresh();
-}
-
-static void nc_shutdown(void) {
-    endwin();
+    s->render.out = cf_render_open(backend);
+    if (s->render.out == NULL) {
+        fprintf(stderr, "connect-four-virus: cannot open the %s renderer\n", cf_render_backend_name(backend));
+        return false;
+    }
+    s->color_count = cf_render_colors(s->render.out);
+    return true;
 }
 
+/* Starts the live view afresh; older lines stay in the scrollback. */
 static void vm_clear_logs(AppState *s) {
-    memset(s->vm_logs, 0, sizeof(s->vm_logs));
-    s->vm_log_count = 0;
+    s->log_floor = cf_log_count(s->log);
+    s->log_scroll = 0;
+    mark_dirty(s, RENDER_LOGS);
 }
 
 static void vm_add_log(AppState *s, const char *fmt, ...) {
     va_list args;
-    char line[VM_LOG_CHARS];
+    char line[CF_LOG_CHARS];
 
     va_start(args, fmt);
     vsnprintf(line, sizeof(line), fmt, args);
     va_end(args);
 
-    if (s->vm_log_count < VM_LOG_LINES) {
-        snprintf(s->vm_logs[s->vm_log_count], VM_LOG_CHARS, "%s", line);
-        s->vm_log_count += 1;
-        return;
+    cf_log_append(s->log, line);
+    /* A scrolled-back view stays on the lines it was showing. */
+    if (s->log_scroll > 0) {
+        s->log_scroll += 1;
     }
-
-    memmove(s->vm_logs, s->vm_logs + 1, sizeof(s->vm_logs[0]) * (VM_LOG_LINES - 1));
-    snprintf(s->vm_logs[VM_LOG_LINES - 1], VM_LOG_CHARS, "%s", line);
+    mark_dirty(s, RENDER_LOGS);
 }
 
 static void vm_set_alert(AppState *s, const char *alert, const char *loss_msg) {
     snprintf(s->vm_current_alert, sizeof(s->vm_current_alert), "%s", alert);
     snprintf(s->loss_msg, sizeof(s->loss_msg), "%s", loss_msg);
     s->loss_msg_len = (int)strlen(s->loss_msg);
+    mark_dirty(s, RENDER_LOGS);
+}
+
+static void set_status(AppState *s, const char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(s->status, sizeof(s->status), fmt, args);
+    va_end(args);
+    mark_dirty(s, RENDER_STATUS);
 }
 
 static bool is_playable_col(const AppState *s, int col) {
-    if (col < 0 || col >= CF_COLS) {
-        return false;
-    }
-    if (s->blocked_cols[col]) {
-        return false;
-    }
-    return cf_is_valid_move(&s->game, col);
+    return cf_meta_playable(&s->fx, &s->game, col);
 }
 
 static int find_first_playable_col(const AppState *s) {
@@ -254,11 +481,11 @@ static bool round_is_draw(const AppState *s) {
 }
 
 static bool is_grid_flipped(const AppState *s) {
-    return s->active_flip_turns_remaining > 0;
+    return s->fx.flip_turns_remaining > 0;
 }
 
 static bool is_purple_takeover(const AppState *s) {
-    return s->active_purple_turns_remaining > 0;
+    return s->fx.purple_turns_remaining > 0;
 }
 
 static int logical_col_from_display(const AppState *s, int display_col) {
@@ -268,41 +495,6 @@ static int logical_col_from_display(const AppState *s, int display_col) {
     return (CF_COLS - 1) - display_col;
 }
 
-static int apply_flip_to_drop_col(const AppState *s, int col) {
-    if (!is_grid_flipped(s)) {
-        return col;
-    }
-    return (CF_COLS - 1) - col;
-}
-
-static void choose_blocked_columns(AppState *s, int count) {
-    int pool[CF_COLS];
-
-    memset(s->blocked_cols, 0, sizeof(s->blocked_cols));
-    s->blocked_count = 0;
-
-    if (count <= 0) {
-        return;
-    }
-
-    for (int i = 0; i < CF_COLS; ++i) {
-        pool[i] = i;
-    }
-
-    for (int i = CF_COLS - 1; i > 0; --i) {
-        int j = rand() % (i + 1);
-        int tmp = pool[i];
-        pool[i] = pool[j];
-        pool[j] = tmp;
-    }
-
-    count = clamp_int(count, 0, CF_COLS - 1);
-    for (int i = 0; i < count; ++i) {
-        s->blocked_cols[pool[i]] = true;
-        s->blocked_count += 1;
-    }
-}
-
 static void append_effect_segment(char *dst, size_t cap, bool *first, const char *segment) {
     size_t len = strlen(dst);
 
@@ -324,140 +516,292 @@ static void build_effect_summary(AppState *s) {
 
     snprintf(s->effect_summary, sizeof(s->effect_summary), "Round effects: ");
 
-    if (infection_pressure(s) == 0 && s->compromised_pct == 0) {
+    if (infection_pressure(s) == 0 && s->meta.compromised_pct == 0) {
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, "clean boot");
         return;
     }
 
-    if (s->active_input_glitch_pct > 0) {
-        snprintf(piece, sizeof(piece), "nVIR jitter %d%%", s->active_input_glitch_pct);
+    if (s->fx.input_glitch_pct > 0) {
+        snprintf(piece, sizeof(piece), "nVIR jitter %d%%", s->fx.input_glitch_pct);
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, piece);
     }
-    if (s->active_forced_move_pct > 0) {
-        snprintf(piece, sizeof(piece), "forced move %d%%", s->active_forced_move_pct);
+    if (s->fx.forced_move_pct > 0) {
+        snprintf(piece, sizeof(piece), "forced move %d%%", s->fx.forced_move_pct);
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, piece);
     }
-    if (s->active_control_shift > 0) {
-        snprintf(piece, sizeof(piece), "MDEF remap %c%d", s->active_control_direction > 0 ? '+' : '-', s->active_control_shift);
+    if (s->fx.control_shift > 0) {
+        snprintf(piece, sizeof(piece), "MDEF remap %c%d", s->fx.control_direction > 0 ? '+' : '-', s->fx.control_shift);
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, piece);
     }
-    if (s->blocked_count > 0) {
-        snprintf(piece, sizeof(piece), "WDEF locked cols %d", s->blocked_count);
+    if (s->fx.blocked_count > 0) {
+        snprintf(piece, sizeof(piece), "WDEF locked cols %d", s->fx.blocked_count);
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, piece);
     }
-    if (s->active_ai_depth_bonus > 0) {
-        snprintf(piece, sizeof(piece), "Macro AI +%d", s->active_ai_depth_bonus);
+    if (s->fx.ai_depth_bonus > 0) {
+        snprintf(piece, sizeof(piece), "Macro AI +%d", s->fx.ai_depth_bonus);
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, piece);
     }
-    if (s->active_ai_opening_moves > 0) {
-        snprintf(piece, sizeof(piece), "AutoStart opener x%d", s->active_ai_opening_moves);
+    if (s->fx.ai_opening_moves > 0) {
+        snprintf(piece, sizeof(piece), "AutoStart opener x%d", s->fx.ai_opening_moves);
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, piece);
     }
-    if (s->active_player_piece_corrupt_pct > 0) {
-        snprintf(piece, sizeof(piece), "666 corruption %d%%", s->active_player_piece_corrupt_pct);
+    if (s->fx.player_piece_corrupt_pct > 0) {
+        snprintf(piece, sizeof(piece), "666 corruption %d%%", s->fx.player_piece_corrupt_pct);
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, piece);
     }
-    if (s->active_flip_turns_remaining > 0) {
+    if (s->fx.flip_turns_remaining > 0) {
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, "grid flip");
     }
-    if (s->active_purple_turns_remaining > 0) {
+    if (s->fx.purple_turns_remaining > 0) {
         append_effect_segment(s->effect_summary, sizeof(s->effect_summary), &first, "purple takeover");
     }
 }
 
 static int ai_search_depth(const AppState *s) {
-    int depth = 6 + s->active_ai_depth_bonus;
+    return cf_meta_ai_depth(&s->meta, &s->fx);
+}
+
+/* --------------------- Engine warm-up --------------------- */
+static void warmup_search(CfEngine *engine, EngineWarmup *w, const bool blocked_cols[CF_COLS]) {
+    int depth = cf_meta_ai_depth(&w->meta, &w->fx);
+    CfGame game;
 
-    if (infection_pressure(s) >= 12 || s->compromised_pct >= 70) {
-        depth += 1;
+    cf_init(&game);
+    for (int i = 0; i < w->fx.ai_opening_moves && !atomic_load(&w->stop); ++i) {
+        int col = cf_engine_choose_move(engine, &game, depth, blocked_cols, 0, NULL);
+        if (col < 0) {
+            return;
+        }
+        cf_drop_piece(&game, col, CF_AI);
     }
 
-    return clamp_int(depth, 6, 8);
-}
+    /* The first search the player waits on is the reply to their first move. */
+    for (int col = 0; col < CF_COLS && !atomic_load(&w->stop); ++col) {
+        CfGame reply = game;
 
-static void apply_round_effects(AppState *s) {
-    int nvir = incident_stack(s, INCIDENT_NVIR);
-    int mdef = incident_stack(s, INCIDENT_MDEF);
-    int wdef = incident_stack(s, INCIDENT_WDEF);
-    int macro = incident_stack(s, INCIDENT_MACRO);
-    int autostart = incident_stack(s, INCIDENT_AUTOSTART);
-    int sevendust = incident_stack(s, INCIDENT_SEVENDUST);
-    int pressure = infection_pressure(s);
-    int compromised = s->compromised_pct;
-    int blocked_count;
+        if (blocked_cols[col] || !cf_is_valid_move(&reply, col)) {
+            continue;
+        }
+        cf_drop_piece(&reply, col, CF_HUMAN);
+        if (!cf_has_winner(&reply, CF_HUMAN)) {
+            cf_engine_choose_move(engine, &reply, depth, blocked_cols, 0, NULL);
+        }
+    }
+}
 
-    memset(s->blocked_cols, 0, sizeof(s->blocked_cols));
-    s->blocked_count = 0;
-    s->active_input_glitch_pct = 0;
-    s->active_forced_move_pct = 0;
-    s->active_control_shift = 0;
-    s->active_control_direction = 1;
-    s->active_ai_depth_bonus = 0;
-    s->active_ai_opening_moves = 0;
-    s->active_player_piece_corrupt_pct = 0;
-    s->active_flip_turns_remaining = 0;
-    s->active_purple_turns_remaining = 0;
+static int mask_bits(unsigned mask) {
+    int bits = 0;
 
-    s->active_input_glitch_pct = clamp_int(nvir * 10 + pressure / 4 + compromised / 8, 0, 72);
-    if (compromised >= 35) {
-        s->active_forced_move_pct = clamp_int((compromised - 30) / 2 + nvir * 6, 0, 68);
+    for (; mask != 0; mask &= mask - 1) {
+        bits += 1;
     }
+    return bits;
+}
 
-    if (mdef > 0) {
-        s->active_control_shift = (mdef >= 3 || compromised >= 80) ? 2 : 1;
-        s->active_control_direction = (rand() % 2 == 0) ? 1 : -1;
-    }
+static void warmup_task(CfEngine *engine, void *arg) {
+    EngineWarmup *w = arg;
 
-    blocked_count = clamp_int(wdef, 0, 2);
-    if (pressure >= 14 && blocked_count < 2 && wdef > 0) {
-        blocked_count += 1;
+    CF_TRACE_BEGIN("engine_warmup");
+    cf_engine_prefault(engine);
+    if (w->presearch) {
+        /* The predicted mask first, then every other mask with as many locked columns. */
+        warmup_search(engine, w, w->fx.blocked_cols);
+        for (unsigned mask = 0; mask < (1u << CF_COLS) && !atomic_load(&w->stop); ++mask) {
+            bool blocked_cols[CF_COLS];
+            bool same = true;
+
+            if (mask_bits(mask) != w->fx.blocked_count) {
+                continue;
+            }
+            for (int col = 0; col < CF_COLS; ++col) {
+                blocked_cols[col] = (mask >> col) & 1u;
+                same = same && blocked_cols[col] == w->fx.blocked_cols[col];
+            }
+            if (!same) {
+                warmup_search(engine, w, blocked_cols);
+            }
+        }
     }
-    if (compromised >= 88 && blocked_count < 3 && wdef > 0) {
-        blocked_count += 1;
+    CF_TRACE_END("engine_warmup");
+}
+
+/*
+ * The first round's depth, openers and number of locked columns follow from
+ * the meta state; which columns lock is the only random part, and rolling a
+ * copy of the effects stream predicts it without drawing from the real one.
+ * With the analysis server connected the local search is only a fallback,
+ * so just the tables are warmed.
+ */
+static void warmup_start(AppState *s) {
+    EngineWarmup *w = &s->warmup;
+    CfRng effects = s->rng[RNG_EFFECTS];
+
+    w->presearch = s->engine_client == NULL;
+    w->meta = s->meta;
+    cf_meta_begin(&w->meta);
+    cf_meta_roll_effects(&w->meta, &effects, &w->fx);
+    atomic_store(&w->stop, false);
+    w->running = cf_engine_post(s->engine, warmup_task, w);
+}
+
+/* Lets the search in progress finish but starts no more; the real game has taken over. */
+static void warmup_stop(AppState *s) {
+    atomic_store(&s->warmup.stop, true);
+}
+
+static void warmup_join(AppState *s) {
+    if (s->warmup.running) {
+        warmup_stop(s);
+        cf_engine_wait(s->engine);
+        s->warmup.running = false;
     }
-    choose_blocked_columns(s, blocked_count);
+}
 
-    s->active_ai_depth_bonus = clamp_int(macro + (compromised >= 75 ? 1 : 0), 0, 2);
+static void ai_job_prepare(AppState *s, AiJob *job) {
+    job->game = s->game;
+    memcpy(job->blocked_cols, s->fx.blocked_cols, sizeof(job->blocked_cols));
+    job->depth = ai_search_depth(s);
+    job->client = s->engine_client;
+    job->engine = s->engine;
+    job->client_failed = false;
+}
 
-    if (autostart >= 1) {
-        s->active_ai_opening_moves = 1;
+/* Uses the shared analysis server when connected; on failure searches locally. */
+static void ai_job_search(AiJob *job) {
+    CfTtStats before;
+    CfTtStats after;
+
+    if (job->client != NULL) {
+        if (cf_client_choose_move(
+                job->client,
+                &job->game,
+                job->depth,
+                job->blocked_cols,
+                SERVER_DEADLINE_MS,
+                &job->info
+            )) {
+            /* The server's table is not visible from here. */
+            job->tt_probes = 0;
+            job->tt_hits = 0;
+            return;
+        }
+        job->client_failed = true;
     }
-    if (autostart >= 3) {
-        s->active_ai_opening_moves = 2;
+
+    cf_tt_get_stats(cf_engine_tt(job->engine), &before);
+    cf_engine_choose_move(job->engine, &job->game, job->depth, job->blocked_cols, 0, &job->info);
+    cf_tt_get_stats(cf_engine_tt(job->engine), &after);
+    job->tt_probes = after.probes - before.probes;
+    job->tt_hits = after.hits - before.hits;
+}
+
+/* Back on the main thread: a failed server connection is dropped for good. */
+static int ai_job_apply(AppState *s, const AiJob *job) {
+    if (job->client_failed && s->engine_client == job->client) {
+        cf_client_close(s->engine_client);
+        s->engine_client = NULL;
+        vm_add_log(s, "[NET] Analysis server lost. Using local engine.");
+    }
+    s->last_ai = job->info;
+    s->last_ai_tt_probes = job->tt_probes;
+    s->last_ai_tt_hits = job->tt_hits;
+    s->ai_stats_valid = true;
+    cf_metric_observe(s->metrics.ai_latency, s->last_ai.elapsed_ms / 1000.0);
+    return s->last_ai.best_col;
+}
+
+static int ai_pick_column(AppState *s) {
+    AiJob job;
+
+    memset(&job, 0, sizeof(job));
+    ai_job_prepare(s, &job);
+    ai_job_search(&job);
+    return ai_job_apply(s, &job);
+}
+
+static void ai_job_task(CfEngine *engine, void *arg) {
+    AiJob *job = arg;
+
+    (void)engine;
+    CF_TRACE_BEGIN("ai_job");
+    ai_job_search(job);
+    CF_TRACE_END("ai_job");
+    atomic_store(&job->done, true);
+    cf_events_wake();
+}
+
+/*
+ * Starts the AI's reply on a worker so the loop keeps drawing and reading keys
+ * meanwhile. A replay searches in place: when the move lands is up to the
+ * recording, not to how long the search took.
+ */
+static void ai_job_start(AppState *s) {
+    AiJob *job = &s->ai_job;
+
+    warmup_stop(s);
+    ai_job_prepare(s, job);
+    atomic_store(&job->done, false);
+    if (g_headless || !cf_engine_post(s->engine, ai_job_task, job)) {
+        ai_job_search(job);
+        atomic_store(&job->done, true);
+        return;
     }
-    if (compromised >= 92) {
-        s->active_ai_opening_moves = 2;
+    job->running = true;
+}
+
+static void ai_job_join(AppState *s) {
+    if (s->ai_job.running) {
+        cf_engine_wait(s->engine);
+        s->ai_job.running = false;
     }
+}
 
-    s->active_player_piece_corrupt_pct = clamp_int(sevendust * 12 + (compromised >= 72 ? 10 : 0), 0, 66);
+static bool ai_job_ready(const AppState *s) {
+    return g_headless ? s->replay_ai_ready : atomic_load(&s->ai_job.done);
+}
 
-    if (compromised >= 50) {
-        int trigger = 14 + compromised / 4 + incident_stack(s, INCIDENT_MDEF) * 5;
-        if ((rand() % 100) < trigger) {
-            s->active_flip_turns_remaining = (compromised >= 85) ? 2 : 1;
-        }
-    }
-    if (compromised >= 58) {
-        int trigger = 10 + compromised / 5 + incident_stack(s, INCIDENT_SEVENDUST) * 5;
-        if ((rand() % 100) < trigger) {
-            s->active_purple_turns_remaining = (compromised >= 85) ? 2 : 1;
-        }
+/* --------------------- Game records --------------------- */
+static void record_round_start(AppState *s) {
+    CfGameRecord *rec = &s->round_record;
+
+    rec->event_count = 0;
+    rec->fx = s->fx;
+    rec->compromised_pct = s->meta.compromised_pct;
+}
+
+static void record_ai_drop(AppState *s, int col) {
+    cf_game_record_event(&s->round_record, CF_EVENT_AI, col, (uint32_t)(s->last_ai.elapsed_ms * 1000.0));
+}
+
+/* Queued for the writer thread; the game never waits on the file. */
+static void record_round_end(AppState *s) {
+    CfGameRecord *rec = &s->round_record;
+
+    if (s->gamedb == NULL) {
+        return;
     }
+    rec->finished_at = (int64_t)time(NULL);
+    rec->outcome = s->winner == 1 ? CF_GAME_WIN : (s->winner == 2 ? CF_GAME_LOSS : CF_GAME_DRAW);
+    cf_gamedb_append(s->gamedb, rec);
+}
+
+static void apply_round_effects(AppState *s) {
+    mark_dirty(s, RENDER_EFFECTS);
+    cf_meta_roll_effects(&s->meta, &s->rng[RNG_EFFECTS], &s->fx);
 
     build_effect_summary(s);
 
-    vm_add_log(s, "[THREAT] Persistent infection pressure: %d.", pressure);
-    vm_add_log(s, "[THREAT] System compromised: %d%%.", compromised);
+    vm_add_log(s, "[THREAT] Persistent infection pressure: %d.", infection_pressure(s));
+    vm_add_log(s, "[THREAT] System compromised: %d%%.", s->meta.compromised_pct);
     vm_add_log(s, "[ROUND] %s", s->effect_summary);
 
-    if (s->blocked_count > 0) {
-        vm_add_log(s, "[WDEF] %d columns quarantined this match.", s->blocked_count);
+    if (s->fx.blocked_count > 0) {
+        vm_add_log(s, "[WDEF] %d columns quarantined this match.", s->fx.blocked_count);
     }
 }
 
 static void vm_boot(AppState *s) {
     s->vm_boot_time = time(NULL);
-    s->vm_ticks = 0;
 
     vm_clear_logs(s);
     vm_set_alert(s, "No active incident.", "You lost to AI!");
@@ -471,46 +815,56 @@ static void vm_boot(AppState *s) {
 static void board_clear(AppState *s) {
     char greeting[96];
 
+    /* A reply still being searched belongs to the old board. */
+    ai_job_join(s);
+    s->turn = TURN_PLAYER;
+    s->timer_due_ms[TIMER_TURN] = 0;
+
     cf_init(&s->game);
     s->cursor_col = CF_COLS / 2;
+    mark_dirty(s, RENDER_BOARD);
+    mark_dirty(s, RENDER_CURSOR);
     s->game_over = false;
     s->winner = 0;
     s->auto_restart_pending = false;
+    s->timer_due_ms[TIMER_AUTO_RESTART] = 0;
     sync_compromised_floor(s);
     build_player_greeting(s, greeting, sizeof(greeting));
-    snprintf(s->status, sizeof(s->status), "%s. Your move.", greeting);
+    set_status(s, "%s. Your move.", greeting);
 
     vm_boot(s);
     apply_round_effects(s);
+    record_round_start(s);
     vm_add_log(
         s,
         "[USER] %s | Record W:%d L:%d | Compromised %d%%",
         greeting,
-        s->total_wins,
-        s->total_losses,
-        s->compromised_pct
+        s->meta.total_wins,
+        s->meta.total_losses,
+        s->meta.compromised_pct
     );
 
-    if (s->active_ai_opening_moves > 0) {
+    if (s->fx.ai_opening_moves > 0) {
         int dropped = 0;
 
-        for (int i = 0; i < s->active_ai_opening_moves; ++i) {
-            int col = cf_ai_choose_move_ex(&s->game, ai_search_depth(s), s->blocked_cols);
+        for (int i = 0; i < s->fx.ai_opening_moves; ++i) {
+            int col = ai_pick_column(s);
             if (col < 0) {
                 break;
             }
 
             cf_drop_piece(&s->game, col, CF_AI);
+            record_ai_drop(s, col);
             dropped += 1;
             vm_add_log(s, "[AUTOSTART] AI opener deployed in column %d.", col + 1);
         }
 
         if (dropped > 0) {
-            snprintf(s->status, sizeof(s->status), "VM boot was compromised. AI opened with %d move(s).", dropped);
+            set_status(s, "VM boot was compromised. AI opened with %d move(s).", dropped);
         }
     }
 
-    if (s->blocked_cols[s->cursor_col] || !is_playable_col(s, s->cursor_col)) {
+    if (s->fx.blocked_cols[s->cursor_col] || !is_playable_col(s, s->cursor_col)) {
         int fallback = find_first_playable_col(s);
         if (fallback >= 0) {
             s->cursor_col = fallback;
@@ -520,201 +874,17 @@ static void board_clear(AppState *s) {
     if (round_is_draw(s)) {
         s->game_over = true;
         s->winner = 0;
-        snprintf(s->status, sizeof(s->status), "No playable columns this round.");
+        set_status(s, "No playable columns this round.");
         arm_auto_restart(s);
     }
 }
 
 static void arm_auto_restart(AppState *s) {
+    cf_metric_add(s->metrics.rounds, 1);
+    record_round_end(s);
+    mark_dirty(s, RENDER_EFFECTS);
     s->auto_restart_pending = true;
-    s->auto_restart_deadline = time(NULL) + AUTO_RESTART_SECONDS;
-}
-
-static void run_mining_minigame(AppState *s) {
-    int hashes = 0;
-    int target = 22 + s->compromised_pct / 8;
-    time_t end_time = time(NULL) + MINING_ROUND_SECONDS;
-    int frame = 0;
-    const char spinner[4] = {'|', '/', '-', '\\'};
-
-    flushinp();
-
-    while (time(NULL) < end_time) {
-        int remaining = (int)(end_time - time(NULL));
-        int ch = getch();
-        int filled = clamp_int((hashes * 24) / target, 0, 24);
-        char bar[25];
-
-        for (int i = 0; i < 24; ++i) {
-            bar[i] = (i < filled) ? '#' : '.';
-        }
-        bar[24] = '\0';
-
-        erase();
-        if (has_colors()) {
-            attron(A_BOLD | COLOR_PAIR(6));
-        } else {
-            attron(A_BOLD);
-        }
-        mvprintw(1, 2, "INTERMISSION MINI-GAME: BITCOIN MINER 0.9");
-        if (has_colors()) {
-            attroff(A_BOLD | COLOR_PAIR(6));
-        } else {
-            attroff(A_BOLD);
-        }
-
-        mvprintw(3, 2, "Mash SPACE to mine blocks before timeout.");
-        mvprintw(4, 2, "Compromised systems need more hashes. Build: [%c]", spinner[frame % 4]);
-        mvprintw(6, 2, "Progress [%s]  %d / %d hashes", bar, hashes, target);
-        mvprintw(7, 2, "Time left: %d sec", remaining);
-        mvprintw(9, 2, "Press SPACE repeatedly. Press any other key to keep going.");
-        refresh();
-
-        if (ch == ' ') {
-            hashes += 1 + (rand() % 2);
-            if ((rand() % 100) < 12) {
-                beep();
-            }
-        }
-
-        if ((rand() % 100) < 4) {
-            hashes += 1;
-        }
-
-        if (hashes >= target) {
-            break;
-        }
-
-        frame += 1;
-        usleep(50000);
-    }
-
-    if (hashes >= target) {
-        int before = s->compromised_pct;
-        s->compromised_pct = clamp_int(s->compromised_pct - 4, 0, 100);
-        sync_compromised_floor(s);
-        vm_add_log(s, "[MINIGAME] Mining success. Compromised %d%% -> %d%%.", before, s->compromised_pct);
-        mvprintw(11, 2, "Success: mined enough blocks. System patched slightly.");
-    } else {
-        int before = s->compromised_pct;
-        s->compromised_pct = clamp_int(s->compromised_pct + 3, 0, 100);
-        vm_add_log(s, "[MINIGAME] Mining failed. Compromised %d%% -> %d%%.", before, s->compromised_pct);
-        mvprintw(11, 2, "Failure: miner overheated. Malware slipped in.");
-    }
-
-    refresh();
-    usleep(1200000);
-}
-
-typedef struct {
-    const char *message;
-    bool phishing;
-} PhishingPrompt;
-
-static void run_phishing_minigame(AppState *s) {
-    static const PhishingPrompt kPrompts[] = {
-        {"'Verify Apple ID now or account deleted in 5 min' from appl3-secure.example", true},
-        {"'Coffee run at 3 PM?' from your teammate", false},
-        {"'Payroll requires your password to release salary' from hr-payfast.biz", true},
-        {"'Meeting moved to tomorrow, same room' from manager", false},
-        {"'Download urgent security patch from random .zip link' from it-support@fake", true},
-        {"'Shared project notes, internal wiki link' from coworker", false}
-    };
-
-    int score = 0;
-    int total = PHISHING_QUESTIONS;
-
-    flushinp();
-
-    for (int q = 0; q < total; ++q) {
-        int idx = rand() % (int)(sizeof(kPrompts) / sizeof(kPrompts[0]));
-        int choice = -1;
-        time_t end_time = time(NULL) + 8;
-
-        while (time(NULL) < end_time && choice < 0) {
-            int remaining = (int)(end_time - time(NULL));
-            int ch = getch();
-
-            erase();
-            if (has_colors()) {
-                attron(A_BOLD | COLOR_PAIR(2));
-            } else {
-                attron(A_BOLD);
-            }
-            mvprintw(1, 2, "INTERMISSION MINI-GAME: PHISHING DETECTOR");
-            if (has_colors()) {
-                attroff(A_BOLD | COLOR_PAIR(2));
-            } else {
-                attroff(A_BOLD);
-            }
-
-            mvprintw(3, 2, "Question %d/%d", q + 1, total);
-            mvprintw(5, 2, "%s", kPrompts[idx].message);
-            mvprintw(7, 2, "Press P = phishing, S = safe");
-            mvprintw(8, 2, "Time left: %d sec", remaining);
-            refresh();
-
-            if (ch == 'p' || ch == 'P') {
-                choice = 1;
-            } else if (ch == 's' || ch == 'S') {
-                choice = 0;
-            }
-
-            usleep(45000);
-        }
-
-        bool correct = false;
-        if (choice >= 0) {
-            bool guessed_phishing = (choice == 1);
-            correct = (guessed_phishing == kPrompts[idx].phishing);
-        }
-
-        erase();
-        if (correct) {
-            score += 1;
-            mvprintw(5, 2, "Correct.");
-            beep();
-        } else {
-            mvprintw(5, 2, "Wrong. That one fooled you.");
-        }
-        refresh();
-        usleep(700000);
-    }
-
-    if (score >= 2) {
-        int before = s->compromised_pct;
-        s->compromised_pct = clamp_int(s->compromised_pct - 3, 0, 100);
-        sync_compromised_floor(s);
-        vm_add_log(s, "[MINIGAME] Phishing drill passed (%d/%d). %d%% -> %d%%.", score, total, before, s->compromised_pct);
-        erase();
-        mvprintw(5, 2, "Drill passed. You avoided most phish.");
-    } else {
-        int before = s->compromised_pct;
-        s->compromised_pct = clamp_int(s->compromised_pct + 3, 0, 100);
-        vm_add_log(s, "[MINIGAME] Phishing drill failed (%d/%d). %d%% -> %d%%.", score, total, before, s->compromised_pct);
-        erase();
-        mvprintw(5, 2, "Drill failed. Several links were clicked.");
-    }
-    refresh();
-    usleep(1200000);
-}
-
-static void maybe_run_intermission_minigame(AppState *s) {
-    int chance = clamp_int(25 + s->compromised_pct / 2, 20, 78);
-
-    if ((rand() % 100) >= chance) {
-        return;
-    }
-
-    vm_add_log(s, "[INTERMISSION] Random mini-game launched.");
-
-    if (rand() % 2 == 0) {
-        run_mining_minigame(s);
-    } else {
-        run_phishing_minigame(s);
-    }
-
-    flushinp();
+    s->timer_due_ms[TIMER_AUTO_RESTART] = s->clock_ms + AUTO_RESTART_SECONDS * 1000.0;
 }
 
 static void process_auto_restart(AppState *s) {
@@ -722,104 +892,57 @@ static void process_auto_restart(AppState *s) {
         return;
     }
 
-    if (time(NULL) < s->auto_restart_deadline) {
+    if (s->clock_ms < s->timer_due_ms[TIMER_AUTO_RESTART]) {
         return;
     }
 
     s->auto_restart_pending = false;
-    maybe_run_intermission_minigame(s);
-    board_clear(s);
+    s->timer_due_ms[TIMER_AUTO_RESTART] = 0;
+    /* A mini-game clears the board itself once it is over. */
+    if (!maybe_start_intermission_minigame(s)) {
+        board_clear(s);
+    }
 }
 
 static void reduce_infection_after_player_win(AppState *s) {
     int before = infection_pressure(s);
-    int before_pct = s->compromised_pct;
+    int before_pct = s->meta.compromised_pct;
 
+    cf_meta_player_won(&s->meta);
+    mark_dirty(s, RENDER_EFFECTS);
     if (before <= 0) {
-        s->total_wins += 1;
-        s->compromised_pct = clamp_int(s->compromised_pct - 2, 0, 100);
         return;
     }
 
-    s->total_wins += 1;
-
-    for (int i = 0; i < INCIDENT_TYPES; ++i) {
-        if (s->incident_stacks[i] > 0) {
-            s->incident_stacks[i] -= 1;
-        }
-    }
-
-    if (s->last_incident_code >= 1 && s->last_incident_code <= INCIDENT_TYPES) {
-        int idx = s->last_incident_code - 1;
-        if (s->incident_stacks[idx] > 0) {
-            s->incident_stacks[idx] -= 1;
-        }
-    }
-
-    s->compromised_pct = clamp_int(s->compromised_pct - 5, 0, 100);
-    sync_compromised_floor(s);
-
     vm_add_log(s, "[AV] Recovery sweep lowered threat %d -> %d.", before, infection_pressure(s));
-    vm_add_log(s, "[AV] Compromised reduced %d%% -> %d%%.", before_pct, s->compromised_pct);
-}
-
-static int remap_drop_col(const AppState *s, int raw_col) {
-    if (s->active_control_shift <= 0) {
-        return raw_col;
-    }
-
-    return normalize_col(raw_col + (s->active_control_direction * s->active_control_shift));
+    vm_add_log(s, "[AV] Compromised reduced %d%% -> %d%%.", before_pct, s->meta.compromised_pct);
 }
 
 static int maybe_glitch_drop_col(AppState *s, int mapped_col) {
-    if (s->active_input_glitch_pct <= 0) {
-        return mapped_col;
-    }
+    int glitched = cf_meta_glitch_col(&s->fx, &s->rng[RNG_GLITCHES], mapped_col);
 
-    if ((rand() % 100) >= s->active_input_glitch_pct) {
+    if (glitched < 0) {
         return mapped_col;
     }
 
-    int drift = (rand() % 2 == 0) ? -1 : 1;
-    if (s->active_input_glitch_pct >= 35 && (rand() % 100) < 35) {
-        drift *= 2;
-    }
-
-    int glitched = normalize_col(mapped_col + drift);
-
-    beep();
+    ui_beep(s);
     vm_add_log(s, "[nVIR] Input glitch rerouted %d -> %d.", mapped_col + 1, glitched + 1);
-    snprintf(s->status, sizeof(s->status), "Virus jitter moved your drop %d -> %d.", mapped_col + 1, glitched + 1);
+    set_status(s, "Virus jitter moved your drop %d -> %d.", mapped_col + 1, glitched + 1);
     return glitched;
 }
 
 static int maybe_forced_virus_move(AppState *s, int raw_col, int current_col) {
-    if (s->active_forced_move_pct <= 0) {
-        return current_col;
-    }
-
-    if ((rand() % 100) >= s->active_forced_move_pct) {
-        return current_col;
-    }
-
-    int forced = normalize_col(current_col + 1);
-    int attempts = 0;
-
-    while (attempts < CF_COLS && !is_playable_col(s, forced)) {
-        forced = normalize_col(forced + 1);
-        attempts += 1;
-    }
+    int forced = cf_meta_forced_col(&s->fx, &s->rng[RNG_GLITCHES], &s->game, current_col);
 
-    if (attempts >= CF_COLS) {
+    if (forced < 0) {
         return current_col;
     }
 
-    flash();
-    beep();
+    ui_flash(s);
+    ui_beep(s);
     vm_add_log(s, "[HIJACK] Virus moved drop from %d to %d.", raw_col + 1, forced + 1);
-    snprintf(
-        s->status,
-        sizeof(s->status),
+    set_status(
+        s,
         "Virus moved you haha! Requested %d -> landed %d.",
         raw_col + 1,
         forced + 1
@@ -828,56 +951,22 @@ static int maybe_forced_virus_move(AppState *s, int raw_col, int current_col) {
 }
 
 static void consume_player_turn_effects(AppState *s) {
-    if (s->active_flip_turns_remaining > 0) {
-        s->active_flip_turns_remaining -= 1;
-    }
-    if (s->active_purple_turns_remaining > 0) {
-        s->active_purple_turns_remaining -= 1;
-    }
+    cf_meta_end_player_turn(&s->fx);
+    mark_dirty(s, RENDER_EFFECTS);
 }
 
 static void maybe_corrupt_player_piece(AppState *s) {
-    int candidate_cols[CF_COLS];
-    int candidate_rows[CF_COLS];
-    int count = 0;
+    int col = cf_meta_corrupt(&s->fx, &s->rng[RNG_GLITCHES], &s->game);
 
-    if (s->active_player_piece_corrupt_pct <= 0) {
+    if (col < 0) {
         return;
     }
 
-    if ((rand() % 100) >= s->active_player_piece_corrupt_pct) {
-        return;
-    }
-
-    for (int col = 0; col < CF_COLS; ++col) {
-        for (int row = 0; row < CF_ROWS; ++row) {
-            if (s->game.board[row][col] != CF_EMPTY) {
-                if (s->game.board[row][col] == CF_HUMAN) {
-                    candidate_cols[count] = col;
-                    candidate_rows[count] = row;
-                    count += 1;
-                }
-                break;
-            }
-        }
-    }
-
-    if (count == 0) {
-        return;
-    }
-
-    int pick = rand() % count;
-    int col = candidate_cols[pick];
-    int row = candidate_rows[pick];
-
-    s->game.board[row][col] = CF_EMPTY;
-    if (s->game.moves > 0) {
-        s->game.moves -= 1;
-    }
-
-    flash();
+    cf_game_record_event(&s->round_record, CF_EVENT_CORRUPT, col, 0);
+    mark_dirty(s, RENDER_BOARD);
+    ui_flash(s);
     vm_add_log(s, "[666] Corruption removed your top token in column %d.", col + 1);
-    snprintf(s->status, sizeof(s->status), "Payload hit: your token in column %d was deleted.", col + 1);
+    set_status(s, "Payload hit: your token in column %d was deleted.", col + 1);
 }
 
 static void move_cursor_to_next_open(AppState *s, int direction) {
@@ -886,8 +975,9 @@ static void move_cursor_to_next_open(AppState *s, int direction) {
 
     for (int step = 1; step <= CF_COLS; ++step) {
         int col = normalize_col(base + (step * actual_direction));
-        if (!s->blocked_cols[col]) {
+        if (!s->fx.blocked_cols[col]) {
             s->cursor_col = col;
+            mark_dirty(s, RENDER_CURSOR);
             return;
         }
     }
@@ -913,217 +1003,217 @@ static void draw_fake_desktop(
         "SUSPICIOUS.EXE"
     };
 
-    erase();
-    if (has_colors()) {
-        attron(A_BOLD | COLOR_PAIR(6));
-    } else {
-        attron(A_BOLD);
-    }
-    mvprintw(0, 0, "Classic Desktop - Macintosh HD - %s", display_player_name(s));
-    if (has_colors()) {
-        attroff(A_BOLD | COLOR_PAIR(6));
-    } else {
-        attroff(A_BOLD);
-    }
+    CfRenderer *out = s->render.out;
+    CfRenderArea screen = screen_area(s);
 
-    mvprintw(1, 0, "Use LEFT/RIGHT then Enter to open an icon.");
+    cf_render_clear(out, screen);
+    cf_render_printf(out, screen, 0, 0, CF_ATTR_BOLD | CF_PAIR_BLUE, "Classic Desktop - Macintosh HD - %s", display_player_name(s));
 
-    mvprintw(3, 2,  "  .-----------------------.");
-    mvprintw(4, 2,  "  | .-------------------. |");
-    mvprintw(5, 2,  "  | | >run#             | |");
-    mvprintw(6, 2,  "  | | _                 | |");
-    mvprintw(7, 2,  "  | | [SUSPICIOUS.EXE]  | |");
-    mvprintw(8, 2,  "  | '-------------------' |");
-    mvprintw(9, 2,  "  |      Finder 9.2       |");
-    mvprintw(10, 2, " .^-----------------------^.");
-    mvprintw(11, 2, " |  ---~   Mac Desktop VM  |");
-    mvprintw(12, 2, " '-------------------------'");
+    cf_render_text(out, screen, 1, 0, 0, "Use LEFT/RIGHT then Enter to open an icon.");
+
+    cf_render_text(out, screen, 3, 2,  0, "  .-----------------------.");
+    cf_render_text(out, screen, 4, 2,  0, "  | .-------------------. |");
+    cf_render_text(out, screen, 5, 2,  0, "  | | >run#             | |");
+    cf_render_text(out, screen, 6, 2,  0, "  | | _                 | |");
+    cf_render_text(out, screen, 7, 2,  0, "  | | [SUSPICIOUS.EXE]  | |");
+    cf_render_text(out, screen, 8, 2,  0, "  | '-------------------' |");
+    cf_render_text(out, screen, 9, 2,  0, "  |      Finder 9.2       |");
+    cf_render_text(out, screen, 10, 2, 0, " .^-----------------------^.");
+    cf_render_text(out, screen, 11, 2, 0, " |  ---~   Mac Desktop VM  |");
+    cf_render_text(out, screen, 12, 2, 0, " '-------------------------'");
 
     for (int i = 0; i < 3; ++i) {
-        int x = 2 + i * 22;
-        if (i == selected_icon) {
-            attron(A_REVERSE | A_BOLD);
-        }
-        mvprintw(14, x, "[ %-15s ]", icons[i]);
-        if (i == selected_icon) {
-            attroff(A_REVERSE | A_BOLD);
-        }
+        unsigned attr = i == selected_icon ? CF_ATTR_REVERSE | CF_ATTR_BOLD : 0;
+
+        cf_render_printf(out, screen, 14, 2 + i * 22, attr, "[ %-15s ]", icons[i]);
     }
 
-    mvprintw(17, 0, "%s", hint);
-    mvprintw(19, 0, "%s", message);
-    refresh();
+    cf_render_text(out, screen, 17, 0, 0, hint);
+    cf_render_text(out, screen, 19, 0, 0, message);
+    cf_render_present(out);
 }
 
-static void run_fake_desktop_intro(AppState *s) {
-    char input_name[32] = {0};
-    int selected_icon = 0;
-    char message[160] = {0};
-
-    if (s->intro_completed) {
-        return;
+static void format_count(double value, char *buf, size_t cap) {
+    if (value >= 1e6) {
+        snprintf(buf, cap, "%.1fM", value / 1e6);
+    } else if (value >= 1e3) {
+        snprintf(buf, cap, "%.1fk", value / 1e3);
+    } else {
+        snprintf(buf, cap, "%.0f", value);
     }
+}
 
-    nodelay(stdscr, false);
-    keypad(stdscr, true);
+static void draw_perf_hud(CfRenderArea area, const AppState *s, int row) {
+    CfRenderer *out = s->render.out;
+    char nodes[16];
+    char nps[16];
+    char tt_hits[16];
+    char sent[40];
+    const CfSearchInfo *ai = &s->last_ai;
+    CfRenderStats stats;
 
-    erase();
-    if (has_colors()) {
-        attron(A_BOLD | COLOR_PAIR(3));
-    } else {
-        attron(A_BOLD);
+    /* Only backends that write the terminal themselves know what a frame cost on the wire. */
+    cf_render_stats(out, &stats);
+    sent[0] = '\0';
+    if (stats.bytes > 0) {
+        snprintf(sent, sizeof(sent), " | out %lluB/frame", (unsigned long long)stats.last_bytes);
     }
-    mvprintw(2, 2, "Welcome to Macintosh");
-    if (has_colors()) {
-        attroff(A_BOLD | COLOR_PAIR(3));
-    } else {
-        attroff(A_BOLD);
-    }
-    mvprintw(4, 2, "Booting Fake Mac OS 9 VM...");
-    mvprintw(6, 2, "Loading Finder, extensions, and questionable startup items.");
-    refresh();
-    usleep(700000);
-
-    erase();
-    mvprintw(3, 2, "Please enter your operator name:");
-    mvprintw(5, 2, "> ");
-    echo();
-    curs_set(1);
-    move(5, 4);
-    getnstr(input_name, (int)sizeof(input_name) - 1);
-    noecho();
-    curs_set(0);
-    trim_player_name(input_name);
-
-    if (input_name[0] == '\0') {
-        snprintf(s->player_name, sizeof(s->player_name), "Player");
+
+    if (!s->ai_stats_valid) {
+        cf_render_printf(out, area, row, 0, 0, "Perf: frame %.2fms%s | loop %.0f/s | AI --", s->frame_ms, sent, s->loop_rate);
+        return;
+    }
+
+    format_count((double)ai->nodes, nodes, sizeof(nodes));
+    format_count(ai->elapsed_ms > 0 ? (double)ai->nodes * 1000.0 / ai->elapsed_ms : 0, nps, sizeof(nps));
+    if (s->last_ai_tt_probes > 0) {
+        snprintf(tt_hits, sizeof(tt_hits), "%d%%", (int)(s->last_ai_tt_hits * 100 / s->last_ai_tt_probes));
     } else {
-        snprintf(s->player_name, sizeof(s->player_name), "%s", input_name);
+        snprintf(tt_hits, sizeof(tt_hits), "--");
     }
 
-    snprintf(message, sizeof(message), "Desktop ready. Choose an icon to open.");
+    cf_render_printf(
+        out,
+        area,
+        row,
+        0,
+        0,
+        "Perf: frame %.2fms%s | loop %.0f/s | AI %.1fms d%d | %s nodes | %s nps | TT hit %s",
+        s->frame_ms,
+        sent,
+        s->loop_rate,
+        ai->elapsed_ms,
+        ai->depth,
+        nodes,
+        nps,
+        tt_hits
+    );
+}
 
-    while (true) {
-        int ch;
-        draw_fake_desktop(
-            s,
-            selected_icon,
-            "Hint: the suspicious executable looks very clickable.",
-            message
-        );
+static int spinner_phase(const AppState *s) {
+    return (int)((long long)(session_now(s) / SPINNER_FRAME_MS) % 4);
+}
 
-        ch = getch();
-        if (ch == KEY_LEFT || ch == 'a' || ch == 'A') {
-            selected_icon = (selected_icon + 2) % 3;
-            continue;
-        }
-        if (ch == KEY_RIGHT || ch == 'd' || ch == 'D') {
-            selected_icon = (selected_icon + 1) % 3;
-            continue;
-        }
-        if (ch >= '1' && ch <= '3') {
-            selected_icon = ch - '1';
-            continue;
-        }
+/* Whole seconds left before the auto restart, rounded up. */
+static int restart_countdown(const AppState *s) {
+    double left_ms = s->timer_due_ms[TIMER_AUTO_RESTART] - session_now(s);
 
-        if (ch == '\n' || ch == KEY_ENTER || ch == ' ') {
-            if (selected_icon == 0) {
-                snprintf(message, sizeof(message), "ReadMe: \"Never open suspicious EXEs.\"");
-                beep();
-            } else if (selected_icon == 1) {
-                snprintf(message, sizeof(message), "Paint failed to launch: missing QuickDraw extension.");
-            } else {
-                erase();
-                if (has_colors()) {
-                    attron(A_BOLD | COLOR_PAIR(1));
-                } else {
-                    attron(A_BOLD);
-                }
-                mvprintw(4, 2, "Launching SUSPICIOUS.EXE...");
-                if (has_colors()) {
-                    attroff(A_BOLD | COLOR_PAIR(1));
-                } else {
-                    attroff(A_BOLD);
-                }
-                mvprintw(6, 2, "This looked like a normal utility. It was not.");
-                mvprintw(8, 2, "Dropping into containment game mode...");
-                refresh();
-                flash();
-                beep();
-                usleep(850000);
-
-                s->desktop_selected_icon = selected_icon;
-                s->compromised_pct = clamp_int(s->compromised_pct + 8, 0, 100);
-                s->intro_completed = true;
-                break;
-            }
-        }
+    if (!s->auto_restart_pending || left_ms <= 0) {
+        return 0;
     }
-
-    nodelay(stdscr, true);
-    flushinp();
+    return (int)((left_ms + 999.0) / 1000.0);
 }
 
-static void draw_vm_console(const AppState *s, int start_y) {
+static void draw_console_header(CfRenderArea area, const AppState *s) {
     int uptime_seconds = (int)difftime(time(NULL), s->vm_boot_time);
     int mm = uptime_seconds / 60;
     int ss = uptime_seconds % 60;
     const char spinner[4] = {'|', '/', '-', '\\'};
-    int width = s->max_x - 1;
 
-    if (start_y >= s->max_y - 2) {
-        return;
-    }
-
-    if (has_colors()) {
-        attron(A_BOLD | COLOR_PAIR(6));
-    } else {
-        attron(A_BOLD);
-    }
-    mvprintw(start_y, 0, "Mac OS 9 VM Console [%c] Uptime %02d:%02d", spinner[s->vm_ticks % 4], mm, ss);
-    if (has_colors()) {
-        attroff(A_BOLD | COLOR_PAIR(6));
-    } else {
-        attroff(A_BOLD);
-    }
+    cf_render_clear(s->render.out, (CfRenderArea){area.y, area.x, 1, area.cols});
+    cf_render_printf(
+        s->render.out,
+        area,
+        0,
+        0,
+        CF_ATTR_BOLD | CF_PAIR_BLUE,
+        "Mac OS 9 VM Console [%c] Uptime %02d:%02d",
+        spinner[spinner_phase(s)],
+        mm,
+        ss
+    );
+}
 
-    mvprintw(
+static void draw_vm_console(CfRenderArea area, const AppState *s) {
+    CfRenderer *out = s->render.out;
+    int start_y = 0;
+    int width = s->max_x - 1;
+    int height = area.rows;
+    int rows;
+    uint64_t first;
+    uint64_t end;
+    char rule[79];
+
+    cf_render_clear(out, area);
+    draw_console_header(area, s);
+
+    cf_render_printf(
+        out,
+        area,
         start_y + 1,
         0,
+        0,
         "Alert: %s | Compromised: %d%% | Stacks N:%d M:%d W:%d O:%d A:%d 6:%d",
         s->vm_current_alert,
-        s->compromised_pct,
-        incident_stack(s, INCIDENT_NVIR),
-        incident_stack(s, INCIDENT_MDEF),
-        incident_stack(s, INCIDENT_WDEF),
-        incident_stack(s, INCIDENT_MACRO),
-        incident_stack(s, INCIDENT_AUTOSTART),
-        incident_stack(s, INCIDENT_SEVENDUST)
+        s->meta.compromised_pct,
+        incident_stack(s, CF_INCIDENT_NVIR),
+        incident_stack(s, CF_INCIDENT_MDEF),
+        incident_stack(s, CF_INCIDENT_WDEF),
+        incident_stack(s, CF_INCIDENT_MACRO),
+        incident_stack(s, CF_INCIDENT_AUTOSTART),
+        incident_stack(s, CF_INCIDENT_SEVENDUST)
     );
 
-    for (int i = 0; i < width && i < 78; ++i) {
-        mvaddch(start_y + 2, i, '-');
+    if (s->perf_hud) {
+        draw_perf_hud(area, s, start_y + 2);
+        start_y += 1;
     }
 
-    for (int i = 0; i < VM_LOG_LINES; ++i) {
-        int row = start_y + 3 + i;
-        if (row >= s->max_y) {
-            break;
-        }
+    width = clamp_int(width, 0, (int)sizeof(rule) - 1);
+    memset(rule, '-', (size_t)width);
+    rule[width] = '\0';
+    cf_render_text(out, area, start_y + 2, 0, 0, rule);
 
-        if (i < s->vm_log_count) {
-            mvprintw(row, 0, "%s", s->vm_logs[i]);
-        } else {
-            mvprintw(row, 0, "");
+    if (s->log_scroll > 0) {
+        cf_render_printf(out, area, start_y + 2, 2, 0, " Scrollback: %d line(s) up, End returns ", s->log_scroll);
+    }
+
+    rows = height - (start_y + 3);
+    if (rows <= 0) {
+        return;
+    }
+    end = cf_log_count(s->log) - (uint64_t)s->log_scroll;
+    first = end > (uint64_t)rows ? end - (uint64_t)rows : 0;
+    if (s->log_scroll == 0 && first < s->log_floor) {
+        first = s->log_floor;
+    }
+    for (uint64_t line = first; line < end; ++line) {
+        const char *text = cf_log_line(s->log, line);
+
+        if (text != NULL) {
+            cf_render_text(out, area, start_y + 3 + (int)(line - first), 0, 0, text);
         }
     }
 }
 
 /* --------------------- Rendering --------------------- */
-static void draw_board_ui(const AppState *s) {
-    int top = 5;
-    int grid_y = top + 3;
+enum {
+    BOARD_TOP = 5,
+    BOARD_GRID_Y = BOARD_TOP + 3
+};
+
+/* First console row: below the grid, status and however many info lines are showing. */
+static int layout_console_y(const AppState *s) {
+    int info_row = BOARD_GRID_Y + CF_ROWS + 2;
     int vm_y;
+
+    info_row += (s->fx.control_shift > 0) ? 1 : 0;
+    info_row += (s->fx.forced_move_pct > 0) ? 1 : 0;
+    info_row += is_grid_flipped(s) ? 1 : 0;
+    info_row += is_purple_takeover(s) ? 1 : 0;
+    info_row += s->game_over ? 1 : 0;
+
+    vm_y = info_row + 2;
+    if (vm_y < BOARD_GRID_Y + CF_ROWS + 5) {
+        vm_y = BOARD_GRID_Y + CF_ROWS + 5;
+    }
+    return vm_y;
+}
+
+static void draw_board_window(CfRenderArea w, const AppState *s) {
+    CfRenderer *out = s->render.out;
+    int top = BOARD_TOP;
+    int grid_y = BOARD_GRID_Y;
     int info_row = grid_y + CF_ROWS + 2;
     bool flipped = is_grid_flipped(s);
     bool purple = is_purple_takeover(s);
@@ -1131,62 +1221,48 @@ static void draw_board_ui(const AppState *s) {
 
     build_player_greeting(s, greeting, sizeof(greeting));
 
-    erase();
+    cf_render_clear(out, w);
 
-    if (has_colors()) {
-        attron(A_BOLD | COLOR_PAIR(3));
-    } else {
-        attron(A_BOLD);
-    }
-    mvprintw(0, 0, "%s :: Connect Four Virus :: Fake Mac OS 9 VM", greeting);
-    if (has_colors()) {
-        attroff(A_BOLD | COLOR_PAIR(3));
-    } else {
-        attroff(A_BOLD);
-    }
+    cf_render_printf(out, w, 0, 0, CF_ATTR_BOLD | CF_PAIR_CYAN, "%s :: Connect Four Virus :: Fake Mac OS 9 VM", greeting);
 
-    mvprintw(1, 0, "LEFT/RIGHT or A/D move | Enter/Space drop | 1-6 quick select | r restart | q quit");
-    mvprintw(
+    cf_render_text(out, w, 1, 0, 0, "LEFT/RIGHT or A/D move | Enter/Space drop | 1-6 quick select | r restart | q quit");
+    cf_render_printf(
+        out,
+        w,
         2,
         0,
+        0,
         "You = O   AI = X   First to connect 4 wins.   Threat Level: %d   System Compromised: %d%%",
         infection_pressure(s),
-        s->compromised_pct
+        s->meta.compromised_pct
     );
-    mvprintw(3, 0, "%s", s->effect_summary);
+    cf_render_text(out, w, 3, 0, 0, s->effect_summary);
 
-    mvprintw(top, 0, "   ");
+    /* Each grid cell is three columns wide, after a three-column row label. */
     for (int display_col = 0; display_col < CF_COLS; ++display_col) {
         int logical_col = logical_col_from_display(s, display_col);
-        if (s->blocked_cols[logical_col]) {
-            if (has_colors()) {
-                attron(COLOR_PAIR(5) | A_BOLD);
-            }
-            printw(" X ");
-            if (has_colors()) {
-                attroff(COLOR_PAIR(5) | A_BOLD);
-            }
+        int x = 3 + display_col * 3;
+
+        if (s->fx.blocked_cols[logical_col]) {
+            cf_render_text(out, w, top, x, color_attr(s, CF_PAIR_MAGENTA), " X ");
         } else {
-            printw(" %d ", display_col + 1);
+            cf_render_printf(out, w, top, x, 0, " %d ", display_col + 1);
         }
     }
 
-    mvprintw(top + 1, 0, "   ");
     for (int display_col = 0; display_col < CF_COLS; ++display_col) {
         int logical_col = logical_col_from_display(s, display_col);
-        if (s->blocked_cols[logical_col]) {
-            printw(" x ");
+        int x = 3 + display_col * 3;
+
+        if (s->fx.blocked_cols[logical_col]) {
+            cf_render_text(out, w, top + 1, x, 0, " x ");
         } else if (logical_col == s->cursor_col && !s->game_over) {
-            attron(A_REVERSE);
-            printw(" ^ ");
-            attroff(A_REVERSE);
-        } else {
-            printw("   ");
+            cf_render_text(out, w, top + 1, x, CF_ATTR_REVERSE, " ^ ");
         }
     }
 
     for (int r = 0; r < CF_ROWS; ++r) {
-        mvprintw(grid_y + r, 0, "%d |", r);
+        cf_render_printf(out, w, grid_y + r, 0, 0, "%d |", r);
         for (int display_col = 0; display_col < CF_COLS; ++display_col) {
             int logical_col = logical_col_from_display(s, display_col);
             CfCell cell = s->game.board[r][logical_col];
@@ -1199,29 +1275,26 @@ static void draw_board_ui(const AppState *s) {
             } else if (cell == CF_AI) {
                 token = 'X';
                 pair = purple ? 5 : 1;
-            } else if (s->blocked_cols[logical_col]) {
+            } else if (s->fx.blocked_cols[logical_col]) {
                 token = '#';
                 pair = 5;
             }
 
-            if (pair > 0 && has_colors()) {
-                attron(COLOR_PAIR(pair) | A_BOLD);
-            }
-            printw(" %c ", token);
-            if (pair > 0 && has_colors()) {
-                attroff(COLOR_PAIR(pair) | A_BOLD);
-            }
+            cf_render_printf(out, w, grid_y + r, 3 + display_col * 3, pair > 0 ? color_attr(s, pair) : 0, " %c ", token);
         }
-        printw("|");
+        cf_render_text(out, w, grid_y + r, 3 + CF_COLS * 3, 0, "|");
     }
 
-    mvprintw(grid_y + CF_ROWS + 1, 0, "%s", s->status);
+    cf_render_text(out, w, grid_y + CF_ROWS + 1, 0, 0, s->status);
 
-    if (s->active_control_shift > 0) {
-        int mapped = remap_drop_col(s, s->cursor_col);
-        mvprintw(
+    if (s->fx.control_shift > 0) {
+        int mapped = cf_meta_remap_col(&s->fx, s->cursor_col);
+        cf_render_printf(
+            out,
+            w,
             info_row,
             0,
+            0,
             "Control remap active: selected %d -> mapped %d",
             s->cursor_col + 1,
             mapped + 1
@@ -1229,39 +1302,30 @@ static void draw_board_ui(const AppState *s) {
         info_row += 1;
     }
 
-    if (s->active_forced_move_pct > 0) {
-        mvprintw(info_row, 0, "Forced virus move chance: %d%%", s->active_forced_move_pct);
+    if (s->fx.forced_move_pct > 0) {
+        cf_render_printf(out, w, info_row, 0, 0, "Forced virus move chance: %d%%", s->fx.forced_move_pct);
         info_row += 1;
     }
 
     if (flipped) {
-        mvprintw(info_row, 0, "Grid inversion active for %d turn(s).", s->active_flip_turns_remaining);
+        cf_render_printf(out, w, info_row, 0, 0, "Grid inversion active for %d turn(s).", s->fx.flip_turns_remaining);
         info_row += 1;
     }
 
     if (purple) {
-        mvprintw(info_row, 0, "Purple takeover active for %d turn(s).", s->active_purple_turns_remaining);
+        cf_render_printf(out, w, info_row, 0, 0, "Purple takeover active for %d turn(s).", s->fx.purple_turns_remaining);
         info_row += 1;
     }
 
-    if (s->game_over) {
+    /* Until the incident scenes are dismissed there is no countdown to show yet. */
+    if (s->game_over && s->auto_restart_pending) {
         int countdown = 0;
         const char spinner[4] = {'|', '/', '-', '\\'};
         int filled = 0;
         char reboot_bar[17];
+        unsigned attr = CF_ATTR_BOLD | CF_PAIR_GREEN;
 
-        if (has_colors()) {
-            attron(A_BOLD | COLOR_PAIR(4));
-        } else {
-            attron(A_BOLD);
-        }
-
-        if (s->auto_restart_pending) {
-            countdown = (int)(s->auto_restart_deadline - time(NULL));
-            if (countdown < 0) {
-                countdown = 0;
-            }
-        }
+        countdown = restart_countdown(s);
 
         filled = clamp_int((AUTO_RESTART_SECONDS - countdown) * 5, 0, 15);
         for (int i = 0; i < 15; ++i) {
@@ -1270,389 +1334,1688 @@ static void draw_board_ui(const AppState *s) {
         reboot_bar[15] = '\0';
 
         if (s->winner == 1) {
-            mvprintw(info_row, 0, "You win. Auto restart in %d sec. Press r now or q to quit.", countdown);
+            cf_render_printf(out, w, info_row, 0, attr, "You win. Auto restart in %d sec. Press r now or q to quit.", countdown);
         } else if (s->winner == 2) {
-            mvprintw(info_row, 0, "AI wins. Auto restart in %d sec. Press r now or q to quit.", countdown);
+            cf_render_printf(out, w, info_row, 0, attr, "AI wins. Auto restart in %d sec. Press r now or q to quit.", countdown);
         } else {
-            mvprintw(info_row, 0, "Draw. Auto restart in %d sec. Press r now or q to quit.", countdown);
+            cf_render_printf(out, w, info_row, 0, attr, "Draw. Auto restart in %d sec. Press r now or q to quit.", countdown);
         }
-        mvprintw(info_row + 1, 0, "Reboot animation [%s] %c", reboot_bar, spinner[s->vm_ticks % 4]);
+        cf_render_printf(out, w, info_row + 1, 0, attr, "Reboot animation [%s] %c", reboot_bar, spinner[spinner_phase(s)]);
         info_row += 1;
+    }
+}
 
-        if (has_colors()) {
-            attroff(A_BOLD | COLOR_PAIR(4));
+static bool parts_changed(const AppState *s, unsigned seen[RENDER_PARTS], unsigned mask) {
+    bool changed = false;
+
+    for (int i = 0; i < RENDER_PARTS; ++i) {
+        if ((mask & (1u << i)) != 0 && seen[i] != s->render_gen[i]) {
+            seen[i] = s->render_gen[i];
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/* Splits the screen into the board and console areas when the terminal size or the console row moves. */
+static void render_layout(AppState *s) {
+    RenderState *r = &s->render;
+    int console_y = layout_console_y(s);
+    int board_rows = console_y < s->max_y - 2 ? console_y : s->max_y;
+
+    if (r->laid_out && r->max_y == s->max_y && r->max_x == s->max_x && r->console_y == console_y) {
+        return;
+    }
+    if (r->laid_out && (r->max_y != s->max_y || r->max_x != s->max_x)) {
+        /* After a resize the terminal's contents are unknown; repaint it all. */
+        cf_render_invalidate(r->out);
+    }
+
+    r->board = (CfRenderArea){0, 0, board_rows, s->max_x};
+    r->console = (CfRenderArea){board_rows, 0, s->max_y - board_rows, s->max_x};
+    r->laid_out = true;
+    r->max_y = s->max_y;
+    r->max_x = s->max_x;
+    r->console_y = console_y;
+    r->invalid = true;
+}
+
+/*
+ * Repaints only what changed since the last call: the board area when the
+ * board, cursor, status or effects generation moved (or, after a game ends,
+ * when the restart countdown ticks), the console when logs or effects did,
+ * and just the console header when only its uptime/spinner advanced.
+ * Returns whether anything was painted.
+ */
+static bool draw_board_ui(AppState *s) {
+    RenderState *r = &s->render;
+    long board_clock;
+    long console_clock;
+    bool board_dirty;
+    bool console_dirty;
+    bool header_dirty;
+
+    render_layout(s);
+
+    board_clock = s->game_over ? (long)restart_countdown(s) * 4 + spinner_phase(s) : -1;
+    console_clock = (long)difftime(time(NULL), s->vm_boot_time) * 4 + spinner_phase(s);
+
+    board_dirty = parts_changed(s, r->board_seen, RENDER_BOARD_PARTS) || board_clock != r->board_clock;
+    console_dirty = parts_changed(s, r->console_seen, RENDER_CONSOLE_PARTS);
+    header_dirty = console_clock != r->console_clock;
+    if (r->invalid) {
+        board_dirty = true;
+        console_dirty = true;
+        r->invalid = false;
+    }
+    if (!board_dirty && !console_dirty && !header_dirty) {
+        return false;
+    }
+    r->board_clock = board_clock;
+    r->console_clock = console_clock;
+
+    if (board_dirty) {
+        draw_board_window(r->board, s);
+    }
+    if (r->console.rows > 0 && (console_dirty || header_dirty)) {
+        /* The perf line changes with the clock too and may wrap, so it takes the full path. */
+        if (console_dirty || s->perf_hud) {
+            draw_vm_console(r->console, s);
         } else {
-            attroff(A_BOLD);
+            draw_console_header(r->console, s);
         }
     }
+    cf_render_present(r->out);
+    return true;
+}
 
-    vm_y = info_row + 2;
-    if (vm_y < grid_y + CF_ROWS + 5) {
-        vm_y = grid_y + CF_ROWS + 5;
+static int read_key(AppState *s) {
+    return cf_render_key(s->render.out);
+}
+
+/* --------------------- Scrollback --------------------- */
+static int console_log_rows(const AppState *s) {
+    int rows;
+
+    if (s->render.console.rows <= 0) {
+        return 1;
     }
+    rows = s->render.console.rows - 3 - (s->perf_hud ? 1 : 0);
+    return rows > 1 ? rows : 1;
+}
 
-    draw_vm_console(s, vm_y);
-    refresh();
+/* Positive `delta` goes back in time, as far as putting the oldest held line on the top row. */
+static void scroll_logs(AppState *s, long delta) {
+    uint64_t held = cf_log_count(s->log) - cf_log_first(s->log);
+    uint64_t rows = (uint64_t)console_log_rows(s);
+    long max_scroll = held > rows ? (long)(held - rows) : 0;
+    long scroll = s->log_scroll + delta;
+
+    scroll = scroll < 0 ? 0 : scroll;
+    scroll = scroll > max_scroll ? max_scroll : scroll;
+    if (scroll != s->log_scroll) {
+        s->log_scroll = (int)scroll;
+        mark_dirty(s, RENDER_LOGS);
+    }
 }
 
-/* --------------------- "Punishment" action (safe VM incident simulation) --------------------- */
-static void run_punishment_action(AppState *s) {
-    int code = 1 + (rand() % INCIDENT_TYPES);
-    int y = s->max_y - 13;
-    int *stack = &s->incident_stacks[code - 1];
-    int severity;
-    int pressure;
+/* --------------------- Animation --------------------- */
+/*
+ * The intro, incident report, loss flood and mini-games are scenes stepped by
+ * the main loop rather than loops of their own: TIMER_ANIMATION fires at the
+ * scene's next frame or the end of its current hold, keys are routed to
+ * scene_key(), and frames the loop was too late for are skipped, not replayed.
+ */
+enum {
+    INTRO_BOOT,
+    INTRO_NAME,
+    INTRO_DESKTOP,
+    INTRO_LAUNCH
+};
 
-    const char *incident = "Unknown";
-    const char *l1 = "";
-    const char *l2 = "";
-    const char *l3 = "";
-    const char *l4 = "";
-    const char *impact = "";
+enum {
+    INCIDENT_PULSES,
+    INCIDENT_REPORT
+};
 
-    if (y < 2) {
-        y = 2;
+enum {
+    MINIGAME_PLAY,
+    MINIGAME_FEEDBACK,
+    MINIGAME_RESULT
+};
+
+/* Frames per second while a scene animates; 0 = it only changes on input or a hold. */
+static const int kSceneFps[SCENE_KINDS] = {0, 0, 0, 40, 20, 22};
+#ifdef CF_TRACE
+static const char *const kSceneTraceNames[SCENE_KINDS] = {
+    "scene_none",
+    "scene_intro",
+    "scene_incident",
+    "scene_squiggles",
+    "scene_mining",
+    "scene_phishing"
+};
+#endif
+
+typedef struct {
+    const char *message;
+    bool phishing;
+} PhishingPrompt;
+
+static const PhishingPrompt kPrompts[] = {
+    {"'Verify Apple ID now or account deleted in 5 min' from appl3-secure.example", true},
+    {"'Coffee run at 3 PM?' from your teammate", false},
+    {"'Payroll requires your password to release salary' from hr-payfast.biz", true},
+    {"'Meeting moved to tomorrow, same room' from manager", false},
+    {"'Download urgent security patch from random .zip link' from it-support@fake", true},
+    {"'Shared project notes, internal wiki link' from coworker", false}
+};
+
+static void scene_start(AppState *s, int kind);
+
+/* From CF_PHISHING_CORPUS when one is loaded, otherwise the built-in prompts above. */
+static void phishing_prompt(const AppState *s, uint64_t prompt, CfCorpusEntry *out) {
+    if (s->corpus != NULL) {
+        cf_corpus_entry(s->corpus, prompt, out);
+        return;
+    }
+    out->text = kPrompts[prompt].message;
+    out->len = strlen(out->text);
+    out->phishing = kPrompts[prompt].phishing;
+}
+
+static void print_title(const AppState *s, int y, int x, int pair, const char *text) {
+    cf_render_text(s->render.out, screen_area(s), y, x, CF_ATTR_BOLD | (unsigned)pair, text);
+}
+
+static void scene_set_frames(Scene *sc, double frame_ms, double now) {
+    sc->frame_ms = frame_ms;
+    sc->next_frame_ms = frame_ms > 0 ? now + frame_ms : 0;
+}
+
+static void scene_hold(Scene *sc, int phase, double hold_ms, double now) {
+    sc->phase = phase;
+    scene_set_frames(sc, 0, now);
+    sc->phase_end_ms = now + hold_ms;
+}
+
+/* Moves to the first frame slot after `now`; slots the loop already missed are counted and dropped. */
+static void scene_next_frame(AppState *s, double now) {
+    Scene *sc = &s->scene;
+    long missed;
+
+    sc->next_frame_ms += sc->frame_ms;
+    if (sc->next_frame_ms > now) {
+        return;
     }
+    missed = (long)((now - sc->next_frame_ms) / sc->frame_ms) + 1;
+    sc->next_frame_ms += (double)missed * sc->frame_ms;
+    s->frames_skipped += (unsigned long)missed;
+    cf_metric_add(s->metrics.frames_skipped, (uint64_t)missed);
+    CF_TRACE_INSTANT_ARG("frames_skipped", "count", missed);
+}
 
-    *stack += 1;
-    severity = *stack;
-    pressure = infection_pressure(s);
-    s->last_incident_code = code;
-    s->total_losses += 1;
-    s->compromised_pct = clamp_int(s->compromised_pct + 6 + severity * 3, 0, 100);
-    sync_compromised_floor(s);
+/* Runs after every scene step (start, key, frame, phase end), so it also marks the scene's state as changed. */
+static void scene_arm(AppState *s) {
+    const Scene *sc = &s->scene;
+    double due = sc->next_frame_ms;
 
-    switch (code) {
-        case INCIDENT_NVIR:
-            incident = "nVIR family";
-            vm_set_alert(s, "nVIR-like resource infection detected.", "[nVIR] Don't panic!");
-            l1 = "[nVIR] System file resource fork patched (simulated).";
-            l2 = "[nVIR] Random beep payload triggered.";
-            l3 = "[nVIR] MacinTalk ghost message: \"Don't panic!\"";
-            l4 = "[AV] Quarantine complete. No host changes were made.";
-            impact = "Next games: input jitter and random move reroutes intensify.";
-            beep();
-            beep();
-            vm_add_log(s, "[ALERT] nVIR signature matched in guest System file.");
-            break;
+    mark_dirty(s, RENDER_SCENE);
+    if (sc->phase_end_ms > 0 && (due == 0 || sc->phase_end_ms < due)) {
+        due = sc->phase_end_ms;
+    }
+    s->timer_due_ms[TIMER_ANIMATION] = sc->kind == SCENE_NONE ? 0 : due;
+}
 
-        case INCIDENT_MDEF:
-            incident = "MDEF / Garfield + CDEF";
-            vm_set_alert(s, "Menu definition resources corrupted.", "[MDEF] Menus are cursed");
-            l1 = "[MDEF] Menu manager hooks replaced (simulated).";
-            l2 = "[CDEF] Control definition conflict injects visual glitches.";
-            l3 = "[UI] Menus become garbled; random crash dialog appears.";
-            l4 = "[AV] Restored clean menu resources in fake VM snapshot.";
-            impact = "Next games: control remap drift gets stronger.";
-            flash();
-            vm_add_log(s, "[ALERT] MDEF/CDEF resource tampering event.");
-            break;
+/* Ends the scene, hands the screen back to the board and runs whatever follows it. */
+static void scene_finish(AppState *s) {
+    int kind = s->scene.kind;
 
-        case INCIDENT_WDEF:
-            incident = "WDEF + Zuc floppy chain";
-            vm_set_alert(s, "Desktop and floppy boot chain anomalies.", "[WDEF] Desktop file chaos");
-            l1 = "[WDEF] Desktop file metadata drift detected.";
-            l2 = "[Zuc] Infected floppy boot block mounted (simulated).";
-            l3 = "[FINDER] Icons flicker, folder views degrade, boot slows down.";
-            l4 = "[AV] Desktop rebuilt; floppy image isolated from startup path.";
-            impact = "Next games: locked columns persist and stack with repeats.";
-            for (int i = 0; i < 2; ++i) {
-                beep();
-                usleep(180000);
-            }
-            vm_add_log(s, "[ALERT] WDEF desktop integrity mismatch.");
-            break;
+    CF_TRACE_END(kSceneTraceNames[kind]);
+    memset(&s->scene, 0, sizeof(s->scene));
+    s->timer_due_ms[TIMER_ANIMATION] = 0;
+    ui_flush_input(s);
+    render_invalidate(s);
 
-        case INCIDENT_MACRO:
-            incident = "Office macro wave (Concept/Laroux)";
-            vm_set_alert(s, "Macro propagation via shared docs.", "[MACRO] Concept/Laroux spread");
-            l1 = "[DOC] Word template altered by Concept-like macro (simulated).";
-            l2 = "[XLS] Laroux-style macro copied into workbook startup path.";
-            l3 = "[NET] Cross-platform file share became infection route.";
-            l4 = "[AV] Macros disabled and startup templates replaced.";
-            impact = "Next games: AI search depth increases.";
-            flash();
-            beep();
-            vm_add_log(s, "[ALERT] Macro payload detected in Office documents.");
+    switch (kind) {
+        case SCENE_INCIDENT:
+            scene_start(s, SCENE_SQUIGGLES);
             break;
-
-        case INCIDENT_AUTOSTART:
-            incident = "AutoStart 9805 worm";
-            vm_set_alert(s, "AutoStart media autorun exploited.", "[AUTOSTART] CD worm loaded");
-            l1 = "[CD-ROM] AutoStart trigger fired on media insert (simulated).";
-            l2 = "[WORM] Autorun app copied itself to removable volumes.";
-            l3 = "[CHAIN] No click required once disc was inserted.";
-            l4 = "[AV] AutoStart disabled in guest control panel profile.";
-            impact = "Next games: AI starts with opening move(s).";
-            flash();
-            vm_add_log(s, "[ALERT] AutoStart worm behavior in guest media stack.");
+        case SCENE_SQUIGGLES:
+            vm_add_log(s, "[INFO] Incident overlay dismissed by operator.");
+            arm_auto_restart(s);
+            break;
+        case SCENE_INTRO:
+        case SCENE_MINING:
+        case SCENE_PHISHING:
+        default:
+            board_clear(s);
             break;
+    }
+}
 
-        case INCIDENT_SEVENDUST:
+/* ---- Fake desktop intro ---- */
+static void draw_intro(const AppState *s) {
+    const Scene *sc = &s->scene;
+    CfRenderer *out = s->render.out;
+    CfRenderArea screen = screen_area(s);
+
+    switch (sc->phase) {
+        case INTRO_BOOT:
+            cf_render_clear(out, screen);
+            print_title(s, 2, 2, 3, "Welcome to Macintosh");
+            cf_render_text(out, screen, 4, 2, 0, "Booting Fake Mac OS 9 VM...");
+            cf_render_text(out, screen, 6, 2, 0, "Loading Finder, extensions, and questionable startup items.");
+            cf_render_present(out);
+            break;
+        case INTRO_NAME:
+            cf_render_clear(out, screen);
+            cf_render_text(out, screen, 3, 2, 0, "Please enter your operator name:");
+            cf_render_printf(out, screen, 5, 2, 0, "> %s", sc->text);
+            cf_render_present(out);
+            break;
+        case INTRO_DESKTOP:
+            draw_fake_desktop(
+                s,
+                sc->selected,
+                "Hint: the suspicious executable looks very clickable.",
+                sc->message
+            );
+            break;
+        case INTRO_LAUNCH:
         default:
-            incident = "SevenDust / 666 polymorph";
-            vm_set_alert(s, "SevenDust timed payload window entered.", "[666] Timed payload trip");
-            l1 = "[666] MDEF-extension polymorph variant A/F observed.";
-            l2 = "[TIME] 06:00-07:00 trigger window reached (simulated).";
-            l3 = "[PAYLOAD] Attempted non-app file deletion on startup disk.";
-            l4 = "[AV] Snapshot rollback blocked all destructive writes.";
-            impact = "Next games: your placed tokens may randomly be deleted.";
-            for (int i = 0; i < 3; ++i) {
-                flash();
-                usleep(200000);
-            }
-            vm_add_log(s, "[ALERT] SevenDust/666 polymorphic chain detected.");
+            cf_render_clear(out, screen);
+            print_title(s, 4, 2, 1, "Launching SUSPICIOUS.EXE...");
+            cf_render_text(out, screen, 6, 2, 0, "This looked like a normal utility. It was not.");
+            cf_render_text(out, screen, 8, 2, 0, "Dropping into containment game mode...");
+            cf_render_present(out);
             break;
     }
+}
 
-    vm_add_log(s, "[STACK] %s severity increased to %d.", incident, severity);
-    vm_add_log(s, "[THREAT] Global pressure now %d.", pressure);
-    vm_add_log(s, "[THREAT] System compromised now %d%%.", s->compromised_pct);
+static void intro_accept_name(AppState *s) {
+    Scene *sc = &s->scene;
 
-    if (has_colors()) {
-        attron(A_BOLD | COLOR_PAIR(1));
-    } else {
-        attron(A_BOLD);
-    }
-    mvprintw(y, 2, "AI VICTORY TAX COLLECTED! [Persistent Incident] ");
-    if (has_colors()) {
-        attroff(A_BOLD | COLOR_PAIR(1));
+    ui_cursor(s, false);
+    trim_player_name(sc->text);
+    if (sc->text[0] == '\0') {
+        snprintf(s->player_name, sizeof(s->player_name), "Player");
     } else {
-        attroff(A_BOLD);
+        snprintf(s->player_name, sizeof(s->player_name), "%s", sc->text);
     }
+    snprintf(sc->message, sizeof(sc->message), "Desktop ready. Choose an icon to open.");
+    sc->phase = INTRO_DESKTOP;
+    draw_intro(s);
+}
 
-    mvprintw(y + 1, 4, "Incident: %s", incident);
-    mvprintw(y + 2, 4, "%s", l1);
-    mvprintw(y + 3, 4, "%s", l2);
-    mvprintw(y + 4, 4, "%s", l3);
-    mvprintw(y + 5, 4, "%s", l4);
-    mvprintw(y + 6, 4, "Stack level: %d (repeats get worse)", severity);
-    mvprintw(y + 7, 4, "Threat level: %d", pressure);
-    mvprintw(y + 8, 4, "System compromised: %d%%", s->compromised_pct);
-    mvprintw(y + 9, 4, "%s", impact);
-    mvprintw(y + 10, 4, "Press any key to acknowledge incident report.");
+/* Typing starts during the boot screen, just as it did when getnstr() read the buffered keys. */
+static void intro_name_key(AppState *s, int ch) {
+    Scene *sc = &s->scene;
 
-    flushinp();
-    refresh();
-    while (getch() == ERR) {
-        usleep(100000);
+    if (sc->name_done) {
+        return;
     }
-
-    for (int i = 0; i < 12; ++i) {
-        move(y + i, 0);
-        clrtoeol();
+    if (ch == '\n' || ch == '\r' || ch == CF_KEY_ENTER) {
+        if (sc->phase == INTRO_NAME) {
+            intro_accept_name(s);
+        } else {
+            sc->name_done = true;
+        }
+        return;
+    }
+    if (ch == CF_KEY_BACKSPACE || ch == 127 || ch == '\b') {
+        if (sc->text_len > 0) {
+            sc->text_len -= 1;
+            sc->text[sc->text_len] = '\0';
+        }
+    } else if (ch >= ' ' && ch <= '~' && sc->text_len < (int)sizeof(sc->text) - 1) {
+        sc->text[sc->text_len] = (char)ch;
+        sc->text_len += 1;
+        sc->text[sc->text_len] = '\0';
+    } else {
+        return;
+    }
+    if (sc->phase == INTRO_NAME) {
+        draw_intro(s);
     }
 }
 
-/* --------------------- Loss flood --------------------- */
-static void show_loss_squiggles(AppState *s) {
-    erase();
-    mvprintw(0, 0, "Classic Mac VM corruption mode: press any key to return...");
-    refresh();
+static void intro_key(AppState *s, int ch, double now) {
+    Scene *sc = &s->scene;
 
-    while (true) {
-        int ch;
-        app_update_dimensions(s);
+    if (sc->phase == INTRO_BOOT || sc->phase == INTRO_NAME) {
+        intro_name_key(s, ch);
+        return;
+    }
+    if (sc->phase != INTRO_DESKTOP) {
+        return;
+    }
 
-        ch = getch();
-        if (ch != ERR) {
-            break;
+    if (ch == CF_KEY_LEFT || ch == 'a' || ch == 'A') {
+        sc->selected = (sc->selected + 2) % 3;
+    } else if (ch == CF_KEY_RIGHT || ch == 'd' || ch == 'D') {
+        sc->selected = (sc->selected + 1) % 3;
+    } else if (ch >= '1' && ch <= '3') {
+        sc->selected = ch - '1';
+    } else if (ch == '\n' || ch == CF_KEY_ENTER || ch == ' ') {
+        if (sc->selected == 0) {
+            snprintf(sc->message, sizeof(sc->message), "ReadMe: \"Never open suspicious EXEs.\"");
+            ui_beep(s);
+        } else if (sc->selected == 1) {
+            snprintf(sc->message, sizeof(sc->message), "Paint failed to launch: missing QuickDraw extension.");
+        } else {
+            scene_hold(sc, INTRO_LAUNCH, 850, now);
+            draw_intro(s);
+            ui_flash(s);
+            ui_beep(s);
+            return;
         }
+    } else {
+        return;
+    }
+    draw_intro(s);
+}
 
-        if (s->max_y > 1 && s->max_x > s->loss_msg_len) {
-            int y = 1 + (rand() % (s->max_y - 1));
-            int x = rand() % (s->max_x - s->loss_msg_len);
-            int pair = random_color_pair(s->color_count);
-
-            if (pair > 0 && has_colors()) {
-                attron(COLOR_PAIR(pair) | A_BOLD);
-                mvaddstr(y, x, s->loss_msg);
-                attroff(COLOR_PAIR(pair) | A_BOLD);
-            } else {
-                mvaddstr(y, x, s->loss_msg);
-            }
-        }
+static void intro_phase_done(AppState *s) {
+    Scene *sc = &s->scene;
 
-        refresh();
-        usleep(25000);
+    if (sc->phase == INTRO_BOOT) {
+        if (sc->name_done) {
+            intro_accept_name(s);
+            return;
+        }
+        sc->phase = INTRO_NAME;
+        ui_cursor(s, true);
+        draw_intro(s);
+        return;
     }
+
+    s->desktop_selected_icon = sc->selected;
+    cf_meta_begin(&s->meta);
+    s->intro_completed = true;
+    scene_finish(s);
 }
 
-/* --------------------- AI turn --------------------- */
-static int ai_take_turn(AppState *s) {
-    int pick = cf_ai_choose_move_ex(&s->game, ai_search_depth(s), s->blocked_cols);
-    if (pick >= 0) {
-        cf_drop_piece(&s->game, pick, CF_AI);
-        vm_add_log(s, "[MOVE] AI dropped in column %d.", pick + 1);
+/* ---- "Punishment" action (safe VM incident simulation) ---- */
+static void draw_incident(AppState *s) {
+    const Scene *sc = &s->scene;
+    int y = s->max_y - 13;
+    CfRenderer *out = s->render.out;
+    CfRenderArea screen = screen_area(s);
+
+    draw_board_ui(s);
+    if (sc->phase != INCIDENT_REPORT) {
+        return;
+    }
+    if (y < 2) {
+        y = 2;
     }
-    return pick;
+
+    /* Drawn over the board and console; the next frame after the scene repaints them. */
+    print_title(s, y, 2, 1, "AI VICTORY TAX COLLECTED! [Persistent Incident] ");
+    cf_render_printf(out, screen, y + 1, 4, 0, "Incident: %s", sc->lines[0]);
+    cf_render_text(out, screen, y + 2, 4, 0, sc->lines[1]);
+    cf_render_text(out, screen, y + 3, 4, 0, sc->lines[2]);
+    cf_render_text(out, screen, y + 4, 4, 0, sc->lines[3]);
+    cf_render_text(out, screen, y + 5, 4, 0, sc->lines[4]);
+    cf_render_printf(out, screen, y + 6, 4, 0, "Stack level: %d (repeats get worse)", sc->severity);
+    cf_render_printf(out, screen, y + 7, 4, 0, "Threat level: %d", sc->pressure);
+    cf_render_printf(out, screen, y + 8, 4, 0, "System compromised: %d%%", s->meta.compromised_pct);
+    cf_render_text(out, screen, y + 9, 4, 0, sc->lines[5]);
+    cf_render_text(out, screen, y + 10, 4, 0, "Press any key to acknowledge incident report.");
+    cf_render_present(out);
 }
 
-int main(void) {
-    AppState s = {0};
-    unsigned int seed = make_seed();
+static void incident_pulse(AppState *s) {
+    Scene *sc = &s->scene;
 
-    srand(seed);
+    if (sc->pulse_flash) {
+        ui_flash(s);
+    } else {
+        ui_beep(s);
+    }
+    sc->pulses_left -= 1;
+}
 
-    nc_init(&s);
-    app_update_dimensions(&s);
-    run_fake_desktop_intro(&s);
-    board_clear(&s);
+static void incident_report(AppState *s, double now) {
+    Scene *sc = &s->scene;
 
-    while (true) {
-        int ch;
+    sc->phase = INCIDENT_REPORT;
+    scene_set_frames(sc, 0, now);
+    ui_flush_input(s);
+    draw_incident(s);
+}
 
-        s.vm_ticks += 1;
-        app_update_dimensions(&s);
-        draw_board_ui(&s);
+/* Multi-step payloads (WDEF, SevenDust) pulse on frames `pulse_ms` apart before the report shows. */
+static void start_incident(AppState *s, double now) {
+    Scene *sc = &s->scene;
+    int code = cf_meta_ai_won(&s->meta, &s->rng[RNG_PUNISHMENTS]);
+    double pulse_ms = 0;
 
-        ch = getch();
-        if (ch == ERR) {
-            process_auto_restart(&s);
-            usleep(12000);
-            continue;
-        }
+    sc->severity = incident_stack(s, code);
+    sc->pressure = infection_pressure(s);
+    cf_metric_add(s->metrics.incidents[code - 1], 1);
+    mark_dirty(s, RENDER_EFFECTS);
 
-        if (ch == 'q' || ch == 'Q') {
+    switch (code) {
+        case CF_INCIDENT_NVIR:
+            sc->lines[0] = "nVIR family";
+            vm_set_alert(s, "nVIR-like resource infection detected.", "[nVIR] Don't panic!");
+            sc->lines[1] = "[nVIR] System file resource fork patched (simulated).";
+            sc->lines[2] = "[nVIR] Random beep payload triggered.";
+            sc->lines[3] = "[nVIR] MacinTalk ghost message: \"Don't panic!\"";
+            sc->lines[4] = "[AV] Quarantine complete. No host changes were made.";
+            sc->lines[5] = "Next games: input jitter and random move reroutes intensify.";
+            ui_beep(s);
+            ui_beep(s);
+            vm_add_log(s, "[ALERT] nVIR signature matched in guest System file.");
             break;
-        }
 
-        if (ch == 'r' || ch == 'R') {
-            board_clear(&s);
-            continue;
-        }
+        case CF_INCIDENT_MDEF:
+            sc->lines[0] = "MDEF / Garfield + CDEF";
+            vm_set_alert(s, "Menu definition resources corrupted.", "[MDEF] Menus are cursed");
+            sc->lines[1] = "[MDEF] Menu manager hooks replaced (simulated).";
+            sc->lines[2] = "[CDEF] Control definition conflict injects visual glitches.";
+            sc->lines[3] = "[UI] Menus become garbled; random crash dialog appears.";
+            sc->lines[4] = "[AV] Restored clean menu resources in fake VM snapshot.";
+            sc->lines[5] = "Next games: control remap drift gets stronger.";
+            ui_flash(s);
+            vm_add_log(s, "[ALERT] MDEF/CDEF resource tampering event.");
+            break;
 
-        if (s.game_over) {
-            process_auto_restart(&s);
-            continue;
+        case CF_INCIDENT_WDEF:
+            sc->lines[0] = "WDEF + Zuc floppy chain";
+            vm_set_alert(s, "Desktop and floppy boot chain anomalies.", "[WDEF] Desktop file chaos");
+            sc->lines[1] = "[WDEF] Desktop file metadata drift detected.";
+            sc->lines[2] = "[Zuc] Infected floppy boot block mounted (simulated).";
+            sc->lines[3] = "[FINDER] Icons flicker, folder views degrade, boot slows down.";
+            sc->lines[4] = "[AV] Desktop rebuilt; floppy image isolated from startup path.";
+            sc->lines[5] = "Next games: locked columns persist and stack with repeats.";
+            sc->pulses_left = 2;
+            sc->pulse_flash = false;
+            pulse_ms = 180;
+            vm_add_log(s, "[ALERT] WDEF desktop integrity mismatch.");
+            break;
+
+        case CF_INCIDENT_MACRO:
+            sc->lines[0] = "Office macro wave (Concept/Laroux)";
+            vm_set_alert(s, "Macro propagation via shared docs.", "[MACRO] Concept/Laroux spread");
+            sc->lines[1] = "[DOC] Word template altered by Concept-like macro (simulated).";
+            sc->lines[2] = "[XLS] Laroux-style macro copied into workbook startup path.";
+            sc->lines[3] = "[NET] Cross-platform file share became infection route.";
+            sc->lines[4] = "[AV] Macros disabled and startup templates replaced.";
+            sc->lines[5] = "Next games: AI search depth increases.";
+            ui_flash(s);
+            ui_beep(s);
+            vm_add_log(s, "[ALERT] Macro payload detected in Office documents.");
+            break;
+
+        case CF_INCIDENT_AUTOSTART:
+            sc->lines[0] = "AutoStart 9805 worm";
+            vm_set_alert(s, "AutoStart media autorun exploited.", "[AUTOSTART] CD worm loaded");
+            sc->lines[1] = "[CD-ROM] AutoStart trigger fired on media insert (simulated).";
+            sc->lines[2] = "[WORM] Autorun app copied itself to removable volumes.";
+            sc->lines[3] = "[CHAIN] No click required once disc was inserted.";
+            sc->lines[4] = "[AV] AutoStart disabled in guest control panel profile.";
+            sc->lines[5] = "Next games: AI starts with opening move(s).";
+            ui_flash(s);
+            vm_add_log(s, "[ALERT] AutoStart worm behavior in guest media stack.");
+            break;
+
+        case CF_INCIDENT_SEVENDUST:
+        default:
+            sc->lines[0] = "SevenDust / 666 polymorph";
+            vm_set_alert(s, "SevenDust timed payload window entered.", "[666] Timed payload trip");
+            sc->lines[1] = "[666] MDEF-extension polymorph variant A/F observed.";
+            sc->lines[2] = "[TIME] 06:00-07:00 trigger window reached (simulated).";
+            sc->lines[3] = "[PAYLOAD] Attempted non-app file deletion on startup disk.";
+            sc->lines[4] = "[AV] Snapshot rollback blocked all destructive writes.";
+            sc->lines[5] = "Next games: your placed tokens may randomly be deleted.";
+            sc->pulses_left = 3;
+            sc->pulse_flash = true;
+            pulse_ms = 200;
+            vm_add_log(s, "[ALERT] SevenDust/666 polymorphic chain detected.");
+            break;
+    }
+
+    vm_add_log(s, "[STACK] %s severity increased to %d.", sc->lines[0], sc->severity);
+    vm_add_log(s, "[THREAT] Global pressure now %d.", sc->pressure);
+    vm_add_log(s, "[THREAT] System compromised now %d%%.", s->meta.compromised_pct);
+
+    if (sc->pulses_left == 0) {
+        incident_report(s, now);
+        return;
+    }
+    sc->phase = INCIDENT_PULSES;
+    draw_incident(s);
+    incident_pulse(s);
+    scene_set_frames(sc, pulse_ms, now);
+}
+
+/* ---- Loss flood ---- */
+static void draw_squiggles_header(AppState *s) {
+    cf_render_clear(s->render.out, screen_area(s));
+    cf_render_text(s->render.out, screen_area(s), 0, 0, 0, "Classic Mac VM corruption mode: press any key to return...");
+    cf_render_present(s->render.out);
+}
+
+static void squiggles_frame(AppState *s) {
+    if (s->max_y > 1 && s->max_x > s->loss_msg_len) {
+        int y = 1 + roll(s, RNG_COSMETIC, s->max_y - 1);
+        int x = roll(s, RNG_COSMETIC, s->max_x - s->loss_msg_len);
+        int pair = random_color_pair(s);
+
+        cf_render_text(s->render.out, screen_area(s), y, x, pair > 0 ? color_attr(s, pair) : 0, s->loss_msg);
+    }
+    cf_render_present(s->render.out);
+}
+
+/* ---- Intermission mini-game: bitcoin miner ---- */
+static void draw_mining(const AppState *s, double now) {
+    static const char spinner[4] = {'|', '/', '-', '\\'};
+    const Scene *sc = &s->scene;
+    int remaining = (int)((sc->deadline_ms - now + 999.0) / 1000.0);
+    int filled = clamp_int((sc->count * 24) / sc->target, 0, 24);
+    char bar[25];
+    CfRenderer *out = s->render.out;
+    CfRenderArea screen = screen_area(s);
+
+    for (int i = 0; i < 24; ++i) {
+        bar[i] = (i < filled) ? '#' : '.';
+    }
+    bar[24] = '\0';
+
+    cf_render_clear(out, screen);
+    print_title(s, 1, 2, 6, "INTERMISSION MINI-GAME: BITCOIN MINER 0.9");
+    cf_render_text(out, screen, 3, 2, 0, "Mash SPACE to mine blocks before timeout.");
+    cf_render_printf(out, screen, 4, 2, 0, "Compromised systems need more hashes. Build: [%c]", spinner[sc->frames % 4]);
+    cf_render_printf(out, screen, 6, 2, 0, "Progress [%s]  %d / %d hashes", bar, sc->count, sc->target);
+    cf_render_printf(out, screen, 7, 2, 0, "Time left: %d sec", remaining > 0 ? remaining : 0);
+    if (sc->rig.threads > 0) {
+        cf_render_printf(
+            out,
+            screen,
+            8,
+            2,
+            0,
+            "Rig: %s x%d  %.2f MH/s  target %d zero bits  shares %llu  best %d bits",
+            cf_sha_kernel_name(sc->rig.kernel),
+            sc->rig.threads,
+            sc->rig.seconds > 0 ? (double)sc->rig.hashes / sc->rig.seconds / 1e6 : 0.0,
+            sc->rig.zero_bits,
+            (unsigned long long)sc->rig.shares,
+            sc->rig.best_bits
+        );
+    }
+    cf_render_text(out, screen, 10, 2, 0, "Press SPACE repeatedly. Press any other key to keep going.");
+    if (sc->phase == MINIGAME_RESULT) {
+        cf_render_text(out, screen, 12, 2, 0, sc->message);
+    }
+    cf_render_present(out);
+}
+
+/*
+ * The rig: real double SHA-256 on a made-up header (connect_four_miner.c),
+ * leaving one core to the game. It only supplies what the screen shows;
+ * progress stays in the seeded units above, so replays are unaffected and
+ * headless runs skip it.
+ */
+static void mining_rig_start(AppState *s) {
+    uint8_t header[CF_BLOCK_HEADER_BYTES];
+    char seed_text[64];
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t stamp = (uint32_t)time(NULL);
+
+    if (g_headless) {
+        return;
+    }
+    memset(header, 0, sizeof(header));
+    header[0] = 2;
+    snprintf(seed_text, sizeof(seed_text), "%llu", (unsigned long long)s->seed);
+    cf_sha256((const uint8_t *)seed_text, strlen(seed_text), header + 4);
+    snprintf(seed_text, sizeof(seed_text), "round %d", s->meta.total_wins + s->meta.total_losses);
+    cf_sha256((const uint8_t *)seed_text, strlen(seed_text), header + 36);
+    for (int i = 0; i < 4; ++i) {
+        header[68 + i] = (uint8_t)(stamp >> (8 * i));
+    }
+    s->miner = cf_miner_start(
+        header,
+        cf_sha_best_kernel(),
+        cpus > 1 ? (int)cpus - 1 : 1,
+        MINING_BASE_BITS + s->scene.target / 2
+    );
+    cf_miner_stats(s->miner, &s->scene.rig);
+}
+
+/* Keeps the last numbers on screen for the result phase. */
+static void mining_rig_stop(AppState *s) {
+    if (s->miner == NULL) {
+        return;
+    }
+    cf_miner_stats(s->miner, &s->scene.rig);
+    cf_miner_stop(s->miner);
+    s->miner = NULL;
+}
+
+static void start_mining(AppState *s, double now) {
+    Scene *sc = &s->scene;
+
+    ui_flush_input(s);
+    sc->phase = MINIGAME_PLAY;
+    sc->target = cf_meta_mining_target(&s->meta);
+    sc->deadline_ms = now + MINING_ROUND_SECONDS * 1000.0;
+    mining_rig_start(s);
+    draw_mining(s, now);
+}
+
+/* One SPACE counts per frame, as when each frame read a single key. */
+static void mining_frame(AppState *s, double now) {
+    Scene *sc = &s->scene;
+
+    if (sc->key_pending) {
+        sc->key_pending = false;
+        sc->count += 1 + roll(s, RNG_MINIGAMES, 2);
+        if (roll(s, RNG_MINIGAMES, 100) < 12) {
+            ui_beep(s);
         }
+    }
+    if (roll(s, RNG_MINIGAMES, 100) < 4) {
+        sc->count += 1;
+    }
 
-        if (ch == KEY_LEFT || ch == 'a' || ch == 'A') {
-            move_cursor_to_next_open(&s, -1);
-            continue;
+    if (sc->count < sc->target && now < sc->deadline_ms) {
+        sc->frames += 1;
+        cf_miner_stats(s->miner, &sc->rig);
+        draw_mining(s, now);
+        return;
+    }
+    mining_rig_stop(s);
+
+    if (sc->count >= sc->target) {
+        int before = s->meta.compromised_pct;
+        cf_meta_minigame_result(&s->meta, CF_MINIGAME_MINING, true);
+        vm_add_log(s, "[MINIGAME] Mining success. Compromised %d%% -> %d%%.", before, s->meta.compromised_pct);
+        snprintf(sc->message, sizeof(sc->message), "Success: mined enough blocks. System patched slightly.");
+    } else {
+        int before = s->meta.compromised_pct;
+        cf_meta_minigame_result(&s->meta, CF_MINIGAME_MINING, false);
+        vm_add_log(s, "[MINIGAME] Mining failed. Compromised %d%% -> %d%%.", before, s->meta.compromised_pct);
+        snprintf(sc->message, sizeof(sc->message), "Failure: miner overheated. Malware slipped in.");
+    }
+    scene_hold(sc, MINIGAME_RESULT, 1200, now);
+    draw_mining(s, now);
+}
+
+/* ---- Intermission mini-game: phishing detector ---- */
+static void draw_phishing(const AppState *s, double now) {
+    const Scene *sc = &s->scene;
+    int remaining = (int)((sc->deadline_ms - now + 999.0) / 1000.0);
+    CfCorpusEntry prompt;
+    CfRenderer *out = s->render.out;
+    CfRenderArea screen = screen_area(s);
+
+    cf_render_clear(out, screen);
+    if (sc->phase != MINIGAME_PLAY) {
+        cf_render_text(out, screen, 5, 2, 0, sc->message);
+        cf_render_present(out);
+        return;
+    }
+    print_title(s, 1, 2, 2, "INTERMISSION MINI-GAME: PHISHING DETECTOR");
+    cf_render_printf(out, screen, 3, 2, 0, "Question %d/%d", sc->question + 1, PHISHING_QUESTIONS);
+    phishing_prompt(s, sc->prompt, &prompt);
+    cf_render_printf(out, screen, 5, 2, 0, "%.*s", clamp_int((int)prompt.len, 0, s->max_x - 4), prompt.text);
+    cf_render_text(out, screen, 7, 2, 0, "Press P = phishing, S = safe");
+    cf_render_printf(out, screen, 8, 2, 0, "Time left: %d sec", remaining > 0 ? remaining : 0);
+    cf_render_present(out);
+}
+
+static void phishing_ask(AppState *s, double now) {
+    Scene *sc = &s->scene;
+
+    sc->phase = MINIGAME_PLAY;
+    if (s->corpus != NULL) {
+        sc->prompt = cf_shuffle_next(&s->corpus_shuffle, &s->rng[RNG_MINIGAMES]);
+    } else {
+        sc->prompt = (uint64_t)roll(s, RNG_MINIGAMES, (int)(sizeof(kPrompts) / sizeof(kPrompts[0])));
+    }
+    sc->choice = -1;
+    sc->deadline_ms = now + 8000.0;
+    scene_set_frames(sc, 1000.0 / kSceneFps[SCENE_PHISHING], now);
+    draw_phishing(s, now);
+}
+
+static void phishing_answer(AppState *s, double now) {
+    Scene *sc = &s->scene;
+    CfCorpusEntry prompt;
+    bool correct;
+
+    phishing_prompt(s, sc->prompt, &prompt);
+    correct = sc->choice >= 0 && (sc->choice == 1) == prompt.phishing;
+
+    if (correct) {
+        sc->count += 1;
+        snprintf(sc->message, sizeof(sc->message), "Correct.");
+        ui_beep(s);
+    } else {
+        snprintf(sc->message, sizeof(sc->message), "Wrong. That one fooled you.");
+    }
+    scene_hold(sc, MINIGAME_FEEDBACK, 700, now);
+    draw_phishing(s, now);
+}
+
+static void phishing_phase_done(AppState *s, double now) {
+    Scene *sc = &s->scene;
+    int before = s->meta.compromised_pct;
+
+    if (sc->phase == MINIGAME_RESULT) {
+        scene_finish(s);
+        return;
+    }
+    sc->question += 1;
+    if (sc->question < PHISHING_QUESTIONS) {
+        phishing_ask(s, now);
+        return;
+    }
+
+    if (sc->count >= 2) {
+        cf_meta_minigame_result(&s->meta, CF_MINIGAME_PHISHING, true);
+        vm_add_log(s, "[MINIGAME] Phishing drill passed (%d/%d). %d%% -> %d%%.", sc->count, PHISHING_QUESTIONS, before, s->meta.compromised_pct);
+        snprintf(sc->message, sizeof(sc->message), "Drill passed. You avoided most phish.");
+    } else {
+        cf_meta_minigame_result(&s->meta, CF_MINIGAME_PHISHING, false);
+        vm_add_log(s, "[MINIGAME] Phishing drill failed (%d/%d). %d%% -> %d%%.", sc->count, PHISHING_QUESTIONS, before, s->meta.compromised_pct);
+        snprintf(sc->message, sizeof(sc->message), "Drill failed. Several links were clicked.");
+    }
+    scene_hold(sc, MINIGAME_RESULT, 1200, now);
+    draw_phishing(s, now);
+}
+
+static bool maybe_start_intermission_minigame(AppState *s) {
+    int chance = cf_meta_intermission_chance(&s->meta);
+
+    if (roll(s, RNG_MINIGAMES, 100) >= chance) {
+        return false;
+    }
+
+    vm_add_log(s, "[INTERMISSION] Random mini-game launched.");
+    scene_start(s, roll(s, RNG_MINIGAMES, 2) == 0 ? SCENE_MINING : SCENE_PHISHING);
+    return true;
+}
+
+/* ---- Scene dispatch ---- */
+static void scene_start(AppState *s, int kind) {
+    Scene *sc = &s->scene;
+    double now = s->clock_ms;
+
+    memset(sc, 0, sizeof(*sc));
+    sc->kind = kind;
+    CF_TRACE_BEGIN(kSceneTraceNames[kind]);
+    if (kSceneFps[kind] > 0) {
+        scene_set_frames(sc, 1000.0 / kSceneFps[kind], now);
+    }
+
+    switch (kind) {
+        case SCENE_INTRO:
+            scene_hold(sc, INTRO_BOOT, 700, now);
+            draw_intro(s);
+            break;
+        case SCENE_INCIDENT:
+            start_incident(s, now);
+            break;
+        case SCENE_SQUIGGLES:
+            draw_squiggles_header(s);
+            break;
+        case SCENE_MINING:
+            start_mining(s, now);
+            break;
+        case SCENE_PHISHING:
+        default:
+            ui_flush_input(s);
+            phishing_ask(s, now);
+            break;
+    }
+    scene_arm(s);
+}
+
+static void scene_tick(AppState *s) {
+    Scene *sc = &s->scene;
+    double now = s->clock_ms;
+
+    if (sc->phase_end_ms > 0 && now >= sc->phase_end_ms) {
+        sc->phase_end_ms = 0;
+        switch (sc->kind) {
+            case SCENE_INTRO:
+                intro_phase_done(s);
+                break;
+            case SCENE_PHISHING:
+                phishing_phase_done(s, now);
+                break;
+            default:
+                scene_finish(s);
+                break;
         }
-        if (ch == KEY_RIGHT || ch == 'd' || ch == 'D') {
-            move_cursor_to_next_open(&s, 1);
-            continue;
+    } else if (sc->next_frame_ms > 0 && now >= sc->next_frame_ms) {
+        scene_next_frame(s, now);
+        switch (sc->kind) {
+            case SCENE_INCIDENT:
+                if (sc->pulses_left > 0) {
+                    incident_pulse(s);
+                } else {
+                    incident_report(s, now);
+                }
+                break;
+            case SCENE_SQUIGGLES:
+                squiggles_frame(s);
+                break;
+            case SCENE_MINING:
+                mining_frame(s, now);
+                break;
+            case SCENE_PHISHING:
+                if (now >= sc->deadline_ms) {
+                    phishing_answer(s, now);
+                } else {
+                    draw_phishing(s, now);
+                }
+                break;
+            default:
+                break;
         }
-        if (ch >= '1' && ch <= '0' + CF_COLS) {
-            int display_col = ch - '1';
-            int requested = logical_col_from_display(&s, display_col);
-            s.cursor_col = requested;
-            if (s.blocked_cols[requested]) {
-                snprintf(s.status, sizeof(s.status), "Column %d is locked this round.", display_col + 1);
+    }
+    scene_arm(s);
+}
+
+static void scene_key(AppState *s, int ch) {
+    Scene *sc = &s->scene;
+    double now = s->clock_ms;
+
+    switch (sc->kind) {
+        case SCENE_INTRO:
+            intro_key(s, ch, now);
+            break;
+        case SCENE_INCIDENT:
+            if (sc->phase == INCIDENT_REPORT) {
+                scene_finish(s);
             }
-            continue;
+            break;
+        case SCENE_SQUIGGLES:
+            scene_finish(s);
+            break;
+        case SCENE_MINING:
+            if (ch == ' ' && sc->phase == MINIGAME_PLAY) {
+                sc->key_pending = true;
+            }
+            break;
+        case SCENE_PHISHING:
+            if (sc->phase == MINIGAME_PLAY && (ch == 'p' || ch == 'P' || ch == 's' || ch == 'S')) {
+                sc->choice = (ch == 'p' || ch == 'P') ? 1 : 0;
+                phishing_answer(s, now);
+            }
+            break;
+        default:
+            break;
+    }
+    scene_arm(s);
+}
+
+/* The terminal was cleared by the resize, so the scene repaints from its state. */
+static void scene_resize(AppState *s) {
+    double now = session_now(s);
+
+    cf_render_invalidate(s->render.out);
+    render_invalidate(s);
+    switch (s->scene.kind) {
+        case SCENE_INTRO:
+            draw_intro(s);
+            break;
+        case SCENE_INCIDENT:
+            draw_incident(s);
+            break;
+        case SCENE_SQUIGGLES:
+            draw_squiggles_header(s);
+            break;
+        case SCENE_MINING:
+            draw_mining(s, now);
+            break;
+        case SCENE_PHISHING:
+            draw_phishing(s, now);
+            break;
+        default:
+            break;
+    }
+}
+
+/* --------------------- Turns --------------------- */
+static void finish_ai_turn(AppState *s) {
+    int ai_col;
+
+    ai_job_join(s);
+    s->turn = TURN_PLAYER;
+    s->timer_due_ms[TIMER_TURN] = 0;
+
+    ai_col = ai_job_apply(s, &s->ai_job);
+    if (ai_col >= 0) {
+        cf_drop_piece(&s->game, ai_col, CF_AI);
+        record_ai_drop(s, ai_col);
+        mark_dirty(s, RENDER_BOARD);
+        vm_add_log(s, "[MOVE] AI dropped in column %d.", ai_col + 1);
+    }
+    if (ai_col < 0) {
+        s->game_over = true;
+        s->winner = 0;
+        set_status(s, "No playable columns remain.");
+        vm_add_log(s, "[RESULT] Draw. Move queue exhausted.");
+        arm_auto_restart(s);
+        return;
+    }
+
+    if (cf_has_winner(&s->game, CF_AI)) {
+        s->game_over = true;
+        s->winner = 2;
+        set_status(s, "AI played column %d and won.", ai_col + 1);
+        vm_add_log(s, "[RESULT] AI victory. Incident simulation armed.");
+        /* The incident report, then the loss flood; the restart is armed when that is dismissed. */
+        scene_start(s, SCENE_INCIDENT);
+        return;
+    }
+    if (round_is_draw(s)) {
+        s->game_over = true;
+        s->winner = 0;
+        set_status(s, "No playable columns remain.");
+        vm_add_log(s, "[RESULT] Draw. Guest state unchanged.");
+        arm_auto_restart(s);
+        return;
+    }
+
+    set_status(s, "AI played column %d. Your move.", ai_col + 1);
+}
+
+static void land_player_drop(AppState *s, int raw_col, int final_col) {
+    s->turn = TURN_PLAYER;
+    s->timer_due_ms[TIMER_TURN] = 0;
+
+    if (!is_playable_col(s, final_col)) {
+        ui_beep(s);
+        set_status(
+            s,
+            "Mapped column %d is unavailable (raw %d).",
+            final_col + 1,
+            raw_col + 1
+        );
+        return;
+    }
+
+    cf_drop_piece(&s->game, final_col, CF_HUMAN);
+    cf_game_record_event(&s->round_record, CF_EVENT_HUMAN, final_col, 0);
+    mark_dirty(s, RENDER_BOARD);
+    if (final_col == raw_col) {
+        vm_add_log(s, "[MOVE] Human dropped in column %d.", final_col + 1);
+    } else {
+        vm_add_log(s, "[MOVE] Human selected %d -> landed %d.", raw_col + 1, final_col + 1);
+    }
+    consume_player_turn_effects(s);
+
+    if (cf_has_winner(&s->game, CF_HUMAN)) {
+        s->game_over = true;
+        s->winner = 1;
+        set_status(s, "You connected four first.");
+        vm_set_alert(s, "No active incident.", "You beat the VM");
+        reduce_infection_after_player_win(s);
+        vm_add_log(s, "[RESULT] Human victory. Guest stabilized.");
+        arm_auto_restart(s);
+        return;
+    }
+    if (round_is_draw(s)) {
+        s->game_over = true;
+        s->winner = 0;
+        set_status(s, "No playable columns remain.");
+        vm_add_log(s, "[RESULT] Draw. No incident triggered.");
+        arm_auto_restart(s);
+        return;
+    }
+
+    maybe_corrupt_player_piece(s);
+
+    if (round_is_draw(s)) {
+        s->game_over = true;
+        s->winner = 0;
+        set_status(s, "No playable columns remain.");
+        vm_add_log(s, "[RESULT] Draw after corruption pulse.");
+        arm_auto_restart(s);
+        return;
+    }
+
+    /* The search runs while "thinking" is on screen; the move lands after both are done. */
+    set_status(s, "AI is thinking...");
+    s->turn = TURN_AI;
+    s->timer_due_ms[TIMER_TURN] = s->clock_ms + AI_THINK_MS;
+    ai_job_start(s);
+}
+
+static void player_drop(AppState *s) {
+    int raw_col = s->cursor_col;
+    int mapped_col = cf_meta_remap_col(&s->fx, raw_col);
+    int flipped_col = cf_meta_flip_col(&s->fx, mapped_col);
+    int final_col = maybe_glitch_drop_col(s, flipped_col);
+    int before_forced = final_col;
+
+    if (flipped_col != mapped_col) {
+        vm_add_log(s, "[MIRROR] Grid flip redirected %d -> %d.", mapped_col + 1, flipped_col + 1);
+    }
+
+    final_col = maybe_forced_virus_move(s, raw_col, final_col);
+    if (final_col != before_forced) {
+        /* Leave the hijack message up for a moment before the piece lands. */
+        s->turn = TURN_HIJACKED;
+        s->pending_raw_col = raw_col;
+        s->pending_col = final_col;
+        s->timer_due_ms[TIMER_TURN] = s->clock_ms + HIJACK_PAUSE_MS;
+        return;
+    }
+    land_player_drop(s, raw_col, final_col);
+}
+
+/*
+ * Once TIMER_TURN has passed during the AI's turn it is disarmed and the
+ * worker's wake-up takes over. Returns whether the AI's move landed.
+ */
+static bool advance_turn(AppState *s, double now) {
+    double due = s->timer_due_ms[TIMER_TURN];
+
+    if (s->turn == TURN_HIJACKED && now >= due) {
+        land_player_drop(s, s->pending_raw_col, s->pending_col);
+        return false;
+    }
+    if (s->turn != TURN_AI) {
+        return false;
+    }
+    if (due > 0 && now >= due) {
+        s->timer_due_ms[TIMER_TURN] = 0;
+    }
+    if (s->timer_due_ms[TIMER_TURN] != 0 || !ai_job_ready(s)) {
+        return false;
+    }
+    CF_TRACE_BEGIN("finish_ai_turn");
+    finish_ai_turn(s);
+    CF_TRACE_END("finish_ai_turn");
+    return true;
+}
+
+/* Frame time is the last draw that painted something; the loop rate is refreshed once a second. */
+static void update_loop_stats(AppState *s, double frame_start, bool painted) {
+    double now = monotonic_ms();
+
+    if (painted) {
+        s->frame_ms = now - frame_start;
+        cf_metric_observe(s->metrics.frame_time, s->frame_ms / 1000.0);
+    }
+    s->loop_count += 1;
+    if (now - s->loop_window_start >= 1000.0) {
+        s->loop_rate = (double)s->loop_count * 1000.0 / (now - s->loop_window_start);
+        s->loop_count = 0;
+        s->loop_window_start = now;
+    }
+}
+
+/* --------------------- Event loop --------------------- */
+static double next_spinner_tick(double now) {
+    return ((double)(long long)(now / SPINNER_FRAME_MS) + 1.0) * SPINNER_FRAME_MS;
+}
+
+static double next_timer_due(const AppState *s) {
+    double due = 0;
+
+    for (int i = 0; i < TIMER_COUNT; ++i) {
+        if (s->timer_due_ms[i] > 0 && (due == 0 || s->timer_due_ms[i] < due)) {
+            due = s->timer_due_ms[i];
         }
+    }
+    return due;
+}
 
-        if (ch == ' ' || ch == '\n' || ch == KEY_ENTER) {
-            int raw_col = s.cursor_col;
-            int mapped_col = remap_drop_col(&s, raw_col);
-            int flipped_col = apply_flip_to_drop_col(&s, mapped_col);
-            int final_col = maybe_glitch_drop_col(&s, flipped_col);
-            int before_forced = final_col;
-            int ai_col;
+static bool timer_due(const AppState *s, int timer, double now) {
+    return s->timer_due_ms[timer] > 0 && now >= s->timer_due_ms[timer];
+}
 
-            if (flipped_col != mapped_col) {
-                vm_add_log(&s, "[MIRROR] Grid flip redirected %d -> %d.", mapped_col + 1, flipped_col + 1);
-            }
+/* Runs whatever is due at s->clock_ms. Returns the REC_* code for the tick, or -1 if it changed nothing. */
+static int run_due_timers(AppState *s) {
+    double now = s->clock_ms;
+    bool acted = false;
 
-            final_col = maybe_forced_virus_move(&s, raw_col, final_col);
-            if (final_col != before_forced) {
-                draw_board_ui(&s);
-                usleep(180000);
-            }
+    /* The spinner timer only wakes the loop; the next frame sees the new phase. */
+    if (timer_due(s, TIMER_SPINNER, now)) {
+        s->timer_due_ms[TIMER_SPINNER] = next_spinner_tick(now);
+    }
+    if (timer_due(s, TIMER_AUTO_RESTART, now)) {
+        acted = true;
+        CF_TRACE_BEGIN("process_auto_restart");
+        process_auto_restart(s);
+        CF_TRACE_END("process_auto_restart");
+    }
+    if (timer_due(s, TIMER_ANIMATION, now)) {
+        acted = true;
+        scene_tick(s);
+    }
+    acted = acted || timer_due(s, TIMER_TURN, now);
+    if (advance_turn(s, now)) {
+        return REC_TICK_AI;
+    }
+    return acted ? REC_TICK : -1;
+}
 
-            if (!is_playable_col(&s, final_col)) {
-                beep();
-                snprintf(
-                    s.status,
-                    sizeof(s.status),
-                    "Mapped column %d is unavailable (raw %d).",
-                    final_col + 1,
-                    raw_col + 1
-                );
-                continue;
-            }
+/* A live tick: reads the clock, runs the timers and records the tick if it mattered. */
+static void session_tick(AppState *s) {
+    int code;
 
-            cf_drop_piece(&s.game, final_col, CF_HUMAN);
-            if (final_col == raw_col) {
-                vm_add_log(&s, "[MOVE] Human dropped in column %d.", final_col + 1);
-            } else {
-                vm_add_log(&s, "[MOVE] Human selected %d -> landed %d.", raw_col + 1, final_col + 1);
-            }
-            consume_player_turn_effects(&s);
-
-            if (cf_has_winner(&s.game, CF_HUMAN)) {
-                s.game_over = true;
-                s.winner = 1;
-                snprintf(s.status, sizeof(s.status), "You connected four first.");
-                vm_set_alert(&s, "No active incident.", "You beat the VM");
-                reduce_infection_after_player_win(&s);
-                vm_add_log(&s, "[RESULT] Human victory. Guest stabilized.");
-                arm_auto_restart(&s);
-                continue;
-            }
-            if (round_is_draw(&s)) {
-                s.game_over = true;
-                s.winner = 0;
-                snprintf(s.status, sizeof(s.status), "No playable columns remain.");
-                vm_add_log(&s, "[RESULT] Draw. No incident triggered.");
-                arm_auto_restart(&s);
-                continue;
-            }
+    s->clock_ms = session_now(s);
+    code = run_due_timers(s);
+    if (code >= 0) {
+        cf_recorder_event(s->recorder, (uint64_t)s->clock_ms, (uint32_t)code);
+    }
+}
 
-            maybe_corrupt_player_piece(&s);
+/* Sleeps until input, a resize, the AI worker or the next timer; falls back to the old 12 ms poll. */
+static void wait_for_work(AppState *s) {
+    double due = next_timer_due(s);
+    double timeout_ms = -1;
+    unsigned events;
 
-            if (round_is_draw(&s)) {
-                s.game_over = true;
-                s.winner = 0;
-                snprintf(s.status, sizeof(s.status), "No playable columns remain.");
-                vm_add_log(&s, "[RESULT] Draw after corruption pulse.");
-                arm_auto_restart(&s);
-                continue;
-            }
+    if (!s->event_loop) {
+        vm_sleep(12000);
+        cf_metric_add(s->metrics.idle_ticks, 1);
+        session_tick(s);
+        return;
+    }
 
-            snprintf(s.status, sizeof(s.status), "AI is thinking...");
-            draw_board_ui(&s);
-            usleep(220000);
-
-            ai_col = ai_take_turn(&s);
-            if (ai_col < 0) {
-                s.game_over = true;
-                s.winner = 0;
-                snprintf(s.status, sizeof(s.status), "No playable columns remain.");
-                vm_add_log(&s, "[RESULT] Draw. Move queue exhausted.");
-                arm_auto_restart(&s);
-                continue;
+    if (due > 0) {
+        /* A timer that came due while handling input fires without sleeping. */
+        timeout_ms = due - session_now(s);
+        timeout_ms = timeout_ms > 0 ? timeout_ms : 0;
+    }
+    CF_TRACE_BEGIN("wait");
+    events = cf_events_wait(timeout_ms);
+    CF_TRACE_END("wait");
+    if ((events & CF_EVENT_TIMEOUT) != 0) {
+        cf_metric_add(s->metrics.idle_ticks, 1);
+    }
+    session_tick(s);
+}
+
+/* One key from the player, live or replayed. Returns false when it quits the game. */
+static bool handle_key(AppState *s, int ch) {
+    if (s->scene.kind != SCENE_NONE) {
+        scene_key(s, ch);
+        return true;
+    }
+
+    if (ch == 'q' || ch == 'Q') {
+        return false;
+    }
+
+    if (ch == 'r' || ch == 'R') {
+        board_clear(s);
+        return true;
+    }
+
+    if (ch == 'h' || ch == 'H') {
+        s->perf_hud = !s->perf_hud;
+        mark_dirty(s, RENDER_LOGS);
+        return true;
+    }
+
+    if (ch == CF_KEY_PPAGE || ch == CF_KEY_NPAGE) {
+        long page = console_log_rows(s) > 1 ? console_log_rows(s) - 1 : 1;
+        scroll_logs(s, ch == CF_KEY_PPAGE ? page : -page);
+        return true;
+    }
+    if (ch == CF_KEY_HOME || ch == CF_KEY_END) {
+        scroll_logs(s, ch == CF_KEY_HOME ? VM_LOG_CAPACITY : -(long)s->log_scroll);
+        return true;
+    }
+
+    if (s->game_over) {
+        CF_TRACE_BEGIN("process_auto_restart");
+        process_auto_restart(s);
+        CF_TRACE_END("process_auto_restart");
+        return true;
+    }
+
+    if (ch == CF_KEY_LEFT || ch == 'a' || ch == 'A') {
+        move_cursor_to_next_open(s, -1);
+        return true;
+    }
+    if (ch == CF_KEY_RIGHT || ch == 'd' || ch == 'D') {
+        move_cursor_to_next_open(s, 1);
+        return true;
+    }
+    if (ch >= '1' && ch <= '0' + CF_COLS) {
+        int display_col = ch - '1';
+        int requested = logical_col_from_display(s, display_col);
+        s->cursor_col = requested;
+        mark_dirty(s, RENDER_CURSOR);
+        if (s->fx.blocked_cols[requested]) {
+            set_status(s, "Column %d is locked this round.", display_col + 1);
+        }
+        return true;
+    }
+
+    if ((ch == ' ' || ch == '\n' || ch == CF_KEY_ENTER) && s->turn == TURN_PLAYER) {
+        player_drop(s);
+    }
+    return true;
+}
+
+/* --------------------- Metrics --------------------- */
+static const char *const kIncidentLabels[CF_INCIDENT_TYPES] = {
+    "type=\"nvir\"",
+    "type=\"mdef\"",
+    "type=\"wdef\"",
+    "type=\"macro\"",
+    "type=\"autostart\"",
+    "type=\"sevendust\""
+};
+static const double kAiLatencyBounds[] = {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5};
+static const double kFrameTimeBounds[] = {0.0001, 0.00025, 0.0005, 0.001, 0.002, 0.004, 0.008, 0.016, 0.033};
+
+/* Starts the exporter named by CF_METRICS (a file path or unix:/socket/path). */
+static void metrics_start(GameMetrics *m) {
+    const char *target = getenv("CF_METRICS");
+    CfMetrics *registry;
+
+    if (target == NULL || target[0] == '\0') {
+        return;
+    }
+    registry = cf_metrics_create();
+    if (registry == NULL) {
+        return;
+    }
+    m->rounds = cf_metrics_add(registry, CF_METRIC_COUNTER, "connect_four_rounds_total", NULL, "Rounds finished (win, loss or draw).");
+    m->wins = cf_metrics_add(registry, CF_METRIC_COUNTER, "connect_four_wins_total", NULL, "Rounds won by the player.");
+    m->losses = cf_metrics_add(registry, CF_METRIC_COUNTER, "connect_four_losses_total", NULL, "Rounds won by the AI.");
+    m->compromised = cf_metrics_add(registry, CF_METRIC_GAUGE, "connect_four_compromised_percent", NULL, "System Compromised meter.");
+    for (int i = 0; i < CF_INCIDENT_TYPES; ++i) {
+        m->incidents[i] = cf_metrics_add(
+            registry,
+            CF_METRIC_COUNTER,
+            "connect_four_incidents_total",
+            kIncidentLabels[i],
+            "Incident simulations run, by type."
+        );
+    }
+    m->ai_latency = cf_metrics_add_histogram(
+        registry,
+        "connect_four_ai_move_seconds",
+        "Wall time of each AI move choice.",
+        kAiLatencyBounds,
+        (int)(sizeof(kAiLatencyBounds) / sizeof(kAiLatencyBounds[0]))
+    );
+    m->frame_time = cf_metrics_add_histogram(
+        registry,
+        "connect_four_frame_seconds",
+        "Time to draw one main-loop frame.",
+        kFrameTimeBounds,
+        (int)(sizeof(kFrameTimeBounds) / sizeof(kFrameTimeBounds[0]))
+    );
+    m->idle_ticks = cf_metrics_add(registry, CF_METRIC_COUNTER, "connect_four_idle_ticks_total", NULL, "Main-loop ticks that found no input and slept.");
+    m->frames_skipped = cf_metrics_add(registry, CF_METRIC_COUNTER, "connect_four_animation_frames_skipped_total", NULL, "Animation frames dropped because the loop ran late.");
+
+    if (!cf_metrics_start(registry, target, METRICS_INTERVAL_MS)) {
+        cf_metrics_destroy(registry);
+        memset(m, 0, sizeof(*m));
+        return;
+    }
+    m->registry = registry;
+}
+
+/* Totals live in AppState; mirroring them once per tick is a handful of relaxed stores. */
+static void metrics_publish(const AppState *s) {
+    cf_metric_set(s->metrics.wins, s->meta.total_wins);
+    cf_metric_set(s->metrics.losses, s->meta.total_losses);
+    cf_metric_set(s->metrics.compromised, s->meta.compromised_pct);
+}
+
+/* --------------------- Spectator feed --------------------- */
+static void feed_start(AppState *s) {
+    const char *name = getenv("CF_FEED");
+
+    if (name == NULL) {
+        return;
+    }
+    s->spectators.feed = cf_feed_open(name[0] != '\0' ? name : CF_FEED_DEFAULT_NAME);
+    s->spectators.scene = -1;
+}
+
+/* Publishes only when a render part, the scene or the turn changed since the last snapshot. */
+static void feed_publish(AppState *s) {
+    SpectatorFeed *sf = &s->spectators;
+    CfFeedSnapshot *snap = &sf->snap;
+    uint64_t count;
+    uint64_t first;
+
+    if (sf->feed == NULL) {
+        return;
+    }
+    if (memcmp(sf->seen, s->render_gen, sizeof(sf->seen)) == 0 && sf->scene == s->scene.kind && sf->turn == s->turn) {
+        return;
+    }
+    memcpy(sf->seen, s->render_gen, sizeof(sf->seen));
+    sf->scene = s->scene.kind;
+    sf->turn = s->turn;
+
+    snap->time_ms = (uint64_t)session_now(s);
+    for (int row = 0; row < CF_ROWS; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            snap->board[row][col] = (int8_t)s->game.board[row][col];
+        }
+    }
+    memcpy(snap->blocked_cols, s->fx.blocked_cols, sizeof(snap->blocked_cols));
+    snap->cursor_col = (int8_t)s->cursor_col;
+    snap->ai_thinking = s->turn != TURN_PLAYER;
+    snap->game_over = s->game_over;
+    snap->winner = (int8_t)s->winner;
+    snap->scene = (int8_t)s->scene.kind;
+    snap->meta = s->meta;
+    snprintf(snap->player_name, sizeof(snap->player_name), "%s", s->player_name);
+    snprintf(snap->status, sizeof(snap->status), "%s", s->status);
+    snprintf(snap->effects, sizeof(snap->effects), "%s", s->effect_summary);
+    snprintf(snap->alert, sizeof(snap->alert), "%s", s->vm_current_alert);
+
+    /* The newest console lines since the last VM boot. */
+    count = cf_log_count(s->log);
+    first = count > CF_FEED_LOG_LINES ? count - CF_FEED_LOG_LINES : 0;
+    first = first < s->log_floor ? s->log_floor : first;
+    first = first < cf_log_first(s->log) ? cf_log_first(s->log) : first;
+    snap->log_count = count;
+    snap->log_lines = 0;
+    for (uint64_t line = first; line < count; ++line) {
+        const char *text = cf_log_line(s->log, line);
+
+        snprintf(snap->log[snap->log_lines++], CF_LOG_CHARS, "%s", text != NULL ? text : "");
+    }
+
+    cf_feed_publish(sf->feed, snap);
+}
+
+/* --------------------- Record / replay --------------------- */
+static void session_seed(AppState *s, uint64_t seed) {
+    s->seed = seed;
+    for (int i = 0; i < RNG_STREAMS; ++i) {
+        cf_rng_seed(&s->rng[i], seed, (uint64_t)i);
+    }
+}
+
+static uint64_t digest_bytes(uint64_t hash, const void *data, size_t len) {
+    const unsigned char *p = data;
+
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t digest_int(uint64_t hash, int value) {
+    return digest_bytes(hash, &value, sizeof(value));
+}
+
+/* FNV-1a over the state a replay has to reproduce; what is on screen and when it was drawn is left out. */
+static uint64_t session_digest(const AppState *s) {
+    uint64_t hash = 14695981039346656037ULL;
+    uint64_t lines = cf_log_count(s->log);
+    const int fields[] = {
+        s->game.moves,
+        s->cursor_col,
+        s->game_over,
+        s->winner,
+        s->meta.last_incident_code,
+        s->meta.total_losses,
+        s->meta.total_wins,
+        s->meta.compromised_pct,
+        s->fx.input_glitch_pct,
+        s->fx.forced_move_pct,
+        s->fx.control_shift,
+        s->fx.control_direction,
+        s->fx.ai_depth_bonus,
+        s->fx.ai_opening_moves,
+        s->fx.player_piece_corrupt_pct,
+        s->fx.flip_turns_remaining,
+        s->fx.purple_turns_remaining,
+        s->turn,
+        s->scene.kind,
+        s->scene.phase
+    };
+
+    for (int row = 0; row < CF_ROWS; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            hash = digest_int(hash, (int)s->game.board[row][col]);
+        }
+    }
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+        hash = digest_int(hash, fields[i]);
+    }
+    for (int i = 0; i < CF_INCIDENT_TYPES; ++i) {
+        hash = digest_int(hash, s->meta.incident_stacks[i]);
+    }
+    for (int col = 0; col < CF_COLS; ++col) {
+        hash = digest_int(hash, s->fx.blocked_cols[col]);
+    }
+    hash = digest_bytes(hash, s->status, strlen(s->status));
+    hash = digest_bytes(hash, s->player_name, strlen(s->player_name));
+    return digest_bytes(hash, &lines, sizeof(lines));
+}
+
+/*
+ * Re-runs a CF_RECORD session with no terminal and no sleeping: each event
+ * sets the session clock and is fed to the same handlers the live loop uses,
+ * so the run is bound by the game logic and the AI alone. Prints throughput
+ * and whether the final state matches the recording's digest.
+ */
+static int run_replay(const char *path, CfEngine *engine) {
+    AppState s = {0};
+    CfReplay *rp = cf_replay_open(path);
+    unsigned long events = 0;
+    unsigned long keys = 0;
+    uint64_t time_ms = 0;
+    uint64_t expected = 0;
+    uint64_t actual;
+    uint32_t code;
+    double started;
+    double wall_ms;
+    bool recorded;
+
+    if (rp == NULL) {
+        fprintf(stderr, "connect-four-virus: cannot read replay %s\n", path);
+        return 2;
+    }
+
+    g_headless = true;
+    s.engine = engine;
+    /* Scenes and frames still draw, into a 0x0 screen: layout-dependent state stays as recorded. */
+    s.render.out = cf_render_open(CF_RENDER_NULL);
+    if (s.render.out == NULL) {
+        fprintf(stderr, "connect-four-virus: out of memory\n");
+        cf_replay_close(rp);
+        return 2;
+    }
+    s.log = cf_log_create(VM_LOG_CAPACITY);
+    session_seed(&s, cf_replay_seed(rp));
+
+    started = monotonic_ms();
+    scene_start(&s, SCENE_INTRO);
+    while (cf_replay_next(rp, &time_ms, &code)) {
+        events += 1;
+        s.clock_ms = (double)time_ms;
+        if (code >= REC_KEY) {
+            keys += 1;
+            if (!handle_key(&s, (int)(code - REC_KEY))) {
+                break;
             }
+            continue;
+        }
+        s.replay_ai_ready = code == REC_TICK_AI;
+        run_due_timers(&s);
+        s.replay_ai_ready = false;
+    }
+    /* After the quit key only the closing record is left. */
+    cf_replay_next(rp, &time_ms, &code);
+    wall_ms = monotonic_ms() - started;
+    actual = session_digest(&s);
+    recorded = cf_replay_digest(rp, &expected);
+
+    printf("Replay %s (seed 0x%016llx)\n", path, (unsigned long long)s.seed);
+    printf("  events      %lu (%lu keys, %lu ticks)\n", events, keys, events - keys);
+    printf("  record      W:%d L:%d | Compromised %d%%\n", s.meta.total_wins, s.meta.total_losses, s.meta.compromised_pct);
+    printf(
+        "  time        %.1f s of play in %.1f ms (%.0fx)\n",
+        s.clock_ms / 1000.0,
+        wall_ms,
+        wall_ms > 0 ? s.clock_ms / wall_ms : 0
+    );
+    printf("  throughput  %.0f events/s\n", wall_ms > 0 ? (double)events * 1000.0 / wall_ms : 0);
+    if (!recorded) {
+        printf("  digest      0x%016llx (recording has none: the session did not quit cleanly)\n", (unsigned long long)actual);
+    } else {
+        printf(
+            "  digest      0x%016llx %s\n",
+            (unsigned long long)actual,
+            expected == actual ? "matches the recording" : "DIFFERS from the recording"
+        );
+    }
 
-            if (cf_has_winner(&s.game, CF_AI)) {
-                s.game_over = true;
-                s.winner = 2;
-                snprintf(s.status, sizeof(s.status), "AI played column %d and won.", ai_col + 1);
-                vm_add_log(&s, "[RESULT] AI victory. Incident simulation armed.");
+    cf_render_close(s.render.out);
+    cf_log_destroy(s.log);
+    cf_replay_close(rp);
+    return recorded && expected != actual ? 1 : 0;
+}
 
+int main(void) {
+    AppState s = {0};
+    const char *record_path = getenv("CF_RECORD");
+    const char *replay_path = getenv("CF_REPLAY");
+    /* Recorded sessions search with a fresh private table and nothing else, so a replay sees the same moves. */
+    bool reproducible = (record_path != NULL && record_path[0] != '\0') || (replay_path != NULL && replay_path[0] != '\0');
+    CfEngineConfig config;
+
+    cf_engine_config_init(&config);
+    if (!reproducible) {
+        config.tt_path = getenv("CF_TT_FILE");
+        config.tablebase_path = getenv("CF_TABLEBASE");
+    }
+    /* One worker for the AI's reply, one so a warm-up search still finishing never holds it up. */
+    config.threads = ENGINE_WORKERS;
+    s.engine = cf_engine_create(&config);
+    if (s.engine == NULL) {
+        fprintf(stderr, "connect-four-virus: out of memory\n");
+        return 1;
+    }
+    if (replay_path != NULL && replay_path[0] != '\0') {
+        int status = run_replay(replay_path, s.engine);
+
+        cf_engine_destroy(s.engine);
+        return status;
+    }
+
+    session_seed(&s, make_seed());
+    if (record_path != NULL && record_path[0] != '\0') {
+        s.recorder = cf_recorder_open(record_path, s.seed);
+        if (s.recorder == NULL) {
+            fprintf(stderr, "connect-four-virus: cannot record to %s\n", record_path);
+        }
+    }
+    /* Before anything else starts: stderr is unusable once the screen is taken over. */
+    if (!screen_open(&s)) {
+        cf_recorder_close(s.recorder, session_digest(&s));
+        cf_engine_destroy(s.engine);
+        return 1;
+    }
+    if (!reproducible) {
+        s.engine_client = cf_client_connect(getenv("CF_SERVER_SOCKET"));
+    }
+    s.loop_window_start = monotonic_ms();
+    metrics_start(&s.metrics);
+    feed_start(&s);
+    s.gamedb = cf_gamedb_open(getenv("CF_GAMEDB"));
+    s.log = cf_log_create(VM_LOG_CAPACITY);
+    if (getenv("CF_LOG_FILE") != NULL) {
+        cf_log_start_sink(s.log, getenv("CF_LOG_FILE"), LOG_SINK_MAX_BYTES, LOG_SINK_KEEP_FILES);
+    }
+    /* Like the tablebase, a corpus file is outside the recording, so reproducible sessions keep the built-in prompts. */
+    if (!reproducible) {
+        s.corpus = cf_corpus_open(getenv("CF_PHISHING_CORPUS"));
+        if (s.corpus != NULL) {
+            cf_shuffle_start(&s.corpus_shuffle, cf_corpus_count(s.corpus), &s.rng[RNG_MINIGAMES]);
+            vm_add_log(&s, "[INFO] Phishing corpus loaded: %llu messages.", (unsigned long long)cf_corpus_count(s.corpus));
+        }
+    }
+    s.event_loop = cf_events_open(STDIN_FILENO);
+    app_update_dimensions(&s);
+    /* The session clock starts with the intro; the intro clears the board when it is done. */
+    s.clock_origin = monotonic_ms();
+    scene_start(&s, SCENE_INTRO);
+    s.timer_due_ms[TIMER_SPINNER] = next_spinner_tick(0);
+    /* Reproducible sessions skip it: a warmed table would change what a replay's cold table finds. */
+    if (!reproducible) {
+        warmup_start(&s);
+    }
+
+    while (true) {
+        int ch;
+        double frame_start;
+        bool painted;
+
+        app_update_dimensions(&s);
+        frame_start = monotonic_ms();
+        painted = false;
+        if (s.scene.kind == SCENE_NONE) {
+            CF_TRACE_BEGIN("draw_board_ui");
+            painted = draw_board_ui(&s);
+            CF_TRACE_END("draw_board_ui");
+        }
+        update_loop_stats(&s, frame_start, painted);
+        metrics_publish(&s);
+        feed_publish(&s);
+        if (painted) {
+            CF_TRACE_COUNTER("frame_us", s.frame_ms * 1000.0);
+        }
+
+        ch = read_key(&s);
+        if (ch == CF_KEY_NONE) {
+            wait_for_work(&s);
+            continue;
+        }
+        if (ch == CF_KEY_CLOSED) {
+            break;
+        }
+        CF_TRACE_INSTANT_ARG("input", "key", ch);
+
+        if (ch == CF_KEY_RESIZE) {
+            if (s.scene.kind != SCENE_NONE) {
                 app_update_dimensions(&s);
-                run_punishment_action(&s);
-                show_loss_squiggles(&s);
-                vm_add_log(&s, "[INFO] Incident overlay dismissed by operator.");
-                arm_auto_restart(&s);
-                continue;
-            }
-            if (round_is_draw(&s)) {
-                s.game_over = true;
-                s.winner = 0;
-                snprintf(s.status, sizeof(s.status), "No playable columns remain.");
-                vm_add_log(&s, "[RESULT] Draw. Guest state unchanged.");
-                arm_auto_restart(&s);
-                continue;
+                scene_resize(&s);
             }
+            continue;
+        }
 
-            snprintf(s.status, sizeof(s.status), "AI played column %d. Your move.", ai_col + 1);
+        s.clock_ms = session_now(&s);
+        cf_recorder_event(s.recorder, (uint64_t)s.clock_ms, (uint32_t)(REC_KEY + ch));
+        if (!handle_key(&s, ch)) {
+            break;
         }
     }
 
-    nc_shutdown();
+    ai_job_join(&s);
+    warmup_join(&s);
+    cf_miner_stop(s.miner);
+    cf_recorder_close(s.recorder, session_digest(&s));
+    cf_events_close();
+    cf_render_close(s.render.out);
+    CF_TRACE_FLUSH(getenv("CF_TRACE_FILE"));
+    metrics_publish(&s);
+    cf_metrics_destroy(s.metrics.registry);
+    cf_feed_close(s.spectators.feed);
+    cf_gamedb_close(s.gamedb);
+    cf_corpus_close(s.corpus);
+    cf_log_destroy(s.log);
+    cf_client_close(s.engine_client);
+    cf_engine_destroy(s.engine);
     return 0;
 }
@@ -1,5 +1,7 @@
 #include "connect_four.h"
 
+#include "connect_four_kernels.h"
+
 void cf_init(CfGame *game) {
     for (int row = 0; row < CF_ROWS; ++row) {
         for (int col = 0; col < CF_COLS; ++col) {
@@ -48,51 +50,7 @@ bool cf_undo_piece(CfGame *game, int col) {
 }
 
 bool cf_has_winner(const CfGame *game, CfCell piece) {
-    for (int row = 0; row < CF_ROWS; ++row) {
-        for (int col = 0; col <= CF_COLS - 4; ++col) {
-            if (game->board[row][col] == piece &&
-                game->board[row][col + 1] == piece &&
-                game->board[row][col + 2] == piece &&
-                game->board[row][col + 3] == piece) {
-                return true;
-            }
-        }
-    }
-
-    for (int row = 0; row <= CF_ROWS - 4; ++row) {
-        for (int col = 0; col < CF_COLS; ++col) {
-            if (game->board[row][col] == piece &&
-                game->board[row + 1][col] == piece &&
-                game->board[row + 2][col] == piece &&
-                game->board[row + 3][col] == piece) {
-                return true;
-            }
-        }
-    }
-
-    for (int row = 0; row <= CF_ROWS - 4; ++row) {
-        for (int col = 0; col <= CF_COLS - 4; ++col) {
-            if (game->board[row][col] == piece &&
-                game->board[row + 1][col + 1] == piece &&
-                game->board[row + 2][col + 2] == piece &&
-                game->board[row + 3][col + 3] == piece) {
-                return true;
-            }
-        }
-    }
-
-    for (int row = 3; row < CF_ROWS; ++row) {
-        for (int col = 0; col <= CF_COLS - 4; ++col) {
-            if (game->board[row][col] == piece &&
-                game->board[row - 1][col + 1] == piece &&
-                game->board[row - 2][col + 2] == piece &&
-                game->board[row - 3][col + 3] == piece) {
-                return true;
-            }
-        }
-    }
-
-    return false;
+    return cf_kernels()->has_winner(game, piece);
 }
 
 bool cf_is_draw(const CfGame *game) {
@@ -112,3 +70,78 @@ int cf_valid_moves(const CfGame *game, int out_cols[CF_COLS]) {
 
     return count;
 }
+
+/*
+ * Replays 1-based column digits from an empty board, alternating colours so
+ * that `to_move` is on move afterwards. On an illegal digit, a full column
+ * or a move that completes four, the board is cleared, the offending index
+ * is stored in `bad_index` and false is returned.
+ */
+bool cf_load_moves(CfGame *game, const char *moves, size_t len, CfCell to_move, size_t *bad_index) {
+    CfCell other = (to_move == CF_AI) ? CF_HUMAN : CF_AI;
+    CfCell piece = (len % 2 == 0) ? to_move : other;
+
+    cf_init(game);
+
+    for (size_t i = 0; i < len; ++i) {
+        int col = moves[i] - '1';
+
+        if (col < 0 || col >= CF_COLS || cf_drop_piece(game, col, piece) < 0 || cf_has_winner(game, piece)) {
+            cf_init(game);
+            if (bad_index != NULL) {
+                *bad_index = i;
+            }
+            return false;
+        }
+        piece = (piece == CF_AI) ? CF_HUMAN : CF_AI;
+    }
+
+    return true;
+}
+
+/*
+ * Column-major key: each column owns CF_ROWS + 1 bits, bottom row first.
+ * Bits below the column height hold the stones of `to_move`; the bit at
+ * the height is a sentinel, so the key is unique for any gravity-legal
+ * board and identical for colour-swapped boards with the mover swapped.
+ */
+uint64_t cf_position_key(const CfGame *game, CfCell to_move) {
+    uint64_t key = 0;
+
+    for (int col = 0; col < CF_COLS; ++col) {
+        int shift = col * (CF_ROWS + 1);
+        int height = 0;
+
+        for (int row = CF_ROWS - 1; row >= 0; --row) {
+            CfCell cell = game->board[row][col];
+            if (cell == CF_EMPTY) {
+                break;
+            }
+            if (cell == to_move) {
+                key |= UINT64_C(1) << (shift + height);
+            }
+            height += 1;
+        }
+
+        key |= UINT64_C(1) << (shift + height);
+    }
+
+    return key;
+}
+
+uint64_t cf_mirror_key(uint64_t key) {
+    const uint64_t column_mask = (UINT64_C(1) << (CF_ROWS + 1)) - 1;
+    uint64_t mirrored = 0;
+
+    for (int col = 0; col < CF_COLS; ++col) {
+        uint64_t bits = (key >> (col * (CF_ROWS + 1))) & column_mask;
+        mirrored |= bits << ((CF_COLS - 1 - col) * (CF_ROWS + 1));
+    }
+
+    return mirrored;
+}
+
+uint64_t cf_canonical_key(uint64_t key) {
+    uint64_t mirrored = cf_mirror_key(key);
+    return mirrored < key ? mirrored : key;
+}
@@ -2,6 +2,8 @@
 #define CONNECT_FOUR_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define CF_ROWS 6
 #define CF_COLS 6
@@ -24,5 +26,9 @@ bool cf_undo_piece(CfGame *game, int col);
 bool cf_has_winner(const CfGame *game, CfCell piece);
 bool cf_is_draw(const CfGame *game);
 int cf_valid_moves(const CfGame *game, int out_cols[CF_COLS]);
+bool cf_load_moves(CfGame *game, const char *moves, size_t len, CfCell to_move, size_t *bad_index);
+uint64_t cf_position_key(const CfGame *game, CfCell to_move);
+uint64_t cf_mirror_key(uint64_t key);
+uint64_t cf_canonical_key(uint64_t key);
 
 #endif
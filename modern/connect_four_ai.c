@@ -2,16 +2,46 @@
 
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "connect_four_kernels.h"
+#include "connect_four_trace.h"
 
 enum {
     WIN_SCORE = 100000000,
-    LOSS_SCORE = -100000000
+    LOSS_SCORE = -100000000,
+    MATE_MARGIN = 1000,
+    MAX_PLY = CF_ROWS * CF_COLS + 1,
+    LIMIT_CHECK_INTERVAL = 1024
 };
 
+typedef struct {
+    const CfKernels *kernels;
+    const bool *blocked_cols;
+    const CfTablebase *tablebase;
+    CfTt *tt;
+    uint64_t nodes;
+    uint64_t node_limit;
+    double deadline;
+    bool aborted;
+    int pv[MAX_PLY][MAX_PLY];
+    int pv_length[MAX_PLY];
+} SearchCtx;
+
 static bool is_col_blocked(const bool blocked_cols[CF_COLS], int col) {
     return blocked_cols != NULL && blocked_cols[col];
 }
 
+static bool has_blocked_cols(const bool blocked_cols[CF_COLS]) {
+    for (int col = 0; col < CF_COLS; ++col) {
+        if (is_col_blocked(blocked_cols, col)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static int collect_valid_moves(
     const CfGame *game,
     const bool blocked_cols[CF_COLS],
@@ -42,132 +72,272 @@ static bool is_better_tie_break(int candidate, int current) {
     return center_distance(candidate) < center_distance(current);
 }
 
-static int evaluate_window(const CfCell window[4]) {
-    int ai_count = 0;
-    int human_count = 0;
-    int empty_count = 0;
-
-    for (int i = 0; i < 4; ++i) {
-        if (window[i] == CF_AI) {
-            ai_count += 1;
-        } else if (window[i] == CF_HUMAN) {
-            human_count += 1;
-        } else {
-            empty_count += 1;
-        }
-    }
+static bool tablebase_score(
+    const CfTablebase *tablebase,
+    const CfGame *game,
+    const bool blocked_cols[CF_COLS],
+    bool ai_to_move,
+    int ply,
+    int *out_score
+) {
+    CfTbValue value;
+    bool ai_wins;
 
-    if (ai_count == 4) {
-        return 100000;
-    }
-    if (human_count == 4) {
-        return -100000;
-    }
-    if (ai_count == 3 && empty_count == 1) {
-        return 120;
+    if (tablebase == NULL || has_blocked_cols(blocked_cols)) {
+        return false;
     }
-    if (ai_count == 2 && empty_count == 2) {
-        return 14;
+    if (CF_ROWS * CF_COLS - game->moves > cf_tablebase_max_empties(tablebase)) {
+        return false;
     }
-    if (human_count == 3 && empty_count == 1) {
-        return -150;
+    if (!cf_tablebase_probe(tablebase, game, ai_to_move ? CF_AI : CF_HUMAN, &value)) {
+        return false;
     }
-    if (human_count == 2 && empty_count == 2) {
-        return -12;
+
+    if (value.result == CF_TB_DRAW) {
+        *out_score = 0;
+        return true;
     }
 
-    return 0;
+    ai_wins = (value.result == CF_TB_WIN) == ai_to_move;
+    *out_score = ai_wins ? WIN_SCORE - (ply + value.distance) : LOSS_SCORE + (ply + value.distance);
+    return true;
 }
 
-static int score_position(const CfGame *game) {
-    int score = 0;
-    CfCell window[4];
+static int tablebase_move(
+    const CfTablebase *tablebase,
+    CfGame *game,
+    const int valid_cols[CF_COLS],
+    int valid_count,
+    const bool blocked_cols[CF_COLS],
+    int *out_score
+) {
+    int best = -1;
+    int best_score = INT_MIN;
 
-    for (int row = 0; row < CF_ROWS; ++row) {
-        if (game->board[row][CF_COLS / 2] == CF_AI) {
-            score += 7;
-        } else if (game->board[row][CF_COLS / 2] == CF_HUMAN) {
-            score -= 7;
+    for (int i = 0; i < valid_count; ++i) {
+        int col = valid_cols[i];
+        int score;
+        bool found;
+
+        cf_drop_piece(game, col, CF_AI);
+        found = tablebase_score(tablebase, game, blocked_cols, false, 1, &score);
+        cf_undo_piece(game, col);
+
+        if (!found) {
+            return -1;
+        }
+        if (score > best_score || (score == best_score && is_better_tie_break(col, best))) {
+            best_score = score;
+            best = col;
         }
     }
 
-    for (int row = 0; row < CF_ROWS; ++row) {
-        for (int col = 0; col <= CF_COLS - 4; ++col) {
-            for (int i = 0; i < 4; ++i) {
-                window[i] = game->board[row][col + i];
-            }
-            score += evaluate_window(window);
+    *out_score = best_score;
+    return best;
+}
+
+static uint64_t search_key(const CfGame *game, bool ai_to_move, const bool blocked_cols[CF_COLS]) {
+    uint64_t key = cf_position_key(game, CF_AI);
+
+    for (int col = 0; col < CF_COLS; ++col) {
+        if (is_col_blocked(blocked_cols, col)) {
+            key |= UINT64_C(1) << (48 + col);
         }
     }
+    if (ai_to_move) {
+        key |= UINT64_C(1) << 63;
+    }
+    return key;
+}
 
-    for (int row = 0; row <= CF_ROWS - 4; ++row) {
-        for (int col = 0; col < CF_COLS; ++col) {
-            for (int i = 0; i < 4; ++i) {
-                window[i] = game->board[row + i][col];
-            }
-            score += evaluate_window(window);
-        }
+/* Win/loss scores depend on ply; the table stores them relative to the node. */
+static int score_to_tt(int score, int ply) {
+    if (score >= WIN_SCORE - MATE_MARGIN) {
+        return score + ply;
     }
+    if (score <= LOSS_SCORE + MATE_MARGIN) {
+        return score - ply;
+    }
+    return score;
+}
 
-    for (int row = 0; row <= CF_ROWS - 4; ++row) {
-        for (int col = 0; col <= CF_COLS - 4; ++col) {
-            for (int i = 0; i < 4; ++i) {
-                window[i] = game->board[row + i][col + i];
-            }
-            score += evaluate_window(window);
-        }
+static int score_from_tt(int score, int ply) {
+    if (score >= WIN_SCORE - MATE_MARGIN) {
+        return score - ply;
+    }
+    if (score <= LOSS_SCORE + MATE_MARGIN) {
+        return score + ply;
     }
+    return score;
+}
 
-    for (int row = 3; row < CF_ROWS; ++row) {
-        for (int col = 0; col <= CF_COLS - 4; ++col) {
-            for (int i = 0; i < 4; ++i) {
-                window[i] = game->board[row - i][col + i];
+static void promote_move(int cols[CF_COLS], int count, int col) {
+    for (int i = 1; i < count; ++i) {
+        if (cols[i] == col) {
+            for (int j = i; j > 0; --j) {
+                cols[j] = cols[j - 1];
             }
-            score += evaluate_window(window);
+            cols[0] = col;
+            return;
         }
     }
+}
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool search_should_stop(SearchCtx *ctx) {
+    if (ctx->aborted) {
+        return true;
+    }
+    if (ctx->node_limit > 0 && ctx->nodes >= ctx->node_limit) {
+        ctx->aborted = true;
+    } else if (ctx->deadline > 0 && (ctx->nodes % LIMIT_CHECK_INTERVAL) == 0 && monotonic_seconds() >= ctx->deadline) {
+        ctx->aborted = true;
+    }
+    return ctx->aborted;
+}
 
-    return score;
+static void update_pv(SearchCtx *ctx, int ply, int col) {
+    int child_length = (ply + 1 < MAX_PLY) ? ctx->pv_length[ply + 1] : 0;
+
+    ctx->pv[ply][0] = col;
+    for (int i = 0; i < child_length && i + 1 < MAX_PLY; ++i) {
+        ctx->pv[ply][i + 1] = ctx->pv[ply + 1][i];
+    }
+    ctx->pv_length[ply] = child_length + 1;
+}
+
+/* Whether a child of `game` could be answered by the endgame table instead of a static score. */
+static bool children_reach_tablebase(const SearchCtx *ctx, const CfGame *game) {
+    return ctx->tablebase != NULL &&
+        !has_blocked_cols(ctx->blocked_cols) &&
+        CF_ROWS * CF_COLS - (game->moves + 1) <= cf_tablebase_max_empties(ctx->tablebase);
+}
+
+/* A depth-0 child scored by eval_children, counted and returned exactly as minimax() would. */
+static int leaf_score(SearchCtx *ctx, const CfChildEval *leaf, int ply) {
+    ctx->nodes += 1;
+    ctx->pv_length[ply] = 0;
+    if (search_should_stop(ctx)) {
+        return 0;
+    }
+    if (leaf->ai_wins) {
+        return WIN_SCORE - ply;
+    }
+    if (leaf->human_wins) {
+        return LOSS_SCORE + ply;
+    }
+    return leaf->score;
 }
 
 static int minimax(
+    SearchCtx *ctx,
     CfGame *game,
     int depth,
     int alpha,
     int beta,
     bool maximizing,
     int ply,
-    int *best_col,
-    const bool blocked_cols[CF_COLS]
+    int *best_col
 ) {
+    const bool *blocked_cols = ctx->blocked_cols;
     int valid_cols[CF_COLS];
     int valid_count = collect_valid_moves(game, blocked_cols, valid_cols);
+    int alpha_orig = alpha;
+    int beta_orig = beta;
+    uint64_t tt_key = 0;
+    int tb_score;
+    int best_score;
+    int local_best;
+    bool leaves;
+    CfChildEval leaf[CF_COLS];
+    CfTtEntry entry;
+
+    ctx->nodes += 1;
+    ctx->pv_length[ply] = 0;
+    if (ply > 0 && search_should_stop(ctx)) {
+        return 0;
+    }
 
-    if (cf_has_winner(game, CF_AI)) {
+    if (ctx->kernels->has_winner(game, CF_AI)) {
         return WIN_SCORE - ply;
     }
-    if (cf_has_winner(game, CF_HUMAN)) {
+    if (ctx->kernels->has_winner(game, CF_HUMAN)) {
         return LOSS_SCORE + ply;
     }
+    /* A tabled root still needs its move, which comes from probing the children. */
+    if (best_col == NULL && valid_count > 0 && tablebase_score(ctx->tablebase, game, blocked_cols, maximizing, ply, &tb_score)) {
+        return tb_score;
+    }
     if (depth == 0 || valid_count == 0) {
-        return score_position(game);
+        return ctx->kernels->score_position(game);
+    }
+
+    if (ctx->tt != NULL) {
+        tt_key = search_key(game, maximizing, blocked_cols);
+        if (cf_tt_probe(ctx->tt, tt_key, &entry)) {
+            int tt_score = score_from_tt(entry.score, ply);
+            bool usable = entry.depth >= depth && (
+                entry.bound == CF_TT_EXACT ||
+                (entry.bound == CF_TT_LOWER && tt_score >= beta) ||
+                (entry.bound == CF_TT_UPPER && tt_score <= alpha));
+
+            /* The root also needs a move, so it only trusts exact entries that carry one. */
+            if (usable && best_col != NULL) {
+                usable = entry.bound == CF_TT_EXACT &&
+                    entry.best_col >= 0 &&
+                    cf_is_valid_move(game, entry.best_col) &&
+                    !is_col_blocked(blocked_cols, entry.best_col);
+            }
+            if (usable) {
+                if (best_col != NULL) {
+                    *best_col = entry.best_col;
+                }
+                if (entry.best_col >= 0) {
+                    ctx->pv[ply][0] = entry.best_col;
+                    ctx->pv_length[ply] = 1;
+                }
+                return tt_score;
+            }
+            if (entry.best_col >= 0) {
+                promote_move(valid_cols, valid_count, entry.best_col);
+            }
+        }
+    }
+
+    /* One batched kernel call scores every depth-0 child; the loops below still visit them in order. */
+    leaves = depth == 1 && !children_reach_tablebase(ctx, game);
+    if (leaves) {
+        ctx->kernels->eval_children(game, valid_cols, valid_count, maximizing ? CF_AI : CF_HUMAN, leaf);
     }
 
     if (maximizing) {
-        int best_score = INT_MIN;
-        int local_best = valid_cols[0];
+        best_score = INT_MIN;
+        local_best = valid_cols[0];
 
         for (int i = 0; i < valid_count; ++i) {
             int col = valid_cols[i];
             int score;
 
-            cf_drop_piece(game, col, CF_AI);
-            score = minimax(game, depth - 1, alpha, beta, false, ply + 1, NULL, blocked_cols);
-            cf_undo_piece(game, col);
+            if (leaves) {
+                score = leaf_score(ctx, &leaf[i], ply + 1);
+            } else {
+                cf_drop_piece(game, col, CF_AI);
+                score = minimax(ctx, game, depth - 1, alpha, beta, false, ply + 1, NULL);
+                cf_undo_piece(game, col);
+            }
+            if (ctx->aborted) {
+                break;
+            }
 
             if (score > best_score || (score == best_score && is_better_tie_break(col, local_best))) {
                 best_score = score;
                 local_best = col;
+                update_pv(ctx, ply, col);
             }
 
             if (best_score > alpha) {
@@ -177,35 +347,57 @@ static int minimax(
                 break;
             }
         }
+    } else {
+        best_score = INT_MAX;
+        local_best = valid_cols[0];
 
-        if (best_col != NULL) {
-            *best_col = local_best;
-        }
-        return best_score;
-    }
-
-    int best_score = INT_MAX;
-    int local_best = valid_cols[0];
+        for (int i = 0; i < valid_count; ++i) {
+            int col = valid_cols[i];
+            int score;
 
-    for (int i = 0; i < valid_count; ++i) {
-        int col = valid_cols[i];
-        int score;
+            if (leaves) {
+                score = leaf_score(ctx, &leaf[i], ply + 1);
+            } else {
+                cf_drop_piece(game, col, CF_HUMAN);
+                score = minimax(ctx, game, depth - 1, alpha, beta, true, ply + 1, NULL);
+                cf_undo_piece(game, col);
+            }
+            if (ctx->aborted) {
+                break;
+            }
 
-        cf_drop_piece(game, col, CF_HUMAN);
-        score = minimax(game, depth - 1, alpha, beta, true, ply + 1, NULL, blocked_cols);
-        cf_undo_piece(game, col);
+            if (score < best_score || (score == best_score && is_better_tie_break(col, local_best))) {
+                best_score = score;
+                local_best = col;
+                update_pv(ctx, ply, col);
+            }
 
-        if (score < best_score || (score == best_score && is_better_tie_break(col, local_best))) {
-            best_score = score;
-            local_best = col;
+            if (best_score < beta) {
+                beta = best_score;
+            }
+            if (alpha >= beta) {
+                break;
+            }
         }
+    }
 
-        if (best_score < beta) {
-            beta = best_score;
-        }
-        if (alpha >= beta) {
-            break;
+    /* A partial result is only a bound of unknown quality: keep it out of the table. */
+    if (ctx->aborted) {
+        return 0;
+    }
+
+    if (ctx->tt != NULL) {
+        entry.score = score_to_tt(best_score, ply);
+        entry.depth = depth;
+        entry.best_col = local_best;
+        if (best_score <= alpha_orig) {
+            entry.bound = CF_TT_UPPER;
+        } else if (best_score >= beta_orig) {
+            entry.bound = CF_TT_LOWER;
+        } else {
+            entry.bound = CF_TT_EXACT;
         }
+        cf_tt_store(ctx->tt, tt_key, &entry);
     }
 
     if (best_col != NULL) {
@@ -214,16 +406,45 @@ static int minimax(
     return best_score;
 }
 
-int cf_ai_choose_move_ex(CfGame *game, int depth, const bool blocked_cols[CF_COLS]) {
+static int finish_choice(CfSearchInfo *info, int col, int score, int depth, uint64_t nodes, double started) {
+    if (info != NULL) {
+        memset(info, 0, sizeof(*info));
+        info->depth = depth;
+        info->score = score;
+        info->best_col = col;
+        info->nodes = nodes;
+        info->elapsed_ms = (monotonic_seconds() - started) * 1000.0;
+        if (col >= 0) {
+            info->pv[0] = col;
+            info->pv_length = 1;
+        }
+    }
+    return col;
+}
+
+static int choose_move(
+    const CfAiTables *tables,
+    CfGame *game,
+    int depth,
+    const bool blocked_cols[CF_COLS],
+    double time_limit_ms,
+    CfSearchInfo *info
+) {
     int valid_cols[CF_COLS];
     int valid_count = collect_valid_moves(game, blocked_cols, valid_cols);
     int forced_block = -1;
     int best = -1;
+    int score;
     int empties = CF_ROWS * CF_COLS - game->moves;
     int search_depth = depth;
+    int completed_depth = 0;
+    int pv[MAX_PLY];
+    int pv_length = 0;
+    double started = monotonic_seconds();
+    SearchCtx ctx;
 
     if (valid_count == 0) {
-        return -1;
+        return finish_choice(info, -1, 0, 0, 0, started);
     }
 
     for (int i = 0; i < valid_count; ++i) {
@@ -231,7 +452,7 @@ int cf_ai_choose_move_ex(CfGame *game, int depth, const bool blocked_cols[CF_COL
         cf_drop_piece(game, col, CF_AI);
         if (cf_has_winner(game, CF_AI)) {
             cf_undo_piece(game, col);
-            return col;
+            return finish_choice(info, col, WIN_SCORE - 1, 1, 0, started);
         }
         cf_undo_piece(game, col);
     }
@@ -247,7 +468,12 @@ int cf_ai_choose_move_ex(CfGame *game, int depth, const bool blocked_cols[CF_COL
         cf_undo_piece(game, col);
     }
     if (forced_block >= 0) {
-        return forced_block;
+        return finish_choice(info, forced_block, 0, 1, 0, started);
+    }
+
+    best = tablebase_move(tables->tablebase, game, valid_cols, valid_count, blocked_cols, &score);
+    if (best >= 0) {
+        return finish_choice(info, best, score, 0, 0, started);
     }
 
     if (search_depth < 1) {
@@ -263,14 +489,211 @@ int cf_ai_choose_move_ex(CfGame *game, int depth, const bool blocked_cols[CF_COL
         search_depth = 8;
     }
 
-    minimax(game, search_depth, INT_MIN, INT_MAX, true, 0, &best, blocked_cols);
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.kernels = cf_kernels();
+    ctx.blocked_cols = blocked_cols;
+    ctx.tablebase = tables->tablebase;
+    ctx.tt = tables->tt;
+    score = 0;
+
+    if (time_limit_ms > 0) {
+        /* Deepen step by step so a deadline hit mid-search still leaves a finished shallower answer. */
+        ctx.deadline = started + time_limit_ms / 1000.0;
+        for (int d = 1; d <= search_depth; ++d) {
+            int candidate = -1;
+            int candidate_score;
+
+            CF_TRACE_BEGIN_ARG("iteration", "depth", d);
+            candidate_score = minimax(&ctx, game, d, INT_MIN, INT_MAX, true, 0, &candidate);
+            CF_TRACE_END("iteration");
+
+            if (ctx.aborted && d > 1) {
+                break;
+            }
+            best = candidate;
+            score = candidate_score;
+            completed_depth = d;
+            pv_length = ctx.pv_length[0];
+            memcpy(pv, ctx.pv[0], sizeof(int) * (size_t)pv_length);
+            if (ctx.aborted) {
+                break;
+            }
+        }
+    } else {
+        CF_TRACE_BEGIN_ARG("iteration", "depth", search_depth);
+        score = minimax(&ctx, game, search_depth, INT_MIN, INT_MAX, true, 0, &best);
+        CF_TRACE_END("iteration");
+        completed_depth = search_depth;
+        pv_length = ctx.pv_length[0];
+        memcpy(pv, ctx.pv[0], sizeof(int) * (size_t)pv_length);
+    }
 
     if (best < 0) {
-        return valid_cols[0];
+        best = valid_cols[0];
+    }
+
+    finish_choice(info, best, score, completed_depth, ctx.nodes, started);
+    if (info != NULL && pv_length > 0 && pv[0] == best) {
+        info->pv_length = pv_length;
+        memcpy(info->pv, pv, sizeof(int) * (size_t)pv_length);
     }
     return best;
 }
 
+int cf_ai_choose_move_with(
+    const CfAiTables *tables,
+    CfGame *game,
+    int depth,
+    const bool blocked_cols[CF_COLS],
+    double time_limit_ms,
+    CfSearchInfo *info
+) {
+    int best;
+
+    CF_TRACE_BEGIN("ai_choose_move");
+    best = choose_move(tables, game, depth, blocked_cols, time_limit_ms, info);
+    CF_TRACE_END("ai_choose_move");
+    return best;
+}
+
+int cf_ai_choose_move_deadline(
+    CfGame *game,
+    int depth,
+    const bool blocked_cols[CF_COLS],
+    double time_limit_ms,
+    CfSearchInfo *info
+) {
+    CfAiTables tables = {NULL, NULL};
+
+    return cf_ai_choose_move_with(&tables, game, depth, blocked_cols, time_limit_ms, info);
+}
+
+int cf_ai_choose_move_info(CfGame *game, int depth, const bool blocked_cols[CF_COLS], CfSearchInfo *info) {
+    return cf_ai_choose_move_deadline(game, depth, blocked_cols, 0, info);
+}
+
+int cf_ai_choose_move_ex(CfGame *game, int depth, const bool blocked_cols[CF_COLS]) {
+    return cf_ai_choose_move_info(game, depth, blocked_cols, NULL);
+}
+
+int cf_ai_search(
+    CfGame *game,
+    const bool blocked_cols[CF_COLS],
+    const CfSearchLimits *limits,
+    CfSearchInfoFn on_info,
+    void *user,
+    CfSearchInfo *out
+) {
+    CfAiTables tables = {NULL, NULL};
+
+    return cf_ai_search_with(&tables, game, blocked_cols, limits, on_info, user, out);
+}
+
+int cf_ai_search_with(
+    const CfAiTables *tables,
+    CfGame *game,
+    const bool blocked_cols[CF_COLS],
+    const CfSearchLimits *limits,
+    CfSearchInfoFn on_info,
+    void *user,
+    CfSearchInfo *out
+) {
+    static const CfSearchLimits kDefaultLimits = {CF_AI_MAX_DEPTH, 0, 0};
+    int valid_cols[CF_COLS];
+    int valid_count = collect_valid_moves(game, blocked_cols, valid_cols);
+    int max_depth;
+    double started = monotonic_seconds();
+    CfSearchInfo info;
+    SearchCtx ctx;
+
+    memset(&info, 0, sizeof(info));
+    info.best_col = -1;
+
+    if (limits == NULL) {
+        limits = &kDefaultLimits;
+    }
+    if (valid_count == 0) {
+        if (out != NULL) {
+            *out = info;
+        }
+        return -1;
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.kernels = cf_kernels();
+    ctx.blocked_cols = blocked_cols;
+    ctx.tablebase = tables->tablebase;
+    ctx.tt = tables->tt;
+    ctx.node_limit = limits->node_limit;
+    ctx.deadline = (limits->time_limit_ms > 0) ? started + limits->time_limit_ms / 1000.0 : 0;
+
+    max_depth = limits->depth;
+    if (max_depth < 1 || max_depth > CF_AI_MAX_DEPTH) {
+        max_depth = CF_AI_MAX_DEPTH;
+    }
+    if (max_depth > CF_ROWS * CF_COLS - game->moves) {
+        max_depth = CF_ROWS * CF_COLS - game->moves;
+    }
+    if (max_depth < 1) {
+        max_depth = 1;
+    }
+
+    info.best_col = valid_cols[0];
+    CF_TRACE_BEGIN("ai_search");
+
+    /* Iterative deepening: each finished iteration replaces the result, an aborted one is dropped. */
+    for (int depth = 1; depth <= max_depth; ++depth) {
+        int best = -1;
+        int score;
+
+        CF_TRACE_BEGIN_ARG("iteration", "depth", depth);
+        score = minimax(&ctx, game, depth, INT_MIN, INT_MAX, true, 0, &best);
+        CF_TRACE_END("iteration");
+
+        if (ctx.aborted && depth > 1) {
+            break;
+        }
+
+        info.depth = depth;
+        info.score = score;
+        info.best_col = (best >= 0) ? best : valid_cols[0];
+        info.pv_length = ctx.pv_length[0];
+        memcpy(info.pv, ctx.pv[0], sizeof(int) * (size_t)info.pv_length);
+        if (info.pv_length == 0 || info.pv[0] != info.best_col) {
+            info.pv[0] = info.best_col;
+            info.pv_length = 1;
+        }
+        info.nodes = ctx.nodes;
+        info.elapsed_ms = (monotonic_seconds() - started) * 1000.0;
+
+        if (on_info != NULL) {
+            on_info(&info, user);
+        }
+        if (ctx.aborted || cf_ai_score_to_mate(score) != 0) {
+            break;
+        }
+    }
+
+    info.nodes = ctx.nodes;
+    info.elapsed_ms = (monotonic_seconds() - started) * 1000.0;
+    CF_TRACE_END("ai_search");
+
+    if (out != NULL) {
+        *out = info;
+    }
+    return info.best_col;
+}
+
+int cf_ai_score_to_mate(int score) {
+    if (score >= WIN_SCORE - MATE_MARGIN) {
+        return WIN_SCORE - score;
+    }
+    if (score <= LOSS_SCORE + MATE_MARGIN) {
+        return -(score - LOSS_SCORE);
+    }
+    return 0;
+}
+
 int cf_ai_choose_move(CfGame *game, int depth) {
     return cf_ai_choose_move_ex(game, depth, NULL);
 }
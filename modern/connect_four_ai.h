@@ -1,9 +1,90 @@
 #ifndef CONNECT_FOUR_AI_H
 #define CONNECT_FOUR_AI_H
 
+#include <stdint.h>
+
 #include "connect_four.h"
+#include "connect_four_tablebase.h"
+#include "connect_four_tt.h"
+
+#define CF_AI_MAX_DEPTH (CF_ROWS * CF_COLS)
+
+typedef struct {
+    int depth;            /* deepest iteration; <= 0 means no depth limit */
+    double time_limit_ms; /* 0 means no time limit */
+    uint64_t node_limit;  /* 0 means no node limit */
+} CfSearchLimits;
+
+typedef struct {
+    int depth;
+    int score;           /* from CF_AI's point of view; see cf_ai_score_to_mate() */
+    int best_col;
+    uint64_t nodes;
+    double elapsed_ms;
+    int pv[CF_ROWS * CF_COLS];
+    int pv_length;
+} CfSearchInfo;
+
+typedef void (*CfSearchInfoFn)(const CfSearchInfo *info, void *user);
+
+/*
+ * The tables a search reads and writes. The *_with() calls take them
+ * explicitly, so searches with different tables can run side by side;
+ * the others search without any. Either member may be NULL.
+ */
+typedef struct {
+    const CfTablebase *tablebase;
+    CfTt *tt;
+} CfAiTables;
 
 int cf_ai_choose_move(CfGame *game, int depth);
 int cf_ai_choose_move_ex(CfGame *game, int depth, const bool blocked_cols[CF_COLS]);
+/* Same choice as cf_ai_choose_move_ex(); also reports score, depth, nodes and time when `info` is set. */
+int cf_ai_choose_move_info(CfGame *game, int depth, const bool blocked_cols[CF_COLS], CfSearchInfo *info);
+/*
+ * As cf_ai_choose_move_info(), but gives up after `time_limit_ms` (0 = no
+ * limit) and returns the best move of the deepest finished depth instead.
+ */
+int cf_ai_choose_move_deadline(
+    CfGame *game,
+    int depth,
+    const bool blocked_cols[CF_COLS],
+    double time_limit_ms,
+    CfSearchInfo *info
+);
+
+int cf_ai_choose_move_with(
+    const CfAiTables *tables,
+    CfGame *game,
+    int depth,
+    const bool blocked_cols[CF_COLS],
+    double time_limit_ms,
+    CfSearchInfo *info
+);
+
+/*
+ * Iterative-deepening search for CF_AI (the side to move) under the given
+ * limits. `on_info` is called after every completed iteration. Returns the
+ * best column, or -1 when no column is playable.
+ */
+int cf_ai_search(
+    CfGame *game,
+    const bool blocked_cols[CF_COLS],
+    const CfSearchLimits *limits,
+    CfSearchInfoFn on_info,
+    void *user,
+    CfSearchInfo *out
+);
+int cf_ai_search_with(
+    const CfAiTables *tables,
+    CfGame *game,
+    const bool blocked_cols[CF_COLS],
+    const CfSearchLimits *limits,
+    CfSearchInfoFn on_info,
+    void *user,
+    CfSearchInfo *out
+);
+/* Plies to a forced win (> 0), to a forced loss (< 0), or 0 for a heuristic score. */
+int cf_ai_score_to_mate(int score);
 
 #endif
@@ -0,0 +1,282 @@
+#include "connect_four_client.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+enum {
+    REPLY_CHARS = 512,
+    REPLY_SLACK_MS = 2000,
+    NO_DEADLINE_WAIT_MS = 30000
+};
+
+#ifdef MSG_NOSIGNAL
+#define CLIENT_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define CLIENT_SEND_FLAGS 0
+#endif
+
+struct CfClient {
+    int fd;
+    unsigned long next_id;
+    char buf[REPLY_CHARS];
+    size_t len;
+};
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* --------------------- Board text --------------------- */
+void cf_board_format(const CfGame *game, char *out) {
+    for (int row = 0; row < CF_ROWS; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            CfCell cell = game->board[row][col];
+            out[row * CF_COLS + col] = cell == CF_AI ? 'x' : (cell == CF_HUMAN ? 'o' : '.');
+        }
+    }
+    out[CF_BOARD_CHARS] = '\0';
+}
+
+bool cf_board_parse(CfGame *game, const char *text, size_t len) {
+    cf_init(game);
+    if (len != CF_BOARD_CHARS) {
+        return false;
+    }
+
+    for (int row = 0; row < CF_ROWS; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            char c = text[row * CF_COLS + col];
+
+            if (c == 'x') {
+                game->board[row][col] = CF_AI;
+            } else if (c == 'o') {
+                game->board[row][col] = CF_HUMAN;
+            } else if (c != '.') {
+                cf_init(game);
+                return false;
+            }
+
+            if (game->board[row][col] != CF_EMPTY) {
+                game->moves += 1;
+            }
+        }
+    }
+
+    for (int row = 0; row + 1 < CF_ROWS; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            if (game->board[row][col] != CF_EMPTY && game->board[row + 1][col] == CF_EMPTY) {
+                cf_init(game);
+                return false;
+            }
+        }
+    }
+
+    if (cf_has_winner(game, CF_AI) || cf_has_winner(game, CF_HUMAN)) {
+        cf_init(game);
+        return false;
+    }
+    return true;
+}
+
+/* --------------------- Connection --------------------- */
+CfClient *cf_client_connect(const char *path) {
+    struct sockaddr_un addr;
+    CfClient *client;
+    int fd;
+
+    if (path == NULL || path[0] == '\0' || strlen(path) >= sizeof(addr.sun_path)) {
+        return NULL;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+#ifdef SO_NOSIGPIPE
+    {
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+    }
+#endif
+    if (connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    client = calloc(1, sizeof(*client));
+    if (client == NULL) {
+        close(fd);
+        return NULL;
+    }
+    client->fd = fd;
+    client->next_id = 1;
+    return client;
+}
+
+void cf_client_close(CfClient *client) {
+    if (client == NULL) {
+        return;
+    }
+    close(client->fd);
+    free(client);
+}
+
+static bool send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t sent = send(fd, data, len, CLIENT_SEND_FLAGS);
+
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        len -= (size_t)sent;
+    }
+    return true;
+}
+
+/* Reads until a complete line is buffered; the line is NUL-terminated in place. */
+static char *read_line(CfClient *client, double give_up_at) {
+    while (true) {
+        char *nl = memchr(client->buf, '\n', client->len);
+        struct pollfd pfd;
+        double remaining;
+        ssize_t got;
+
+        if (nl != NULL) {
+            *nl = '\0';
+            return client->buf;
+        }
+        if (client->len == sizeof(client->buf)) {
+            return NULL;
+        }
+
+        remaining = give_up_at - monotonic_ms();
+        if (remaining <= 0) {
+            return NULL;
+        }
+        pfd.fd = client->fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, (int)remaining + 1) <= 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NULL;
+        }
+
+        got = recv(client->fd, client->buf + client->len, sizeof(client->buf) - client->len, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return NULL;
+        }
+        client->len += (size_t)got;
+    }
+}
+
+static void consume_line(CfClient *client, const char *line) {
+    size_t used = strlen(line) + 1;
+
+    memmove(client->buf, client->buf + used, client->len - used);
+    client->len -= used;
+}
+
+bool cf_client_choose_move(
+    CfClient *client,
+    const CfGame *game,
+    int depth,
+    const bool blocked_cols[CF_COLS],
+    double deadline_ms,
+    CfSearchInfo *out
+) {
+    char board[CF_BOARD_CHARS + 1];
+    char blocked[CF_COLS + 1];
+    char request[REPLY_CHARS];
+    size_t blocked_len = 0;
+    unsigned long id;
+    double give_up_at;
+    int len;
+
+    if (client == NULL) {
+        return false;
+    }
+
+    cf_board_format(game, board);
+    for (int col = 0; col < CF_COLS; ++col) {
+        if (blocked_cols != NULL && blocked_cols[col]) {
+            blocked[blocked_len++] = (char)('1' + col);
+        }
+    }
+    if (blocked_len == 0) {
+        blocked[blocked_len++] = '-';
+    }
+    blocked[blocked_len] = '\0';
+
+    id = client->next_id++;
+    len = snprintf(request, sizeof(request), "choose %lu %s %s %d %.0f\n", id, board, blocked, depth, deadline_ms);
+    if (len <= 0 || (size_t)len >= sizeof(request) || !send_all(client->fd, request, (size_t)len)) {
+        return false;
+    }
+
+    give_up_at = monotonic_ms() + (deadline_ms > 0 ? deadline_ms + REPLY_SLACK_MS : NO_DEADLINE_WAIT_MS);
+    while (true) {
+        char *line = read_line(client, give_up_at);
+        unsigned long reply_id;
+        int col;
+        int score;
+        int reply_depth;
+        unsigned long long nodes;
+        double time_us;
+        bool matched;
+
+        if (line == NULL) {
+            return false;
+        }
+
+        /* Replies to requests we already gave up on are skipped. */
+        matched = false;
+        if (sscanf(line, "ok %lu %d %d %d %llu %lf", &reply_id, &col, &score, &reply_depth, &nodes, &time_us) == 6) {
+            matched = reply_id == id;
+            if (matched && out != NULL) {
+                memset(out, 0, sizeof(*out));
+                out->best_col = col;
+                out->score = score;
+                out->depth = reply_depth;
+                out->nodes = nodes;
+                out->elapsed_ms = time_us / 1000.0;
+                if (col >= 0) {
+                    out->pv[0] = col;
+                    out->pv_length = 1;
+                }
+            }
+            consume_line(client, line);
+            if (matched) {
+                return col >= -1 && col < CF_COLS;
+            }
+        } else if (sscanf(line, "error %lu", &reply_id) == 1) {
+            consume_line(client, line);
+            if (reply_id == id) {
+                return false;
+            }
+        } else {
+            consume_line(client, line);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef CONNECT_FOUR_CLIENT_H
+#define CONNECT_FOUR_CLIENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "connect_four.h"
+#include "connect_four_ai.h"
+
+/*
+ * Client for connect-four-server over a Unix-domain socket.
+ *
+ * Wire format, one line each way, pipelining allowed (replies carry the id):
+ *   choose <id> <board> <blocked|-> <depth> <deadline_ms>
+ *   ok <id> <col> <score> <depth> <nodes> <time_us>
+ *   error <id> <reason>
+ * <board> is CF_ROWS*CF_COLS characters, top row first: 'x' for the side to
+ * move (searched as CF_AI), 'o' for the opponent, '.' for empty. <col> is
+ * 0-based, -1 when no column is playable.
+ */
+
+#define CF_SERVER_DEFAULT_SOCKET "/tmp/connect-four.sock"
+#define CF_BOARD_CHARS (CF_ROWS * CF_COLS)
+
+typedef struct CfClient CfClient;
+
+/* Returns NULL when `path` is NULL/empty or nothing is listening there. */
+CfClient *cf_client_connect(const char *path);
+void cf_client_close(CfClient *client);
+
+/*
+ * Remote cf_ai_choose_move_deadline(). Returns false when the server is gone,
+ * replied with an error or did not answer within the deadline (plus slack);
+ * the caller should then fall back to the in-process AI.
+ */
+bool cf_client_choose_move(
+    CfClient *client,
+    const CfGame *game,
+    int depth,
+    const bool blocked_cols[CF_COLS],
+    double deadline_ms,
+    CfSearchInfo *out
+);
+
+/* Board text for the wire format; `out` needs CF_BOARD_CHARS + 1 bytes. */
+void cf_board_format(const CfGame *game, char *out);
+/* Rejects floating stones and boards where either side already has four. */
+bool cf_board_parse(CfGame *game, const char *text, size_t len);
+
+#endif
@@ -0,0 +1,263 @@
+#include "connect_four_corpus.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum {
+    INDEX_BYTE_ORDER = 0x01020304,
+    INDEX_FORMAT_VERSION = 1,
+    INITIAL_ENTRIES = 1024,
+    PATH_CHARS = 512
+};
+
+static const char kIndexMagic[8] = {'C', 'F', '4', 'P', 'H', 'X', '1', '\n'};
+static const uint64_t kPhishingBit = UINT64_C(1) << 63;
+
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t format_version;
+    uint64_t corpus_bytes;
+    int64_t corpus_mtime_sec;
+    int64_t corpus_mtime_nsec;
+    uint64_t entry_count;
+} IndexHeader;
+
+struct CfCorpus {
+    const char *text;
+    size_t text_size;
+    void *index_map;
+    size_t index_map_size;
+    uint64_t *built; /* the index when it could not be stored */
+    const uint64_t *entries;
+    uint64_t count;
+    bool index_built;
+};
+
+/* --------------------- Index --------------------- */
+/* The corpus's modification time; macOS names the field differently. */
+static struct timespec corpus_mtime(const struct stat *st) {
+#ifdef __APPLE__
+    return st->st_mtimespec;
+#else
+    return st->st_mtim;
+#endif
+}
+
+static void index_header_for(IndexHeader *header, const struct stat *st, uint64_t count) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, kIndexMagic, sizeof(kIndexMagic));
+    header->byte_order = INDEX_BYTE_ORDER;
+    header->format_version = INDEX_FORMAT_VERSION;
+    header->corpus_bytes = (uint64_t)st->st_size;
+    header->corpus_mtime_sec = (int64_t)corpus_mtime(st).tv_sec;
+    header->corpus_mtime_nsec = (int64_t)corpus_mtime(st).tv_nsec;
+    header->entry_count = count;
+}
+
+/* Maps `index_path` if it was built from exactly this corpus file. */
+static bool index_map(CfCorpus *corpus, const char *index_path, const struct stat *corpus_st) {
+    IndexHeader expected;
+    const IndexHeader *header;
+    struct stat st;
+    void *map;
+    int fd = open(index_path, O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size <= sizeof(IndexHeader)) {
+        close(fd);
+        return false;
+    }
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    header = map;
+    index_header_for(&expected, corpus_st, header->entry_count);
+    if (memcmp(header, &expected, sizeof(expected)) != 0 ||
+        header->entry_count != ((uint64_t)st.st_size - sizeof(IndexHeader)) / sizeof(uint64_t)) {
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+    corpus->index_map = map;
+    corpus->index_map_size = (size_t)st.st_size;
+    corpus->entries = (const uint64_t *)(header + 1);
+    corpus->count = header->entry_count;
+    return true;
+}
+
+static bool entries_push(uint64_t **items, uint64_t *count, uint64_t *cap, uint64_t value) {
+    if (*count == *cap) {
+        uint64_t next_cap = *cap == 0 ? INITIAL_ENTRIES : *cap * 2;
+        uint64_t *grown = realloc(*items, (size_t)next_cap * sizeof(**items));
+
+        if (grown == NULL) {
+            return false;
+        }
+        *items = grown;
+        *cap = next_cap;
+    }
+    (*items)[(*count)++] = value;
+    return true;
+}
+
+/* One pass over the corpus: every "P\t" / "S\t" line with some text after it. */
+static bool index_build(CfCorpus *corpus) {
+    const char *text = corpus->text;
+    size_t size = corpus->text_size;
+    size_t pos = 0;
+    uint64_t cap = 0;
+
+    while (pos < size) {
+        const char *nl = memchr(text + pos, '\n', size - pos);
+        size_t end = nl != NULL ? (size_t)(nl - text) : size;
+        char label = text[pos];
+
+        if (end - pos > 2 && text[pos + 1] == '\t' && (label == 'P' || label == 'p' || label == 'S' || label == 's')) {
+            uint64_t word = (uint64_t)pos | ((label == 'P' || label == 'p') ? kPhishingBit : 0);
+
+            if (!entries_push(&corpus->built, &corpus->count, &cap, word)) {
+                return false;
+            }
+        }
+        pos = end + 1;
+    }
+    corpus->entries = corpus->built;
+    corpus->index_built = true;
+    return true;
+}
+
+/* Best effort: written beside the corpus and renamed into place, then mapped in place of the heap copy. */
+static void index_store(CfCorpus *corpus, const char *index_path, const struct stat *corpus_st) {
+    IndexHeader header;
+    char tmp_path[PATH_CHARS + sizeof(".tmp")];
+    FILE *fp;
+    bool ok;
+
+    index_header_for(&header, corpus_st, corpus->count);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", index_path);
+    fp = fopen(tmp_path, "wb");
+    ok = fp != NULL && fwrite(&header, sizeof(header), 1, fp) == 1 &&
+         fwrite(corpus->built, sizeof(uint64_t), (size_t)corpus->count, fp) == (size_t)corpus->count;
+    if (fp != NULL) {
+        ok = fclose(fp) == 0 && ok;
+    }
+    ok = ok && rename(tmp_path, index_path) == 0;
+    if (!ok) {
+        unlink(tmp_path);
+        return;
+    }
+    if (index_map(corpus, index_path, corpus_st)) {
+        free(corpus->built);
+        corpus->built = NULL;
+    }
+}
+
+/* --------------------- Corpus --------------------- */
+CfCorpus *cf_corpus_open(const char *path) {
+    CfCorpus *corpus;
+    char index_path[PATH_CHARS];
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (path == NULL || path[0] == '\0') {
+        return NULL;
+    }
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    /* Draws jump around the file; read-ahead would only pull in pages nobody asked for. */
+    madvise(map, (size_t)st.st_size, MADV_RANDOM);
+
+    corpus = calloc(1, sizeof(*corpus));
+    if (corpus == NULL) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+    corpus->text = map;
+    corpus->text_size = (size_t)st.st_size;
+
+    snprintf(index_path, sizeof(index_path), "%s%s", path, CF_CORPUS_INDEX_SUFFIX);
+    if (!index_map(corpus, index_path, &st)) {
+        if (!index_build(corpus)) {
+            cf_corpus_close(corpus);
+            return NULL;
+        }
+        /* The scan touched every page; let them go so only what draws read stays resident. */
+        madvise(map, (size_t)st.st_size, MADV_DONTNEED);
+        if (corpus->count > 0) {
+            index_store(corpus, index_path, &st);
+        }
+    }
+    if (corpus->count == 0) {
+        cf_corpus_close(corpus);
+        return NULL;
+    }
+    return corpus;
+}
+
+void cf_corpus_close(CfCorpus *corpus) {
+    if (corpus == NULL) {
+        return;
+    }
+    if (corpus->index_map != NULL) {
+        munmap(corpus->index_map, corpus->index_map_size);
+    }
+    free(corpus->built);
+    munmap((void *)corpus->text, corpus->text_size);
+    free(corpus);
+}
+
+uint64_t cf_corpus_count(const CfCorpus *corpus) {
+    return corpus != NULL ? corpus->count : 0;
+}
+
+void cf_corpus_info(const CfCorpus *corpus, CfCorpusInfo *out) {
+    memset(out, 0, sizeof(*out));
+    if (corpus == NULL) {
+        return;
+    }
+    out->entries = corpus->count;
+    out->bytes = corpus->text_size;
+    out->index_built = corpus->index_built;
+    out->index_stored = corpus->index_map != NULL;
+}
+
+void cf_corpus_entry(const CfCorpus *corpus, uint64_t index, CfCorpusEntry *out) {
+    uint64_t word = corpus->entries[index];
+    size_t start = (size_t)(word & ~kPhishingBit) + 2;
+    const char *nl;
+    size_t end;
+
+    /* A stored index is only trusted as far as its header; an offset past the end reads as empty. */
+    start = start < corpus->text_size ? start : corpus->text_size;
+    nl = memchr(corpus->text + start, '\n', corpus->text_size - start);
+    end = nl != NULL ? (size_t)(nl - corpus->text) : corpus->text_size;
+
+    if (end > start && corpus->text[end - 1] == '\r') {
+        end -= 1;
+    }
+    out->text = corpus->text + start;
+    out->len = end - start;
+    out->phishing = (word & kPhishingBit) != 0;
+}
@@ -0,0 +1,49 @@
+#ifndef CONNECT_FOUR_CORPUS_H
+#define CONNECT_FOUR_CORPUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Labeled message corpus for the phishing mini-game.
+ *
+ * Corpus file: UTF-8 text, one message per line as "P<TAB>text" (phishing)
+ * or "S<TAB>text" (safe). Blank lines, lines starting with '#' and lines
+ * without a label are skipped.
+ *
+ * The file is memory-mapped and never copied. Entries are found through an
+ * offset index ("<corpus>.idx"): one 8-byte word per message, the line's
+ * offset with the label in the top bit, behind a header recording the
+ * corpus size and modification time. A missing or stale index is rebuilt
+ * with one pass over the file and written back when the directory allows;
+ * a current one is simply mapped. Either way opening costs no more than a
+ * scan, and resident memory is whatever pages the draws touch.
+ */
+
+#define CF_CORPUS_INDEX_SUFFIX ".idx"
+
+typedef struct CfCorpus CfCorpus;
+
+typedef struct {
+    const char *text; /* not NUL-terminated */
+    size_t len;
+    bool phishing;
+} CfCorpusEntry;
+
+typedef struct {
+    uint64_t entries;
+    uint64_t bytes;
+    bool index_built; /* false when a stored index was used */
+    bool index_stored; /* the index is mapped from disk rather than held in memory */
+} CfCorpusInfo;
+
+/* NULL when the file cannot be read or holds no labeled lines. */
+CfCorpus *cf_corpus_open(const char *path);
+void cf_corpus_close(CfCorpus *corpus);
+uint64_t cf_corpus_count(const CfCorpus *corpus);
+void cf_corpus_info(const CfCorpus *corpus, CfCorpusInfo *out);
+/* `index` must be below cf_corpus_count(). */
+void cf_corpus_entry(const CfCorpus *corpus, uint64_t index, CfCorpusEntry *out);
+
+#endif
@@ -0,0 +1,244 @@
+#include "connect_four_engine.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    MAX_THREADS = 256,
+    QUEUE_CAPACITY = 256
+};
+
+typedef struct {
+    CfEngineTaskFn fn;
+    void *arg;
+} Task;
+
+struct CfEngine {
+    CfEngineConfig config;
+    CfAiTables tables;
+    CfTablebase *tablebase;
+    CfTt *tt;
+
+    _Atomic uint64_t searches;
+    _Atomic uint64_t nodes;
+    _Atomic uint64_t search_us;
+
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_cond_t idle;
+    Task queue[QUEUE_CAPACITY];
+    size_t head;
+    size_t count;
+    size_t running;
+    bool stopping;
+    pthread_t workers[MAX_THREADS];
+    int started;
+};
+
+int cf_engine_api_version(void) {
+    return CF_ENGINE_API_VERSION;
+}
+
+void cf_engine_config_init(CfEngineConfig *config) {
+    memset(config, 0, sizeof(*config));
+    config->tt_slots = CF_TT_DEFAULT_SLOTS;
+}
+
+/* --------------------- Pool --------------------- */
+static void *engine_worker(void *arg) {
+    CfEngine *engine = arg;
+
+    pthread_mutex_lock(&engine->lock);
+    while (true) {
+        Task task;
+
+        while (engine->count == 0 && !engine->stopping) {
+            pthread_cond_wait(&engine->ready, &engine->lock);
+        }
+        if (engine->count == 0) {
+            break;
+        }
+        task = engine->queue[engine->head];
+        engine->head = (engine->head + 1) % QUEUE_CAPACITY;
+        engine->count -= 1;
+        engine->running += 1;
+        pthread_mutex_unlock(&engine->lock);
+
+        task.fn(engine, task.arg);
+
+        pthread_mutex_lock(&engine->lock);
+        engine->running -= 1;
+        if (engine->count == 0 && engine->running == 0) {
+            pthread_cond_broadcast(&engine->idle);
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
+    return NULL;
+}
+
+bool cf_engine_post(CfEngine *engine, CfEngineTaskFn fn, void *arg) {
+    bool queued = false;
+
+    pthread_mutex_lock(&engine->lock);
+    if (engine->started > 0 && !engine->stopping && engine->count < QUEUE_CAPACITY) {
+        engine->queue[(engine->head + engine->count) % QUEUE_CAPACITY] = (Task){fn, arg};
+        engine->count += 1;
+        queued = true;
+        pthread_cond_signal(&engine->ready);
+    }
+    pthread_mutex_unlock(&engine->lock);
+    return queued;
+}
+
+void cf_engine_wait(CfEngine *engine) {
+    pthread_mutex_lock(&engine->lock);
+    while (engine->count > 0 || engine->running > 0) {
+        pthread_cond_wait(&engine->idle, &engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+}
+
+/* --------------------- Engine --------------------- */
+static bool engine_open_tt(CfEngine *engine, const char *path) {
+    engine->tt = NULL;
+    if (engine->config.tt_slots == 0) {
+        return true;
+    }
+    if (path != NULL && path[0] != '\0') {
+        engine->tt = cf_tt_open_shared(path, engine->config.tt_slots);
+    }
+    if (engine->tt == NULL) {
+        engine->tt = cf_tt_create(engine->config.tt_slots);
+    }
+    engine->tables.tt = engine->tt;
+    return engine->tt != NULL;
+}
+
+CfEngine *cf_engine_create(const CfEngineConfig *config) {
+    CfEngine *engine = calloc(1, sizeof(*engine));
+    int threads;
+
+    if (engine == NULL) {
+        return NULL;
+    }
+    if (config != NULL) {
+        engine->config = *config;
+    } else {
+        cf_engine_config_init(&engine->config);
+    }
+    /* The paths are only read here; the engine does not keep the caller's strings. */
+    engine_open_tt(engine, engine->config.tt_path);
+    engine->tablebase = cf_tablebase_open(engine->config.tablebase_path);
+    engine->tables.tablebase = engine->tablebase;
+    engine->config.tt_path = NULL;
+    engine->config.tablebase_path = NULL;
+    atomic_init(&engine->searches, 0);
+    atomic_init(&engine->nodes, 0);
+    atomic_init(&engine->search_us, 0);
+
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->ready, NULL);
+    pthread_cond_init(&engine->idle, NULL);
+    threads = engine->config.threads < 0 ? 0 : engine->config.threads;
+    threads = threads > MAX_THREADS ? MAX_THREADS : threads;
+    for (int i = 0; i < threads; ++i) {
+        if (pthread_create(&engine->workers[i], NULL, engine_worker, engine) != 0) {
+            break;
+        }
+        engine->started += 1;
+    }
+    return engine;
+}
+
+void cf_engine_destroy(CfEngine *engine) {
+    if (engine == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&engine->lock);
+    engine->stopping = true;
+    pthread_cond_broadcast(&engine->ready);
+    pthread_mutex_unlock(&engine->lock);
+    for (int i = 0; i < engine->started; ++i) {
+        pthread_join(engine->workers[i], NULL);
+    }
+    pthread_mutex_destroy(&engine->lock);
+    pthread_cond_destroy(&engine->ready);
+    pthread_cond_destroy(&engine->idle);
+    cf_tt_close(engine->tt);
+    cf_tablebase_close(engine->tablebase);
+    free(engine);
+}
+
+static void engine_count(CfEngine *engine, const CfSearchInfo *info) {
+    atomic_fetch_add_explicit(&engine->searches, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&engine->nodes, info->nodes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&engine->search_us, (uint64_t)(info->elapsed_ms * 1000.0), memory_order_relaxed);
+}
+
+int cf_engine_choose_move(
+    CfEngine *engine,
+    CfGame *game,
+    int depth,
+    const bool blocked_cols[CF_COLS],
+    double time_limit_ms,
+    CfSearchInfo *info
+) {
+    CfSearchInfo local;
+    CfSearchInfo *out = info != NULL ? info : &local;
+    int col = cf_ai_choose_move_with(&engine->tables, game, depth, blocked_cols, time_limit_ms, out);
+
+    engine_count(engine, out);
+    return col;
+}
+
+int cf_engine_search(
+    CfEngine *engine,
+    CfGame *game,
+    const bool blocked_cols[CF_COLS],
+    const CfSearchLimits *limits,
+    CfSearchInfoFn on_info,
+    void *user,
+    CfSearchInfo *out
+) {
+    CfSearchInfo local;
+    CfSearchInfo *result = out != NULL ? out : &local;
+    int col = cf_ai_search_with(&engine->tables, game, blocked_cols, limits, on_info, user, result);
+
+    engine_count(engine, result);
+    return col;
+}
+
+void cf_engine_stats(CfEngine *engine, CfEngineStats *out) {
+    memset(out, 0, sizeof(*out));
+    out->searches = atomic_load_explicit(&engine->searches, memory_order_relaxed);
+    out->nodes = atomic_load_explicit(&engine->nodes, memory_order_relaxed);
+    out->search_ms = (double)atomic_load_explicit(&engine->search_us, memory_order_relaxed) / 1000.0;
+    cf_tt_get_stats(engine->tt, &out->tt);
+    out->tt_shared = cf_tt_is_shared(engine->tt);
+    out->tablebase_empties = engine->tablebase != NULL ? cf_tablebase_max_empties(engine->tablebase) : -1;
+    out->threads = engine->started;
+}
+
+bool cf_engine_clear(CfEngine *engine) {
+    if (cf_tt_is_shared(engine->tt)) {
+        return true;
+    }
+    cf_tt_close(engine->tt);
+    engine->tables.tt = NULL;
+    return engine_open_tt(engine, NULL);
+}
+
+void cf_engine_prefault(CfEngine *engine) {
+    cf_tablebase_prefault(engine->tablebase);
+    cf_tt_prefault(engine->tt);
+}
+
+CfTt *cf_engine_tt(CfEngine *engine) {
+    return engine->tt;
+}
+
+const CfTablebase *cf_engine_tablebase(CfEngine *engine) {
+    return engine->tablebase;
+}
@@ -0,0 +1,104 @@
+#ifndef CONNECT_FOUR_ENGINE_H
+#define CONNECT_FOUR_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "connect_four.h"
+#include "connect_four_ai.h"
+#include "connect_four_tablebase.h"
+#include "connect_four_tt.h"
+
+/*
+ * libcfengine: the board rules, the AI and its tables behind one handle.
+ *
+ * A CfEngine owns its transposition table, its endgame table, its settings,
+ * its counters and a small worker pool. Nothing in it is global, so one
+ * process can run several engines, and any number of threads can search
+ * through one engine at once (the table is lock-free).
+ *
+ * The API is versioned: CF_ENGINE_API_VERSION changes only when a call
+ * changes meaning. New settings are added at the end of CfEngineConfig and
+ * cf_engine_config_init() gives them defaults, so code that fills the
+ * config through it keeps building and behaving the same after a rebuild.
+ * Callers allocate CfEngineConfig and CfEngineStats themselves, so that
+ * promise is source-only: any change to either layout (or to CfTtStats
+ * inside the stats) bumps CF_ENGINE_API_VERSION and the soname, and
+ * binaries built against libcfengine.so.1 never meet the new layout.
+ * The shared library exports only the calls listed in libcfengine.map,
+ * the board rules and cf_ai_score_to_mate(); the rest stays internal.
+ */
+
+#define CF_ENGINE_API_VERSION 1
+
+typedef struct CfEngine CfEngine;
+
+typedef struct {
+    size_t tt_slots;            /* 0: no transposition table */
+    const char *tt_path;        /* file-backed table shared between processes; NULL or "" for a private one */
+    const char *tablebase_path; /* NULL or "": no endgame table */
+    int threads;                /* workers for cf_engine_post(); 0: no pool */
+} CfEngineConfig;
+
+typedef struct {
+    uint64_t searches;
+    uint64_t nodes;
+    double search_ms;
+    CfTtStats tt;
+    bool tt_shared;
+    int tablebase_empties; /* -1 without an endgame table */
+    int threads;
+} CfEngineStats;
+
+typedef void (*CfEngineTaskFn)(CfEngine *engine, void *arg);
+
+int cf_engine_api_version(void);
+void cf_engine_config_init(CfEngineConfig *config);
+
+/* NULL config means the defaults. NULL only when out of memory; a table that cannot be opened is left out. */
+CfEngine *cf_engine_create(const CfEngineConfig *config);
+/* Runs what was posted, stops the workers and frees the tables; NULL is a no-op. */
+void cf_engine_destroy(CfEngine *engine);
+
+/* cf_ai_choose_move_with() / cf_ai_search_with() on this engine's tables; safe from any thread. */
+int cf_engine_choose_move(
+    CfEngine *engine,
+    CfGame *game,
+    int depth,
+    const bool blocked_cols[CF_COLS],
+    double time_limit_ms,
+    CfSearchInfo *info
+);
+int cf_engine_search(
+    CfEngine *engine,
+    CfGame *game,
+    const bool blocked_cols[CF_COLS],
+    const CfSearchLimits *limits,
+    CfSearchInfoFn on_info,
+    void *user,
+    CfSearchInfo *out
+);
+
+void cf_engine_stats(CfEngine *engine, CfEngineStats *out);
+/*
+ * Forgets cached search results. A shared table belongs to every process
+ * using it and is kept. Not while a search on this engine runs.
+ */
+bool cf_engine_clear(CfEngine *engine);
+/* Faults the tables in so the first searches do not pay for it. */
+void cf_engine_prefault(CfEngine *engine);
+/* The engine's own tables, for in-tree tools that read them (libcfengine.a only); either may be NULL. */
+CfTt *cf_engine_tt(CfEngine *engine);
+const CfTablebase *cf_engine_tablebase(CfEngine *engine);
+
+/*
+ * Runs fn(engine, arg) on a pool worker, in posting order per worker.
+ * False without a pool, with the queue full or while shutting down;
+ * the caller then runs the task itself.
+ */
+bool cf_engine_post(CfEngine *engine, CfEngineTaskFn fn, void *arg);
+/* Returns once everything posted so far has finished. */
+void cf_engine_wait(CfEngine *engine);
+
+#endif
@@ -0,0 +1,135 @@
+#include "connect_four_events.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+static int g_input_fd = -1;
+static int g_wake_pipe[2] = {-1, -1};
+static struct sigaction g_prev_winch;
+static bool g_open = false;
+
+static void on_winch(int sig) {
+    int saved_errno = errno;
+
+    if (write(g_wake_pipe[1], "r", 1) < 0) {
+        /* Pipe full: a wake-up is already pending. */
+    }
+    if ((g_prev_winch.sa_flags & SA_SIGINFO) == 0 &&
+        g_prev_winch.sa_handler != SIG_DFL &&
+        g_prev_winch.sa_handler != SIG_IGN) {
+        g_prev_winch.sa_handler(sig);
+    }
+    errno = saved_errno;
+}
+
+static bool set_flags(int fd) {
+    int fl = fcntl(fd, F_GETFL);
+    int fd_flags = fcntl(fd, F_GETFD);
+
+    return fl >= 0 && fd_flags >= 0 &&
+        fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0 &&
+        fcntl(fd, F_SETFD, fd_flags | FD_CLOEXEC) == 0;
+}
+
+bool cf_events_open(int input_fd) {
+    struct sigaction sa;
+
+    if (g_open) {
+        return false;
+    }
+    if (pipe(g_wake_pipe) != 0) {
+        return false;
+    }
+    if (!set_flags(g_wake_pipe[0]) || !set_flags(g_wake_pipe[1])) {
+        close(g_wake_pipe[0]);
+        close(g_wake_pipe[1]);
+        g_wake_pipe[0] = g_wake_pipe[1] = -1;
+        return false;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_winch;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    if (sigaction(SIGWINCH, &sa, &g_prev_winch) != 0) {
+        close(g_wake_pipe[0]);
+        close(g_wake_pipe[1]);
+        g_wake_pipe[0] = g_wake_pipe[1] = -1;
+        return false;
+    }
+
+    g_input_fd = input_fd;
+    g_open = true;
+    return true;
+}
+
+void cf_events_close(void) {
+    if (!g_open) {
+        return;
+    }
+    sigaction(SIGWINCH, &g_prev_winch, NULL);
+    close(g_wake_pipe[0]);
+    close(g_wake_pipe[1]);
+    g_wake_pipe[0] = g_wake_pipe[1] = -1;
+    g_input_fd = -1;
+    g_open = false;
+}
+
+unsigned cf_events_wait(double timeout_ms) {
+    struct pollfd fds[2];
+    unsigned events = 0;
+    int timeout = -1;
+    int ready;
+
+    if (!g_open) {
+        return 0;
+    }
+    /* Round up so a timer is never reported before it is due. */
+    if (timeout_ms >= 0) {
+        timeout = timeout_ms > 86400000.0 ? 86400000 : (int)timeout_ms;
+        if (timeout < timeout_ms) {
+            timeout += 1;
+        }
+    }
+
+    fds[0].fd = g_input_fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = g_wake_pipe[0];
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    ready = poll(fds, 2, timeout);
+    if (ready < 0) {
+        return 0;
+    }
+    if (ready == 0) {
+        return CF_EVENT_TIMEOUT;
+    }
+    if ((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+        events |= CF_EVENT_INPUT;
+    }
+    if ((fds[1].revents & POLLIN) != 0) {
+        char drain[64];
+        ssize_t got;
+
+        while ((got = read(g_wake_pipe[0], drain, sizeof(drain))) > 0) {
+            events |= memchr(drain, 'r', (size_t)got) != NULL ? CF_EVENT_RESIZE : 0;
+            events |= memchr(drain, 'w', (size_t)got) != NULL ? CF_EVENT_WAKE : 0;
+        }
+    }
+    return events;
+}
+
+void cf_events_wake(void) {
+    if (g_wake_pipe[1] < 0) {
+        return;
+    }
+    if (write(g_wake_pipe[1], "w", 1) < 0) {
+        /* Pipe full: a wake-up is already pending. */
+    }
+}
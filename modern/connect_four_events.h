@@ -0,0 +1,34 @@
+#ifndef CONNECT_FOUR_EVENTS_H
+#define CONNECT_FOUR_EVENTS_H
+
+#include <stdbool.h>
+
+/*
+ * Blocking wait for the terminal front end: sleeps in poll() until the input
+ * fd is readable, the terminal is resized, or a timeout expires.
+ *
+ * SIGWINCH is delivered through a self-pipe, so a resize wakes the wait
+ * immediately. The handler chains to whatever handler was installed before
+ * (ncurses' own, when called after initscr), so KEY_RESIZE still arrives
+ * through getch(). Only one event source exists per process.
+ *
+ * cf_events_wake() lets another thread (a background AI search) end the
+ * current wait early; it only writes to the pipe, so it is safe anywhere.
+ */
+
+enum {
+    CF_EVENT_INPUT = 1 << 0,
+    CF_EVENT_RESIZE = 1 << 1,
+    CF_EVENT_TIMEOUT = 1 << 2,
+    CF_EVENT_WAKE = 1 << 3
+};
+
+bool cf_events_open(int input_fd);
+/* Restores the previous SIGWINCH handler. */
+void cf_events_close(void);
+
+/* Returns a mask of CF_EVENT_*; 0 when interrupted. timeout_ms < 0 waits forever. */
+unsigned cf_events_wait(double timeout_ms);
+void cf_events_wake(void);
+
+#endif
@@ -0,0 +1,205 @@
+#include "connect_four_feed.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Segment layout: a header the reader validates, the sequence word and one
+ * snapshot. Bump FEED_FORMAT_VERSION whenever CfFeedSnapshot changes, so
+ * an old viewer refuses a new game instead of misreading it.
+ */
+enum {
+    FEED_BYTE_ORDER = 0x01020304,
+    FEED_FORMAT_VERSION = 1,
+    FEED_READ_TRIES = 64
+};
+
+static const char kFeedMagic[8] = {'C', 'F', '4', 'F', 'E', 'E', 'D', '\n'};
+
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t format_version;
+    uint32_t snapshot_bytes;
+    _Atomic uint32_t finished;
+    _Atomic uint64_t seq; /* odd while a publish is in progress */
+    CfFeedSnapshot snap;
+} FeedSegment;
+
+struct CfFeed {
+    FeedSegment *seg;
+    char *name;
+    uint64_t frames;
+};
+
+struct CfFeedReader {
+    const FeedSegment *seg;
+};
+
+/* Cross-process atomics are only sound when they need no lock. */
+static bool atomics_usable(void) {
+    static _Atomic uint64_t lock_free_probe;
+
+    return atomic_is_lock_free(&lock_free_probe);
+}
+
+/* --------------------- Writer --------------------- */
+CfFeed *cf_feed_open(const char *name) {
+    CfFeed *feed;
+    void *map;
+    int fd;
+
+    if (name == NULL || name[0] == '\0' || !atomics_usable()) {
+        return NULL;
+    }
+    feed = calloc(1, sizeof(*feed));
+    if (feed == NULL || (feed->name = strdup(name)) == NULL) {
+        free(feed);
+        return NULL;
+    }
+
+    /* A viewer still attached to a previous game keeps that segment; this one starts fresh. */
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        free(feed->name);
+        free(feed);
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)sizeof(FeedSegment)) != 0) {
+        close(fd);
+        shm_unlink(name);
+        free(feed->name);
+        free(feed);
+        return NULL;
+    }
+    map = mmap(NULL, sizeof(FeedSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        shm_unlink(name);
+        free(feed->name);
+        free(feed);
+        return NULL;
+    }
+
+    feed->seg = map;
+    memcpy(feed->seg->magic, kFeedMagic, sizeof(kFeedMagic));
+    feed->seg->byte_order = FEED_BYTE_ORDER;
+    feed->seg->format_version = FEED_FORMAT_VERSION;
+    feed->seg->snapshot_bytes = (uint32_t)sizeof(CfFeedSnapshot);
+    return feed;
+}
+
+void cf_feed_close(CfFeed *feed) {
+    if (feed == NULL) {
+        return;
+    }
+    atomic_store_explicit(&feed->seg->finished, 1, memory_order_release);
+    munmap(feed->seg, sizeof(FeedSegment));
+    shm_unlink(feed->name);
+    free(feed->name);
+    free(feed);
+}
+
+void cf_feed_publish(CfFeed *feed, CfFeedSnapshot *snap) {
+    FeedSegment *seg;
+    uint64_t seq;
+
+    if (feed == NULL) {
+        return;
+    }
+    seg = feed->seg;
+    feed->frames += 1;
+    snap->frame = feed->frames;
+
+    seq = atomic_load_explicit(&seg->seq, memory_order_relaxed);
+    atomic_store_explicit(&seg->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&seg->snap, snap, sizeof(*snap));
+    atomic_store_explicit(&seg->seq, seq + 2, memory_order_release);
+}
+
+/* --------------------- Reader --------------------- */
+CfFeedReader *cf_feed_attach(const char *name) {
+    CfFeedReader *reader;
+    const FeedSegment *seg;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (name == NULL || name[0] == '\0' || !atomics_usable()) {
+        return NULL;
+    }
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FeedSegment)) {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, sizeof(FeedSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    seg = map;
+    if (memcmp(seg->magic, kFeedMagic, sizeof(kFeedMagic)) != 0 ||
+        seg->byte_order != FEED_BYTE_ORDER ||
+        seg->format_version != FEED_FORMAT_VERSION ||
+        seg->snapshot_bytes != sizeof(CfFeedSnapshot)) {
+        munmap(map, sizeof(FeedSegment));
+        return NULL;
+    }
+
+    reader = calloc(1, sizeof(*reader));
+    if (reader == NULL) {
+        munmap(map, sizeof(FeedSegment));
+        return NULL;
+    }
+    reader->seg = seg;
+    return reader;
+}
+
+void cf_feed_detach(CfFeedReader *reader) {
+    if (reader == NULL) {
+        return;
+    }
+    munmap((void *)reader->seg, sizeof(FeedSegment));
+    free(reader);
+}
+
+bool cf_feed_read(CfFeedReader *reader, CfFeedSnapshot *out) {
+    const FeedSegment *seg = reader->seg;
+
+    for (int attempt = 0; attempt < FEED_READ_TRIES; ++attempt) {
+        uint64_t before = atomic_load_explicit((_Atomic uint64_t *)&seg->seq, memory_order_acquire);
+        uint64_t after;
+
+        if (before == 0) {
+            return false;
+        }
+        if ((before & 1) != 0) {
+            sched_yield();
+            continue;
+        }
+        memcpy(out, &seg->snap, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit((_Atomic uint64_t *)&seg->seq, memory_order_relaxed);
+        if (before == after) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool cf_feed_finished(const CfFeedReader *reader) {
+    return atomic_load_explicit((_Atomic uint32_t *)&reader->seg->finished, memory_order_acquire) != 0;
+}
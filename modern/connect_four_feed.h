@@ -0,0 +1,62 @@
+#ifndef CONNECT_FOUR_FEED_H
+#define CONNECT_FOUR_FEED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "connect_four.h"
+#include "connect_four_log.h"
+#include "connect_four_meta.h"
+
+/*
+ * Spectator feed: the game's visible state in a POSIX shared-memory segment
+ * that other processes map read-only.
+ *
+ * One writer, any number of readers, guarded by a seqlock. The writer bumps
+ * the sequence to odd, copies the snapshot in and bumps it back to even;
+ * it never waits for anyone. A reader copies the snapshot out and keeps it
+ * only if the sequence was even and unchanged across the copy, so a slow
+ * or dead reader costs the game nothing.
+ */
+
+#define CF_FEED_DEFAULT_NAME "/connect-four-feed"
+#define CF_FEED_LOG_LINES 12
+
+typedef struct {
+    uint64_t frame;   /* bumped by every publish */
+    uint64_t time_ms; /* session clock */
+    int8_t board[CF_ROWS][CF_COLS];
+    bool blocked_cols[CF_COLS];
+    int8_t cursor_col;
+    bool ai_thinking;
+    bool game_over;
+    int8_t winner;
+    int8_t scene; /* 0 while the board is showing */
+    CfMeta meta;
+    char player_name[32];
+    char status[160];
+    char effects[220];
+    char alert[80];
+    int log_lines;
+    uint64_t log_count;
+    char log[CF_FEED_LOG_LINES][CF_LOG_CHARS];
+} CfFeedSnapshot;
+
+typedef struct CfFeed CfFeed;
+typedef struct CfFeedReader CfFeedReader;
+
+/* Creates (or takes over) the segment; NULL when shared memory is unavailable. */
+CfFeed *cf_feed_open(const char *name);
+/* Marks the feed finished, unmaps it and removes the name; NULL is a no-op. */
+void cf_feed_close(CfFeed *feed);
+/* A memcpy between two sequence bumps. Sets `snap->frame`. */
+void cf_feed_publish(CfFeed *feed, CfFeedSnapshot *snap);
+
+CfFeedReader *cf_feed_attach(const char *name);
+void cf_feed_detach(CfFeedReader *reader);
+/* False when no consistent copy could be taken (the writer kept publishing) or nothing was published yet. */
+bool cf_feed_read(CfFeedReader *reader, CfFeedSnapshot *out);
+/* True once the game has closed the feed. */
+bool cf_feed_finished(const CfFeedReader *reader);
+
+#endif
@@ -0,0 +1,736 @@
+#include "connect_four_gamedb.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum {
+    GAMEDB_VERSION = 1,
+    GAMEDB_HEADER_BYTES = 5,
+    GAMEDB_PAYLOAD_MAX = 2048,
+    GAMEDB_QUEUE_BYTES = 1 << 20,
+    INDEX_BYTE_ORDER = 0x01020304,
+    INDEX_FORMAT_VERSION = 1,
+    INDEX_END = CF_COLS,
+    VARINT_MAX_BYTES = 10,
+    PATH_CHARS = 512
+};
+
+static const char kGameDbMagic[4] = {'C', 'F', 'G', 'D'};
+static const char kIndexMagic[8] = {'C', 'F', '4', 'I', 'D', 'X', '1', '\n'};
+
+struct CfGameDb {
+    FILE *fp;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stop;
+    unsigned char *pending;
+    size_t pending_len;
+    unsigned char *spare;
+};
+
+struct CfGameReader {
+    const unsigned char *map;
+    size_t size;
+    size_t pos;
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t format_version;
+    uint64_t covered_bytes;
+    uint64_t games;
+    uint64_t entry_count;
+} IndexHeader;
+
+/* (key, next, outcome) -> count, sorted by key then next then outcome. */
+typedef struct {
+    uint64_t key;
+    uint8_t next;
+    uint8_t outcome;
+    uint16_t reserved;
+    uint32_t count;
+} IndexEntry;
+
+struct CfGameIndex {
+    void *map;
+    size_t map_size;
+    const IndexHeader *header;
+    const IndexEntry *entries;
+};
+
+/* --------------------- Encoding --------------------- */
+static size_t put_varint(unsigned char *dst, uint64_t value) {
+    size_t len = 0;
+
+    do {
+        unsigned char byte = (unsigned char)(value & 0x7f);
+
+        value >>= 7;
+        dst[len++] = (unsigned char)(byte | (value != 0 ? 0x80 : 0));
+    } while (value != 0);
+    return len;
+}
+
+static bool get_varint(const unsigned char *data, size_t size, size_t *pos, uint64_t *out) {
+    uint64_t value = 0;
+
+    for (int shift = 0; shift < 7 * VARINT_MAX_BYTES; shift += 7) {
+        unsigned char byte;
+
+        if (*pos >= size) {
+            return false;
+        }
+        byte = data[(*pos)++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t fnv1a32(const unsigned char *data, size_t len) {
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static size_t encode_payload(const CfGameRecord *rec, unsigned char *out) {
+    const CfRoundEffects *fx = &rec->fx;
+    unsigned blocked = 0;
+    size_t len = 0;
+    int count = rec->event_count < CF_GAMEDB_MAX_EVENTS ? rec->event_count : CF_GAMEDB_MAX_EVENTS;
+
+    for (int col = 0; col < CF_COLS; ++col) {
+        blocked |= fx->blocked_cols[col] ? 1u << col : 0u;
+    }
+    len += put_varint(out + len, (uint64_t)rec->finished_at);
+    out[len++] = (unsigned char)rec->outcome;
+    out[len++] = (unsigned char)rec->compromised_pct;
+    out[len++] = (unsigned char)blocked;
+    out[len++] = (unsigned char)fx->input_glitch_pct;
+    out[len++] = (unsigned char)fx->forced_move_pct;
+    out[len++] = (unsigned char)fx->control_shift;
+    out[len++] = (unsigned char)(fx->control_direction < 0 ? 1 : 0);
+    out[len++] = (unsigned char)fx->ai_depth_bonus;
+    out[len++] = (unsigned char)fx->ai_opening_moves;
+    out[len++] = (unsigned char)fx->player_piece_corrupt_pct;
+    out[len++] = (unsigned char)fx->flip_turns_remaining;
+    out[len++] = (unsigned char)fx->purple_turns_remaining;
+    len += put_varint(out + len, (uint64_t)count);
+    for (int i = 0; i < count; ++i) {
+        const CfGameEvent *ev = &rec->events[i];
+
+        out[len++] = (unsigned char)((ev->kind << 4) | (ev->col & 0x0f));
+        if (ev->kind == CF_EVENT_AI) {
+            len += put_varint(out + len, ev->ai_us);
+        }
+    }
+    return len;
+}
+
+static bool decode_payload(const unsigned char *data, size_t size, CfGameRecord *rec) {
+    CfRoundEffects *fx = &rec->fx;
+    size_t pos = 0;
+    uint64_t value;
+
+    memset(rec, 0, sizeof(*rec));
+    if (!get_varint(data, size, &pos, &value) || size - pos < 12) {
+        return false;
+    }
+    rec->finished_at = (int64_t)value;
+    rec->outcome = data[pos] < CF_GAME_OUTCOMES ? (CfGameOutcome)data[pos] : CF_GAME_DRAW;
+    rec->compromised_pct = data[pos + 1];
+    for (int col = 0; col < CF_COLS; ++col) {
+        fx->blocked_cols[col] = (data[pos + 2] >> col) & 1u;
+        fx->blocked_count += fx->blocked_cols[col];
+    }
+    fx->input_glitch_pct = data[pos + 3];
+    fx->forced_move_pct = data[pos + 4];
+    fx->control_shift = data[pos + 5];
+    fx->control_direction = data[pos + 6] != 0 ? -1 : 1;
+    fx->ai_depth_bonus = data[pos + 7];
+    fx->ai_opening_moves = data[pos + 8];
+    fx->player_piece_corrupt_pct = data[pos + 9];
+    fx->flip_turns_remaining = data[pos + 10];
+    fx->purple_turns_remaining = data[pos + 11];
+    pos += 12;
+
+    if (!get_varint(data, size, &pos, &value) || value > CF_GAMEDB_MAX_EVENTS) {
+        return false;
+    }
+    rec->event_count = (int)value;
+    for (int i = 0; i < rec->event_count; ++i) {
+        CfGameEvent *ev = &rec->events[i];
+
+        if (pos >= size) {
+            return false;
+        }
+        ev->kind = data[pos] >> 4;
+        ev->col = data[pos] & 0x0f;
+        pos += 1;
+        if (ev->kind > CF_EVENT_CORRUPT || ev->col >= CF_COLS) {
+            return false;
+        }
+        if (ev->kind == CF_EVENT_AI) {
+            if (!get_varint(data, size, &pos, &value)) {
+                return false;
+            }
+            ev->ai_us = value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+        }
+    }
+    return pos == size;
+}
+
+void cf_game_record_event(CfGameRecord *rec, CfGameEventKind kind, int col, uint32_t ai_us) {
+    CfGameEvent *ev;
+
+    if (rec->event_count >= CF_GAMEDB_MAX_EVENTS || col < 0 || col >= CF_COLS) {
+        return;
+    }
+    ev = &rec->events[rec->event_count++];
+    ev->kind = (uint8_t)kind;
+    ev->col = (uint8_t)col;
+    ev->ai_us = ai_us;
+}
+
+/* --------------------- Writer --------------------- */
+static void *writer_thread(void *arg) {
+    CfGameDb *db = arg;
+
+    pthread_mutex_lock(&db->lock);
+    while (true) {
+        unsigned char *batch;
+        size_t len;
+
+        while (db->pending_len == 0 && !db->stop) {
+            pthread_cond_wait(&db->wake, &db->lock);
+        }
+        if (db->pending_len == 0) {
+            break;
+        }
+        /* Swap buffers so the game can keep queueing while this one is written. */
+        batch = db->pending;
+        len = db->pending_len;
+        db->pending = db->spare;
+        db->pending_len = 0;
+        db->spare = batch;
+        pthread_mutex_unlock(&db->lock);
+
+        fwrite(batch, 1, len, db->fp);
+        fflush(db->fp);
+
+        pthread_mutex_lock(&db->lock);
+    }
+    pthread_mutex_unlock(&db->lock);
+    return NULL;
+}
+
+static void gamedb_free(CfGameDb *db) {
+    if (db->fp != NULL) {
+        fclose(db->fp);
+    }
+    free(db->pending);
+    free(db->spare);
+    free(db);
+}
+
+/* An empty file gets a header; anything else must already be a game file. */
+static bool gamedb_check_header(FILE *fp) {
+    unsigned char header[GAMEDB_HEADER_BYTES];
+    long size;
+
+    if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0) {
+        return false;
+    }
+    if (size == 0) {
+        memcpy(header, kGameDbMagic, sizeof(kGameDbMagic));
+        header[4] = GAMEDB_VERSION;
+        return fwrite(header, 1, sizeof(header), fp) == sizeof(header) && fflush(fp) == 0;
+    }
+    rewind(fp);
+    if (size < GAMEDB_HEADER_BYTES ||
+        fread(header, 1, sizeof(header), fp) != sizeof(header) ||
+        memcmp(header, kGameDbMagic, sizeof(kGameDbMagic)) != 0 ||
+        header[4] != GAMEDB_VERSION) {
+        return false;
+    }
+    return fseek(fp, 0, SEEK_END) == 0;
+}
+
+CfGameDb *cf_gamedb_open(const char *path) {
+    CfGameDb *db;
+
+    if (path == NULL || path[0] == '\0') {
+        return NULL;
+    }
+    db = calloc(1, sizeof(*db));
+    if (db == NULL) {
+        return NULL;
+    }
+    db->pending = malloc(GAMEDB_QUEUE_BYTES);
+    db->spare = malloc(GAMEDB_QUEUE_BYTES);
+    db->fp = fopen(path, "a+b");
+    if (db->pending == NULL || db->spare == NULL || db->fp == NULL || !gamedb_check_header(db->fp)) {
+        gamedb_free(db);
+        return NULL;
+    }
+
+    pthread_mutex_init(&db->lock, NULL);
+    pthread_cond_init(&db->wake, NULL);
+    if (pthread_create(&db->thread, NULL, writer_thread, db) != 0) {
+        pthread_mutex_destroy(&db->lock);
+        pthread_cond_destroy(&db->wake);
+        gamedb_free(db);
+        return NULL;
+    }
+    return db;
+}
+
+void cf_gamedb_close(CfGameDb *db) {
+    if (db == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&db->lock);
+    db->stop = true;
+    pthread_cond_signal(&db->wake);
+    pthread_mutex_unlock(&db->lock);
+    pthread_join(db->thread, NULL);
+
+    pthread_mutex_destroy(&db->lock);
+    pthread_cond_destroy(&db->wake);
+    gamedb_free(db);
+}
+
+bool cf_gamedb_append(CfGameDb *db, const CfGameRecord *rec) {
+    unsigned char payload[GAMEDB_PAYLOAD_MAX];
+    unsigned char frame[VARINT_MAX_BYTES];
+    size_t payload_len;
+    size_t frame_len;
+    uint32_t check;
+    bool queued = false;
+
+    if (db == NULL) {
+        return false;
+    }
+    payload_len = encode_payload(rec, payload);
+    frame_len = put_varint(frame, payload_len);
+    check = fnv1a32(payload, payload_len);
+
+    pthread_mutex_lock(&db->lock);
+    if (db->pending_len + frame_len + payload_len + 4 <= GAMEDB_QUEUE_BYTES) {
+        unsigned char *dst = db->pending + db->pending_len;
+
+        memcpy(dst, frame, frame_len);
+        memcpy(dst + frame_len, payload, payload_len);
+        for (int i = 0; i < 4; ++i) {
+            dst[frame_len + payload_len + (size_t)i] = (unsigned char)(check >> (8 * i));
+        }
+        db->pending_len += frame_len + payload_len + 4;
+        pthread_cond_signal(&db->wake);
+        queued = true;
+    }
+    pthread_mutex_unlock(&db->lock);
+    return queued;
+}
+
+/* --------------------- Reader --------------------- */
+CfGameReader *cf_gamedb_reader_open(const char *path) {
+    CfGameReader *reader;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (path == NULL || path[0] == '\0') {
+        return NULL;
+    }
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < GAMEDB_HEADER_BYTES) {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    if (memcmp(map, kGameDbMagic, sizeof(kGameDbMagic)) != 0 || ((const unsigned char *)map)[4] != GAMEDB_VERSION) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+
+    reader = calloc(1, sizeof(*reader));
+    if (reader == NULL) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+    reader->map = map;
+    reader->size = (size_t)st.st_size;
+    reader->pos = GAMEDB_HEADER_BYTES;
+    /* Records are read front to back, once. */
+    madvise(map, reader->size, MADV_SEQUENTIAL);
+    return reader;
+}
+
+void cf_gamedb_reader_close(CfGameReader *reader) {
+    if (reader == NULL) {
+        return;
+    }
+    munmap((void *)reader->map, reader->size);
+    free(reader);
+}
+
+void cf_gamedb_reader_seek(CfGameReader *reader, uint64_t offset) {
+    reader->pos = offset < GAMEDB_HEADER_BYTES ? GAMEDB_HEADER_BYTES : (size_t)offset;
+}
+
+bool cf_gamedb_reader_next(CfGameReader *reader, CfGameRecord *rec) {
+    size_t pos = reader->pos;
+    uint64_t len;
+    uint32_t check = 0;
+
+    if (!get_varint(reader->map, reader->size, &pos, &len) || len > GAMEDB_PAYLOAD_MAX || reader->size - pos < len + 4) {
+        return false;
+    }
+    for (int i = 0; i < 4; ++i) {
+        check |= (uint32_t)reader->map[pos + len + (size_t)i] << (8 * i);
+    }
+    if (check != fnv1a32(reader->map + pos, (size_t)len) || !decode_payload(reader->map + pos, (size_t)len, rec)) {
+        return false;
+    }
+    reader->pos = pos + (size_t)len + 4;
+    return true;
+}
+
+uint64_t cf_gamedb_reader_offset(const CfGameReader *reader) {
+    return reader->pos;
+}
+
+/* --------------------- Index building --------------------- */
+typedef struct {
+    IndexEntry *items;
+    size_t count;
+    size_t cap;
+} EntryList;
+
+static bool entry_push(EntryList *list, uint64_t key, int next, int outcome) {
+    IndexEntry *entry;
+
+    if (list->count == list->cap) {
+        size_t cap = list->cap > 0 ? list->cap * 2 : 4096;
+        IndexEntry *items = realloc(list->items, cap * sizeof(*items));
+
+        if (items == NULL) {
+            return false;
+        }
+        list->items = items;
+        list->cap = cap;
+    }
+    entry = &list->items[list->count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->key = key;
+    entry->next = (uint8_t)next;
+    entry->outcome = (uint8_t)outcome;
+    entry->count = 1;
+    return true;
+}
+
+static int entry_order(const IndexEntry *a, const IndexEntry *b) {
+    if (a->key != b->key) {
+        return a->key < b->key ? -1 : 1;
+    }
+    if (a->next != b->next) {
+        return a->next < b->next ? -1 : 1;
+    }
+    if (a->outcome != b->outcome) {
+        return a->outcome < b->outcome ? -1 : 1;
+    }
+    return 0;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    return entry_order(a, b);
+}
+
+/* The round's result for whoever is to move. */
+static int mover_outcome(CfGameOutcome player, CfCell mover) {
+    if (player == CF_GAME_DRAW || mover == CF_HUMAN) {
+        return player;
+    }
+    return player == CF_GAME_WIN ? CF_GAME_LOSS : CF_GAME_WIN;
+}
+
+static bool push_position(EntryList *list, const CfGame *game, CfCell mover, int col, CfGameOutcome outcome) {
+    uint64_t key = cf_position_key(game, mover);
+    uint64_t canonical = cf_canonical_key(key);
+
+    /* Stored as the mirror image: so is the move. */
+    if (canonical != key && col < CF_COLS) {
+        col = CF_COLS - 1 - col;
+    }
+    return entry_push(list, canonical, col, mover_outcome(outcome, mover));
+}
+
+static bool corrupt_top(CfGame *game, int col) {
+    for (int row = 0; row < CF_ROWS; ++row) {
+        if (game->board[row][col] != CF_EMPTY) {
+            game->board[row][col] = CF_EMPTY;
+            game->moves -= game->moves > 0 ? 1 : 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Replays the record, adding the position before every drop and the one it ended on. */
+static bool index_record(EntryList *list, const CfGameRecord *rec) {
+    CfGame game;
+    CfCell mover = CF_HUMAN;
+
+    cf_init(&game);
+    for (int i = 0; i < rec->event_count; ++i) {
+        const CfGameEvent *ev = &rec->events[i];
+        CfCell piece = ev->kind == CF_EVENT_AI ? CF_AI : CF_HUMAN;
+
+        if (ev->kind == CF_EVENT_CORRUPT) {
+            if (!corrupt_top(&game, ev->col)) {
+                return true;
+            }
+            continue;
+        }
+        if (!cf_is_valid_move(&game, ev->col)) {
+            return true;
+        }
+        if (!push_position(list, &game, piece, ev->col, rec->outcome)) {
+            return false;
+        }
+        cf_drop_piece(&game, ev->col, piece);
+        mover = piece == CF_HUMAN ? CF_AI : CF_HUMAN;
+    }
+    return push_position(list, &game, mover, INDEX_END, rec->outcome);
+}
+
+/* Sorts and folds equal entries into one with the summed count. */
+static void entries_coalesce(EntryList *list) {
+    size_t out = 0;
+
+    qsort(list->items, list->count, sizeof(*list->items), compare_entries);
+    for (size_t i = 0; i < list->count; ++i) {
+        if (out > 0 && entry_order(&list->items[out - 1], &list->items[i]) == 0) {
+            list->items[out - 1].count += list->items[i].count;
+        } else {
+            list->items[out++] = list->items[i];
+        }
+    }
+    list->count = out;
+}
+
+static bool write_entry(FILE *fp, const IndexEntry *entry, uint64_t *written) {
+    *written += 1;
+    return fwrite(entry, sizeof(*entry), 1, fp) == 1;
+}
+
+/* Streams old (mapped) and new (sorted) entries into `fp` in order, merging equal keys. */
+static bool merge_entries(FILE *fp, const IndexEntry *old, size_t old_count, const EntryList *fresh, uint64_t *written) {
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < old_count || j < fresh->count) {
+        IndexEntry entry;
+        int order;
+
+        if (i >= old_count) {
+            order = 1;
+        } else if (j >= fresh->count) {
+            order = -1;
+        } else {
+            order = entry_order(&old[i], &fresh->items[j]);
+        }
+        if (order < 0) {
+            entry = old[i++];
+        } else if (order > 0) {
+            entry = fresh->items[j++];
+        } else {
+            entry = old[i++];
+            entry.count += fresh->items[j++].count;
+        }
+        if (!write_entry(fp, &entry, written)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool cf_gamedb_index_update(const char *games_path, const char *index_path, CfGameIndexStats *stats) {
+    CfGameReader *reader = cf_gamedb_reader_open(games_path);
+    CfGameIndex *old = cf_gamedb_index_open(index_path);
+    const IndexEntry *old_entries = NULL;
+    size_t old_count = 0;
+    uint64_t games = 0;
+    EntryList fresh = {0};
+    CfGameRecord rec;
+    IndexHeader header;
+    char tmp_path[PATH_CHARS];
+    FILE *fp;
+    bool ok = true;
+
+    memset(stats, 0, sizeof(*stats));
+    if (reader == NULL) {
+        cf_gamedb_index_close(old);
+        return false;
+    }
+    /* An index past the end of the game file belongs to some other file. */
+    if (old != NULL && old->header->covered_bytes <= reader->size) {
+        old_entries = old->entries;
+        old_count = (size_t)old->header->entry_count;
+        games = old->header->games;
+        cf_gamedb_reader_seek(reader, old->header->covered_bytes);
+    }
+
+    while (ok && cf_gamedb_reader_next(reader, &rec)) {
+        ok = index_record(&fresh, &rec);
+        stats->new_games += 1;
+    }
+    if (!ok) {
+        free(fresh.items);
+        cf_gamedb_index_close(old);
+        cf_gamedb_reader_close(reader);
+        return false;
+    }
+    entries_coalesce(&fresh);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.byte_order = INDEX_BYTE_ORDER;
+    header.format_version = INDEX_FORMAT_VERSION;
+    header.covered_bytes = cf_gamedb_reader_offset(reader);
+    header.games = games + stats->new_games;
+
+    /* Written beside the old index and renamed over it, so a reader never sees half of one. */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", index_path);
+    fp = fopen(tmp_path, "wb");
+    ok = fp != NULL && fwrite(&header, sizeof(header), 1, fp) == 1;
+    ok = ok && merge_entries(fp, old_entries, old_count, &fresh, &header.entry_count);
+    ok = ok && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+    if (fp != NULL) {
+        ok = fclose(fp) == 0 && ok;
+    }
+    ok = ok && rename(tmp_path, index_path) == 0;
+    if (!ok) {
+        unlink(tmp_path);
+    }
+
+    stats->games = header.games;
+    stats->entries = header.entry_count;
+    free(fresh.items);
+    cf_gamedb_index_close(old);
+    cf_gamedb_reader_close(reader);
+    return ok;
+}
+
+/* --------------------- Index lookup --------------------- */
+CfGameIndex *cf_gamedb_index_open(const char *index_path) {
+    CfGameIndex *index;
+    const IndexHeader *header;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (index_path == NULL || index_path[0] == '\0') {
+        return NULL;
+    }
+    fd = open(index_path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(IndexHeader)) {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    header = map;
+    if (memcmp(header->magic, kIndexMagic, sizeof(kIndexMagic)) != 0 ||
+        header->byte_order != INDEX_BYTE_ORDER ||
+        header->format_version != INDEX_FORMAT_VERSION ||
+        header->entry_count != ((uint64_t)st.st_size - sizeof(IndexHeader)) / sizeof(IndexEntry)) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+
+    index = calloc(1, sizeof(*index));
+    if (index == NULL) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+    index->map = map;
+    index->map_size = (size_t)st.st_size;
+    index->header = header;
+    index->entries = (const IndexEntry *)(header + 1);
+    return index;
+}
+
+void cf_gamedb_index_close(CfGameIndex *index) {
+    if (index == NULL) {
+        return;
+    }
+    munmap(index->map, index->map_size);
+    free(index);
+}
+
+uint64_t cf_gamedb_index_games(const CfGameIndex *index) {
+    return index->header->games;
+}
+
+void cf_gamedb_index_lookup(const CfGameIndex *index, const CfGame *game, CfCell to_move, CfPositionStats *out) {
+    uint64_t key = cf_position_key(game, to_move);
+    uint64_t canonical = cf_canonical_key(key);
+    bool mirrored = canonical != key;
+    size_t lo = 0;
+    size_t hi = (size_t)index->header->entry_count;
+
+    memset(out, 0, sizeof(*out));
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (index->entries[mid].key < canonical) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (size_t i = lo; i < (size_t)index->header->entry_count && index->entries[i].key == canonical; ++i) {
+        const IndexEntry *entry = &index->entries[i];
+        int next = entry->next;
+
+        if (next > INDEX_END || entry->outcome >= CF_GAME_OUTCOMES) {
+            continue;
+        }
+        if (mirrored && next < CF_COLS) {
+            next = CF_COLS - 1 - next;
+        }
+        out->occurrences += entry->count;
+        out->next[next][entry->outcome] += entry->count;
+    }
+}
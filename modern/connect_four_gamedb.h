@@ -0,0 +1,111 @@
+#ifndef CONNECT_FOUR_GAMEDB_H
+#define CONNECT_FOUR_GAMEDB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "connect_four.h"
+#include "connect_four_meta.h"
+
+/*
+ * Game records: every finished round appended to a compact file, and a
+ * position index built over that file.
+ *
+ * Game file: "CFGD", a version byte, then one record per round: a varint
+ * payload length, the payload and a 4-byte FNV-1a of the payload. A record
+ * cut short by a crash fails its length or checksum and ends the readable
+ * part of the file. The payload is the finish time, the outcome, the
+ * round's effects as rolled (locked columns included) and the event list:
+ * one byte per drop or corruption (kind << 4 | column), AI drops followed
+ * by a varint of the search time in microseconds.
+ *
+ * The writer encodes on the caller's thread into a pending buffer and a
+ * background thread does the file I/O, so the game never waits on the disk.
+ *
+ * Index file ("<games>.idx"): a header recording how far into the game file
+ * it reaches, then entries sorted by key. Each entry counts how often the
+ * side to move in a canonical position (mirror images merged) made a given
+ * move, split by how that round ended for them. Updating reads only the
+ * records added since and merges them in; a lookup is a binary search.
+ */
+
+#define CF_GAMEDB_MAX_EVENTS 160
+#define CF_GAMEDB_INDEX_SUFFIX ".idx"
+
+typedef enum {
+    CF_GAME_WIN,
+    CF_GAME_LOSS,
+    CF_GAME_DRAW,
+    CF_GAME_OUTCOMES
+} CfGameOutcome;
+
+typedef enum {
+    CF_EVENT_HUMAN,
+    CF_EVENT_AI,
+    CF_EVENT_CORRUPT
+} CfGameEventKind;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t col;
+    uint32_t ai_us; /* CF_EVENT_AI only */
+} CfGameEvent;
+
+typedef struct {
+    int64_t finished_at; /* Unix seconds */
+    CfGameOutcome outcome; /* for the player */
+    int compromised_pct; /* when the round started */
+    CfRoundEffects fx;
+    int event_count;
+    CfGameEvent events[CF_GAMEDB_MAX_EVENTS];
+} CfGameRecord;
+
+/* --------------------- Writing --------------------- */
+typedef struct CfGameDb CfGameDb;
+
+/* Opens `path` for appending (creating it) and starts the writer thread. */
+CfGameDb *cf_gamedb_open(const char *path);
+/* Writes everything queued, then closes; NULL is a no-op. */
+void cf_gamedb_close(CfGameDb *db);
+/* Never touches the disk; false when the record was dropped (queue full). */
+bool cf_gamedb_append(CfGameDb *db, const CfGameRecord *rec);
+
+/* Adds to `rec` unless it is full. */
+void cf_game_record_event(CfGameRecord *rec, CfGameEventKind kind, int col, uint32_t ai_us);
+
+/* --------------------- Reading --------------------- */
+typedef struct CfGameReader CfGameReader;
+
+CfGameReader *cf_gamedb_reader_open(const char *path);
+void cf_gamedb_reader_close(CfGameReader *reader);
+/* Starts at byte `offset` (0 for the first record). */
+void cf_gamedb_reader_seek(CfGameReader *reader, uint64_t offset);
+/* False at the end of the readable records. */
+bool cf_gamedb_reader_next(CfGameReader *reader, CfGameRecord *rec);
+/* Offset just past the last record read. */
+uint64_t cf_gamedb_reader_offset(const CfGameReader *reader);
+
+/* --------------------- Position index --------------------- */
+typedef struct {
+    uint64_t games;
+    uint64_t entries;
+    uint64_t new_games;
+} CfGameIndexStats;
+
+/* What followed a position: next[col] by outcome for the side to move; next[CF_COLS] is "the round ended here". */
+typedef struct {
+    uint64_t occurrences;
+    uint64_t next[CF_COLS + 1][CF_GAME_OUTCOMES];
+} CfPositionStats;
+
+typedef struct CfGameIndex CfGameIndex;
+
+/* Brings `index_path` up to date with `games_path`, rebuilding it if it does not match. */
+bool cf_gamedb_index_update(const char *games_path, const char *index_path, CfGameIndexStats *stats);
+CfGameIndex *cf_gamedb_index_open(const char *index_path);
+void cf_gamedb_index_close(CfGameIndex *index);
+uint64_t cf_gamedb_index_games(const CfGameIndex *index);
+void cf_gamedb_index_lookup(const CfGameIndex *index, const CfGame *game, CfCell to_move, CfPositionStats *out);
+
+#endif
@@ -0,0 +1,594 @@
+#include "connect_four_kernels.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86 1
+#else
+#define KERNELS_X86 0
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define KERNELS_NEON 1
+#else
+#define KERNELS_NEON 0
+#endif
+
+enum {
+    CELLS = CF_ROWS * CF_COLS,
+    WINDOW_FOUR = 100000,
+    WINDOW_AI_THREE = 120,
+    WINDOW_AI_TWO = 14,
+    WINDOW_HUMAN_THREE = -150,
+    WINDOW_HUMAN_TWO = -12,
+    CENTER_WEIGHT = 7
+};
+
+/*
+ * Bitboards: bit row * CF_COLS + col, the same order as the cells of
+ * game->board, so a row of SIMD compares yields the bits directly. A
+ * window starting at bit b in direction d covers b, b+d, b+2d, b+3d; the
+ * START masks hold the bits where a window fits without wrapping.
+ */
+_Static_assert(sizeof(CfCell) == 4, "the SIMD compares load CfCell as 32-bit lanes");
+_Static_assert(CELLS <= 64 && CELLS % 4 == 0, "the board must fit one 64-bit word in whole 4-cell loads");
+
+#define FIRST_COLUMN (((UINT64_C(1) << CELLS) - 1) / ((UINT64_C(1) << CF_COLS) - 1))
+#define COLUMNS_FROM(col) (FIRST_COLUMN * (((UINT64_C(1) << CF_COLS) - 1) ^ ((UINT64_C(1) << (col)) - 1)))
+#define COLUMNS_UPTO(col) (FIRST_COLUMN * ((UINT64_C(1) << ((col) + 1)) - 1))
+#define ROWS_UPTO(row) ((UINT64_C(1) << (((row) + 1) * CF_COLS)) - 1)
+
+#define START_HORIZONTAL COLUMNS_UPTO(CF_COLS - 4)
+#define START_VERTICAL ROWS_UPTO(CF_ROWS - 4)
+#define START_DIAGONAL (START_HORIZONTAL & START_VERTICAL)
+#define START_ANTI_DIAGONAL (COLUMNS_FROM(3) & START_VERTICAL)
+#define CENTER_COLUMN (FIRST_COLUMN << (CF_COLS / 2))
+
+typedef struct {
+    uint64_t ai;
+    uint64_t human;
+} Bits;
+
+static const char *const kSetNames[CF_KERNEL_SETS] = {"scalar", "sse4.2", "avx2", "neon"};
+
+/* --------------------- Scalar reference --------------------- */
+static bool has_winner_scalar(const CfGame *game, CfCell piece) {
+    for (int row = 0; row < CF_ROWS; ++row) {
+        for (int col = 0; col <= CF_COLS - 4; ++col) {
+            if (game->board[row][col] == piece &&
+                game->board[row][col + 1] == piece &&
+                game->board[row][col + 2] == piece &&
+                game->board[row][col + 3] == piece) {
+                return true;
+            }
+        }
+    }
+
+    for (int row = 0; row <= CF_ROWS - 4; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            if (game->board[row][col] == piece &&
+                game->board[row + 1][col] == piece &&
+                game->board[row + 2][col] == piece &&
+                game->board[row + 3][col] == piece) {
+                return true;
+            }
+        }
+    }
+
+    for (int row = 0; row <= CF_ROWS - 4; ++row) {
+        for (int col = 0; col <= CF_COLS - 4; ++col) {
+            if (game->board[row][col] == piece &&
+                game->board[row + 1][col + 1] == piece &&
+                game->board[row + 2][col + 2] == piece &&
+                game->board[row + 3][col + 3] == piece) {
+                return true;
+            }
+        }
+    }
+
+    for (int row = 3; row < CF_ROWS; ++row) {
+        for (int col = 0; col <= CF_COLS - 4; ++col) {
+            if (game->board[row][col] == piece &&
+                game->board[row - 1][col + 1] == piece &&
+                game->board[row - 2][col + 2] == piece &&
+                game->board[row - 3][col + 3] == piece) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+int cf_evaluate_window(const CfCell window[4]) {
+    int ai_count = 0;
+    int human_count = 0;
+    int empty_count = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        if (window[i] == CF_AI) {
+            ai_count += 1;
+        } else if (window[i] == CF_HUMAN) {
+            human_count += 1;
+        } else {
+            empty_count += 1;
+        }
+    }
+
+    if (ai_count == 4) {
+        return WINDOW_FOUR;
+    }
+    if (human_count == 4) {
+        return -WINDOW_FOUR;
+    }
+    if (ai_count == 3 && empty_count == 1) {
+        return WINDOW_AI_THREE;
+    }
+    if (ai_count == 2 && empty_count == 2) {
+        return WINDOW_AI_TWO;
+    }
+    if (human_count == 3 && empty_count == 1) {
+        return WINDOW_HUMAN_THREE;
+    }
+    if (human_count == 2 && empty_count == 2) {
+        return WINDOW_HUMAN_TWO;
+    }
+
+    return 0;
+}
+
+static int score_position_scalar(const CfGame *game) {
+    int score = 0;
+    CfCell window[4];
+
+    for (int row = 0; row < CF_ROWS; ++row) {
+        if (game->board[row][CF_COLS / 2] == CF_AI) {
+            score += CENTER_WEIGHT;
+        } else if (game->board[row][CF_COLS / 2] == CF_HUMAN) {
+            score -= CENTER_WEIGHT;
+        }
+    }
+
+    for (int row = 0; row < CF_ROWS; ++row) {
+        for (int col = 0; col <= CF_COLS - 4; ++col) {
+            for (int i = 0; i < 4; ++i) {
+                window[i] = game->board[row][col + i];
+            }
+            score += cf_evaluate_window(window);
+        }
+    }
+
+    for (int row = 0; row <= CF_ROWS - 4; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            for (int i = 0; i < 4; ++i) {
+                window[i] = game->board[row + i][col];
+            }
+            score += cf_evaluate_window(window);
+        }
+    }
+
+    for (int row = 0; row <= CF_ROWS - 4; ++row) {
+        for (int col = 0; col <= CF_COLS - 4; ++col) {
+            for (int i = 0; i < 4; ++i) {
+                window[i] = game->board[row + i][col + i];
+            }
+            score += cf_evaluate_window(window);
+        }
+    }
+
+    for (int row = 3; row < CF_ROWS; ++row) {
+        for (int col = 0; col <= CF_COLS - 4; ++col) {
+            for (int i = 0; i < 4; ++i) {
+                window[i] = game->board[row - i][col + i];
+            }
+            score += cf_evaluate_window(window);
+        }
+    }
+
+    return score;
+}
+
+static void eval_children_scalar(const CfGame *game, const int cols[], int count, CfCell piece, CfChildEval out[]) {
+    CfGame child = *game;
+
+    for (int i = 0; i < count; ++i) {
+        int col = cols[i];
+        int row = cf_drop_piece(&child, col, piece);
+
+        out[i].ai_wins = has_winner_scalar(&child, CF_AI);
+        out[i].human_wins = has_winner_scalar(&child, CF_HUMAN);
+        out[i].score = score_position_scalar(&child);
+        child.board[row][col] = CF_EMPTY;
+        child.moves -= 1;
+    }
+}
+
+static unsigned winning_drops_scalar(const CfGame *game, const int cols[], int count, CfCell piece) {
+    CfGame child = *game;
+    unsigned wins = 0;
+
+    for (int i = 0; i < count; ++i) {
+        int col = cols[i];
+        int row = cf_drop_piece(&child, col, piece);
+
+        if (has_winner_scalar(&child, piece)) {
+            wins |= 1u << i;
+        }
+        child.board[row][col] = CF_EMPTY;
+        child.moves -= 1;
+    }
+    return wins;
+}
+
+/* --------------------- Bitboard bodies --------------------- */
+/*
+ * Inlined into each instruction-set wrapper below, so the compiler emits
+ * POPCNT, ANDN and friends wherever the wrapper's target allows them.
+ */
+typedef struct {
+    uint64_t three; /* windows holding exactly three stones */
+    uint64_t two;   /* exactly two */
+    uint64_t four;
+} Tally;
+
+static inline __attribute__((always_inline)) bool bits_has_four(uint64_t b) {
+    return ((b & b >> 1 & b >> 2 & b >> 3 & START_HORIZONTAL) |
+        (b & b >> CF_COLS & b >> (2 * CF_COLS) & b >> (3 * CF_COLS) & START_VERTICAL) |
+        (b & b >> (CF_COLS + 1) & b >> (2 * (CF_COLS + 1)) & b >> (3 * (CF_COLS + 1)) & START_DIAGONAL) |
+        (b & b >> (CF_COLS - 1) & b >> (2 * (CF_COLS - 1)) & b >> (3 * (CF_COLS - 1)) & START_ANTI_DIAGONAL)) != 0;
+}
+
+/* Per-window stone counts for one direction, as a bit-sliced adder over the four cells. */
+static inline __attribute__((always_inline)) Tally bits_tally(uint64_t b0, uint64_t b1, uint64_t b2, uint64_t b3) {
+    uint64_t sum_lo = b0 ^ b1;
+    uint64_t carry_lo = b0 & b1;
+    uint64_t sum_hi = b2 ^ b3;
+    uint64_t carry_hi = b2 & b3;
+    uint64_t ones = sum_lo ^ sum_hi;
+    uint64_t twos = carry_lo ^ carry_hi ^ (sum_lo & sum_hi);
+    Tally tally;
+
+    tally.four = carry_lo & carry_hi;
+    tally.three = ones & twos;
+    tally.two = twos & ~ones;
+    return tally;
+}
+
+static inline __attribute__((always_inline)) int bits_direction_score(Bits bits, int step, uint64_t starts) {
+    uint64_t a1 = bits.ai >> step;
+    uint64_t a2 = bits.ai >> (2 * step);
+    uint64_t a3 = bits.ai >> (3 * step);
+    uint64_t h1 = bits.human >> step;
+    uint64_t h2 = bits.human >> (2 * step);
+    uint64_t h3 = bits.human >> (3 * step);
+    /* Windows without a stone of the other side: only those score. */
+    uint64_t ai_only = starts & ~(bits.human | h1 | h2 | h3);
+    uint64_t human_only = starts & ~(bits.ai | a1 | a2 | a3);
+    Tally ai = bits_tally(bits.ai, a1, a2, a3);
+    Tally human = bits_tally(bits.human, h1, h2, h3);
+
+    return WINDOW_FOUR * __builtin_popcountll(ai.four & ai_only) +
+        WINDOW_AI_THREE * __builtin_popcountll(ai.three & ai_only) +
+        WINDOW_AI_TWO * __builtin_popcountll(ai.two & ai_only) -
+        WINDOW_FOUR * __builtin_popcountll(human.four & human_only) +
+        WINDOW_HUMAN_THREE * __builtin_popcountll(human.three & human_only) +
+        WINDOW_HUMAN_TWO * __builtin_popcountll(human.two & human_only);
+}
+
+static inline __attribute__((always_inline)) int bits_score(Bits bits) {
+    return CENTER_WEIGHT * (__builtin_popcountll(bits.ai & CENTER_COLUMN) - __builtin_popcountll(bits.human & CENTER_COLUMN)) +
+        bits_direction_score(bits, 1, START_HORIZONTAL) +
+        bits_direction_score(bits, CF_COLS, START_VERTICAL) +
+        bits_direction_score(bits, CF_COLS + 1, START_DIAGONAL) +
+        bits_direction_score(bits, CF_COLS - 1, START_ANTI_DIAGONAL);
+}
+
+/* The cell a stone dropped into `col` lands on: the empty cell of that column nearest the bottom row. */
+static inline __attribute__((always_inline)) uint64_t bits_drop(uint64_t occupied, int col) {
+    uint64_t empty = ~occupied & (FIRST_COLUMN << col);
+
+    return UINT64_C(1) << (63 - __builtin_clzll(empty));
+}
+
+static inline __attribute__((always_inline)) void bits_children(
+    Bits bits,
+    const int cols[],
+    int count,
+    CfCell piece,
+    CfChildEval out[]
+) {
+    uint64_t occupied = bits.ai | bits.human;
+
+    for (int i = 0; i < count; ++i) {
+        uint64_t drop = bits_drop(occupied, cols[i]);
+        Bits child = bits;
+
+        if (piece == CF_AI) {
+            child.ai |= drop;
+        } else {
+            child.human |= drop;
+        }
+        out[i].ai_wins = bits_has_four(child.ai);
+        out[i].human_wins = bits_has_four(child.human);
+        out[i].score = bits_score(child);
+    }
+}
+
+static inline __attribute__((always_inline)) unsigned bits_winning_drops(
+    Bits bits,
+    const int cols[],
+    int count,
+    CfCell piece
+) {
+    uint64_t occupied = bits.ai | bits.human;
+    uint64_t stones = piece == CF_AI ? bits.ai : bits.human;
+    unsigned wins = 0;
+
+    for (int i = 0; i < count; ++i) {
+        wins |= (unsigned)bits_has_four(stones | bits_drop(occupied, cols[i])) << i;
+    }
+    return wins;
+}
+
+/* --------------------- x86 --------------------- */
+#if KERNELS_X86
+__attribute__((target("sse4.2,popcnt"))) static Bits bits_sse42(const CfGame *game) {
+    const CfCell *cells = &game->board[0][0];
+    const __m128i ai = _mm_set1_epi32(CF_AI);
+    const __m128i human = _mm_set1_epi32(CF_HUMAN);
+    Bits bits = {0, 0};
+
+    for (int i = 0; i < CELLS; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(cells + i));
+
+        bits.ai |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, ai))) << i;
+        bits.human |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, human))) << i;
+    }
+    return bits;
+}
+
+__attribute__((target("sse4.2,popcnt"))) static bool has_winner_sse42(const CfGame *game, CfCell piece) {
+    Bits bits = bits_sse42(game);
+    return bits_has_four(piece == CF_AI ? bits.ai : bits.human);
+}
+
+__attribute__((target("sse4.2,popcnt"))) static int score_position_sse42(const CfGame *game) {
+    return bits_score(bits_sse42(game));
+}
+
+__attribute__((target("sse4.2,popcnt"))) static void eval_children_sse42(
+    const CfGame *game,
+    const int cols[],
+    int count,
+    CfCell piece,
+    CfChildEval out[]
+) {
+    bits_children(bits_sse42(game), cols, count, piece, out);
+}
+
+__attribute__((target("sse4.2,popcnt"))) static unsigned winning_drops_sse42(
+    const CfGame *game,
+    const int cols[],
+    int count,
+    CfCell piece
+) {
+    return bits_winning_drops(bits_sse42(game), cols, count, piece);
+}
+
+#define AVX2_TARGET "avx2,bmi,bmi2,popcnt"
+
+__attribute__((target(AVX2_TARGET))) static Bits bits_avx2(const CfGame *game) {
+    const CfCell *cells = &game->board[0][0];
+    const __m256i ai = _mm256_set1_epi32(CF_AI);
+    const __m256i human = _mm256_set1_epi32(CF_HUMAN);
+    Bits bits = {0, 0};
+    int i = 0;
+
+    for (; i + 8 <= CELLS; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(cells + i));
+
+        bits.ai |= (uint64_t)(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, ai))) << i;
+        bits.human |= (uint64_t)(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, human))) << i;
+    }
+    for (; i < CELLS; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(cells + i));
+
+        bits.ai |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, _mm256_castsi256_si128(ai)))) << i;
+        bits.human |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, _mm256_castsi256_si128(human)))) << i;
+    }
+    return bits;
+}
+
+__attribute__((target(AVX2_TARGET))) static bool has_winner_avx2(const CfGame *game, CfCell piece) {
+    Bits bits = bits_avx2(game);
+    return bits_has_four(piece == CF_AI ? bits.ai : bits.human);
+}
+
+__attribute__((target(AVX2_TARGET))) static int score_position_avx2(const CfGame *game) {
+    return bits_score(bits_avx2(game));
+}
+
+__attribute__((target(AVX2_TARGET))) static void eval_children_avx2(
+    const CfGame *game,
+    const int cols[],
+    int count,
+    CfCell piece,
+    CfChildEval out[]
+) {
+    bits_children(bits_avx2(game), cols, count, piece, out);
+}
+
+__attribute__((target(AVX2_TARGET))) static unsigned winning_drops_avx2(
+    const CfGame *game,
+    const int cols[],
+    int count,
+    CfCell piece
+) {
+    return bits_winning_drops(bits_avx2(game), cols, count, piece);
+}
+#endif
+
+/* --------------------- ARM64 --------------------- */
+#if KERNELS_NEON
+static Bits bits_neon(const CfGame *game) {
+    static const uint32_t kLaneBits[4] = {1, 2, 4, 8};
+    const uint32_t *cells = (const uint32_t *)&game->board[0][0];
+    const uint32x4_t weights = vld1q_u32(kLaneBits);
+    const uint32x4_t ai = vdupq_n_u32((uint32_t)CF_AI);
+    const uint32x4_t human = vdupq_n_u32((uint32_t)CF_HUMAN);
+    Bits bits = {0, 0};
+
+    for (int i = 0; i < CELLS; i += 4) {
+        uint32x4_t v = vld1q_u32(cells + i);
+
+        bits.ai |= (uint64_t)vaddvq_u32(vandq_u32(vceqq_u32(v, ai), weights)) << i;
+        bits.human |= (uint64_t)vaddvq_u32(vandq_u32(vceqq_u32(v, human), weights)) << i;
+    }
+    return bits;
+}
+
+static bool has_winner_neon(const CfGame *game, CfCell piece) {
+    Bits bits = bits_neon(game);
+    return bits_has_four(piece == CF_AI ? bits.ai : bits.human);
+}
+
+static int score_position_neon(const CfGame *game) {
+    return bits_score(bits_neon(game));
+}
+
+static void eval_children_neon(const CfGame *game, const int cols[], int count, CfCell piece, CfChildEval out[]) {
+    bits_children(bits_neon(game), cols, count, piece, out);
+}
+
+static unsigned winning_drops_neon(const CfGame *game, const int cols[], int count, CfCell piece) {
+    return bits_winning_drops(bits_neon(game), cols, count, piece);
+}
+#endif
+
+/* --------------------- Dispatch --------------------- */
+static const CfKernels kScalar = {
+    CF_KERNELS_SCALAR,
+    has_winner_scalar,
+    score_position_scalar,
+    eval_children_scalar,
+    winning_drops_scalar
+};
+
+#if KERNELS_X86
+static const CfKernels kSse42 = {
+    CF_KERNELS_SSE42,
+    has_winner_sse42,
+    score_position_sse42,
+    eval_children_sse42,
+    winning_drops_sse42
+};
+
+static const CfKernels kAvx2 = {
+    CF_KERNELS_AVX2,
+    has_winner_avx2,
+    score_position_avx2,
+    eval_children_avx2,
+    winning_drops_avx2
+};
+#endif
+
+#if KERNELS_NEON
+static const CfKernels kNeon = {
+    CF_KERNELS_NEON,
+    has_winner_neon,
+    score_position_neon,
+    eval_children_neon,
+    winning_drops_neon
+};
+#endif
+
+/* Written once before main() runs, read-only afterwards. */
+static const CfKernels *g_kernels = &kScalar;
+
+bool cf_kernel_set_available(CfKernelSet set) {
+    switch (set) {
+        case CF_KERNELS_SCALAR:
+            return true;
+#if KERNELS_X86
+        case CF_KERNELS_SSE42:
+            return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case CF_KERNELS_AVX2:
+            return __builtin_cpu_supports("avx2") &&
+                __builtin_cpu_supports("bmi") &&
+                __builtin_cpu_supports("bmi2") &&
+                __builtin_cpu_supports("popcnt");
+#endif
+#if KERNELS_NEON
+        case CF_KERNELS_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+CfKernelSet cf_kernel_set_best(void) {
+    static const CfKernelSet kPreference[] = {CF_KERNELS_AVX2, CF_KERNELS_SSE42, CF_KERNELS_NEON};
+
+    for (size_t i = 0; i < sizeof(kPreference) / sizeof(kPreference[0]); ++i) {
+        if (cf_kernel_set_available(kPreference[i])) {
+            return kPreference[i];
+        }
+    }
+    return CF_KERNELS_SCALAR;
+}
+
+const char *cf_kernel_set_name(CfKernelSet set) {
+    return set >= 0 && set < CF_KERNEL_SETS ? kSetNames[set] : "?";
+}
+
+bool cf_kernel_set_parse(const char *name, CfKernelSet *out) {
+    for (int i = 0; i < CF_KERNEL_SETS; ++i) {
+        if (strcmp(name, kSetNames[i]) == 0) {
+            *out = (CfKernelSet)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const CfKernels *cf_kernels_for(CfKernelSet set) {
+    if (!cf_kernel_set_available(set)) {
+        return NULL;
+    }
+    switch (set) {
+#if KERNELS_X86
+        case CF_KERNELS_SSE42:
+            return &kSse42;
+        case CF_KERNELS_AVX2:
+            return &kAvx2;
+#endif
+#if KERNELS_NEON
+        case CF_KERNELS_NEON:
+            return &kNeon;
+#endif
+        default:
+            return &kScalar;
+    }
+}
+
+const CfKernels *cf_kernels(void) {
+    return g_kernels;
+}
+
+__attribute__((constructor)) static void kernels_select(void) {
+    const char *forced = getenv("CF_KERNELS");
+    CfKernelSet set;
+
+#if KERNELS_X86
+    __builtin_cpu_init();
+#endif
+    if (forced == NULL || !cf_kernel_set_parse(forced, &set) || !cf_kernel_set_available(set)) {
+        set = cf_kernel_set_best();
+    }
+    g_kernels = cf_kernels_for(set);
+}
@@ -0,0 +1,63 @@
+#ifndef CONNECT_FOUR_KERNELS_H
+#define CONNECT_FOUR_KERNELS_H
+
+#include <stdbool.h>
+
+#include "connect_four.h"
+
+/*
+ * The board kernels the search spends its time in, built once per
+ * instruction set and picked at run time:
+ *
+ *   scalar  the reference cell loops; every CPU
+ *   sse4.2  boards turned into bitboards with SSE compares, windows counted with POPCNT
+ *   avx2    the same with 256-bit compares, bit logic built for BMI1/BMI2
+ *   neon    the same with NEON compares (ARM64)
+ *
+ * Every set returns exactly what the scalar one does for every board, so
+ * searches, node counts and replays do not depend on the machine. The best
+ * set the CPU supports is chosen once at startup; CF_KERNELS=<name> forces
+ * one (ignored when the CPU lacks it).
+ */
+
+typedef enum {
+    CF_KERNELS_SCALAR,
+    CF_KERNELS_SSE42,
+    CF_KERNELS_AVX2,
+    CF_KERNELS_NEON,
+    CF_KERNEL_SETS
+} CfKernelSet;
+
+/* One child of a position as a search leaf: who has four after the drop, and the static score. */
+typedef struct {
+    bool ai_wins;
+    bool human_wins;
+    int score;
+} CfChildEval;
+
+typedef struct {
+    CfKernelSet set;
+    /* Win detection: does `piece` have four in a row? */
+    bool (*has_winner)(const CfGame *game, CfCell piece);
+    /* Window evaluation: the static score from CF_AI's point of view. */
+    int (*score_position)(const CfGame *game);
+    /* Batch child evaluation: `piece` dropped into each of `cols` (all playable), one result per column. */
+    void (*eval_children)(const CfGame *game, const int cols[], int count, CfCell piece, CfChildEval out[]);
+    /* Multi-board test: bit i set when dropping `piece` into cols[i] (playable) makes four. */
+    unsigned (*winning_drops)(const CfGame *game, const int cols[], int count, CfCell piece);
+} CfKernels;
+
+bool cf_kernel_set_available(CfKernelSet set);
+CfKernelSet cf_kernel_set_best(void);
+const char *cf_kernel_set_name(CfKernelSet set);
+/* By name as printed above; false for an unknown name. */
+bool cf_kernel_set_parse(const char *name, CfKernelSet *out);
+/* A given set's table, or NULL when this CPU or build lacks it. */
+const CfKernels *cf_kernels_for(CfKernelSet set);
+/* The table chosen at startup. */
+const CfKernels *cf_kernels(void);
+
+/* Score of one four-cell window; score_position() is the sum over every window plus the centre column. */
+int cf_evaluate_window(const CfCell window[4]);
+
+#endif
@@ -0,0 +1,284 @@
+#include "connect_four_log.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+    SINK_INTERVAL_MS = 250,
+    PATH_CHARS = 512
+};
+
+/* `seq` is the line number + 1 once the slot is complete, 0 while it is being rewritten. */
+typedef struct {
+    _Atomic uint64_t seq;
+    struct timespec stamp;
+    char text[CF_LOG_CHARS];
+} LogSlot;
+
+struct CfLog {
+    LogSlot *slots;
+    uint64_t capacity;
+    _Atomic uint64_t count;
+
+    bool running;
+    atomic_bool stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    char path[PATH_CHARS];
+    long max_bytes;
+    int keep_files;
+
+    /* Sink thread only. */
+    FILE *fp;
+    long written;
+    uint64_t next;
+};
+
+/* --------------------- Ring --------------------- */
+CfLog *cf_log_create(int capacity) {
+    CfLog *log = calloc(1, sizeof(*log));
+    uint64_t cap = 1;
+
+    if (log == NULL) {
+        return NULL;
+    }
+    while (cap < (uint64_t)(capacity > 1 ? capacity : 1)) {
+        cap <<= 1;
+    }
+    log->slots = calloc(cap, sizeof(*log->slots));
+    if (log->slots == NULL) {
+        free(log);
+        return NULL;
+    }
+    log->capacity = cap;
+    atomic_init(&log->count, 0);
+    atomic_init(&log->stop, false);
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->wake, NULL);
+    return log;
+}
+
+void cf_log_append(CfLog *log, const char *text) {
+    uint64_t line;
+    LogSlot *slot;
+
+    if (log == NULL) {
+        return;
+    }
+    line = atomic_load_explicit(&log->count, memory_order_relaxed);
+    slot = &log->slots[line & (log->capacity - 1)];
+
+    /* Seqlock-style: the sink sees either the old line, the new one, or a 0 it skips. */
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    clock_gettime(CLOCK_REALTIME, &slot->stamp);
+    snprintf(slot->text, sizeof(slot->text), "%s", text);
+    atomic_store_explicit(&slot->seq, line + 1, memory_order_release);
+    atomic_store_explicit(&log->count, line + 1, memory_order_release);
+}
+
+uint64_t cf_log_count(const CfLog *log) {
+    return log != NULL ? atomic_load_explicit(&log->count, memory_order_relaxed) : 0;
+}
+
+uint64_t cf_log_first(const CfLog *log) {
+    uint64_t count = cf_log_count(log);
+
+    return count > log->capacity ? count - log->capacity : 0;
+}
+
+const char *cf_log_line(const CfLog *log, uint64_t line) {
+    if (log == NULL || line >= cf_log_count(log) || line < cf_log_first(log)) {
+        return NULL;
+    }
+    return log->slots[line & (log->capacity - 1)].text;
+}
+
+/* --------------------- File sink --------------------- */
+static bool open_sink(CfLog *log, const char *mode) {
+    log->fp = fopen(log->path, mode);
+    if (log->fp == NULL) {
+        return false;
+    }
+    fseek(log->fp, 0, SEEK_END);
+    log->written = ftell(log->fp);
+    if (log->written < 0) {
+        log->written = 0;
+    }
+    return true;
+}
+
+/* path -> path.1 -> path.2 ...; the oldest is overwritten by the rename. */
+static void rotate(CfLog *log) {
+    char from[PATH_CHARS + 16];
+    char to[PATH_CHARS + 16];
+
+    fclose(log->fp);
+    log->fp = NULL;
+    for (int i = log->keep_files; i >= 1; --i) {
+        if (i == 1) {
+            snprintf(from, sizeof(from), "%s", log->path);
+        } else {
+            snprintf(from, sizeof(from), "%s.%d", log->path, i - 1);
+        }
+        snprintf(to, sizeof(to), "%s.%d", log->path, i);
+        rename(from, to);
+    }
+    if (log->keep_files < 1) {
+        remove(log->path);
+    }
+    open_sink(log, "w");
+}
+
+static void write_line(CfLog *log, const struct timespec *stamp, const char *text) {
+    struct tm tm;
+    time_t secs = stamp->tv_sec;
+    int len;
+
+    localtime_r(&secs, &tm);
+    len = fprintf(
+        log->fp,
+        "%04d-%02d-%02d %02d:%02d:%02d.%03ld %s\n",
+        tm.tm_year + 1900,
+        tm.tm_mon + 1,
+        tm.tm_mday,
+        tm.tm_hour,
+        tm.tm_min,
+        tm.tm_sec,
+        stamp->tv_nsec / 1000000L,
+        text
+    );
+    log->written += len > 0 ? len : 0;
+    if (log->max_bytes > 0 && log->written >= log->max_bytes) {
+        rotate(log);
+    }
+}
+
+static void note_missed(CfLog *log, const struct timespec *stamp, uint64_t missed) {
+    char note[64];
+
+    if (missed == 0 || log->fp == NULL) {
+        return;
+    }
+    snprintf(note, sizeof(note), "[LOG] %llu line(s) lost: sink fell behind.", (unsigned long long)missed);
+    write_line(log, stamp, note);
+}
+
+/* Writes every line appended since the last drain; lines already overwritten are only counted. */
+static void drain(CfLog *log) {
+    uint64_t count = atomic_load_explicit(&log->count, memory_order_acquire);
+    uint64_t missed = 0;
+    struct timespec now;
+
+    if (count - log->next > log->capacity) {
+        missed = count - log->capacity - log->next;
+        log->next = count - log->capacity;
+    }
+
+    for (; log->next < count && log->fp != NULL; ++log->next) {
+        LogSlot *slot = &log->slots[log->next & (log->capacity - 1)];
+        uint64_t before = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        struct timespec stamp = slot->stamp;
+        char text[CF_LOG_CHARS];
+
+        memcpy(text, slot->text, sizeof(text));
+        text[sizeof(text) - 1] = '\0';
+        atomic_thread_fence(memory_order_acquire);
+        if (before != log->next + 1 || atomic_load_explicit(&slot->seq, memory_order_relaxed) != before) {
+            missed += 1;
+            continue;
+        }
+        note_missed(log, &stamp, missed);
+        missed = 0;
+        if (log->fp != NULL) {
+            write_line(log, &stamp, text);
+        }
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    note_missed(log, &now, missed);
+    if (log->fp != NULL) {
+        fflush(log->fp);
+    }
+}
+
+static void wait_interval(CfLog *log) {
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)SINK_INTERVAL_MS * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&log->lock);
+    while (!atomic_load(&log->stop)) {
+        if (pthread_cond_timedwait(&log->wake, &log->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+static void *sink_thread(void *arg) {
+    CfLog *log = arg;
+
+    while (!atomic_load(&log->stop)) {
+        drain(log);
+        wait_interval(log);
+    }
+    drain(log);
+    if (log->fp != NULL) {
+        fclose(log->fp);
+        log->fp = NULL;
+    }
+    return NULL;
+}
+
+bool cf_log_start_sink(CfLog *log, const char *path, long max_bytes, int keep_files) {
+    if (log == NULL || log->running || path == NULL || path[0] == '\0') {
+        return false;
+    }
+    if (strlen(path) >= sizeof(log->path)) {
+        return false;
+    }
+    memcpy(log->path, path, strlen(path) + 1);
+    log->max_bytes = max_bytes;
+    log->keep_files = keep_files;
+    if (!open_sink(log, "a")) {
+        return false;
+    }
+    /* Lines appended before the sink started are part of the session too. */
+    log->next = cf_log_first(log);
+
+    if (pthread_create(&log->thread, NULL, sink_thread, log) != 0) {
+        fclose(log->fp);
+        log->fp = NULL;
+        return false;
+    }
+    log->running = true;
+    return true;
+}
+
+void cf_log_destroy(CfLog *log) {
+    if (log == NULL) {
+        return;
+    }
+    if (log->running) {
+        pthread_mutex_lock(&log->lock);
+        atomic_store(&log->stop, true);
+        pthread_cond_signal(&log->wake);
+        pthread_mutex_unlock(&log->lock);
+        pthread_join(log->thread, NULL);
+    }
+    pthread_mutex_destroy(&log->lock);
+    pthread_cond_destroy(&log->wake);
+    free(log->slots);
+    free(log);
+}
@@ -0,0 +1,43 @@
+#ifndef CONNECT_FOUR_LOG_H
+#define CONNECT_FOUR_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Scrollback for the VM console: a fixed ring of timestamped lines with one
+ * writer (the UI thread). Appending is a copy into the next slot and a
+ * release store, never a lock or a syscall beyond reading the clock; the
+ * oldest lines are overwritten once the ring is full.
+ *
+ * An optional sink thread streams every line to a file, rotating it to
+ * path.1, path.2, ... once it grows past a size limit. The sink reads the
+ * ring on its own schedule; if it falls a whole ring behind, the lines it
+ * missed are counted in the file instead of stalling the writer.
+ *
+ * Lines are numbered from 0 in append order. cf_log_line() and the other
+ * readers are for the writer's thread only.
+ */
+
+#define CF_LOG_CHARS 100
+
+typedef struct CfLog CfLog;
+
+/* `capacity` is rounded up to a power of two. */
+CfLog *cf_log_create(int capacity);
+/* Stops the sink after it has written everything appended so far. */
+void cf_log_destroy(CfLog *log);
+
+void cf_log_append(CfLog *log, const char *text);
+
+/* Number of lines ever appended; the next line gets this number. */
+uint64_t cf_log_count(const CfLog *log);
+/* Oldest line still held. */
+uint64_t cf_log_first(const CfLog *log);
+/* NULL when `line` was overwritten or not written yet. */
+const char *cf_log_line(const CfLog *log, uint64_t line);
+
+/* Rotates after `max_bytes`, keeping `keep_files` old files. */
+bool cf_log_start_sink(CfLog *log, const char *path, long max_bytes, int keep_files);
+
+#endif
@@ -0,0 +1,340 @@
+#include "connect_four_meta.h"
+
+#include <string.h>
+
+enum {
+    INTRO_COMPROMISE_PCT = 8,
+    MAX_FLOOR_PCT = 96
+};
+
+static int normalize_col(int col) {
+    while (col < 0) {
+        col += CF_COLS;
+    }
+    while (col >= CF_COLS) {
+        col -= CF_COLS;
+    }
+    return col;
+}
+
+int cf_meta_clamp(int value, int lo, int hi) {
+    if (value < lo) {
+        return lo;
+    }
+    if (value > hi) {
+        return hi;
+    }
+    return value;
+}
+
+/* --------------------- Stacks and meter --------------------- */
+int cf_meta_pressure(const CfMeta *meta) {
+    int total = 0;
+
+    for (int i = 0; i < CF_INCIDENT_TYPES; ++i) {
+        total += meta->incident_stacks[i];
+    }
+
+    return total;
+}
+
+int cf_meta_stack(const CfMeta *meta, int code) {
+    if (code < 1 || code > CF_INCIDENT_TYPES) {
+        return 0;
+    }
+    return meta->incident_stacks[code - 1];
+}
+
+static int max_stack(const CfMeta *meta) {
+    int max_stack = 0;
+
+    for (int i = 0; i < CF_INCIDENT_TYPES; ++i) {
+        if (meta->incident_stacks[i] > max_stack) {
+            max_stack = meta->incident_stacks[i];
+        }
+    }
+
+    return max_stack;
+}
+
+void cf_meta_sync_floor(CfMeta *meta) {
+    int floor_pct = cf_meta_clamp(cf_meta_pressure(meta) * 4 + max_stack(meta) * 5, 0, MAX_FLOOR_PCT);
+
+    if (meta->compromised_pct < floor_pct) {
+        meta->compromised_pct = floor_pct;
+    }
+    meta->compromised_pct = cf_meta_clamp(meta->compromised_pct, 0, 100);
+}
+
+void cf_meta_begin(CfMeta *meta) {
+    meta->compromised_pct = cf_meta_clamp(meta->compromised_pct + INTRO_COMPROMISE_PCT, 0, 100);
+}
+
+/* --------------------- Round effects --------------------- */
+static void choose_blocked_columns(CfRoundEffects *fx, CfRng *rng, int count) {
+    int pool[CF_COLS];
+
+    memset(fx->blocked_cols, 0, sizeof(fx->blocked_cols));
+    fx->blocked_count = 0;
+
+    if (count <= 0) {
+        return;
+    }
+
+    for (int i = 0; i < CF_COLS; ++i) {
+        pool[i] = i;
+    }
+
+    for (int i = CF_COLS - 1; i > 0; --i) {
+        int j = cf_rng_below(rng, i + 1);
+        int tmp = pool[i];
+        pool[i] = pool[j];
+        pool[j] = tmp;
+    }
+
+    count = cf_meta_clamp(count, 0, CF_COLS - 1);
+    for (int i = 0; i < count; ++i) {
+        fx->blocked_cols[pool[i]] = true;
+        fx->blocked_count += 1;
+    }
+}
+
+void cf_meta_roll_effects(const CfMeta *meta, CfRng *rng, CfRoundEffects *fx) {
+    int nvir = cf_meta_stack(meta, CF_INCIDENT_NVIR);
+    int mdef = cf_meta_stack(meta, CF_INCIDENT_MDEF);
+    int wdef = cf_meta_stack(meta, CF_INCIDENT_WDEF);
+    int macro = cf_meta_stack(meta, CF_INCIDENT_MACRO);
+    int autostart = cf_meta_stack(meta, CF_INCIDENT_AUTOSTART);
+    int sevendust = cf_meta_stack(meta, CF_INCIDENT_SEVENDUST);
+    int pressure = cf_meta_pressure(meta);
+    int compromised = meta->compromised_pct;
+    int blocked_count;
+
+    memset(fx, 0, sizeof(*fx));
+    fx->control_direction = 1;
+
+    fx->input_glitch_pct = cf_meta_clamp(nvir * 10 + pressure / 4 + compromised / 8, 0, 72);
+    if (compromised >= 35) {
+        fx->forced_move_pct = cf_meta_clamp((compromised - 30) / 2 + nvir * 6, 0, 68);
+    }
+
+    if (mdef > 0) {
+        fx->control_shift = (mdef >= 3 || compromised >= 80) ? 2 : 1;
+        fx->control_direction = (cf_rng_below(rng, 2) == 0) ? 1 : -1;
+    }
+
+    blocked_count = cf_meta_clamp(wdef, 0, 2);
+    if (pressure >= 14 && blocked_count < 2 && wdef > 0) {
+        blocked_count += 1;
+    }
+    if (compromised >= 88 && blocked_count < 3 && wdef > 0) {
+        blocked_count += 1;
+    }
+    choose_blocked_columns(fx, rng, blocked_count);
+
+    fx->ai_depth_bonus = cf_meta_clamp(macro + (compromised >= 75 ? 1 : 0), 0, 2);
+
+    if (autostart >= 1) {
+        fx->ai_opening_moves = 1;
+    }
+    if (autostart >= 3) {
+        fx->ai_opening_moves = 2;
+    }
+    if (compromised >= 92) {
+        fx->ai_opening_moves = 2;
+    }
+
+    fx->player_piece_corrupt_pct = cf_meta_clamp(sevendust * 12 + (compromised >= 72 ? 10 : 0), 0, 66);
+
+    if (compromised >= 50) {
+        int trigger = 14 + compromised / 4 + mdef * 5;
+        if (cf_rng_below(rng, 100) < trigger) {
+            fx->flip_turns_remaining = (compromised >= 85) ? 2 : 1;
+        }
+    }
+    if (compromised >= 58) {
+        int trigger = 10 + compromised / 5 + sevendust * 5;
+        if (cf_rng_below(rng, 100) < trigger) {
+            fx->purple_turns_remaining = (compromised >= 85) ? 2 : 1;
+        }
+    }
+}
+
+int cf_meta_ai_depth(const CfMeta *meta, const CfRoundEffects *fx) {
+    int depth = 6 + fx->ai_depth_bonus;
+
+    if (cf_meta_pressure(meta) >= 12 || meta->compromised_pct >= 70) {
+        depth += 1;
+    }
+
+    return cf_meta_clamp(depth, 6, 8);
+}
+
+/* --------------------- Round results --------------------- */
+int cf_meta_ai_won(CfMeta *meta, CfRng *rng) {
+    int code = 1 + cf_rng_below(rng, CF_INCIDENT_TYPES);
+    int *stack = &meta->incident_stacks[code - 1];
+
+    *stack += 1;
+    meta->last_incident_code = code;
+    meta->total_losses += 1;
+    meta->compromised_pct = cf_meta_clamp(meta->compromised_pct + 6 + *stack * 3, 0, 100);
+    cf_meta_sync_floor(meta);
+    return code;
+}
+
+void cf_meta_player_won(CfMeta *meta) {
+    meta->total_wins += 1;
+    if (cf_meta_pressure(meta) <= 0) {
+        meta->compromised_pct = cf_meta_clamp(meta->compromised_pct - 2, 0, 100);
+        return;
+    }
+
+    for (int i = 0; i < CF_INCIDENT_TYPES; ++i) {
+        if (meta->incident_stacks[i] > 0) {
+            meta->incident_stacks[i] -= 1;
+        }
+    }
+
+    if (meta->last_incident_code >= 1 && meta->last_incident_code <= CF_INCIDENT_TYPES) {
+        int idx = meta->last_incident_code - 1;
+        if (meta->incident_stacks[idx] > 0) {
+            meta->incident_stacks[idx] -= 1;
+        }
+    }
+
+    meta->compromised_pct = cf_meta_clamp(meta->compromised_pct - 5, 0, 100);
+    cf_meta_sync_floor(meta);
+}
+
+/* --------------------- Mini-games --------------------- */
+int cf_meta_intermission_chance(const CfMeta *meta) {
+    return cf_meta_clamp(25 + meta->compromised_pct / 2, 20, 78);
+}
+
+int cf_meta_mining_target(const CfMeta *meta) {
+    return 22 + meta->compromised_pct / 8;
+}
+
+void cf_meta_minigame_result(CfMeta *meta, CfMinigame game, bool passed) {
+    if (!passed) {
+        meta->compromised_pct = cf_meta_clamp(meta->compromised_pct + 3, 0, 100);
+        return;
+    }
+    meta->compromised_pct = cf_meta_clamp(meta->compromised_pct - (game == CF_MINIGAME_MINING ? 4 : 3), 0, 100);
+    cf_meta_sync_floor(meta);
+}
+
+/* --------------------- Per-move payloads --------------------- */
+bool cf_meta_playable(const CfRoundEffects *fx, const CfGame *game, int col) {
+    if (col < 0 || col >= CF_COLS) {
+        return false;
+    }
+    if (fx->blocked_cols[col]) {
+        return false;
+    }
+    return cf_is_valid_move(game, col);
+}
+
+int cf_meta_remap_col(const CfRoundEffects *fx, int col) {
+    if (fx->control_shift <= 0) {
+        return col;
+    }
+
+    return normalize_col(col + (fx->control_direction * fx->control_shift));
+}
+
+int cf_meta_flip_col(const CfRoundEffects *fx, int col) {
+    if (fx->flip_turns_remaining <= 0) {
+        return col;
+    }
+    return (CF_COLS - 1) - col;
+}
+
+int cf_meta_glitch_col(const CfRoundEffects *fx, CfRng *rng, int col) {
+    int drift;
+
+    if (fx->input_glitch_pct <= 0) {
+        return -1;
+    }
+
+    if (cf_rng_below(rng, 100) >= fx->input_glitch_pct) {
+        return -1;
+    }
+
+    drift = (cf_rng_below(rng, 2) == 0) ? -1 : 1;
+    if (fx->input_glitch_pct >= 35 && cf_rng_below(rng, 100) < 35) {
+        drift *= 2;
+    }
+
+    return normalize_col(col + drift);
+}
+
+int cf_meta_forced_col(const CfRoundEffects *fx, CfRng *rng, const CfGame *game, int col) {
+    int forced;
+    int attempts = 0;
+
+    if (fx->forced_move_pct <= 0) {
+        return -1;
+    }
+
+    if (cf_rng_below(rng, 100) >= fx->forced_move_pct) {
+        return -1;
+    }
+
+    forced = normalize_col(col + 1);
+    while (attempts < CF_COLS && !cf_meta_playable(fx, game, forced)) {
+        forced = normalize_col(forced + 1);
+        attempts += 1;
+    }
+
+    return attempts >= CF_COLS ? -1 : forced;
+}
+
+int cf_meta_corrupt(const CfRoundEffects *fx, CfRng *rng, CfGame *game) {
+    int candidate_cols[CF_COLS];
+    int candidate_rows[CF_COLS];
+    int count = 0;
+    int pick;
+
+    if (fx->player_piece_corrupt_pct <= 0) {
+        return -1;
+    }
+
+    if (cf_rng_below(rng, 100) >= fx->player_piece_corrupt_pct) {
+        return -1;
+    }
+
+    for (int col = 0; col < CF_COLS; ++col) {
+        for (int row = 0; row < CF_ROWS; ++row) {
+            if (game->board[row][col] != CF_EMPTY) {
+                if (game->board[row][col] == CF_HUMAN) {
+                    candidate_cols[count] = col;
+                    candidate_rows[count] = row;
+                    count += 1;
+                }
+                break;
+            }
+        }
+    }
+
+    if (count == 0) {
+        return -1;
+    }
+
+    pick = cf_rng_below(rng, count);
+    game->board[candidate_rows[pick]][candidate_cols[pick]] = CF_EMPTY;
+    if (game->moves > 0) {
+        game->moves -= 1;
+    }
+    return candidate_cols[pick];
+}
+
+void cf_meta_end_player_turn(CfRoundEffects *fx) {
+    if (fx->flip_turns_remaining > 0) {
+        fx->flip_turns_remaining -= 1;
+    }
+    if (fx->purple_turns_remaining > 0) {
+        fx->purple_turns_remaining -= 1;
+    }
+}
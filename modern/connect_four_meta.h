@@ -0,0 +1,101 @@
+#ifndef CONNECT_FOUR_META_H
+#define CONNECT_FOUR_META_H
+
+#include <stdbool.h>
+
+#include "connect_four.h"
+#include "connect_four_rng.h"
+
+/*
+ * The meta-game around each round of Connect Four: incident stacks and the
+ * System Compromised meter that persist across rounds, the effects rolled
+ * from them at the start of a round, and the per-move payloads (jitter,
+ * hijacks, corruption) those effects fire.
+ *
+ * Everything here is plain state and arithmetic with the randomness passed
+ * in, so the terminal game and the headless simulator run the same rules.
+ * Nothing logs or draws; callers compare before/after values to report.
+ * Draws from each CfRng happen in a fixed order, so a recorded session
+ * replays identically.
+ */
+
+#define CF_INCIDENT_TYPES 6
+
+enum {
+    CF_INCIDENT_NVIR = 1,
+    CF_INCIDENT_MDEF,
+    CF_INCIDENT_WDEF,
+    CF_INCIDENT_MACRO,
+    CF_INCIDENT_AUTOSTART,
+    CF_INCIDENT_SEVENDUST
+};
+
+typedef enum {
+    CF_MINIGAME_MINING,
+    CF_MINIGAME_PHISHING
+} CfMinigame;
+
+/* Persists for the whole session. */
+typedef struct {
+    int incident_stacks[CF_INCIDENT_TYPES];
+    int last_incident_code;
+    int total_losses;
+    int total_wins;
+    int compromised_pct;
+} CfMeta;
+
+/* Rolled once per round by cf_meta_roll_effects(). */
+typedef struct {
+    bool blocked_cols[CF_COLS];
+    int blocked_count;
+    int input_glitch_pct;
+    int forced_move_pct;
+    int control_shift;
+    int control_direction;
+    int ai_depth_bonus;
+    int ai_opening_moves;
+    int player_piece_corrupt_pct;
+    int flip_turns_remaining;
+    int purple_turns_remaining;
+} CfRoundEffects;
+
+int cf_meta_clamp(int value, int lo, int hi);
+
+/* Sum of all incident stacks ("threat level"). */
+int cf_meta_pressure(const CfMeta *meta);
+/* `code` is a CF_INCIDENT_* value; 0 for anything else. */
+int cf_meta_stack(const CfMeta *meta, int code);
+/* Raises the meter to the floor the stacks imply. */
+void cf_meta_sync_floor(CfMeta *meta);
+
+/* Opening SUSPICIOUS.EXE: the session starts a little compromised. */
+void cf_meta_begin(CfMeta *meta);
+void cf_meta_roll_effects(const CfMeta *meta, CfRng *rng, CfRoundEffects *fx);
+/* AI search depth for this round, 6 to 8. */
+int cf_meta_ai_depth(const CfMeta *meta, const CfRoundEffects *fx);
+
+/* The AI won: picks and stacks an incident. Returns its CF_INCIDENT_* code. */
+int cf_meta_ai_won(CfMeta *meta, CfRng *rng);
+/* The player won: every stack (and the last incident's twice) drops by one. */
+void cf_meta_player_won(CfMeta *meta);
+
+/* Percent chance of a mini-game between rounds. */
+int cf_meta_intermission_chance(const CfMeta *meta);
+/* Hashes the bitcoin miner asks for. */
+int cf_meta_mining_target(const CfMeta *meta);
+void cf_meta_minigame_result(CfMeta *meta, CfMinigame game, bool passed);
+
+bool cf_meta_playable(const CfRoundEffects *fx, const CfGame *game, int col);
+/* MDEF control drift, then the grid flip: where a drop aimed at `col` goes. */
+int cf_meta_remap_col(const CfRoundEffects *fx, int col);
+int cf_meta_flip_col(const CfRoundEffects *fx, int col);
+/* nVIR jitter: where a drop at `col` slips to, or -1 when it does not fire. */
+int cf_meta_glitch_col(const CfRoundEffects *fx, CfRng *rng, int col);
+/* The virus hijacks the drop to the next playable column; -1 when it does not fire. */
+int cf_meta_forced_col(const CfRoundEffects *fx, CfRng *rng, const CfGame *game, int col);
+/* SevenDust: deletes one of the player's top tokens. Returns its column or -1. */
+int cf_meta_corrupt(const CfRoundEffects *fx, CfRng *rng, CfGame *game);
+/* Counts down the flip and purple takeover after each player move. */
+void cf_meta_end_player_turn(CfRoundEffects *fx);
+
+#endif
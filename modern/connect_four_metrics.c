@@ -0,0 +1,447 @@
+#include "connect_four_metrics.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+enum {
+    MAX_METRICS = 64,
+    MAX_BOUNDS = 24,
+    POLL_SLICE_MS = 200,
+    REQUEST_WAIT_MS = 100,
+    REQUEST_CHARS = 512,
+    PATH_CHARS = 512
+};
+
+/* Histogram sums are kept in fixed point so they can be added atomically. */
+#define SUM_SCALE 1e6
+
+#ifdef MSG_NOSIGNAL
+#define METRICS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define METRICS_SEND_FLAGS 0
+#endif
+
+struct CfMetric {
+    CfMetricKind kind;
+    const char *name;
+    const char *labels;
+    const char *help;
+    _Atomic int64_t value;
+    int bound_count;
+    double bounds[MAX_BOUNDS];
+    _Atomic uint64_t buckets[MAX_BOUNDS + 1];
+    _Atomic int64_t sum;
+};
+
+struct CfMetrics {
+    CfMetric *metrics[MAX_METRICS];
+    int count;
+
+    bool running;
+    atomic_bool stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int interval_ms;
+    int listen_fd;
+    char path[PATH_CHARS];
+};
+
+/* --------------------- Registration --------------------- */
+CfMetrics *cf_metrics_create(void) {
+    CfMetrics *metrics = calloc(1, sizeof(*metrics));
+
+    if (metrics == NULL) {
+        return NULL;
+    }
+    metrics->listen_fd = -1;
+    atomic_init(&metrics->stop, false);
+    pthread_mutex_init(&metrics->lock, NULL);
+    pthread_cond_init(&metrics->wake, NULL);
+    return metrics;
+}
+
+static CfMetric *add_metric(CfMetrics *metrics, CfMetricKind kind, const char *name, const char *labels, const char *help) {
+    CfMetric *metric;
+
+    if (metrics == NULL || metrics->running || metrics->count == MAX_METRICS) {
+        return NULL;
+    }
+    metric = calloc(1, sizeof(*metric));
+    if (metric == NULL) {
+        return NULL;
+    }
+    metric->kind = kind;
+    metric->name = name;
+    metric->labels = labels;
+    metric->help = help;
+    metrics->metrics[metrics->count++] = metric;
+    return metric;
+}
+
+CfMetric *cf_metrics_add(CfMetrics *metrics, CfMetricKind kind, const char *name, const char *labels, const char *help) {
+    if (kind == CF_METRIC_HISTOGRAM) {
+        return NULL;
+    }
+    return add_metric(metrics, kind, name, labels, help);
+}
+
+CfMetric *cf_metrics_add_histogram(
+    CfMetrics *metrics,
+    const char *name,
+    const char *help,
+    const double *bounds,
+    int bound_count
+) {
+    CfMetric *metric;
+
+    if (bound_count < 0 || bound_count > MAX_BOUNDS) {
+        return NULL;
+    }
+    metric = add_metric(metrics, CF_METRIC_HISTOGRAM, name, NULL, help);
+    if (metric != NULL) {
+        memcpy(metric->bounds, bounds, (size_t)bound_count * sizeof(double));
+        metric->bound_count = bound_count;
+    }
+    return metric;
+}
+
+/* --------------------- Recording --------------------- */
+void cf_metric_add(CfMetric *metric, uint64_t delta) {
+    if (metric != NULL) {
+        atomic_fetch_add_explicit(&metric->value, (int64_t)delta, memory_order_relaxed);
+    }
+}
+
+void cf_metric_set(CfMetric *metric, int64_t value) {
+    if (metric != NULL) {
+        atomic_store_explicit(&metric->value, value, memory_order_relaxed);
+    }
+}
+
+void cf_metric_observe(CfMetric *metric, double value) {
+    int bucket = 0;
+
+    if (metric == NULL || metric->kind != CF_METRIC_HISTOGRAM) {
+        return;
+    }
+    while (bucket < metric->bound_count && value > metric->bounds[bucket]) {
+        bucket += 1;
+    }
+    atomic_fetch_add_explicit(&metric->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&metric->sum, (int64_t)(value * SUM_SCALE), memory_order_relaxed);
+}
+
+/* --------------------- Formatting --------------------- */
+static const char *kind_name(CfMetricKind kind) {
+    switch (kind) {
+        case CF_METRIC_COUNTER:
+            return "counter";
+        case CF_METRIC_GAUGE:
+            return "gauge";
+        default:
+            return "histogram";
+    }
+}
+
+static void format_histogram(FILE *fp, CfMetric *metric) {
+    uint64_t cumulative = 0;
+
+    for (int b = 0; b <= metric->bound_count; ++b) {
+        cumulative += atomic_load_explicit(&metric->buckets[b], memory_order_relaxed);
+        if (b < metric->bound_count) {
+            fprintf(fp, "%s_bucket{le=\"%g\"} %llu\n", metric->name, metric->bounds[b], (unsigned long long)cumulative);
+        } else {
+            fprintf(fp, "%s_bucket{le=\"+Inf\"} %llu\n", metric->name, (unsigned long long)cumulative);
+        }
+    }
+    /* Buckets are read one by one while the game records, so report their total as the count. */
+    fprintf(
+        fp,
+        "%s_sum %.6f\n%s_count %llu\n",
+        metric->name,
+        (double)atomic_load_explicit(&metric->sum, memory_order_relaxed) / SUM_SCALE,
+        metric->name,
+        (unsigned long long)cumulative
+    );
+}
+
+/* Returns a malloc'd snapshot of every metric, or NULL. */
+static char *format_snapshot(CfMetrics *metrics, size_t *len) {
+    struct timespec cpu;
+    char *text = NULL;
+    FILE *fp = open_memstream(&text, len);
+
+    if (fp == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < metrics->count; ++i) {
+        CfMetric *metric = metrics->metrics[i];
+        bool first = i == 0 || strcmp(metrics->metrics[i - 1]->name, metric->name) != 0;
+
+        if (first) {
+            fprintf(fp, "# HELP %s %s\n# TYPE %s %s\n", metric->name, metric->help, metric->name, kind_name(metric->kind));
+        }
+        if (metric->kind == CF_METRIC_HISTOGRAM) {
+            format_histogram(fp, metric);
+        } else if (metric->labels != NULL) {
+            fprintf(fp, "%s{%s} %lld\n", metric->name, metric->labels, (long long)atomic_load_explicit(&metric->value, memory_order_relaxed));
+        } else {
+            fprintf(fp, "%s %lld\n", metric->name, (long long)atomic_load_explicit(&metric->value, memory_order_relaxed));
+        }
+    }
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu) == 0) {
+        fprintf(
+            fp,
+            "# HELP process_cpu_seconds_total CPU time used by the process.\n"
+            "# TYPE process_cpu_seconds_total counter\n"
+            "process_cpu_seconds_total %.6f\n",
+            (double)cpu.tv_sec + (double)cpu.tv_nsec / 1e9
+        );
+    }
+    if (fclose(fp) != 0) {
+        free(text);
+        return NULL;
+    }
+    return text;
+}
+
+/* --------------------- File exporter --------------------- */
+static void write_file(CfMetrics *metrics) {
+    char tmp[PATH_CHARS + 8];
+    size_t len = 0;
+    char *text = format_snapshot(metrics, &len);
+    FILE *fp;
+
+    if (text == NULL) {
+        return;
+    }
+    snprintf(tmp, sizeof(tmp), "%s.tmp", metrics->path);
+    fp = fopen(tmp, "w");
+    if (fp != NULL) {
+        bool ok = fwrite(text, 1, len, fp) == len;
+
+        if (fclose(fp) == 0 && ok) {
+            rename(tmp, metrics->path);
+        } else {
+            unlink(tmp);
+        }
+    }
+    free(text);
+}
+
+static void wait_interval(CfMetrics *metrics) {
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += metrics->interval_ms / 1000;
+    deadline.tv_nsec += (long)(metrics->interval_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&metrics->lock);
+    while (!atomic_load(&metrics->stop)) {
+        if (pthread_cond_timedwait(&metrics->wake, &metrics->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&metrics->lock);
+}
+
+static void *file_thread(void *arg) {
+    CfMetrics *metrics = arg;
+
+    while (!atomic_load(&metrics->stop)) {
+        write_file(metrics);
+        wait_interval(metrics);
+    }
+    /* Leave the final values behind for whoever scrapes after exit. */
+    write_file(metrics);
+    return NULL;
+}
+
+/* --------------------- Socket exporter --------------------- */
+static void send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, METRICS_SEND_FLAGS);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+/*
+ * One snapshot per connection. A client that sends an HTTP request gets an
+ * HTTP response; one that sends nothing (socat, nc -U) gets the bare text.
+ */
+static void serve_client(CfMetrics *metrics, int fd) {
+    char request[REQUEST_CHARS];
+    struct pollfd pfd = {fd, POLLIN, 0};
+    struct timeval send_timeout = {1, 0};
+    ssize_t got = 0;
+    size_t len = 0;
+    char *text;
+
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+#ifdef SO_NOSIGPIPE
+    {
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+    }
+#endif
+    if (poll(&pfd, 1, REQUEST_WAIT_MS) > 0) {
+        got = recv(fd, request, sizeof(request) - 1, 0);
+    }
+
+    text = format_snapshot(metrics, &len);
+    if (text == NULL) {
+        return;
+    }
+    if (got >= 4 && memcmp(request, "GET ", 4) == 0) {
+        char header[160];
+        int header_len = snprintf(
+            header,
+            sizeof(header),
+            "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n",
+            len
+        );
+        send_all(fd, header, (size_t)header_len);
+    }
+    send_all(fd, text, len);
+    free(text);
+}
+
+static void *socket_thread(void *arg) {
+    CfMetrics *metrics = arg;
+
+    while (!atomic_load(&metrics->stop)) {
+        struct pollfd pfd = {metrics->listen_fd, POLLIN, 0};
+        int fd;
+
+        if (poll(&pfd, 1, POLL_SLICE_MS) <= 0) {
+            continue;
+        }
+        fd = accept(metrics->listen_fd, NULL, NULL);
+        if (fd >= 0) {
+            serve_client(metrics, fd);
+            close(fd);
+        }
+    }
+    return NULL;
+}
+
+static int open_listener(const char *path) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+
+    /* Same rule as the analysis server: never take over a live socket. */
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    unlink(path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* --------------------- Lifecycle --------------------- */
+bool cf_metrics_start(CfMetrics *metrics, const char *target, int interval_ms) {
+    size_t prefix_len = strlen(CF_METRICS_UNIX_PREFIX);
+    bool use_socket;
+    void *(*run)(void *);
+
+    if (metrics == NULL || metrics->running || target == NULL || target[0] == '\0') {
+        return false;
+    }
+    use_socket = strncmp(target, CF_METRICS_UNIX_PREFIX, prefix_len) == 0;
+    if (use_socket) {
+        target += prefix_len;
+    }
+    if (strlen(target) >= sizeof(metrics->path)) {
+        return false;
+    }
+    memcpy(metrics->path, target, strlen(target) + 1);
+    metrics->interval_ms = interval_ms > 0 ? interval_ms : 1000;
+
+    if (use_socket) {
+        metrics->listen_fd = open_listener(metrics->path);
+        if (metrics->listen_fd < 0) {
+            return false;
+        }
+        run = socket_thread;
+    } else {
+        run = file_thread;
+    }
+
+    if (pthread_create(&metrics->thread, NULL, run, metrics) != 0) {
+        if (metrics->listen_fd >= 0) {
+            close(metrics->listen_fd);
+            unlink(metrics->path);
+            metrics->listen_fd = -1;
+        }
+        return false;
+    }
+    metrics->running = true;
+    return true;
+}
+
+void cf_metrics_destroy(CfMetrics *metrics) {
+    if (metrics == NULL) {
+        return;
+    }
+    if (metrics->running) {
+        pthread_mutex_lock(&metrics->lock);
+        atomic_store(&metrics->stop, true);
+        pthread_cond_signal(&metrics->wake);
+        pthread_mutex_unlock(&metrics->lock);
+        pthread_join(metrics->thread, NULL);
+    }
+    if (metrics->listen_fd >= 0) {
+        close(metrics->listen_fd);
+        unlink(metrics->path);
+    }
+    for (int i = 0; i < metrics->count; ++i) {
+        free(metrics->metrics[i]);
+    }
+    pthread_mutex_destroy(&metrics->lock);
+    pthread_cond_destroy(&metrics->wake);
+    free(metrics);
+}
@@ -0,0 +1,56 @@
+#ifndef CONNECT_FOUR_METRICS_H
+#define CONNECT_FOUR_METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Counters, gauges and histograms exported in Prometheus text format.
+ *
+ * Recording is a relaxed atomic add/store and never blocks, so it is safe
+ * on the render path. A background thread formats a snapshot and either
+ * rewrites a file (write + rename, so readers never see half a file) or
+ * answers each connection on a Unix socket ("unix:/path"); plain HTTP GETs
+ * get an HTTP response so curl --unix-socket works too.
+ *
+ * Register every metric before cf_metrics_start(). Every cf_metric_* call
+ * accepts NULL and does nothing, so callers need no "metrics enabled" checks.
+ */
+
+#define CF_METRICS_UNIX_PREFIX "unix:"
+
+typedef enum {
+    CF_METRIC_COUNTER,
+    CF_METRIC_GAUGE,
+    CF_METRIC_HISTOGRAM
+} CfMetricKind;
+
+typedef struct CfMetrics CfMetrics;
+typedef struct CfMetric CfMetric;
+
+CfMetrics *cf_metrics_create(void);
+/* Stops the exporter (removing its socket) and frees every metric. */
+void cf_metrics_destroy(CfMetrics *metrics);
+
+/*
+ * `labels` is the text between the braces (e.g. "type=\"nvir\"") or NULL.
+ * Metrics sharing a name must be registered consecutively.
+ */
+CfMetric *cf_metrics_add(CfMetrics *metrics, CfMetricKind kind, const char *name, const char *labels, const char *help);
+/* `bounds` are ascending bucket upper limits; +Inf is implied. */
+CfMetric *cf_metrics_add_histogram(
+    CfMetrics *metrics,
+    const char *name,
+    const char *help,
+    const double *bounds,
+    int bound_count
+);
+
+/* `target` is a file path or CF_METRICS_UNIX_PREFIX followed by a socket path. */
+bool cf_metrics_start(CfMetrics *metrics, const char *target, int interval_ms);
+
+void cf_metric_add(CfMetric *metric, uint64_t delta);
+void cf_metric_set(CfMetric *metric, int64_t value);
+void cf_metric_observe(CfMetric *metric, double value);
+
+#endif
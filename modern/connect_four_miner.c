@@ -0,0 +1,648 @@
+#include "connect_four_miner.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MINER_X86 1
+#else
+#define MINER_X86 0
+#endif
+
+enum {
+    LANES = 8,
+    MAX_THREADS = 256,
+    CHUNK_BITS = 16,
+    TIME_OFFSET = 68,
+    NONCE_OFFSET = 76
+};
+
+static const char *const kKernelNames[CF_SHA_KERNELS] = {"scalar", "lanes", "avx2", "sha-ni"};
+
+static const uint32_t kInit[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t kRound[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* --------------------- Scalar SHA-256 --------------------- */
+static uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void store_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint32_t bswap32(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+}
+
+/* `w` holds the block as big-endian words; it is used as the schedule and overwritten. */
+static void compress_scalar(uint32_t state[8], uint32_t w[16]) {
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    uint32_t f = state[5];
+    uint32_t g = state[6];
+    uint32_t h = state[7];
+
+    for (int i = 0; i < 64; ++i) {
+        uint32_t t1;
+        uint32_t t2;
+
+        if (i >= 16) {
+            uint32_t w15 = w[(i - 15) & 15];
+            uint32_t w2 = w[(i - 2) & 15];
+            uint32_t s0 = rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3);
+            uint32_t s1 = rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10);
+
+            w[i & 15] += s0 + w[(i - 7) & 15] + s1;
+        }
+        t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + kRound[i] + w[i & 15];
+        t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void cf_sha256(const uint8_t *data, size_t len, uint8_t out[CF_SHA256_BYTES]) {
+    uint32_t state[8];
+    uint32_t w[16];
+    uint8_t tail[128];
+    size_t full = len / 64;
+    size_t rest = len % 64;
+    size_t tail_len = rest < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+
+    memcpy(state, kInit, sizeof(state));
+    for (size_t block = 0; block < full; ++block) {
+        for (int i = 0; i < 16; ++i) {
+            w[i] = load_be32(data + block * 64 + (size_t)i * 4);
+        }
+        compress_scalar(state, w);
+    }
+
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, data + full * 64, rest);
+    tail[rest] = 0x80;
+    for (int i = 0; i < 8; ++i) {
+        tail[tail_len - 1 - (size_t)i] = (uint8_t)(bits >> (8 * i));
+    }
+    for (size_t off = 0; off < tail_len; off += 64) {
+        for (int i = 0; i < 16; ++i) {
+            w[i] = load_be32(tail + off + (size_t)i * 4);
+        }
+        compress_scalar(state, w);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        store_be32(out + i * 4, state[i]);
+    }
+}
+
+void cf_block_hash(const uint8_t header[CF_BLOCK_HEADER_BYTES], uint8_t out[CF_SHA256_BYTES]) {
+    uint8_t first[CF_SHA256_BYTES];
+
+    cf_sha256(header, CF_BLOCK_HEADER_BYTES, first);
+    cf_sha256(first, sizeof(first), out);
+}
+
+static int zero_bits_of(uint32_t h7, uint32_t h6) {
+    uint32_t top = bswap32(h7);
+
+    if (top != 0) {
+        return __builtin_clz(top);
+    }
+    top = bswap32(h6);
+    return 32 + (top != 0 ? __builtin_clz(top) : 32);
+}
+
+int cf_block_hash_zero_bits(const uint8_t hash[CF_SHA256_BYTES]) {
+    return zero_bits_of(load_be32(hash + 28), load_be32(hash + 24));
+}
+
+/* --------------------- Nonce scan --------------------- */
+/*
+ * The first 64 header bytes never change while the nonce does, so their
+ * compression (the midstate) is done once. Each nonce then costs the
+ * second block of the first hash and the single block of the second.
+ */
+typedef struct {
+    uint32_t midstate[8];
+    uint32_t tail[3];
+    int zero_bits;
+} ScanJob;
+
+static void scan_job_init(ScanJob *job, const uint8_t header[CF_BLOCK_HEADER_BYTES], int zero_bits) {
+    uint32_t w[16];
+
+    for (int i = 0; i < 16; ++i) {
+        w[i] = load_be32(header + i * 4);
+    }
+    memcpy(job->midstate, kInit, sizeof(job->midstate));
+    compress_scalar(job->midstate, w);
+    for (int i = 0; i < 3; ++i) {
+        job->tail[i] = load_be32(header + 64 + i * 4);
+    }
+    job->zero_bits = zero_bits < 0 ? 0 : (zero_bits > 64 ? 64 : zero_bits);
+}
+
+/* Shares are rare, so the exact bit count is only worked out for candidates. */
+static void scan_result(const ScanJob *job, uint32_t nonce, uint32_t h7, uint32_t h6, CfMineResult *out) {
+    uint32_t top = bswap32(h7);
+    int need = job->zero_bits < out->best_bits + 1 ? job->zero_bits : out->best_bits + 1;
+    int bits;
+
+    if (need > 0 && top >> (32 - (need > 32 ? 32 : need)) != 0) {
+        return;
+    }
+    bits = zero_bits_of(h7, h6);
+    if (bits >= job->zero_bits) {
+        out->shares += 1;
+    }
+    if (bits > out->best_bits) {
+        out->best_bits = bits;
+        out->best_nonce = nonce;
+    }
+}
+
+static void hash_nonce_scalar(const ScanJob *job, uint32_t nonce, uint32_t digest[8]) {
+    uint32_t w[16] = {0};
+    uint32_t state[8];
+
+    w[0] = job->tail[0];
+    w[1] = job->tail[1];
+    w[2] = job->tail[2];
+    w[3] = bswap32(nonce);
+    w[4] = 0x80000000u;
+    w[15] = CF_BLOCK_HEADER_BYTES * 8;
+    memcpy(state, job->midstate, sizeof(state));
+    compress_scalar(state, w);
+
+    memcpy(w, state, sizeof(state));
+    w[8] = 0x80000000u;
+    memset(w + 9, 0, 6 * sizeof(w[0]));
+    w[15] = CF_SHA256_BYTES * 8;
+    memcpy(digest, kInit, sizeof(kInit));
+    compress_scalar(digest, w);
+}
+
+static void scan_scalar(const ScanJob *job, uint32_t first, uint32_t count, CfMineResult *out) {
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t digest[8];
+
+        hash_nonce_scalar(job, first + i, digest);
+        scan_result(job, first + i, digest[7], digest[6], out);
+    }
+    out->hashes += count;
+}
+
+/* --------------------- Vector lanes --------------------- */
+/*
+ * Eight nonces per pass using the compiler's vector extension: SSE2 or NEON
+ * by default, AVX2 when the same body is instantiated with that target.
+ * Everything stays in always-inline helpers working through pointers, so
+ * no vector ever crosses a call boundary with a different ABI.
+ */
+typedef uint32_t VecU32 __attribute__((vector_size(LANES * sizeof(uint32_t))));
+
+#define VROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static inline __attribute__((always_inline)) void compress_lanes(VecU32 state[8], VecU32 w[16]) {
+    VecU32 a = state[0];
+    VecU32 b = state[1];
+    VecU32 c = state[2];
+    VecU32 d = state[3];
+    VecU32 e = state[4];
+    VecU32 f = state[5];
+    VecU32 g = state[6];
+    VecU32 h = state[7];
+
+    for (int i = 0; i < 64; ++i) {
+        VecU32 t1;
+        VecU32 t2;
+
+        if (i >= 16) {
+            VecU32 w15 = w[(i - 15) & 15];
+            VecU32 w2 = w[(i - 2) & 15];
+
+            w[i & 15] += (VROTR(w15, 7) ^ VROTR(w15, 18) ^ (w15 >> 3)) + w[(i - 7) & 15] +
+                         (VROTR(w2, 17) ^ VROTR(w2, 19) ^ (w2 >> 10));
+        }
+        t1 = h + (VROTR(e, 6) ^ VROTR(e, 11) ^ VROTR(e, 25)) + ((e & f) ^ (~e & g)) + kRound[i] + w[i & 15];
+        t2 = (VROTR(a, 2) ^ VROTR(a, 13) ^ VROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+static inline __attribute__((always_inline)) void scan_lanes_body(
+    const ScanJob *job,
+    uint32_t first,
+    uint32_t count,
+    CfMineResult *out
+) {
+    uint32_t done = 0;
+
+    for (; count - done >= LANES; done += LANES) {
+        VecU32 state[8];
+        VecU32 w[16];
+        uint32_t h7[LANES];
+        uint32_t h6[LANES];
+
+        for (int i = 0; i < 8; ++i) {
+            state[i] = (VecU32){0} + job->midstate[i];
+        }
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (VecU32){0};
+        }
+        w[0] += job->tail[0];
+        w[1] += job->tail[1];
+        w[2] += job->tail[2];
+        for (int lane = 0; lane < LANES; ++lane) {
+            w[3][lane] = bswap32(first + done + (uint32_t)lane);
+        }
+        w[4] += 0x80000000u;
+        w[15] += CF_BLOCK_HEADER_BYTES * 8;
+        compress_lanes(state, w);
+
+        for (int i = 0; i < 8; ++i) {
+            w[i] = state[i];
+            state[i] = (VecU32){0} + kInit[i];
+        }
+        w[8] = (VecU32){0} + 0x80000000u;
+        for (int i = 9; i < 15; ++i) {
+            w[i] = (VecU32){0};
+        }
+        w[15] = (VecU32){0} + CF_SHA256_BYTES * 8;
+        compress_lanes(state, w);
+
+        memcpy(h7, &state[7], sizeof(h7));
+        memcpy(h6, &state[6], sizeof(h6));
+        for (int lane = 0; lane < LANES; ++lane) {
+            scan_result(job, first + done + (uint32_t)lane, h7[lane], h6[lane], out);
+        }
+    }
+    out->hashes += done;
+    if (done < count) {
+        scan_scalar(job, first + done, count - done, out);
+    }
+}
+
+static void scan_lanes(const ScanJob *job, uint32_t first, uint32_t count, CfMineResult *out) {
+    scan_lanes_body(job, first, count, out);
+}
+
+#if MINER_X86
+__attribute__((target("avx2"))) static void scan_avx2(const ScanJob *job, uint32_t first, uint32_t count, CfMineResult *out) {
+    scan_lanes_body(job, first, count, out);
+}
+
+/* --------------------- SHA extensions --------------------- */
+/*
+ * sha256rnds2 has a long latency, so two nonces are hashed side by side to
+ * keep the unit busy. State is kept as ABEF / CDGH, the layout it works on.
+ */
+enum {
+    SHANI_WAYS = 2
+};
+
+__attribute__((target("sha,sse4.1"))) static void compress_shani(
+    uint32_t state[SHANI_WAYS][8],
+    uint32_t w[SHANI_WAYS][16]
+) {
+    __m128i abef[SHANI_WAYS];
+    __m128i cdgh[SHANI_WAYS];
+    __m128i abef_save[SHANI_WAYS];
+    __m128i cdgh_save[SHANI_WAYS];
+    __m128i msg[SHANI_WAYS][4];
+
+    for (int way = 0; way < SHANI_WAYS; ++way) {
+        __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[way][0]), 0xB1);
+        __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[way][4]), 0x1B);
+
+        abef[way] = _mm_alignr_epi8(tmp, efgh, 8);
+        cdgh[way] = _mm_blend_epi16(efgh, tmp, 0xF0);
+        abef_save[way] = abef[way];
+        cdgh_save[way] = cdgh[way];
+    }
+
+#pragma GCC unroll 16
+    for (int group = 0; group < 16; ++group) {
+        __m128i k = _mm_loadu_si128((const __m128i *)&kRound[group * 4]);
+
+        for (int way = 0; way < SHANI_WAYS; ++way) {
+            __m128i words;
+            __m128i round_in;
+
+            if (group < 4) {
+                words = _mm_loadu_si128((const __m128i *)&w[way][group * 4]);
+            } else {
+                __m128i prev1 = msg[way][(group - 1) & 3];
+                __m128i prev2 = msg[way][(group - 2) & 3];
+
+                words = _mm_sha256msg1_epu32(msg[way][group & 3], msg[way][(group - 3) & 3]);
+                words = _mm_add_epi32(words, _mm_alignr_epi8(prev1, prev2, 4));
+                words = _mm_sha256msg2_epu32(words, prev1);
+            }
+            msg[way][group & 3] = words;
+
+            round_in = _mm_add_epi32(words, k);
+            cdgh[way] = _mm_sha256rnds2_epu32(cdgh[way], abef[way], round_in);
+            round_in = _mm_shuffle_epi32(round_in, 0x0E);
+            abef[way] = _mm_sha256rnds2_epu32(abef[way], cdgh[way], round_in);
+        }
+    }
+
+    for (int way = 0; way < SHANI_WAYS; ++way) {
+        __m128i tmp = _mm_shuffle_epi32(_mm_add_epi32(abef[way], abef_save[way]), 0x1B);
+        __m128i hgfe = _mm_shuffle_epi32(_mm_add_epi32(cdgh[way], cdgh_save[way]), 0xB1);
+
+        _mm_storeu_si128((__m128i *)&state[way][0], _mm_blend_epi16(tmp, hgfe, 0xF0));
+        _mm_storeu_si128((__m128i *)&state[way][4], _mm_alignr_epi8(hgfe, tmp, 8));
+    }
+}
+
+__attribute__((target("sha,sse4.1"))) static void scan_shani(const ScanJob *job, uint32_t first, uint32_t count, CfMineResult *out) {
+    uint32_t block1[SHANI_WAYS][16] = {{0}};
+    uint32_t block2[SHANI_WAYS][16] = {{0}};
+    uint32_t done = 0;
+
+    for (int way = 0; way < SHANI_WAYS; ++way) {
+        memcpy(block1[way], job->tail, sizeof(job->tail));
+        block1[way][4] = 0x80000000u;
+        block1[way][15] = CF_BLOCK_HEADER_BYTES * 8;
+        block2[way][8] = 0x80000000u;
+        block2[way][15] = CF_SHA256_BYTES * 8;
+    }
+
+    for (; count - done >= SHANI_WAYS; done += SHANI_WAYS) {
+        uint32_t state[SHANI_WAYS][8];
+
+        for (int way = 0; way < SHANI_WAYS; ++way) {
+            block1[way][3] = bswap32(first + done + (uint32_t)way);
+            memcpy(state[way], job->midstate, sizeof(state[way]));
+        }
+        compress_shani(state, block1);
+        for (int way = 0; way < SHANI_WAYS; ++way) {
+            memcpy(block2[way], state[way], sizeof(state[way]));
+            memcpy(state[way], kInit, sizeof(state[way]));
+        }
+        compress_shani(state, block2);
+        for (int way = 0; way < SHANI_WAYS; ++way) {
+            scan_result(job, first + done + (uint32_t)way, state[way][7], state[way][6], out);
+        }
+    }
+    out->hashes += done;
+    if (done < count) {
+        scan_scalar(job, first + done, count - done, out);
+    }
+}
+#endif
+
+/* --------------------- Kernel selection --------------------- */
+bool cf_sha_kernel_available(CfShaKernel kernel) {
+    switch (kernel) {
+        case CF_SHA_SCALAR:
+        case CF_SHA_LANES:
+            return true;
+#if MINER_X86
+        case CF_SHA_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case CF_SHA_SHANI:
+            return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+#endif
+        default:
+            return false;
+    }
+}
+
+CfShaKernel cf_sha_best_kernel(void) {
+    static const CfShaKernel kPreference[] = {CF_SHA_SHANI, CF_SHA_AVX2, CF_SHA_LANES};
+
+    for (size_t i = 0; i < sizeof(kPreference) / sizeof(kPreference[0]); ++i) {
+        if (cf_sha_kernel_available(kPreference[i])) {
+            return kPreference[i];
+        }
+    }
+    return CF_SHA_SCALAR;
+}
+
+const char *cf_sha_kernel_name(CfShaKernel kernel) {
+    return kernel >= 0 && kernel < CF_SHA_KERNELS ? kKernelNames[kernel] : "?";
+}
+
+bool cf_sha_kernel_parse(const char *name, CfShaKernel *out) {
+    for (int i = 0; i < CF_SHA_KERNELS; ++i) {
+        if (strcmp(name, kKernelNames[i]) == 0) {
+            *out = (CfShaKernel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void scan_with(CfShaKernel kernel, const ScanJob *job, uint32_t first, uint32_t count, CfMineResult *out) {
+    switch (kernel) {
+        case CF_SHA_LANES:
+            scan_lanes(job, first, count, out);
+            return;
+#if MINER_X86
+        case CF_SHA_AVX2:
+            scan_avx2(job, first, count, out);
+            return;
+        case CF_SHA_SHANI:
+            scan_shani(job, first, count, out);
+            return;
+#endif
+        default:
+            scan_scalar(job, first, count, out);
+            return;
+    }
+}
+
+void cf_mine_scan(
+    CfShaKernel kernel,
+    const uint8_t header[CF_BLOCK_HEADER_BYTES],
+    uint32_t first,
+    uint32_t count,
+    int zero_bits,
+    CfMineResult *out
+) {
+    ScanJob job;
+
+    if (!cf_sha_kernel_available(kernel)) {
+        kernel = CF_SHA_SCALAR;
+    }
+    scan_job_init(&job, header, zero_bits);
+    scan_with(kernel, &job, first, count, out);
+}
+
+/* --------------------- Worker pool --------------------- */
+struct CfMiner {
+    uint8_t header[CF_BLOCK_HEADER_BYTES];
+    CfShaKernel kernel;
+    int zero_bits;
+    int threads;
+    pthread_t thread[MAX_THREADS];
+    int started;
+    atomic_bool stop;
+    _Atomic uint64_t next_chunk;
+    _Atomic uint64_t hashes;
+    _Atomic uint64_t shares;
+    _Atomic int best_bits;
+    double started_at;
+};
+
+static double miner_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *miner_thread(void *arg) {
+    CfMiner *miner = arg;
+    uint8_t header[CF_BLOCK_HEADER_BYTES];
+    uint64_t epoch = UINT64_MAX;
+    ScanJob job;
+
+    memcpy(header, miner->header, sizeof(header));
+    while (!atomic_load_explicit(&miner->stop, memory_order_relaxed)) {
+        uint64_t chunk = atomic_fetch_add_explicit(&miner->next_chunk, 1, memory_order_relaxed);
+        uint64_t chunk_epoch = chunk >> (32 - CHUNK_BITS);
+        CfMineResult result = {0};
+        int best;
+
+        /* A new pass over the nonce space: bump the header time so the work is fresh. */
+        if (chunk_epoch != epoch) {
+            uint32_t time_field = (uint32_t)miner->header[TIME_OFFSET] |
+                                  ((uint32_t)miner->header[TIME_OFFSET + 1] << 8) |
+                                  ((uint32_t)miner->header[TIME_OFFSET + 2] << 16) |
+                                  ((uint32_t)miner->header[TIME_OFFSET + 3] << 24);
+
+            time_field += (uint32_t)chunk_epoch;
+            for (int i = 0; i < 4; ++i) {
+                header[TIME_OFFSET + i] = (uint8_t)(time_field >> (8 * i));
+            }
+            scan_job_init(&job, header, miner->zero_bits);
+            epoch = chunk_epoch;
+        }
+
+        scan_with(miner->kernel, &job, (uint32_t)(chunk << CHUNK_BITS), 1u << CHUNK_BITS, &result);
+        atomic_fetch_add_explicit(&miner->hashes, result.hashes, memory_order_relaxed);
+        atomic_fetch_add_explicit(&miner->shares, result.shares, memory_order_relaxed);
+        best = atomic_load_explicit(&miner->best_bits, memory_order_relaxed);
+        while (result.best_bits > best &&
+               !atomic_compare_exchange_weak_explicit(&miner->best_bits, &best, result.best_bits, memory_order_relaxed, memory_order_relaxed)) {
+        }
+    }
+    return NULL;
+}
+
+CfMiner *cf_miner_start(const uint8_t header[CF_BLOCK_HEADER_BYTES], CfShaKernel kernel, int threads, int zero_bits) {
+    CfMiner *miner = calloc(1, sizeof(*miner));
+
+    if (miner == NULL) {
+        return NULL;
+    }
+    memcpy(miner->header, header, sizeof(miner->header));
+    miner->kernel = cf_sha_kernel_available(kernel) ? kernel : CF_SHA_SCALAR;
+    miner->zero_bits = zero_bits;
+    miner->threads = threads < 1 ? 1 : (threads > MAX_THREADS ? MAX_THREADS : threads);
+    atomic_init(&miner->stop, false);
+    atomic_init(&miner->next_chunk, 0);
+    atomic_init(&miner->hashes, 0);
+    atomic_init(&miner->shares, 0);
+    atomic_init(&miner->best_bits, 0);
+    miner->started_at = miner_now();
+
+    for (int i = 0; i < miner->threads; ++i) {
+        if (pthread_create(&miner->thread[i], NULL, miner_thread, miner) != 0) {
+            break;
+        }
+        miner->started += 1;
+    }
+    if (miner->started == 0) {
+        free(miner);
+        return NULL;
+    }
+    return miner;
+}
+
+void cf_miner_stats(CfMiner *miner, CfMinerStats *out) {
+    memset(out, 0, sizeof(*out));
+    if (miner == NULL) {
+        return;
+    }
+    out->kernel = miner->kernel;
+    out->threads = miner->started;
+    out->zero_bits = miner->zero_bits;
+    out->hashes = atomic_load_explicit(&miner->hashes, memory_order_relaxed);
+    out->shares = atomic_load_explicit(&miner->shares, memory_order_relaxed);
+    out->best_bits = atomic_load_explicit(&miner->best_bits, memory_order_relaxed);
+    out->seconds = miner_now() - miner->started_at;
+}
+
+void cf_miner_stop(CfMiner *miner) {
+    if (miner == NULL) {
+        return;
+    }
+    atomic_store(&miner->stop, true);
+    for (int i = 0; i < miner->started; ++i) {
+        pthread_join(miner->thread[i], NULL);
+    }
+    free(miner);
+}
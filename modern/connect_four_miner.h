@@ -0,0 +1,87 @@
+#ifndef CONNECT_FOUR_MINER_H
+#define CONNECT_FOUR_MINER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Toy proof of work behind the Bitcoin Miner mini-game and connect-four-miner:
+ * double SHA-256 over an 80-byte block header, scanning the nonce, exactly
+ * as Bitcoin hashes a header. Nothing here touches the network, a wallet or
+ * a real chain; the headers are made up locally.
+ *
+ * A share is a hash with at least `zero_bits` leading zero bits when read
+ * the way Bitcoin prints it (byte-reversed). Kernels:
+ *
+ *   scalar  one nonce at a time, plain C
+ *   lanes   eight nonces at once in portable vector code (SSE2 or NEON)
+ *   avx2    the same lanes compiled for AVX2
+ *   sha-ni  the x86 SHA extensions, two nonces interleaved
+ *
+ * Every kernel finds the same shares for the same nonces; the best one the
+ * CPU supports is picked at run time.
+ */
+
+#define CF_BLOCK_HEADER_BYTES 80
+#define CF_SHA256_BYTES 32
+
+typedef enum {
+    CF_SHA_SCALAR,
+    CF_SHA_LANES,
+    CF_SHA_AVX2,
+    CF_SHA_SHANI,
+    CF_SHA_KERNELS
+} CfShaKernel;
+
+typedef struct {
+    uint64_t hashes;
+    uint64_t shares;
+    int best_bits;
+    uint32_t best_nonce;
+} CfMineResult;
+
+bool cf_sha_kernel_available(CfShaKernel kernel);
+CfShaKernel cf_sha_best_kernel(void);
+const char *cf_sha_kernel_name(CfShaKernel kernel);
+/* By name as printed above; false for an unknown name. */
+bool cf_sha_kernel_parse(const char *name, CfShaKernel *out);
+
+void cf_sha256(const uint8_t *data, size_t len, uint8_t out[CF_SHA256_BYTES]);
+void cf_block_hash(const uint8_t header[CF_BLOCK_HEADER_BYTES], uint8_t out[CF_SHA256_BYTES]);
+int cf_block_hash_zero_bits(const uint8_t hash[CF_SHA256_BYTES]);
+
+/* Hashes nonces [first, first + count) with the rest of `header` fixed and adds the result to `out`. */
+void cf_mine_scan(
+    CfShaKernel kernel,
+    const uint8_t header[CF_BLOCK_HEADER_BYTES],
+    uint32_t first,
+    uint32_t count,
+    int zero_bits,
+    CfMineResult *out
+);
+
+/*
+ * Worker threads sharing one header. They take nonce ranges from a shared
+ * counter; when the 32-bit nonce runs out the header's time field is bumped,
+ * as real miners do, so a run never repeats work.
+ */
+typedef struct CfMiner CfMiner;
+
+typedef struct {
+    CfShaKernel kernel;
+    int threads;
+    int zero_bits;
+    uint64_t hashes;
+    uint64_t shares;
+    int best_bits;
+    double seconds;
+} CfMinerStats;
+
+CfMiner *cf_miner_start(const uint8_t header[CF_BLOCK_HEADER_BYTES], CfShaKernel kernel, int threads, int zero_bits);
+/* Safe to call from any thread while the miner runs. */
+void cf_miner_stats(CfMiner *miner, CfMinerStats *out);
+/* Stops and joins the workers; NULL is a no-op. */
+void cf_miner_stop(CfMiner *miner);
+
+#endif
@@ -0,0 +1,1012 @@
+#include "connect_four_render.h"
+
+#include <errno.h>
+#include <ncurses.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+enum {
+    TEXT_CHARS = 1024,
+    INPUT_BYTES = 64,
+    ESCAPE_WAIT_MS = 25,
+    FLASH_US = 100000,
+    FALLBACK_ROWS = 24,
+    SCROLL_MAX_LINES = 8,
+    SCROLL_MIN_ROWS = 2,
+    FALLBACK_COLS = 80
+};
+
+_Static_assert(
+    CF_KEY_DOWN == KEY_DOWN && CF_KEY_UP == KEY_UP && CF_KEY_LEFT == KEY_LEFT && CF_KEY_RIGHT == KEY_RIGHT &&
+        CF_KEY_HOME == KEY_HOME && CF_KEY_BACKSPACE == KEY_BACKSPACE && CF_KEY_NPAGE == KEY_NPAGE &&
+        CF_KEY_PPAGE == KEY_PPAGE && CF_KEY_ENTER == KEY_ENTER && CF_KEY_END == KEY_END && CF_KEY_RESIZE == KEY_RESIZE &&
+        CF_KEY_NONE == ERR,
+    "CF_KEY_* must keep the curses numbering that recordings store"
+);
+
+static const char *const kBackendNames[CF_RENDER_BACKENDS] = {"ncurses", "null", "ansi"};
+
+typedef struct {
+    char ch;
+    uint8_t attr;
+} Cell;
+
+/* One backend; coordinates reaching it are already clipped to the screen. */
+typedef struct {
+    bool (*open)(CfRenderer *r);
+    void (*close)(CfRenderer *r);
+    void (*size)(CfRenderer *r);
+    void (*put)(CfRenderer *r, int y, int x, unsigned attr, const char *text, int len);
+    void (*fill)(CfRenderer *r, int y, int x, int len);
+    void (*present)(CfRenderer *r);
+    void (*invalidate)(CfRenderer *r);
+    int (*key)(CfRenderer *r);
+    void (*flush_input)(CfRenderer *r);
+    void (*beep)(CfRenderer *r);
+    void (*flash)(CfRenderer *r);
+    void (*cursor)(CfRenderer *r, bool visible);
+} Backend;
+
+struct CfRenderer {
+    const Backend *ops;
+    CfRenderBackend backend;
+    int colors;
+    int rows;
+    int cols;
+    int cursor_y;
+    int cursor_x;
+    bool cursor_visible;
+    CfRenderStats stats;
+
+    /* Keys read from stdin (null, ansi). */
+    unsigned char input[INPUT_BYTES];
+    int input_len;
+    bool input_closed;
+
+    /* ansi: what the terminal shows, the frame being drawn, and where the terminal's cursor and colours are. */
+    Cell *front;
+    Cell *back;
+    bool repaint;
+    bool resized;
+    int term_y;
+    int term_x;
+    unsigned term_attr;
+    bool tty;
+    struct termios saved;
+    char *out;
+    size_t out_len;
+    size_t out_cap;
+};
+
+/* --------------------- Input --------------------- */
+static void input_fill(CfRenderer *r, int wait_ms) {
+    struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+    ssize_t got;
+
+    if (r->input_closed || r->input_len == INPUT_BYTES || poll(&pfd, 1, wait_ms) <= 0) {
+        return;
+    }
+    got = read(STDIN_FILENO, r->input + r->input_len, (size_t)(INPUT_BYTES - r->input_len));
+    if (got == 0) {
+        r->input_closed = true;
+    } else if (got > 0) {
+        r->input_len += (int)got;
+    }
+}
+
+static void input_consume(CfRenderer *r, int count) {
+    memmove(r->input, r->input + count, (size_t)(r->input_len - count));
+    r->input_len -= count;
+}
+
+static int escape_key(char final, int param) {
+    switch (final) {
+        case 'A':
+            return CF_KEY_UP;
+        case 'B':
+            return CF_KEY_DOWN;
+        case 'C':
+            return CF_KEY_RIGHT;
+        case 'D':
+            return CF_KEY_LEFT;
+        case 'H':
+            return CF_KEY_HOME;
+        case 'F':
+            return CF_KEY_END;
+        case 'M':
+            return CF_KEY_ENTER;
+        case '~':
+            switch (param) {
+                case 1:
+                case 7:
+                    return CF_KEY_HOME;
+                case 4:
+                case 8:
+                    return CF_KEY_END;
+                case 5:
+                    return CF_KEY_PPAGE;
+                case 6:
+                    return CF_KEY_NPAGE;
+                default:
+                    return CF_KEY_NONE;
+            }
+        default:
+            return CF_KEY_NONE;
+    }
+}
+
+/*
+ * Decodes the xterm/VT100 sequences for the keys the game uses (both the
+ * ESC [ and the ESC O forms). A lone ESC, or one whose sequence does not
+ * complete within ESCAPE_WAIT_MS, is the Escape key; unknown sequences are
+ * skipped.
+ */
+static int stdin_key(CfRenderer *r) {
+    while (true) {
+        int param = 0;
+        int end;
+        int key;
+
+        input_fill(r, 0);
+        if (r->input_len == 0) {
+            return r->input_closed ? CF_KEY_CLOSED : CF_KEY_NONE;
+        }
+        if (r->input[0] != 0x1b) {
+            int ch = r->input[0];
+
+            input_consume(r, 1);
+            return ch;
+        }
+        if (r->input_len < 3) {
+            input_fill(r, ESCAPE_WAIT_MS);
+        }
+        if (r->input_len < 3 || (r->input[1] != '[' && r->input[1] != 'O')) {
+            input_consume(r, 1);
+            return 0x1b;
+        }
+        for (end = 2; end < r->input_len && r->input[end] >= '0' && r->input[end] <= ';'; ++end) {
+            param = r->input[end] >= '0' && r->input[end] <= '9' ? param * 10 + (r->input[end] - '0') : 0;
+        }
+        if (end == r->input_len) {
+            input_consume(r, 1);
+            return 0x1b;
+        }
+        key = escape_key((char)r->input[end], param);
+        input_consume(r, end + 1);
+        if (key != CF_KEY_NONE) {
+            return key;
+        }
+    }
+}
+
+static void stdin_flush(CfRenderer *r) {
+    r->input_len = 0;
+    if (r->tty) {
+        tcflush(STDIN_FILENO, TCIFLUSH);
+    }
+}
+
+/* --------------------- ncurses --------------------- */
+static bool curses_open(CfRenderer *r) {
+    initscr();
+    cbreak();
+    noecho();
+    keypad(stdscr, true);
+    nodelay(stdscr, true);
+    curs_set(0);
+
+    r->colors = 0;
+    if (has_colors()) {
+        start_color();
+        use_default_colors();
+
+        init_pair(CF_PAIR_RED, COLOR_RED, -1);
+        init_pair(CF_PAIR_YELLOW, COLOR_YELLOW, -1);
+        init_pair(CF_PAIR_CYAN, COLOR_CYAN, -1);
+        init_pair(CF_PAIR_GREEN, COLOR_GREEN, -1);
+        init_pair(CF_PAIR_MAGENTA, COLOR_MAGENTA, -1);
+        init_pair(CF_PAIR_BLUE, COLOR_BLUE, -1);
+        init_pair(CF_PAIR_WHITE, COLOR_WHITE, -1);
+        r->colors = CF_PAIRS;
+    }
+
+    erase();
+    refresh();
+    return true;
+}
+
+static void curses_close(CfRenderer *r) {
+    (void)r;
+    endwin();
+}
+
+static void curses_size(CfRenderer *r) {
+    getmaxyx(stdscr, r->rows, r->cols);
+}
+
+static void curses_put(CfRenderer *r, int y, int x, unsigned attr, const char *text, int len) {
+    attr_t curses_attr = A_NORMAL;
+
+    (void)r;
+    curses_attr |= (attr & CF_ATTR_BOLD) != 0 ? A_BOLD : 0;
+    curses_attr |= (attr & CF_ATTR_REVERSE) != 0 ? A_REVERSE : 0;
+    curses_attr |= (attr & CF_ATTR_PAIR_MASK) != 0 ? COLOR_PAIR(attr & CF_ATTR_PAIR_MASK) : 0;
+    attrset(curses_attr);
+    mvaddnstr(y, x, text, len);
+    attrset(A_NORMAL);
+}
+
+static void curses_fill(CfRenderer *r, int y, int x, int len) {
+    (void)r;
+    mvhline(y, x, ' ', len);
+}
+
+/* curses keeps its own copy of the screen and sends only the difference. */
+static void curses_present(CfRenderer *r) {
+    refresh();
+    r->stats.frames += 1;
+}
+
+static void curses_invalidate(CfRenderer *r) {
+    (void)r;
+    clearok(curscr, true);
+}
+
+static int curses_key(CfRenderer *r) {
+    (void)r;
+    return getch();
+}
+
+static void curses_flush_input(CfRenderer *r) {
+    (void)r;
+    flushinp();
+}
+
+static void curses_beep(CfRenderer *r) {
+    (void)r;
+    beep();
+}
+
+static void curses_flash(CfRenderer *r) {
+    (void)r;
+    flash();
+}
+
+static void curses_cursor(CfRenderer *r, bool visible) {
+    (void)r;
+    curs_set(visible ? 1 : 0);
+}
+
+static const Backend kCurses = {
+    curses_open,
+    curses_close,
+    curses_size,
+    curses_put,
+    curses_fill,
+    curses_present,
+    curses_invalidate,
+    curses_key,
+    curses_flush_input,
+    curses_beep,
+    curses_flash,
+    curses_cursor
+};
+
+/* --------------------- null --------------------- */
+static bool null_open(CfRenderer *r) {
+    (void)r;
+    return true;
+}
+
+static void null_renderer(CfRenderer *r) {
+    (void)r;
+}
+
+static void null_put(CfRenderer *r, int y, int x, unsigned attr, const char *text, int len) {
+    (void)r;
+    (void)y;
+    (void)x;
+    (void)attr;
+    (void)text;
+    (void)len;
+}
+
+static void null_fill(CfRenderer *r, int y, int x, int len) {
+    (void)r;
+    (void)y;
+    (void)x;
+    (void)len;
+}
+
+static void null_cursor(CfRenderer *r, bool visible) {
+    (void)r;
+    (void)visible;
+}
+
+static const Backend kNull = {
+    null_open,
+    null_renderer,
+    null_renderer,
+    null_put,
+    null_fill,
+    null_renderer,
+    null_renderer,
+    stdin_key,
+    stdin_flush,
+    null_renderer,
+    null_renderer,
+    null_cursor
+};
+
+/* --------------------- ansi --------------------- */
+static void out_reserve(CfRenderer *r, size_t more) {
+    size_t cap = r->out_cap > 0 ? r->out_cap : 4096;
+    char *grown;
+
+    if (r->out_len + more <= r->out_cap) {
+        return;
+    }
+    while (cap < r->out_len + more) {
+        cap *= 2;
+    }
+    grown = realloc(r->out, cap);
+    if (grown == NULL) {
+        abort();
+    }
+    r->out = grown;
+    r->out_cap = cap;
+}
+
+static void out_bytes(CfRenderer *r, const char *bytes, size_t len) {
+    out_reserve(r, len);
+    memcpy(r->out + r->out_len, bytes, len);
+    r->out_len += len;
+}
+
+static void out_str(CfRenderer *r, const char *text) {
+    out_bytes(r, text, strlen(text));
+}
+
+/* Sends the buffer in one write() (more only if the terminal takes it in pieces). */
+static size_t out_flush(CfRenderer *r) {
+    size_t sent = 0;
+
+    while (sent < r->out_len) {
+        ssize_t n = write(STDOUT_FILENO, r->out + sent, r->out_len - sent);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        sent += (size_t)n;
+    }
+    r->out_len = 0;
+    r->stats.bytes += sent;
+    return sent;
+}
+
+static int digits(int value) {
+    int count = 1;
+
+    while (value >= 10) {
+        value /= 10;
+        count += 1;
+    }
+    return count;
+}
+
+/* SGR for `attr` from scratch; the plain attribute is the 3-byte reset. */
+static void out_attr(CfRenderer *r, unsigned attr) {
+    static const char kAnsiColor[CF_PAIRS + 1] = {0, '1', '3', '6', '2', '5', '4', '7'};
+    char sgr[24];
+    size_t len = 0;
+    unsigned pair = attr & CF_ATTR_PAIR_MASK;
+
+    if (attr == 0) {
+        out_str(r, "\x1b[m");
+        r->term_attr = 0;
+        return;
+    }
+    len += (size_t)snprintf(sgr + len, sizeof(sgr) - len, "\x1b[0");
+    if ((attr & CF_ATTR_BOLD) != 0) {
+        len += (size_t)snprintf(sgr + len, sizeof(sgr) - len, ";1");
+    }
+    if ((attr & CF_ATTR_REVERSE) != 0) {
+        len += (size_t)snprintf(sgr + len, sizeof(sgr) - len, ";7");
+    }
+    if (pair > 0 && pair <= CF_PAIRS) {
+        len += (size_t)snprintf(sgr + len, sizeof(sgr) - len, ";3%c", kAnsiColor[pair]);
+    }
+    len += (size_t)snprintf(sgr + len, sizeof(sgr) - len, "m");
+    out_bytes(r, sgr, len);
+    r->term_attr = attr;
+}
+
+/*
+ * Puts the terminal's cursor on (y, x) the cheapest way: stay, rewrite the
+ * unchanged cells in between when they already have the current colours,
+ * step forward, newline to a row start, or an absolute jump.
+ */
+static void out_move(CfRenderer *r, int y, int x) {
+    const Cell *row = r->back + (size_t)y * (size_t)r->cols;
+    int jump = 4 + digits(y + 1) + digits(x + 1);
+    char seq[32];
+
+    if (r->term_y == y && r->term_x == x) {
+        return;
+    }
+    if (r->term_y == y && r->term_x >= 0 && r->term_x < x) {
+        int gap = x - r->term_x;
+        int forward = gap == 1 ? 3 : 3 + digits(gap);
+        bool rewrite = gap <= forward && gap <= jump;
+
+        for (int i = r->term_x; rewrite && i < x; ++i) {
+            rewrite = row[i].attr == r->term_attr;
+        }
+        if (rewrite) {
+            for (int i = r->term_x; i < x; ++i) {
+                out_bytes(r, &row[i].ch, 1);
+            }
+        } else if (forward < jump) {
+            snprintf(seq, sizeof(seq), gap == 1 ? "\x1b[C" : "\x1b[%dC", gap);
+            out_str(r, seq);
+        } else {
+            snprintf(seq, sizeof(seq), "\x1b[%d;%dH", y + 1, x + 1);
+            out_str(r, seq);
+        }
+    } else if (x == 0 && r->term_y == y - 1) {
+        out_str(r, "\r\n");
+    } else {
+        snprintf(seq, sizeof(seq), "\x1b[%d;%dH", y + 1, x + 1);
+        out_str(r, seq);
+    }
+    r->term_y = y;
+    r->term_x = x;
+}
+
+static void ansi_resize(CfRenderer *r, int rows, int cols) {
+    size_t cells = (size_t)rows * (size_t)cols;
+
+    free(r->front);
+    free(r->back);
+    r->front = calloc(cells > 0 ? cells : 1, sizeof(Cell));
+    r->back = calloc(cells > 0 ? cells : 1, sizeof(Cell));
+    if (r->front == NULL || r->back == NULL) {
+        abort();
+    }
+    for (size_t i = 0; i < cells; ++i) {
+        r->front[i].ch = ' ';
+        r->back[i].ch = ' ';
+    }
+    r->rows = rows;
+    r->cols = cols;
+    r->repaint = true;
+}
+
+static int env_size(const char *name, int fallback) {
+    const char *text = getenv(name);
+    char *end;
+    long value;
+
+    if (text == NULL || text[0] == '\0') {
+        return fallback;
+    }
+    value = strtol(text, &end, 10);
+    return *end == '\0' && value > 0 && value < 10000 ? (int)value : fallback;
+}
+
+static void ansi_size(CfRenderer *r) {
+    struct winsize ws;
+    int rows = FALLBACK_ROWS;
+    int cols = FALLBACK_COLS;
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+        rows = ws.ws_row;
+        cols = ws.ws_col;
+    }
+    /* LINES and COLUMNS win over the terminal's own answer, as they do for curses. */
+    rows = env_size("LINES", rows);
+    cols = env_size("COLUMNS", cols);
+    if (rows != r->rows || cols != r->cols) {
+        r->resized = r->front != NULL;
+        ansi_resize(r, rows, cols);
+    }
+}
+
+/*
+ * What the ansi backend has to undo, kept outside the renderer so a signal
+ * handler and an atexit() hook can reach it: curses restores the terminal
+ * when the game is interrupted or exits without closing it, and so must we.
+ */
+static const int kRestoreSignals[3] = {SIGINT, SIGTERM, SIGHUP};
+static const char kAnsiRestore[] = "\x1b[m\x1b[?25h\x1b[?1049l";
+static volatile sig_atomic_t g_ansi_active = 0;
+static bool g_ansi_tty = false;
+static struct termios g_ansi_saved;
+static struct sigaction g_ansi_prev[3];
+static bool g_ansi_atexit = false;
+
+/* Only write() and tcsetattr(): both are safe inside a signal handler. */
+static void ansi_restore_terminal(void) {
+    if (!g_ansi_active) {
+        return;
+    }
+    g_ansi_active = 0;
+    if (write(STDOUT_FILENO, kAnsiRestore, sizeof(kAnsiRestore) - 1) < 0) {
+        /* Nothing left to report it to. */
+    }
+    if (g_ansi_tty) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &g_ansi_saved);
+    }
+}
+
+static void ansi_on_signal(int sig) {
+    ansi_restore_terminal();
+    for (int i = 0; i < 3; ++i) {
+        if (kRestoreSignals[i] == sig) {
+            sigaction(sig, &g_ansi_prev[i], NULL);
+        }
+    }
+    raise(sig);
+}
+
+static void ansi_hooks_install(void) {
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = ansi_on_signal;
+    sigemptyset(&sa.sa_mask);
+    for (int i = 0; i < 3; ++i) {
+        sigaction(kRestoreSignals[i], &sa, &g_ansi_prev[i]);
+    }
+    if (!g_ansi_atexit) {
+        g_ansi_atexit = atexit(ansi_restore_terminal) == 0;
+    }
+    g_ansi_active = 1;
+}
+
+static void ansi_hooks_remove(void) {
+    g_ansi_active = 0;
+    for (int i = 0; i < 3; ++i) {
+        sigaction(kRestoreSignals[i], &g_ansi_prev[i], NULL);
+    }
+}
+
+static bool ansi_open(CfRenderer *r) {
+    r->tty = isatty(STDIN_FILENO);
+    if (r->tty) {
+        struct termios raw;
+
+        if (tcgetattr(STDIN_FILENO, &r->saved) != 0) {
+            return false;
+        }
+        /* Like curses' cbreak/noecho: keys one at a time, no echo, Ctrl-C still interrupts. */
+        raw = r->saved;
+        raw.c_lflag &= (tcflag_t)~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+    g_ansi_tty = r->tty;
+    g_ansi_saved = r->saved;
+    ansi_hooks_install();
+    r->colors = CF_PAIRS;
+    r->term_y = -1;
+    r->term_x = -1;
+    ansi_size(r);
+    r->resized = false;
+    /* Alternate screen, cursor hidden; the first present() clears it. */
+    out_str(r, "\x1b[?1049h\x1b[?25l");
+    out_flush(r);
+    return true;
+}
+
+static void ansi_close(CfRenderer *r) {
+    ansi_hooks_remove();
+    out_str(r, kAnsiRestore);
+    out_flush(r);
+    if (r->tty) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &r->saved);
+    }
+    free(r->front);
+    free(r->back);
+    free(r->out);
+}
+
+static void ansi_put(CfRenderer *r, int y, int x, unsigned attr, const char *text, int len) {
+    Cell *cell = r->back + (size_t)y * (size_t)r->cols + (size_t)x;
+
+    for (int i = 0; i < len; ++i) {
+        unsigned char ch = (unsigned char)text[i];
+
+        /* Control bytes would move the real cursor; show them as '?' instead. */
+        cell[i].ch = ch < ' ' || ch == 0x7f ? '?' : (char)ch;
+        cell[i].attr = (uint8_t)attr;
+    }
+}
+
+static void ansi_fill(CfRenderer *r, int y, int x, int len) {
+    Cell *cell = r->back + (size_t)y * (size_t)r->cols + (size_t)x;
+
+    for (int i = 0; i < len; ++i) {
+        cell[i].ch = ' ';
+        cell[i].attr = 0;
+    }
+}
+
+static bool same_cell(Cell a, Cell b) {
+    return a.ch == b.ch && a.attr == b.attr;
+}
+
+static int changed_cells(const Cell *front, const Cell *back, int count) {
+    int changed = 0;
+
+    for (int i = 0; i < count; ++i) {
+        changed += same_cell(front[i], back[i]) ? 0 : 1;
+    }
+    return changed;
+}
+
+/* Emits the cells of row `y` that differ from what the terminal shows. */
+static void ansi_diff_row(CfRenderer *r, int y) {
+    Cell *front = r->front + (size_t)y * (size_t)r->cols;
+    const Cell *back = r->back + (size_t)y * (size_t)r->cols;
+    int blank_from = r->cols;
+
+    while (blank_from > 0 && back[blank_from - 1].ch == ' ' && back[blank_from - 1].attr == 0) {
+        blank_from -= 1;
+    }
+
+    for (int x = 0; x < r->cols; ++x) {
+        if (same_cell(front[x], back[x])) {
+            continue;
+        }
+        /* Only blanks from here on: one erase-to-end-of-line when it is shorter than the spaces. */
+        if (x >= blank_from && changed_cells(front + x, back + x, r->cols - x) > 3) {
+            out_move(r, y, x);
+            if (r->term_attr != 0) {
+                out_attr(r, 0);
+            }
+            out_str(r, "\x1b[K");
+            memcpy(front + x, back + x, (size_t)(r->cols - x) * sizeof(Cell));
+            return;
+        }
+        out_move(r, y, x);
+        if (back[x].attr != r->term_attr) {
+            out_attr(r, back[x].attr);
+        }
+        out_bytes(r, &back[x].ch, 1);
+        front[x] = back[x];
+        /* The last column leaves the cursor pending a wrap; its position is only certain after a jump. */
+        r->term_x = x + 1 < r->cols ? x + 1 : -1;
+    }
+}
+
+static bool same_row(const Cell *a, const Cell *b, int cols) {
+    return memcmp(a, b, (size_t)cols * sizeof(Cell)) == 0;
+}
+
+static bool blank_row(const Cell *row, int cols) {
+    for (int x = 0; x < cols; ++x) {
+        if (row[x].ch != ' ' || row[x].attr != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * When a block of rows moved up (the console's log as lines arrive), lets
+ * the terminal move it: a scroll region and a few line feeds instead of
+ * resending every moved row. Rows the scroll does not fix go through the
+ * normal diff afterwards.
+ */
+static void ansi_scroll(CfRenderer *r) {
+    size_t cols = (size_t)r->cols;
+    int best_shift = 0;
+    int best_top = 0;
+    int best_rows = 0;
+    int best_saved = 0;
+    char seq[64];
+
+    for (int shift = 1; shift <= SCROLL_MAX_LINES && shift < r->rows; ++shift) {
+        int top = 0;
+        int saved = 0;
+
+        for (int y = 0; y + shift <= r->rows; ++y) {
+            const Cell *back = r->back + (size_t)y * cols;
+            bool moved = y + shift < r->rows && same_row(back, r->front + (size_t)(y + shift) * cols, r->cols);
+
+            if (moved) {
+                /* Only rows that changed and are not blank would cost anything to resend. */
+                saved += !same_row(back, r->front + (size_t)y * cols, r->cols) && !blank_row(back, r->cols);
+                continue;
+            }
+            if (saved > best_saved) {
+                best_shift = shift;
+                best_top = top;
+                best_rows = y - top;
+                best_saved = saved;
+            }
+            top = y + 1;
+            saved = 0;
+        }
+    }
+    if (best_saved < SCROLL_MIN_ROWS) {
+        return;
+    }
+
+    /* Lines scrolled in take the current background, so go back to plain first. */
+    if (r->term_attr != 0) {
+        out_attr(r, 0);
+    }
+    snprintf(seq, sizeof(seq), "\x1b[%d;%dr\x1b[%d;1H", best_top + 1, best_top + best_rows + best_shift, best_top + best_rows + best_shift);
+    out_str(r, seq);
+    for (int i = 0; i < best_shift; ++i) {
+        out_str(r, "\n");
+    }
+    /* Resetting the region homes the cursor. */
+    out_str(r, "\x1b[r");
+    r->term_y = 0;
+    r->term_x = 0;
+
+    memmove(
+        r->front + (size_t)best_top * cols,
+        r->front + (size_t)(best_top + best_shift) * cols,
+        (size_t)best_rows * cols * sizeof(Cell)
+    );
+    for (size_t i = (size_t)(best_top + best_rows) * cols; i < (size_t)(best_top + best_rows + best_shift) * cols; ++i) {
+        r->front[i].ch = ' ';
+        r->front[i].attr = 0;
+    }
+}
+
+static void ansi_present(CfRenderer *r) {
+    size_t sent;
+
+    if (r->repaint) {
+        out_str(r, "\x1b[m\x1b[H\x1b[2J");
+        for (size_t i = 0; i < (size_t)r->rows * (size_t)r->cols; ++i) {
+            r->front[i].ch = ' ';
+            r->front[i].attr = 0;
+        }
+        r->term_y = 0;
+        r->term_x = 0;
+        r->term_attr = 0;
+        r->repaint = false;
+    } else {
+        ansi_scroll(r);
+    }
+    for (int y = 0; y < r->rows; ++y) {
+        ansi_diff_row(r, y);
+    }
+    if (r->cursor_visible && r->rows > 0 && r->cols > 0) {
+        int y = r->cursor_y < r->rows ? r->cursor_y : r->rows - 1;
+        int x = r->cursor_x < r->cols ? r->cursor_x : r->cols - 1;
+        char seq[32];
+
+        if (r->term_y != y || r->term_x != x) {
+            snprintf(seq, sizeof(seq), "\x1b[%d;%dH", y + 1, x + 1);
+            out_str(r, seq);
+            r->term_y = y;
+            r->term_x = x;
+        }
+    }
+    if (r->out_len == 0) {
+        return;
+    }
+    sent = out_flush(r);
+    r->stats.frames += 1;
+    r->stats.last_bytes = sent;
+}
+
+static void ansi_invalidate(CfRenderer *r) {
+    r->repaint = true;
+}
+
+static int ansi_key(CfRenderer *r) {
+    if (r->resized) {
+        r->resized = false;
+        return CF_KEY_RESIZE;
+    }
+    return stdin_key(r);
+}
+
+static void ansi_beep(CfRenderer *r) {
+    out_str(r, "\a");
+    out_flush(r);
+}
+
+/* Reverse video for a moment, as curses' flash() does on terminals without a flash capability of their own. */
+static void ansi_flash(CfRenderer *r) {
+    out_str(r, "\x1b[?5h");
+    out_flush(r);
+    usleep(FLASH_US);
+    out_str(r, "\x1b[?5l");
+    out_flush(r);
+}
+
+static void ansi_cursor(CfRenderer *r, bool visible) {
+    out_str(r, visible ? "\x1b[?25h" : "\x1b[?25l");
+    out_flush(r);
+}
+
+static const Backend kAnsi = {
+    ansi_open,
+    ansi_close,
+    ansi_size,
+    ansi_put,
+    ansi_fill,
+    ansi_present,
+    ansi_invalidate,
+    ansi_key,
+    stdin_flush,
+    ansi_beep,
+    ansi_flash,
+    ansi_cursor
+};
+
+/* --------------------- Renderer --------------------- */
+const char *cf_render_backend_name(CfRenderBackend backend) {
+    return backend >= 0 && backend < CF_RENDER_BACKENDS ? kBackendNames[backend] : "?";
+}
+
+bool cf_render_backend_parse(const char *name, CfRenderBackend *out) {
+    for (int i = 0; i < CF_RENDER_BACKENDS; ++i) {
+        if (strcmp(name, kBackendNames[i]) == 0) {
+            *out = (CfRenderBackend)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+CfRenderer *cf_render_open(CfRenderBackend backend) {
+    static const Backend *const kBackends[CF_RENDER_BACKENDS] = {&kCurses, &kNull, &kAnsi};
+    CfRenderer *r;
+
+    if (backend < 0 || backend >= CF_RENDER_BACKENDS) {
+        return NULL;
+    }
+    r = calloc(1, sizeof(*r));
+    if (r == NULL) {
+        return NULL;
+    }
+    r->ops = kBackends[backend];
+    r->backend = backend;
+    if (!r->ops->open(r)) {
+        free(r);
+        return NULL;
+    }
+    r->ops->size(r);
+    return r;
+}
+
+void cf_render_close(CfRenderer *r) {
+    if (r == NULL) {
+        return;
+    }
+    r->ops->close(r);
+    free(r);
+}
+
+CfRenderBackend cf_render_backend(const CfRenderer *r) {
+    return r->backend;
+}
+
+int cf_render_colors(const CfRenderer *r) {
+    return r->colors;
+}
+
+void cf_render_size(CfRenderer *r, int *rows, int *cols) {
+    r->ops->size(r);
+    *rows = r->rows;
+    *cols = r->cols;
+}
+
+/* Clips one run of cells to the screen and hands it to the backend. */
+static void render_put(CfRenderer *r, int y, int x, unsigned attr, const char *text, int len) {
+    if (y < 0 || y >= r->rows || x >= r->cols) {
+        return;
+    }
+    if (x < 0) {
+        text -= x;
+        len += x;
+        x = 0;
+    }
+    if (len > r->cols - x) {
+        len = r->cols - x;
+    }
+    if (len > 0) {
+        r->ops->put(r, y, x, attr, text, len);
+    }
+}
+
+void cf_render_clear(CfRenderer *r, CfRenderArea area) {
+    int x = area.x < 0 ? 0 : area.x;
+    int end = area.x + area.cols < r->cols ? area.x + area.cols : r->cols;
+
+    for (int y = area.y < 0 ? 0 : area.y; y < area.y + area.rows && y < r->rows; ++y) {
+        if (end > x) {
+            r->ops->fill(r, y, x, end - x);
+        }
+    }
+}
+
+void cf_render_text(CfRenderer *r, CfRenderArea area, int y, int x, unsigned attr, const char *text) {
+    int len = (int)strlen(text);
+
+    if (y < 0 || x < 0 || x >= area.cols) {
+        return;
+    }
+    if (r->colors == 0) {
+        attr &= ~(unsigned)CF_ATTR_PAIR_MASK;
+    }
+    /* Wraps at the area's right edge like a curses window; what does not fit above its bottom is lost. */
+    while (len > 0 && y < area.rows) {
+        int run = len < area.cols - x ? len : area.cols - x;
+
+        render_put(r, area.y + y, area.x + x, attr, text, run);
+        text += run;
+        len -= run;
+        x += run;
+        if (x >= area.cols && len > 0) {
+            y += 1;
+            x = 0;
+        }
+    }
+    r->cursor_y = area.y + y;
+    r->cursor_x = area.x + x;
+}
+
+void cf_render_printf(CfRenderer *r, CfRenderArea area, int y, int x, unsigned attr, const char *fmt, ...) {
+    char text[TEXT_CHARS];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    cf_render_text(r, area, y, x, attr, text);
+}
+
+void cf_render_present(CfRenderer *r) {
+    r->ops->present(r);
+}
+
+void cf_render_invalidate(CfRenderer *r) {
+    r->ops->invalidate(r);
+}
+
+int cf_render_key(CfRenderer *r) {
+    return r->ops->key(r);
+}
+
+void cf_render_flush_input(CfRenderer *r) {
+    r->ops->flush_input(r);
+}
+
+void cf_render_beep(CfRenderer *r) {
+    r->ops->beep(r);
+}
+
+void cf_render_flash(CfRenderer *r) {
+    r->ops->flash(r);
+}
+
+void cf_render_cursor(CfRenderer *r, bool visible) {
+    r->cursor_visible = visible;
+    r->ops->cursor(r, visible);
+}
+
+void cf_render_stats(const CfRenderer *r, CfRenderStats *out) {
+    *out = r->stats;
+}
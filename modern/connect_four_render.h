@@ -0,0 +1,115 @@
+#ifndef CONNECT_FOUR_RENDER_H
+#define CONNECT_FOUR_RENDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * The game's terminal front end behind one small interface, so the drawing
+ * code never calls a terminal library itself:
+ *
+ *   ncurses  the curses screen, as the game always used
+ *   null     no terminal: a 0x0 screen that drops everything; keys still
+ *            come from stdin, so scripted and replayed sessions run headless
+ *   ansi     raw escape sequences: a cell framebuffer, and each present()
+ *            sends only the cells that differ from the last frame, in one
+ *            write() (cursor jumps, colour changes and erase-to-end-of-line
+ *            picked for the fewest bytes)
+ *
+ * Drawing goes through CfRenderArea rectangles: coordinates are relative to
+ * the area, text wraps at its right edge like a curses window and is cut
+ * off at its bottom. Nothing reaches the terminal before present().
+ *
+ * Keys use the curses numbering (a recorded session replays the same codes
+ * whichever backend recorded it).
+ */
+
+typedef enum {
+    CF_RENDER_NCURSES,
+    CF_RENDER_NULL,
+    CF_RENDER_ANSI,
+    CF_RENDER_BACKENDS
+} CfRenderBackend;
+
+/* Attributes: a colour pair in the low bits (0: the terminal default) plus flags. */
+enum {
+    CF_PAIR_RED = 1,
+    CF_PAIR_YELLOW = 2,
+    CF_PAIR_CYAN = 3,
+    CF_PAIR_GREEN = 4,
+    CF_PAIR_MAGENTA = 5,
+    CF_PAIR_BLUE = 6,
+    CF_PAIR_WHITE = 7,
+    CF_PAIRS = 7,
+    CF_ATTR_PAIR_MASK = 0x0f,
+    CF_ATTR_BOLD = 0x10,
+    CF_ATTR_REVERSE = 0x20
+};
+
+enum {
+    CF_KEY_NONE = -1,  /* nothing waiting */
+    CF_KEY_CLOSED = -2, /* the input reached end of file */
+    CF_KEY_DOWN = 0402,
+    CF_KEY_UP = 0403,
+    CF_KEY_LEFT = 0404,
+    CF_KEY_RIGHT = 0405,
+    CF_KEY_HOME = 0406,
+    CF_KEY_BACKSPACE = 0407,
+    CF_KEY_NPAGE = 0522,
+    CF_KEY_PPAGE = 0523,
+    CF_KEY_ENTER = 0527,
+    CF_KEY_END = 0550,
+    CF_KEY_RESIZE = 0632
+};
+
+typedef struct {
+    int y;
+    int x;
+    int rows;
+    int cols;
+} CfRenderArea;
+
+typedef struct {
+    uint64_t frames;     /* present() calls that sent something */
+    uint64_t bytes;      /* bytes written to the terminal; 0 where the backend cannot tell */
+    uint64_t last_bytes; /* of the last frame that sent something */
+} CfRenderStats;
+
+typedef struct CfRenderer CfRenderer;
+
+const char *cf_render_backend_name(CfRenderBackend backend);
+/* By name as printed above; false for an unknown name. */
+bool cf_render_backend_parse(const char *name, CfRenderBackend *out);
+
+/* Takes over the terminal (nothing for null); NULL when it cannot. */
+CfRenderer *cf_render_open(CfRenderBackend backend);
+/* Gives the terminal back as it was; NULL is a no-op. */
+void cf_render_close(CfRenderer *r);
+CfRenderBackend cf_render_backend(const CfRenderer *r);
+
+/* Colour pairs the terminal shows; 0 when it is monochrome and pairs are dropped. */
+int cf_render_colors(const CfRenderer *r);
+/* Current terminal size; rereads it, so call once per frame rather than per cell. */
+void cf_render_size(CfRenderer *r, int *rows, int *cols);
+
+/* Blanks the area. */
+void cf_render_clear(CfRenderer *r, CfRenderArea area);
+void cf_render_text(CfRenderer *r, CfRenderArea area, int y, int x, unsigned attr, const char *text);
+void cf_render_printf(CfRenderer *r, CfRenderArea area, int y, int x, unsigned attr, const char *fmt, ...)
+    __attribute__((format(printf, 6, 7)));
+/* Shows what was drawn since the last call. */
+void cf_render_present(CfRenderer *r);
+/* The terminal's contents are unknown (after a resize): the next present() repaints everything. */
+void cf_render_invalidate(CfRenderer *r);
+
+/* Next key, CF_KEY_NONE when none is waiting; never blocks. */
+int cf_render_key(CfRenderer *r);
+void cf_render_flush_input(CfRenderer *r);
+void cf_render_beep(CfRenderer *r);
+void cf_render_flash(CfRenderer *r);
+/* Shows the cursor where the last text ended, or hides it. */
+void cf_render_cursor(CfRenderer *r, bool visible);
+
+void cf_render_stats(const CfRenderer *r, CfRenderStats *out);
+
+#endif
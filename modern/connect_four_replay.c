@@ -0,0 +1,217 @@
+#include "connect_four_replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    REPLAY_VERSION = 1,
+    REPLAY_HEADER_BYTES = 13,
+    VARINT_MAX_BYTES = 10
+};
+
+static const char kReplayMagic[4] = {'C', 'F', 'R', 'P'};
+
+struct CfRecorder {
+    FILE *fp;
+    uint64_t last_ms;
+};
+
+struct CfReplay {
+    unsigned char *data;
+    size_t size;
+    size_t pos;
+    uint64_t seed;
+    uint64_t now_ms;
+    bool closed;
+    uint64_t digest;
+};
+
+/* --------------------- Encoding --------------------- */
+static void put_u64(unsigned char *dst, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        dst[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static uint64_t get_u64(const unsigned char *src) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < 8; ++i) {
+        value |= (uint64_t)src[i] << (8 * i);
+    }
+    return value;
+}
+
+static int put_varint(unsigned char *dst, uint64_t value) {
+    int len = 0;
+
+    do {
+        unsigned char byte = (unsigned char)(value & 0x7f);
+
+        value >>= 7;
+        dst[len++] = (unsigned char)(byte | (value != 0 ? 0x80 : 0));
+    } while (value != 0);
+    return len;
+}
+
+static bool get_varint(CfReplay *rp, uint64_t *out) {
+    uint64_t value = 0;
+
+    for (int shift = 0; shift < 7 * VARINT_MAX_BYTES; shift += 7) {
+        unsigned char byte;
+
+        if (rp->pos >= rp->size) {
+            return false;
+        }
+        byte = rp->data[rp->pos++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* --------------------- Recorder --------------------- */
+CfRecorder *cf_recorder_open(const char *path, uint64_t seed) {
+    CfRecorder *rec;
+    unsigned char header[REPLAY_HEADER_BYTES];
+
+    if (path == NULL || path[0] == '\0') {
+        return NULL;
+    }
+    rec = calloc(1, sizeof(*rec));
+    if (rec == NULL) {
+        return NULL;
+    }
+    rec->fp = fopen(path, "wb");
+    if (rec->fp == NULL) {
+        free(rec);
+        return NULL;
+    }
+
+    memcpy(header, kReplayMagic, sizeof(kReplayMagic));
+    header[4] = REPLAY_VERSION;
+    put_u64(header + 5, seed);
+    if (fwrite(header, 1, sizeof(header), rec->fp) != sizeof(header)) {
+        fclose(rec->fp);
+        free(rec);
+        return NULL;
+    }
+    return rec;
+}
+
+bool cf_recorder_event(CfRecorder *rec, uint64_t time_ms, uint32_t code) {
+    unsigned char buf[2 * VARINT_MAX_BYTES];
+    int len;
+
+    if (rec == NULL) {
+        return false;
+    }
+    time_ms = time_ms > rec->last_ms ? time_ms : rec->last_ms;
+    len = put_varint(buf, time_ms - rec->last_ms);
+    len += put_varint(buf + len, (uint64_t)code + 1);
+    rec->last_ms = time_ms;
+    return fwrite(buf, 1, (size_t)len, rec->fp) == (size_t)len && fflush(rec->fp) == 0;
+}
+
+bool cf_recorder_close(CfRecorder *rec, uint64_t digest) {
+    unsigned char buf[2 + 8];
+    bool ok;
+
+    if (rec == NULL) {
+        return true;
+    }
+    buf[0] = 0;
+    buf[1] = 0;
+    put_u64(buf + 2, digest);
+    ok = fwrite(buf, 1, sizeof(buf), rec->fp) == sizeof(buf);
+    ok = fclose(rec->fp) == 0 && ok;
+    free(rec);
+    return ok;
+}
+
+/* --------------------- Replay --------------------- */
+CfReplay *cf_replay_open(const char *path) {
+    FILE *fp;
+    CfReplay *rp;
+    long size;
+
+    if (path == NULL || path[0] == '\0') {
+        return NULL;
+    }
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    rp = calloc(1, sizeof(*rp));
+    if (rp == NULL || fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < REPLAY_HEADER_BYTES) {
+        free(rp);
+        fclose(fp);
+        return NULL;
+    }
+    rewind(fp);
+    rp->size = (size_t)size;
+    rp->data = malloc(rp->size);
+    if (rp->data == NULL || fread(rp->data, 1, rp->size, fp) != rp->size) {
+        cf_replay_close(rp);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+
+    if (memcmp(rp->data, kReplayMagic, sizeof(kReplayMagic)) != 0 || rp->data[4] != REPLAY_VERSION) {
+        cf_replay_close(rp);
+        return NULL;
+    }
+    rp->seed = get_u64(rp->data + 5);
+    rp->pos = REPLAY_HEADER_BYTES;
+    return rp;
+}
+
+void cf_replay_close(CfReplay *rp) {
+    if (rp == NULL) {
+        return;
+    }
+    free(rp->data);
+    free(rp);
+}
+
+uint64_t cf_replay_seed(const CfReplay *rp) {
+    return rp->seed;
+}
+
+bool cf_replay_next(CfReplay *rp, uint64_t *time_ms, uint32_t *code) {
+    size_t start = rp->pos;
+    uint64_t delta;
+    uint64_t stored;
+
+    if (rp->closed || !get_varint(rp, &delta) || !get_varint(rp, &stored)) {
+        rp->pos = start;
+        return false;
+    }
+    if (stored == 0) {
+        if (rp->size - rp->pos < 8) {
+            rp->pos = start;
+            return false;
+        }
+        rp->digest = get_u64(rp->data + rp->pos);
+        rp->pos += 8;
+        rp->closed = true;
+        return false;
+    }
+    rp->now_ms += delta;
+    *time_ms = rp->now_ms;
+    *code = (uint32_t)(stored - 1);
+    return true;
+}
+
+bool cf_replay_digest(const CfReplay *rp, uint64_t *digest) {
+    if (!rp->closed) {
+        return false;
+    }
+    *digest = rp->digest;
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef CONNECT_FOUR_REPLAY_H
+#define CONNECT_FOUR_REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Session recordings: the seed a session's RNG streams started from and
+ * every event the game loop acted on, stamped with the session clock.
+ *
+ * File layout: "CFRP", a version byte, the seed (8 bytes, little endian),
+ * then one record per event as two LEB128 varints: milliseconds since the
+ * previous event and code + 1. Codes are the caller's. A record whose code
+ * varint is 0 closes the file and is followed by an 8-byte digest of the
+ * final state, so a replay can check that it arrived at the same place.
+ *
+ * The recorder flushes after every event; a session that was killed still
+ * replays up to its last event, just without the closing digest.
+ */
+
+typedef struct CfRecorder CfRecorder;
+typedef struct CfReplay CfReplay;
+
+CfRecorder *cf_recorder_open(const char *path, uint64_t seed);
+/* `time_ms` is absolute session time; it must not go backwards. */
+bool cf_recorder_event(CfRecorder *rec, uint64_t time_ms, uint32_t code);
+/* Writes the closing record and frees the recorder; NULL is a no-op. */
+bool cf_recorder_close(CfRecorder *rec, uint64_t digest);
+
+/* Reads the whole file up front so replaying does no I/O. */
+CfReplay *cf_replay_open(const char *path);
+void cf_replay_close(CfReplay *rp);
+uint64_t cf_replay_seed(const CfReplay *rp);
+/* False at the end of the file or at a truncated record. */
+bool cf_replay_next(CfReplay *rp, uint64_t *time_ms, uint32_t *code);
+/* True once cf_replay_next() has reached a closing record. */
+bool cf_replay_digest(const CfReplay *rp, uint64_t *digest);
+
+#endif
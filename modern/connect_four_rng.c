@@ -0,0 +1,102 @@
+#include "connect_four_rng.h"
+
+enum {
+    RNG_ROTATE_SHIFT = 59,
+    SHUFFLE_ROUNDS = 4
+};
+
+static const uint64_t kRngMultiplier = 6364136223846793005ULL;
+
+void cf_rng_seed(CfRng *rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1u;
+    cf_rng_next(rng);
+    rng->state += seed;
+    cf_rng_next(rng);
+}
+
+uint32_t cf_rng_next(CfRng *rng) {
+    uint64_t old = rng->state;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> RNG_ROTATE_SHIFT);
+
+    rng->state = old * kRngMultiplier + rng->inc;
+    return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+}
+
+int cf_rng_below(CfRng *rng, int bound) {
+    uint32_t range;
+    uint32_t threshold;
+
+    if (bound <= 0) {
+        return 0;
+    }
+    range = (uint32_t)bound;
+    /* 2^32 mod range: draws below it would make the low values more likely. */
+    threshold = (0u - range) % range;
+    for (;;) {
+        uint32_t r = cf_rng_next(rng);
+
+        if (r >= threshold) {
+            return (int)(r % range);
+        }
+    }
+}
+
+static void shuffle_rekey(CfShuffle *shuffle, CfRng *rng) {
+    for (int i = 0; i < SHUFFLE_ROUNDS; ++i) {
+        shuffle->key[i] = cf_rng_next(rng);
+    }
+    shuffle->drawn = 0;
+}
+
+void cf_shuffle_start(CfShuffle *shuffle, uint64_t n, CfRng *rng) {
+    int bits = 2;
+
+    while (bits < 64 && (UINT64_C(1) << bits) < n) {
+        bits += 2;
+    }
+    shuffle->n = n;
+    shuffle->half_bits = bits / 2;
+    shuffle->drawn = 0;
+    shuffle_rekey(shuffle, rng);
+}
+
+static uint64_t shuffle_round(uint64_t x, uint32_t key, uint64_t mask) {
+    x = (x ^ key) * 0x9e3779b97f4a7c15ULL;
+    x ^= x >> 29;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 32;
+    return x & mask;
+}
+
+static uint64_t shuffle_permute(const CfShuffle *shuffle, uint64_t x) {
+    uint64_t mask = (UINT64_C(1) << shuffle->half_bits) - 1;
+    uint64_t left = x >> shuffle->half_bits;
+    uint64_t right = x & mask;
+
+    for (int i = 0; i < SHUFFLE_ROUNDS; ++i) {
+        uint64_t next = left ^ shuffle_round(right, shuffle->key[i], mask);
+
+        left = right;
+        right = next;
+    }
+    return (left << shuffle->half_bits) | right;
+}
+
+uint64_t cf_shuffle_next(CfShuffle *shuffle, CfRng *rng) {
+    uint64_t x;
+
+    if (shuffle->n == 0) {
+        return 0;
+    }
+    if (shuffle->drawn >= shuffle->n) {
+        shuffle_rekey(shuffle, rng);
+    }
+    /* Cycle walking: the domain is under 4n, so this takes a few steps at most on average. */
+    x = shuffle->drawn++;
+    do {
+        x = shuffle_permute(shuffle, x);
+    } while (x >= shuffle->n);
+    return x;
+}
@@ -0,0 +1,42 @@
+#ifndef CONNECT_FOUR_RNG_H
+#define CONNECT_FOUR_RNG_H
+
+#include <stdint.h>
+
+/*
+ * Small seeded generator (PCG32, XSH-RR output). Each CfRng is an
+ * independent stream: the same seed with different `stream` numbers gives
+ * uncorrelated sequences, so one subsystem drawing more or fewer numbers
+ * never shifts what another one sees. No global state; copy a CfRng to fork
+ * its sequence.
+ */
+
+typedef struct {
+    uint64_t state;
+    uint64_t inc;
+} CfRng;
+
+void cf_rng_seed(CfRng *rng, uint64_t seed, uint64_t stream);
+uint32_t cf_rng_next(CfRng *rng);
+/* Uniform in [0, bound) without modulo bias; 0 when bound <= 0. */
+int cf_rng_below(CfRng *rng, int bound);
+
+/*
+ * Draws from [0, n) without replacement: every value once per pass, in an
+ * order fixed by a key taken from `rng`, then a new pass with a new key.
+ * The order is a keyed Feistel permutation over the next even power of
+ * two, walked until it lands below n, so a draw is O(1) on average and the
+ * state is the same few words whatever n is.
+ */
+typedef struct {
+    uint64_t n;
+    uint64_t drawn;
+    int half_bits;
+    uint32_t key[4];
+} CfShuffle;
+
+void cf_shuffle_start(CfShuffle *shuffle, uint64_t n, CfRng *rng);
+/* 0 when n is 0. */
+uint64_t cf_shuffle_next(CfShuffle *shuffle, CfRng *rng);
+
+#endif
@@ -0,0 +1,439 @@
+#include "connect_four_tablebase.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * On-disk layout (native byte order, checked through `byte_order`):
+ *
+ *   TbHeader
+ *   data blocks   one per TB_BLOCK_ENTRIES positions: the first entry is a
+ *                 bare value byte (its key lives in the index), every
+ *                 following entry is a varint key delta plus a value byte
+ *   TbIndexEntry  one per block: first key and offset of the block
+ *
+ * Probing binary-searches the index and decodes a single block.
+ */
+enum {
+    TB_BLOCK_ENTRIES = 128,
+    TB_BYTE_ORDER = 0x01020304
+};
+
+static const char kTbMagic[8] = {'C', 'F', '4', 'T', 'B', '0', '1', '\n'};
+
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;
+    uint8_t rows;
+    uint8_t cols;
+    uint8_t max_empties;
+    uint8_t reserved0;
+    uint32_t block_entries;
+    uint32_t reserved1;
+    uint64_t entry_count;
+    uint64_t block_count;
+    uint64_t index_offset;
+    uint64_t data_offset;
+} TbHeader;
+
+typedef struct {
+    uint64_t first_key;
+    uint64_t offset;
+} TbIndexEntry;
+
+struct CfTablebase {
+    const uint8_t *map;
+    size_t map_size;
+    const TbHeader *header;
+    const TbIndexEntry *index;
+    const uint8_t *data;
+    size_t data_size;
+};
+
+struct CfTbWriter {
+    FILE *file;
+    char *path;
+    int max_empties;
+    uint64_t entry_count;
+    uint64_t offset;
+    uint64_t last_key;
+    TbIndexEntry *index;
+    size_t index_count;
+    size_t index_cap;
+    bool failed;
+};
+
+uint8_t cf_tb_pack_value(CfTbValue value) {
+    int distance = value.distance;
+
+    if (distance < 0) {
+        distance = 0;
+    }
+    if (distance > 63) {
+        distance = 63;
+    }
+    return (uint8_t)(((unsigned)value.result << 6) | (unsigned)distance);
+}
+
+CfTbValue cf_tb_unpack_value(uint8_t packed) {
+    CfTbValue value;
+    value.result = (CfTbResult)(packed >> 6);
+    value.distance = packed & 63;
+    return value;
+}
+
+/* --------------------- Reader --------------------- */
+CfTablebase *cf_tablebase_open(const char *path) {
+    struct stat st;
+    CfTablebase *tb;
+    const TbHeader *header;
+    void *map;
+    int fd;
+
+    if (path == NULL || path[0] == '\0') {
+        return NULL;
+    }
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TbHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    header = (const TbHeader *)map;
+    if (memcmp(header->magic, kTbMagic, sizeof(kTbMagic)) != 0 ||
+        header->byte_order != TB_BYTE_ORDER ||
+        header->rows != CF_ROWS ||
+        header->cols != CF_COLS ||
+        header->block_entries != TB_BLOCK_ENTRIES ||
+        header->data_offset > header->index_offset ||
+        header->index_offset > (uint64_t)st.st_size ||
+        header->block_count > ((uint64_t)st.st_size - header->index_offset) / sizeof(TbIndexEntry)) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+
+    tb = calloc(1, sizeof(*tb));
+    if (tb == NULL) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+
+    tb->map = map;
+    tb->map_size = (size_t)st.st_size;
+    tb->header = header;
+    tb->index = (const TbIndexEntry *)(tb->map + header->index_offset);
+    tb->data = tb->map + header->data_offset;
+    tb->data_size = (size_t)(header->index_offset - header->data_offset);
+
+    /* Endgame probes come in bursts; let the kernel read ahead. */
+    madvise((void *)tb->map, tb->map_size, MADV_WILLNEED);
+    return tb;
+}
+
+void cf_tablebase_close(CfTablebase *tb) {
+    if (tb == NULL) {
+        return;
+    }
+    munmap((void *)tb->map, tb->map_size);
+    free(tb);
+}
+
+void cf_tablebase_prefault(const CfTablebase *tb) {
+    long page = sysconf(_SC_PAGESIZE);
+    size_t step = page > 0 ? (size_t)page : 4096;
+    volatile uint8_t sink = 0;
+
+    if (tb == NULL) {
+        return;
+    }
+    for (size_t offset = 0; offset < tb->map_size; offset += step) {
+        sink ^= tb->map[offset];
+    }
+    (void)sink;
+}
+
+int cf_tablebase_max_empties(const CfTablebase *tb) {
+    return tb != NULL ? tb->header->max_empties : 0;
+}
+
+size_t cf_tablebase_entry_count(const CfTablebase *tb) {
+    return tb != NULL ? (size_t)tb->header->entry_count : 0;
+}
+
+static bool read_varint(const uint8_t **cursor, const uint8_t *end, uint64_t *out) {
+    uint64_t value = 0;
+    int shift = 0;
+
+    while (*cursor < end && shift < 64) {
+        uint8_t byte = **cursor;
+        *cursor += 1;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *out = value;
+            return true;
+        }
+        shift += 7;
+    }
+
+    return false;
+}
+
+static bool lookup_key(const CfTablebase *tb, uint64_t key, uint8_t *out) {
+    size_t lo = 0;
+    size_t hi = (size_t)tb->header->block_count;
+    size_t block;
+    size_t entries;
+    const uint8_t *cursor;
+    const uint8_t *end;
+    uint64_t current;
+
+    if (hi == 0 || key < tb->index[0].first_key) {
+        return false;
+    }
+
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (tb->index[mid].first_key <= key) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    block = lo;
+    if (tb->index[block].offset >= tb->data_size) {
+        return false;
+    }
+
+    cursor = tb->data + tb->index[block].offset;
+    end = (block + 1 < tb->header->block_count)
+        ? tb->data + tb->index[block + 1].offset
+        : tb->data + tb->data_size;
+    entries = TB_BLOCK_ENTRIES;
+    if (block == tb->header->block_count - 1) {
+        entries = (size_t)(tb->header->entry_count - (uint64_t)block * TB_BLOCK_ENTRIES);
+    }
+
+    current = tb->index[block].first_key;
+    for (size_t i = 0; i < entries && cursor < end; ++i) {
+        uint8_t value;
+
+        if (i > 0) {
+            uint64_t delta;
+            if (!read_varint(&cursor, end, &delta) || cursor >= end) {
+                return false;
+            }
+            current += delta;
+        }
+
+        value = *cursor;
+        cursor += 1;
+
+        if (current == key) {
+            *out = value;
+            return true;
+        }
+        if (current > key) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool cf_tablebase_probe(const CfTablebase *tb, const CfGame *game, CfCell to_move, CfTbValue *out) {
+    CfCell opponent = (to_move == CF_AI) ? CF_HUMAN : CF_AI;
+    int mover_count = 0;
+    int stones = 0;
+    int empties;
+    uint8_t packed;
+
+    if (tb == NULL) {
+        return false;
+    }
+
+    for (int row = 0; row < CF_ROWS; ++row) {
+        for (int col = 0; col < CF_COLS; ++col) {
+            CfCell cell = game->board[row][col];
+            if (cell != CF_EMPTY) {
+                stones += 1;
+                if (cell == to_move) {
+                    mover_count += 1;
+                }
+            }
+        }
+    }
+
+    /* Only positions with regular alternating stone counts are tabled. */
+    empties = CF_ROWS * CF_COLS - stones;
+    if (empties < 1 || empties > tb->header->max_empties || mover_count != stones / 2) {
+        return false;
+    }
+    if (cf_has_winner(game, to_move) || cf_has_winner(game, opponent)) {
+        return false;
+    }
+
+    if (!lookup_key(tb, cf_canonical_key(cf_position_key(game, to_move)), &packed)) {
+        return false;
+    }
+
+    if (out != NULL) {
+        *out = cf_tb_unpack_value(packed);
+    }
+    return true;
+}
+
+/* --------------------- Writer --------------------- */
+CfTbWriter *cf_tablebase_writer_open(const char *path, int max_empties) {
+    CfTbWriter *writer;
+    TbHeader placeholder;
+
+    if (path == NULL || max_empties < 1 || max_empties > CF_ROWS * CF_COLS) {
+        return NULL;
+    }
+
+    writer = calloc(1, sizeof(*writer));
+    if (writer == NULL) {
+        return NULL;
+    }
+
+    writer->path = malloc(strlen(path) + 1);
+    writer->file = fopen(path, "wb");
+    if (writer->path == NULL || writer->file == NULL) {
+        if (writer->file != NULL) {
+            fclose(writer->file);
+        }
+        free(writer->path);
+        free(writer);
+        return NULL;
+    }
+
+    strcpy(writer->path, path);
+    setvbuf(writer->file, NULL, _IOFBF, 1 << 20);
+    writer->max_empties = max_empties;
+
+    memset(&placeholder, 0, sizeof(placeholder));
+    if (fwrite(&placeholder, sizeof(placeholder), 1, writer->file) != 1) {
+        writer->failed = true;
+    }
+
+    return writer;
+}
+
+static void writer_put(CfTbWriter *writer, const uint8_t *bytes, size_t len) {
+    if (writer->failed) {
+        return;
+    }
+    if (fwrite(bytes, 1, len, writer->file) != len) {
+        writer->failed = true;
+        return;
+    }
+    writer->offset += len;
+}
+
+bool cf_tablebase_writer_add(CfTbWriter *writer, uint64_t key, uint8_t value) {
+    if (writer == NULL || writer->failed) {
+        return false;
+    }
+    if (writer->entry_count > 0 && key <= writer->last_key) {
+        writer->failed = true;
+        return false;
+    }
+
+    if (writer->entry_count % TB_BLOCK_ENTRIES == 0) {
+        if (writer->index_count == writer->index_cap) {
+            size_t cap = writer->index_cap ? writer->index_cap * 2 : 1024;
+            TbIndexEntry *grown = realloc(writer->index, cap * sizeof(*grown));
+            if (grown == NULL) {
+                writer->failed = true;
+                return false;
+            }
+            writer->index = grown;
+            writer->index_cap = cap;
+        }
+
+        writer->index[writer->index_count].first_key = key;
+        writer->index[writer->index_count].offset = writer->offset;
+        writer->index_count += 1;
+    } else {
+        uint8_t varint[10];
+        size_t len = 0;
+        uint64_t delta = key - writer->last_key;
+
+        while (delta >= 0x80) {
+            varint[len++] = (uint8_t)(delta | 0x80);
+            delta >>= 7;
+        }
+        varint[len++] = (uint8_t)delta;
+        writer_put(writer, varint, len);
+    }
+
+    writer_put(writer, &value, 1);
+    writer->last_key = key;
+    writer->entry_count += 1;
+    return !writer->failed;
+}
+
+bool cf_tablebase_writer_finish(CfTbWriter *writer) {
+    TbHeader header;
+    bool ok;
+
+    if (writer == NULL) {
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kTbMagic, sizeof(kTbMagic));
+    header.byte_order = TB_BYTE_ORDER;
+    header.rows = CF_ROWS;
+    header.cols = CF_COLS;
+    header.max_empties = (uint8_t)writer->max_empties;
+    header.block_entries = TB_BLOCK_ENTRIES;
+    header.entry_count = writer->entry_count;
+    header.block_count = writer->index_count;
+    header.data_offset = sizeof(TbHeader);
+
+    /* Keep the index 8-byte aligned inside the mapping. */
+    while (!writer->failed && (sizeof(TbHeader) + writer->offset) % 8 != 0) {
+        uint8_t pad = 0;
+        writer_put(writer, &pad, 1);
+    }
+    header.index_offset = sizeof(TbHeader) + writer->offset;
+
+    if (!writer->failed && writer->index_count > 0 &&
+        fwrite(writer->index, sizeof(TbIndexEntry), writer->index_count, writer->file) != writer->index_count) {
+        writer->failed = true;
+    }
+    if (!writer->failed &&
+        (fseek(writer->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, writer->file) != 1)) {
+        writer->failed = true;
+    }
+
+    ok = !writer->failed;
+    if (fclose(writer->file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        remove(writer->path);
+    }
+
+    free(writer->index);
+    free(writer->path);
+    free(writer);
+    return ok;
+}
@@ -0,0 +1,45 @@
+#ifndef CONNECT_FOUR_TABLEBASE_H
+#define CONNECT_FOUR_TABLEBASE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "connect_four.h"
+
+typedef enum {
+    CF_TB_DRAW = 0,
+    CF_TB_WIN = 1,
+    CF_TB_LOSS = 2
+} CfTbResult;
+
+/* Exact outcome from the point of view of the side to move. */
+typedef struct {
+    CfTbResult result;
+    int distance;
+} CfTbValue;
+
+typedef struct CfTablebase CfTablebase;
+
+CfTablebase *cf_tablebase_open(const char *path);
+void cf_tablebase_close(CfTablebase *tb);
+/* Reads one byte per page so probes never wait on the disk; blocks until the file is resident. */
+void cf_tablebase_prefault(const CfTablebase *tb);
+int cf_tablebase_max_empties(const CfTablebase *tb);
+size_t cf_tablebase_entry_count(const CfTablebase *tb);
+bool cf_tablebase_probe(const CfTablebase *tb, const CfGame *game, CfCell to_move, CfTbValue *out);
+
+/* Packs / unpacks the one-byte value stored per position. */
+uint8_t cf_tb_pack_value(CfTbValue value);
+CfTbValue cf_tb_unpack_value(uint8_t packed);
+
+/*
+ * Streams a finished table to disk. Keys must be canonical position keys
+ * added in strictly ascending order.
+ */
+typedef struct CfTbWriter CfTbWriter;
+
+CfTbWriter *cf_tablebase_writer_open(const char *path, int max_empties);
+bool cf_tablebase_writer_add(CfTbWriter *writer, uint64_t key, uint8_t value);
+bool cf_tablebase_writer_finish(CfTbWriter *writer);
+
+#endif
@@ -0,0 +1,121 @@
+#include "connect_four_trace.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum {
+    TRACE_RING_EVENTS = 1 << 16
+};
+
+typedef struct {
+    const char *name;
+    const char *arg_name;
+    int64_t arg;
+    uint64_t ts_ns;
+    char phase;
+} TraceEvent;
+
+typedef struct TraceBuffer {
+    struct TraceBuffer *next;
+    int tid;
+    uint64_t written;
+    TraceEvent events[TRACE_RING_EVENTS];
+} TraceBuffer;
+
+static pthread_mutex_t g_trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static TraceBuffer *g_trace_buffers = NULL;
+static int g_trace_next_tid = 1;
+static _Thread_local TraceBuffer *t_trace_buffer = NULL;
+
+static uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Registration takes the lock once per thread; recording never does. */
+static TraceBuffer *thread_buffer(void) {
+    TraceBuffer *buffer = t_trace_buffer;
+
+    if (buffer != NULL) {
+        return buffer;
+    }
+    buffer = calloc(1, sizeof(*buffer));
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_trace_lock);
+    buffer->tid = g_trace_next_tid++;
+    buffer->next = g_trace_buffers;
+    g_trace_buffers = buffer;
+    pthread_mutex_unlock(&g_trace_lock);
+
+    t_trace_buffer = buffer;
+    return buffer;
+}
+
+void cf_trace_event(const char *name, char phase, const char *arg_name, int64_t arg) {
+    TraceBuffer *buffer = thread_buffer();
+    TraceEvent *event;
+
+    if (buffer == NULL) {
+        return;
+    }
+    event = &buffer->events[buffer->written % TRACE_RING_EVENTS];
+    event->name = name;
+    event->phase = phase;
+    event->arg_name = arg_name;
+    event->arg = arg;
+    event->ts_ns = trace_now_ns();
+    buffer->written += 1;
+}
+
+static void write_event(FILE *fp, const TraceBuffer *buffer, const TraceEvent *event, bool *first) {
+    fprintf(
+        fp,
+        "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+        *first ? "" : ",\n",
+        event->name,
+        event->phase,
+        (double)event->ts_ns / 1000.0,
+        buffer->tid
+    );
+    if (event->phase == 'i') {
+        fprintf(fp, ",\"s\":\"t\"");
+    }
+    if (event->arg_name != NULL) {
+        fprintf(fp, ",\"args\":{\"%s\":%lld}", event->arg_name, (long long)event->arg);
+    }
+    fputc('}', fp);
+    *first = false;
+}
+
+bool cf_trace_flush(const char *path) {
+    bool first = true;
+    FILE *fp;
+
+    if (path == NULL || path[0] == '\0') {
+        path = CF_TRACE_DEFAULT_FILE;
+    }
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        return false;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    pthread_mutex_lock(&g_trace_lock);
+    for (const TraceBuffer *buffer = g_trace_buffers; buffer != NULL; buffer = buffer->next) {
+        uint64_t start = buffer->written > TRACE_RING_EVENTS ? buffer->written - TRACE_RING_EVENTS : 0;
+
+        for (uint64_t i = start; i < buffer->written; ++i) {
+            write_event(fp, buffer, &buffer->events[i % TRACE_RING_EVENTS], &first);
+        }
+    }
+    pthread_mutex_unlock(&g_trace_lock);
+    fprintf(fp, "\n]}\n");
+
+    return fclose(fp) == 0;
+}
@@ -0,0 +1,41 @@
+#ifndef CONNECT_FOUR_TRACE_H
+#define CONNECT_FOUR_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Timeline tracing in Chrome trace format (chrome://tracing, Perfetto).
+ *
+ * Compiled out unless built with -DCF_TRACE (make TRACE=1): every macro
+ * below then expands to nothing. When enabled, each thread appends events
+ * to its own fixed-size ring buffer (oldest events are overwritten, no
+ * locks on the hot path), and cf_trace_flush() writes all buffers as one
+ * JSON file. Event names must be string literals.
+ */
+
+#define CF_TRACE_DEFAULT_FILE "connect-four-trace.json"
+
+void cf_trace_event(const char *name, char phase, const char *arg_name, int64_t arg);
+/* Writes every thread's buffer to `path` (NULL/empty: CF_TRACE_DEFAULT_FILE). Call once, at exit. */
+bool cf_trace_flush(const char *path);
+
+#ifdef CF_TRACE
+#define CF_TRACE_BEGIN(name) cf_trace_event((name), 'B', NULL, 0)
+#define CF_TRACE_BEGIN_ARG(name, arg_name, arg) cf_trace_event((name), 'B', (arg_name), (int64_t)(arg))
+#define CF_TRACE_END(name) cf_trace_event((name), 'E', NULL, 0)
+#define CF_TRACE_INSTANT(name) cf_trace_event((name), 'i', NULL, 0)
+#define CF_TRACE_INSTANT_ARG(name, arg_name, arg) cf_trace_event((name), 'i', (arg_name), (int64_t)(arg))
+#define CF_TRACE_COUNTER(name, value) cf_trace_event((name), 'C', "value", (int64_t)(value))
+#define CF_TRACE_FLUSH(path) cf_trace_flush(path)
+#else
+#define CF_TRACE_BEGIN(name) ((void)0)
+#define CF_TRACE_BEGIN_ARG(name, arg_name, arg) ((void)0)
+#define CF_TRACE_END(name) ((void)0)
+#define CF_TRACE_INSTANT(name) ((void)0)
+#define CF_TRACE_INSTANT_ARG(name, arg_name, arg) ((void)0)
+#define CF_TRACE_COUNTER(name, value) ((void)0)
+#define CF_TRACE_FLUSH(path) ((void)0)
+#endif
+
+#endif
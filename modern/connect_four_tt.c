@@ -0,0 +1,311 @@
+#include "connect_four_tt.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "connect_four.h"
+
+/*
+ * Lockless transposition table (xor-validated slots).
+ *
+ * Each slot is two 64-bit words written with independent atomic stores:
+ * `data` and `check = key ^ data`. A reader accepts a slot only when
+ * check ^ data reproduces its key, so a slot torn by a concurrent writer
+ * (thread or another process sharing the file) reads as a miss instead of
+ * returning mixed data. Buckets hold two slots: a depth-preferred one and
+ * an always-replace one.
+ *
+ * Bump TT_FORMAT_VERSION whenever the evaluator or the key layout changes,
+ * so stale shared files are rejected instead of feeding old scores.
+ */
+enum {
+    TT_BYTE_ORDER = 0x01020304,
+    TT_FORMAT_VERSION = 1,
+    TT_BUCKET_SLOTS = 2,
+    TT_NO_MOVE = 15
+};
+
+static const char kTtMagic[8] = {'C', 'F', '4', 'T', 'T', '0', '1', '\n'};
+
+typedef struct {
+    _Atomic uint64_t check;
+    _Atomic uint64_t data;
+} TtSlot;
+
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t format_version;
+    uint16_t rows;
+    uint16_t cols;
+    uint32_t reserved0;
+    uint64_t slot_count;
+    _Atomic uint32_t generation;
+    uint32_t reserved1;
+    uint64_t reserved2[3];
+} TtHeader;
+
+struct CfTt {
+    void *map;
+    size_t map_size;
+    TtHeader *header;
+    TtSlot *slots;
+    size_t bucket_mask;
+    uint8_t generation;
+    bool shared;
+    _Atomic uint64_t probes;
+    _Atomic uint64_t hits;
+    _Atomic uint64_t stores;
+};
+
+static size_t round_slots(size_t slots) {
+    size_t rounded = TT_BUCKET_SLOTS * 2;
+
+    while (rounded < slots && rounded < ((size_t)1 << 40)) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+static uint64_t mix_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= UINT64_C(0xff51afd7ed558ccd);
+    key ^= key >> 33;
+    key *= UINT64_C(0xc4ceb9fe1a85ec53);
+    key ^= key >> 33;
+    return key;
+}
+
+static size_t map_bytes(size_t slots) {
+    return sizeof(TtHeader) + slots * sizeof(TtSlot);
+}
+
+static void init_header(TtHeader *header, size_t slots) {
+    memcpy(header->magic, kTtMagic, sizeof(kTtMagic));
+    header->byte_order = TT_BYTE_ORDER;
+    header->format_version = TT_FORMAT_VERSION;
+    header->rows = CF_ROWS;
+    header->cols = CF_COLS;
+    header->slot_count = slots;
+    atomic_store(&header->generation, 0);
+}
+
+static bool header_matches(const TtHeader *header, size_t slots) {
+    return memcmp(header->magic, kTtMagic, sizeof(kTtMagic)) == 0 &&
+        header->byte_order == TT_BYTE_ORDER &&
+        header->format_version == TT_FORMAT_VERSION &&
+        header->rows == CF_ROWS &&
+        header->cols == CF_COLS &&
+        header->slot_count == slots;
+}
+
+static CfTt *wrap_mapping(void *map, size_t map_size, bool shared) {
+    CfTt *tt = calloc(1, sizeof(*tt));
+
+    if (tt == NULL) {
+        munmap(map, map_size);
+        return NULL;
+    }
+
+    tt->map = map;
+    tt->map_size = map_size;
+    tt->header = map;
+    tt->slots = (TtSlot *)((uint8_t *)map + sizeof(TtHeader));
+    tt->bucket_mask = (size_t)(tt->header->slot_count / TT_BUCKET_SLOTS) - 1;
+    tt->shared = shared;
+    /* Each session gets its own age so stale deep entries can be replaced. */
+    tt->generation = (uint8_t)(atomic_fetch_add(&tt->header->generation, 1) + 1);
+    return tt;
+}
+
+CfTt *cf_tt_create(size_t slots) {
+    size_t count = round_slots(slots);
+    size_t bytes = map_bytes(count);
+    void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    init_header(map, count);
+    return wrap_mapping(map, bytes, false);
+}
+
+CfTt *cf_tt_open_shared(const char *path, size_t slots) {
+    size_t count = round_slots(slots);
+    size_t bytes = map_bytes(count);
+    static _Atomic uint64_t lock_free_probe;
+    struct stat st;
+    void *map;
+    int fd;
+
+    /* Cross-process sharing is only sound when 64-bit atomics need no lock. */
+    if (path == NULL || path[0] == '\0' || !atomic_is_lock_free(&lock_free_probe)) {
+        return NULL;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    /* The lock only serialises creation; probes and stores never take it. */
+    if (flock(fd, LOCK_EX) != 0 || fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    if (st.st_size == 0 && ftruncate(fd, (off_t)bytes) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size != 0 && (size_t)st.st_size != bytes) {
+        close(fd);
+        return NULL;
+    }
+
+    map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    if (st.st_size == 0) {
+        init_header(map, count);
+    } else if (!header_matches(map, count)) {
+        munmap(map, bytes);
+        close(fd);
+        return NULL;
+    }
+
+    flock(fd, LOCK_UN);
+    close(fd);
+    return wrap_mapping(map, bytes, true);
+}
+
+void cf_tt_close(CfTt *tt) {
+    if (tt == NULL) {
+        return;
+    }
+    if (tt->shared) {
+        msync(tt->map, tt->map_size, MS_ASYNC);
+    }
+    munmap(tt->map, tt->map_size);
+    free(tt);
+}
+
+void cf_tt_prefault(CfTt *tt) {
+    long page = sysconf(_SC_PAGESIZE);
+    size_t step = page > (long)sizeof(TtSlot) ? (size_t)page / sizeof(TtSlot) : 1;
+    size_t count;
+
+    if (tt == NULL) {
+        return;
+    }
+    count = (tt->bucket_mask + 1) * TT_BUCKET_SLOTS;
+    for (size_t i = 0; i < count; i += step) {
+        /* A write that changes nothing, atomically, so a concurrent store is never lost. */
+        atomic_fetch_or_explicit(&tt->slots[i].data, 0, memory_order_relaxed);
+    }
+}
+
+bool cf_tt_is_shared(const CfTt *tt) {
+    return tt != NULL && tt->shared;
+}
+
+/*
+ * data layout: score (32) | depth (8) | bound (2) | best col (4) | generation (8)
+ */
+static uint64_t pack_entry(const CfTtEntry *entry, uint8_t generation) {
+    uint64_t score = (uint32_t)entry->score;
+    uint64_t depth = (uint64_t)(entry->depth < 0 ? 0 : (entry->depth > 255 ? 255 : entry->depth));
+    uint64_t move = (entry->best_col >= 0 && entry->best_col < CF_COLS) ? (uint64_t)entry->best_col : TT_NO_MOVE;
+
+    return score | (depth << 32) | ((uint64_t)entry->bound << 40) | (move << 42) | ((uint64_t)generation << 46);
+}
+
+static void unpack_entry(uint64_t data, CfTtEntry *out) {
+    int move = (int)((data >> 42) & 15);
+
+    out->score = (int32_t)(uint32_t)(data & 0xffffffffu);
+    out->depth = (int)((data >> 32) & 255);
+    out->bound = (CfTtBound)((data >> 40) & 3);
+    out->best_col = (move == TT_NO_MOVE) ? -1 : move;
+}
+
+static uint8_t entry_generation(uint64_t data) {
+    return (uint8_t)((data >> 46) & 255);
+}
+
+bool cf_tt_probe(CfTt *tt, uint64_t key, CfTtEntry *out) {
+    TtSlot *bucket;
+
+    if (tt == NULL) {
+        return false;
+    }
+
+    atomic_fetch_add_explicit(&tt->probes, 1, memory_order_relaxed);
+    bucket = &tt->slots[(mix_key(key) & tt->bucket_mask) * TT_BUCKET_SLOTS];
+
+    for (int i = 0; i < TT_BUCKET_SLOTS; ++i) {
+        uint64_t data = atomic_load_explicit(&bucket[i].data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&bucket[i].check, memory_order_relaxed);
+
+        if (data != 0 && (check ^ data) == key) {
+            unpack_entry(data, out);
+            if (out->bound == CF_TT_NONE) {
+                return false;
+            }
+            atomic_fetch_add_explicit(&tt->hits, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void cf_tt_store(CfTt *tt, uint64_t key, const CfTtEntry *entry) {
+    TtSlot *bucket;
+    TtSlot *target;
+    uint64_t data;
+    uint64_t deep_data;
+    uint64_t deep_check;
+
+    if (tt == NULL || entry->bound == CF_TT_NONE) {
+        return;
+    }
+
+    bucket = &tt->slots[(mix_key(key) & tt->bucket_mask) * TT_BUCKET_SLOTS];
+    data = pack_entry(entry, tt->generation);
+    deep_data = atomic_load_explicit(&bucket[0].data, memory_order_relaxed);
+    deep_check = atomic_load_explicit(&bucket[0].check, memory_order_relaxed);
+
+    if (deep_data == 0 ||
+        (deep_check ^ deep_data) == key ||
+        entry_generation(deep_data) != tt->generation ||
+        entry->depth >= (int)((deep_data >> 32) & 255)) {
+        target = &bucket[0];
+    } else {
+        target = &bucket[1];
+    }
+
+    atomic_store_explicit(&target->data, data, memory_order_relaxed);
+    atomic_store_explicit(&target->check, key ^ data, memory_order_relaxed);
+    atomic_fetch_add_explicit(&tt->stores, 1, memory_order_relaxed);
+}
+
+void cf_tt_get_stats(const CfTt *tt, CfTtStats *out) {
+    memset(out, 0, sizeof(*out));
+    if (tt == NULL) {
+        return;
+    }
+    out->probes = atomic_load_explicit(&tt->probes, memory_order_relaxed);
+    out->hits = atomic_load_explicit(&tt->hits, memory_order_relaxed);
+    out->stores = atomic_load_explicit(&tt->stores, memory_order_relaxed);
+}
@@ -0,0 +1,49 @@
+#ifndef CONNECT_FOUR_TT_H
+#define CONNECT_FOUR_TT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CF_TT_DEFAULT_SLOTS ((size_t)1 << 20)
+
+typedef enum {
+    CF_TT_NONE = 0,
+    CF_TT_EXACT = 1,
+    CF_TT_LOWER = 2,
+    CF_TT_UPPER = 3
+} CfTtBound;
+
+typedef struct {
+    int score;
+    int depth;
+    CfTtBound bound;
+    int best_col;
+} CfTtEntry;
+
+typedef struct {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+} CfTtStats;
+
+typedef struct CfTt CfTt;
+
+/* Private table in anonymous memory. */
+CfTt *cf_tt_create(size_t slots);
+/*
+ * Table backed by a shared file mapping. Every process that opens the same
+ * path sees the same entries; probes and stores never take a lock.
+ * Returns NULL when the file cannot be used (then fall back to cf_tt_create).
+ */
+CfTt *cf_tt_open_shared(const char *path, size_t slots);
+void cf_tt_close(CfTt *tt);
+/* Faults every page of the table in, writable, so the first searches do not pay for it. */
+void cf_tt_prefault(CfTt *tt);
+
+bool cf_tt_is_shared(const CfTt *tt);
+bool cf_tt_probe(CfTt *tt, uint64_t key, CfTtEntry *out);
+void cf_tt_store(CfTt *tt, uint64_t key, const CfTtEntry *entry);
+void cf_tt_get_stats(const CfTt *tt, CfTtStats *out);
+
+#endif